@@ -0,0 +1,452 @@
+// This file is part of Dust Racing 2D.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// Dust Racing 2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Dust Racing 2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Dust Racing 2D. If not, see <http://www.gnu.org/licenses/>.
+
+#include "compiledtrack.hpp"
+#include "trackdatabase.hpp"
+
+#include <QDir>
+#include <QDomDocument>
+#include <QDomElement>
+#include <QFileInfo>
+#include <QSaveFile>
+
+#include <cassert>
+#include <cstring>
+
+namespace {
+
+const char MAGIC[4] = {'D', 'R', 'T', 'B'};
+
+// Reads as another value on a machine of the other byte order
+const quint32 BYTE_ORDER_MARK = 0x01020304;
+
+const auto FILE_EXTENSION = ".trkb";
+
+static_assert(sizeof(CompiledTrack::Header) == 80, "CompiledTrack::Header must be packed");
+static_assert(sizeof(CompiledTrack::Tile) == 16, "CompiledTrack::Tile must be packed");
+static_assert(sizeof(CompiledTrack::Object) == 20, "CompiledTrack::Object must be packed");
+static_assert(sizeof(CompiledTrack::Node) == 20, "CompiledTrack::Node must be packed");
+static_assert(sizeof(CompiledTrack::String) == 8, "CompiledTrack::String must be packed");
+
+//! \return true if the section is aligned for records of the given size and within the file.
+bool isSectionValid(const CompiledTrack::Section & section, quint64 recordSize, qint64 fileSize)
+{
+    return section.offset % 4 == 0 &&
+        section.offset + recordSize * section.count <= static_cast<quint64>(fileSize);
+}
+
+} // namespace
+
+CompiledTrack::CompiledTrack()
+    : m_data(nullptr)
+    , m_size(0)
+    , m_header(nullptr)
+{
+}
+
+template<typename T>
+const T * CompiledTrack::section(const Section & section) const
+{
+    assert(m_data);
+    return reinterpret_cast<const T *>(m_data + section.offset);
+}
+
+QString CompiledTrack::compiledFileName(QString trackFileName)
+{
+    const QFileInfo info(trackFileName);
+    return info.path() + QDir::separator() + info.completeBaseName() + FILE_EXTENSION;
+}
+
+bool CompiledTrack::open(QString fileName)
+{
+    close();
+
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    m_size = m_file.size();
+    if (m_size >= static_cast<qint64>(sizeof(Header)))
+    {
+        m_data = m_file.map(0, m_size);
+        m_header = reinterpret_cast<const Header *>(m_data);
+    }
+
+    if (!m_data || !isValid())
+    {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+bool CompiledTrack::open(const QByteArray & data)
+{
+    close();
+
+    // QByteArray data is aligned for the records
+    m_buffer = data;
+    m_size = m_buffer.size();
+    if (m_size >= static_cast<qint64>(sizeof(Header)))
+    {
+        m_data = reinterpret_cast<const uchar *>(m_buffer.constData());
+        m_header = reinterpret_cast<const Header *>(m_data);
+    }
+
+    if (!m_data || !isValid())
+    {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+bool CompiledTrack::isValid() const
+{
+    if (std::memcmp(m_header->magic, MAGIC, sizeof(MAGIC)) ||
+        m_header->version != VERSION ||
+        m_header->byteOrderMark != BYTE_ORDER_MARK)
+    {
+        return false;
+    }
+
+    if (!isSectionValid(m_header->tiles, sizeof(Tile), m_size) ||
+        !isSectionValid(m_header->objects, sizeof(Object), m_size) ||
+        !isSectionValid(m_header->nodes, sizeof(Node), m_size) ||
+        !isSectionValid(m_header->strings, sizeof(String), m_size) ||
+        !isSectionValid(m_header->stringData, 1, m_size))
+    {
+        return false;
+    }
+
+    const unsigned int strings = stringCount();
+    for (unsigned int index = 0; index < strings; index++)
+    {
+        const String & string = section<String>(m_header->strings)[index];
+        if (static_cast<quint64>(string.offset) + string.length > m_header->stringData.count)
+        {
+            return false;
+        }
+    }
+
+    if (m_header->name >= strings)
+    {
+        return false;
+    }
+
+    // Check the records here, so that the loaders can use them as such
+    for (unsigned int index = 0; index < tileCount(); index++)
+    {
+        const Tile & tile = tiles()[index];
+        if (tile.i >= m_header->cols || tile.j >= m_header->rows || tile.type >= strings)
+        {
+            return false;
+        }
+    }
+
+    for (unsigned int index = 0; index < objectCount(); index++)
+    {
+        const Object & object = objects()[index];
+        if (object.category >= strings || object.role >= strings)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void CompiledTrack::close()
+{
+    if (m_data && m_buffer.isEmpty())
+    {
+        m_file.unmap(const_cast<uchar *>(m_data));
+    }
+
+    m_file.close();
+    m_buffer.clear();
+
+    m_data = nullptr;
+    m_size = 0;
+    m_header = nullptr;
+}
+
+bool CompiledTrack::isOpen() const
+{
+    return m_header;
+}
+
+QString CompiledTrack::name() const
+{
+    return QString::fromUtf8(string(m_header->name));
+}
+
+unsigned int CompiledTrack::cols() const
+{
+    return m_header->cols;
+}
+
+unsigned int CompiledTrack::rows() const
+{
+    return m_header->rows;
+}
+
+unsigned int CompiledTrack::index() const
+{
+    return m_header->index;
+}
+
+bool CompiledTrack::isUserTrack() const
+{
+    return m_header->isUserTrack;
+}
+
+qint64 CompiledTrack::sourceSize() const
+{
+    return m_header->sourceSize;
+}
+
+unsigned int CompiledTrack::tileCount() const
+{
+    return m_header->tiles.count;
+}
+
+const CompiledTrack::Tile * CompiledTrack::tiles() const
+{
+    return section<Tile>(m_header->tiles);
+}
+
+unsigned int CompiledTrack::objectCount() const
+{
+    return m_header->objects.count;
+}
+
+const CompiledTrack::Object * CompiledTrack::objects() const
+{
+    return section<Object>(m_header->objects);
+}
+
+unsigned int CompiledTrack::nodeCount() const
+{
+    return m_header->nodes.count;
+}
+
+const CompiledTrack::Node * CompiledTrack::nodes() const
+{
+    return section<Node>(m_header->nodes);
+}
+
+unsigned int CompiledTrack::stringCount() const
+{
+    return m_header->strings.count;
+}
+
+QByteArray CompiledTrack::string(unsigned int index) const
+{
+    assert(index < stringCount());
+    const String & string = section<String>(m_header->strings)[index];
+    return QByteArray::fromRawData(section<char>(m_header->stringData) + string.offset, string.length);
+}
+
+CompiledTrack::~CompiledTrack()
+{
+    close();
+}
+
+CompiledTrackWriter::CompiledTrackWriter(QString name, bool isUserTrack, unsigned int cols, unsigned int rows, unsigned int index)
+    : m_header()
+{
+    std::memcpy(m_header.magic, MAGIC, sizeof(MAGIC));
+    m_header.version = CompiledTrack::VERSION;
+    m_header.byteOrderMark = BYTE_ORDER_MARK;
+    m_header.cols = cols;
+    m_header.rows = rows;
+    m_header.index = index;
+    m_header.isUserTrack = isUserTrack;
+    m_header.name = stringIndex(name);
+}
+
+std::unique_ptr<CompiledTrackWriter> CompiledTrackWriter::fromXml(QString trackFileName)
+{
+    typedef TrackDataBase::DataKeywords Keywords;
+
+    QDomDocument doc;
+
+    QFile file(trackFileName);
+    if (!file.open(QIODevice::ReadOnly) || !doc.setContent(&file))
+    {
+        return nullptr;
+    }
+
+    file.close();
+
+    const QDomElement root = doc.documentElement();
+    if (root.nodeName() != Keywords::Header::track)
+    {
+        return nullptr;
+    }
+
+    std::unique_ptr<CompiledTrackWriter> writer(new CompiledTrackWriter(
+        root.attribute(Keywords::Header::name, "undefined"),
+        root.attribute(Keywords::Header::user, "0").toUInt(),
+        root.attribute(Keywords::Header::cols, "0").toUInt(),
+        root.attribute(Keywords::Header::rows, "0").toUInt(),
+        root.attribute(Keywords::Header::index, "999").toUInt()));
+    writer->setSourceSize(QFileInfo(trackFileName).size());
+
+    for (QDomElement element = root.firstChildElement(); !element.isNull(); element = element.nextSiblingElement())
+    {
+        if (element.nodeName() == Keywords::Track::tile)
+        {
+            writer->addTile(
+                element.attribute(Keywords::Tile::i, "0").toUInt(),
+                element.attribute(Keywords::Tile::j, "0").toUInt(),
+                element.attribute(Keywords::Tile::type, "clear"),
+                element.attribute(Keywords::Tile::orientation, "0").toInt(),
+                element.attribute(Keywords::Tile::computerHint, "0").toUInt(),
+                element.attribute(Keywords::Tile::excludeFromMinimap, "0").toInt());
+        }
+        else if (element.nodeName() == Keywords::Track::object)
+        {
+            writer->addObject(
+                element.attribute(Keywords::Object::category, ""),
+                element.attribute(Keywords::Object::role, ""),
+                element.attribute(Keywords::Object::x, "0").toInt(),
+                element.attribute(Keywords::Object::y, "0").toInt(),
+                element.attribute(Keywords::Object::orientation, "0").toInt(),
+                element.attribute(Keywords::Object::forceStationary, "0").toUInt());
+        }
+        else if (element.nodeName() == Keywords::Track::node)
+        {
+            writer->addNode(
+                element.attribute(Keywords::Node::index, "0").toInt(),
+                element.attribute(Keywords::Node::x, "0").toInt(),
+                element.attribute(Keywords::Node::y, "0").toInt(),
+                element.attribute(Keywords::Node::width, "0").toInt(),
+                element.attribute(Keywords::Node::height, "0").toInt());
+        }
+    }
+
+    return writer;
+}
+
+void CompiledTrackWriter::setSourceSize(qint64 sourceSize)
+{
+    m_header.sourceSize = sourceSize;
+}
+
+void CompiledTrackWriter::addTile(unsigned int i, unsigned int j, QString type, int orientation, int computerHint, bool excludeFromMinimap)
+{
+    CompiledTrack::Tile tile = {};
+    tile.i = i;
+    tile.j = j;
+    tile.orientation = orientation;
+    tile.type = stringIndex(type);
+    tile.computerHint = computerHint;
+    tile.excludeFromMinimap = excludeFromMinimap;
+    m_tiles.push_back(tile);
+}
+
+void CompiledTrackWriter::addObject(QString category, QString role, int x, int y, int orientation, bool forceStationary)
+{
+    CompiledTrack::Object object = {};
+    object.x = x;
+    object.y = y;
+    object.orientation = orientation;
+    object.category = stringIndex(category);
+    object.role = stringIndex(role);
+    object.forceStationary = forceStationary;
+    m_objects.push_back(object);
+}
+
+void CompiledTrackWriter::addNode(int index, int x, int y, int width, int height)
+{
+    m_nodes.push_back({index, x, y, width, height});
+}
+
+quint16 CompiledTrackWriter::stringIndex(QString string)
+{
+    auto iter = m_stringIndices.find(string);
+    if (iter != m_stringIndices.end())
+    {
+        return iter.value();
+    }
+
+    const QByteArray data = string.toUtf8();
+    m_strings.push_back({static_cast<quint32>(m_stringData.size()), static_cast<quint32>(data.size())});
+    m_stringData.append(data);
+
+    const quint16 index = m_strings.size() - 1;
+    m_stringIndices.insert(string, index);
+    return index;
+}
+
+QByteArray CompiledTrackWriter::data() const
+{
+    // The indices are 16-bit
+    if (m_strings.size() > 0x10000)
+    {
+        return QByteArray();
+    }
+
+    CompiledTrack::Header header = m_header;
+    quint32 offset = sizeof(header);
+
+    const auto setSection = [&offset] (CompiledTrack::Section & section, size_t count, size_t recordSize) {
+        section.offset = offset;
+        section.count = count;
+        offset += count * recordSize;
+    };
+
+    setSection(header.tiles, m_tiles.size(), sizeof(CompiledTrack::Tile));
+    setSection(header.objects, m_objects.size(), sizeof(CompiledTrack::Object));
+    setSection(header.nodes, m_nodes.size(), sizeof(CompiledTrack::Node));
+    setSection(header.strings, m_strings.size(), sizeof(CompiledTrack::String));
+    setSection(header.stringData, m_stringData.size(), 1);
+
+    QByteArray data;
+    data.reserve(offset);
+    data.append(reinterpret_cast<const char *>(&header), sizeof(header));
+    data.append(reinterpret_cast<const char *>(m_tiles.data()), sizeof(CompiledTrack::Tile) * m_tiles.size());
+    data.append(reinterpret_cast<const char *>(m_objects.data()), sizeof(CompiledTrack::Object) * m_objects.size());
+    data.append(reinterpret_cast<const char *>(m_nodes.data()), sizeof(CompiledTrack::Node) * m_nodes.size());
+    data.append(reinterpret_cast<const char *>(m_strings.data()), sizeof(CompiledTrack::String) * m_strings.size());
+    data.append(m_stringData);
+
+    return data;
+}
+
+bool CompiledTrackWriter::save(QString fileName) const
+{
+    const QByteArray compiled = data();
+    if (compiled.isEmpty())
+    {
+        return false;
+    }
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        return false;
+    }
+
+    file.write(compiled);
+
+    return file.commit();
+}
@@ -0,0 +1,269 @@
+// This file is part of Dust Racing 2D.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// Dust Racing 2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Dust Racing 2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Dust Racing 2D. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef COMPILEDTRACK_HPP
+#define COMPILEDTRACK_HPP
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QString>
+
+#include <memory>
+#include <vector>
+
+/*! A track compiled to a binary file by the editor or cached by the game. The tiles, objects and route
+ *  nodes are stored in packed arrays that are used directly from the memory-mapped
+ *  file, so loading a track doesn't involve any parsing. The values are the same
+ *  as in the XML track file, i.e. in the coordinates of the editor.
+ *
+ *  The file consists of the header followed by the sections listed in it. Strings
+ *  (the name, tile types, object categories and roles) are stored once as UTF-8 in
+ *  a string table and referred to by their index. Numbers are in the byte order of
+ *  the machine that compiled the track. Files of another version or byte order are
+ *  rejected and the track should be compiled again from the XML file. */
+class CompiledTrack
+{
+public:
+
+    static const quint32 VERSION = 1;
+
+    //! A range of records in the file.
+    struct Section
+    {
+        quint32 offset;
+
+        quint32 count;
+    };
+
+    struct Header
+    {
+        char magic[4];
+
+        quint32 version;
+
+        quint32 byteOrderMark;
+
+        quint32 cols;
+
+        quint32 rows;
+
+        quint32 index;
+
+        quint32 isUserTrack;
+
+        //! String index of the track name.
+        quint32 name;
+
+        //! Size of the XML file the track was compiled from.
+        quint64 sourceSize;
+
+        Section tiles;
+
+        Section objects;
+
+        Section nodes;
+
+        //! String records.
+        Section strings;
+
+        //! UTF-8 data of the strings. The count is in bytes.
+        Section stringData;
+    };
+
+    struct Tile
+    {
+        quint16 i;
+
+        quint16 j;
+
+        qint32 orientation;
+
+        //! String index of the tile type.
+        quint16 type;
+
+        quint8 computerHint;
+
+        quint8 excludeFromMinimap;
+
+        quint32 reserved;
+    };
+
+    struct Object
+    {
+        qint32 x;
+
+        qint32 y;
+
+        qint32 orientation;
+
+        //! String index of the category.
+        quint16 category;
+
+        //! String index of the role.
+        quint16 role;
+
+        quint8 forceStationary;
+
+        quint8 reserved[3];
+    };
+
+    struct Node
+    {
+        qint32 index;
+
+        qint32 x;
+
+        qint32 y;
+
+        qint32 width;
+
+        qint32 height;
+    };
+
+    struct String
+    {
+        //! Offset in the string data.
+        quint32 offset;
+
+        quint32 length;
+    };
+
+    //! Constructor.
+    CompiledTrack();
+
+    //! Destructor. Unmaps the file.
+    ~CompiledTrack();
+
+    CompiledTrack(const CompiledTrack & other) = delete;
+
+    CompiledTrack & operator= (const CompiledTrack & other) = delete;
+
+    //! \return the name of the compiled file of the given XML track file.
+    static QString compiledFileName(QString trackFileName);
+
+    /*! Map the given file and check that all sections and string indices are
+     *  within the file and that the tiles are within the map.
+     *  \return false if the file couldn't be mapped or is not valid. */
+    bool open(QString fileName);
+
+    /*! Use the given compiled data instead of a file, e.g. when it couldn't be
+     *  cached. The data is checked like the file in open(). */
+    bool open(const QByteArray & data);
+
+    //! Unmap the file.
+    void close();
+
+    bool isOpen() const;
+
+    QString name() const;
+
+    unsigned int cols() const;
+
+    unsigned int rows() const;
+
+    unsigned int index() const;
+
+    bool isUserTrack() const;
+
+    //! \return size of the XML file the track was compiled from.
+    qint64 sourceSize() const;
+
+    unsigned int tileCount() const;
+
+    const Tile * tiles() const;
+
+    unsigned int objectCount() const;
+
+    const Object * objects() const;
+
+    unsigned int nodeCount() const;
+
+    const Node * nodes() const;
+
+    unsigned int stringCount() const;
+
+    //! \return the UTF-8 data of the given string without copying it.
+    QByteArray string(unsigned int index) const;
+
+private:
+
+    template<typename T>
+    const T * section(const Section & section) const;
+
+    bool isValid() const;
+
+    QFile m_file;
+
+    //! The data given to open() instead of a file.
+    QByteArray m_buffer;
+
+    const uchar * m_data;
+
+    qint64 m_size;
+
+    const Header * m_header;
+};
+
+//! Writes the compiled track file read by CompiledTrack.
+class CompiledTrackWriter
+{
+public:
+
+    //! Constructor.
+    CompiledTrackWriter(QString name, bool isUserTrack, unsigned int cols, unsigned int rows, unsigned int index);
+
+    /*! Compile the given XML track file. Missing attributes get the same defaults
+     *  as in the game, e.g. the track index is 999. The game, the editor and the
+     *  --compile option all use this, so they can't convert the values differently.
+     *  \return nullptr if the file couldn't be read. */
+    static std::unique_ptr<CompiledTrackWriter> fromXml(QString trackFileName);
+
+    //! Set the size of the XML file the track is compiled from.
+    void setSourceSize(qint64 sourceSize);
+
+    void addTile(unsigned int i, unsigned int j, QString type, int orientation, int computerHint, bool excludeFromMinimap);
+
+    void addObject(QString category, QString role, int x, int y, int orientation, bool forceStationary);
+
+    void addNode(int index, int x, int y, int width, int height);
+
+    //! \return the contents of the compiled file, or an empty array if there are too many strings.
+    QByteArray data() const;
+
+    //! Write the file atomically. \return false if failed.
+    bool save(QString fileName) const;
+
+private:
+
+    //! \return index of the given string. Adds the string to the table if needed.
+    quint16 stringIndex(QString string);
+
+    CompiledTrack::Header m_header;
+
+    std::vector<CompiledTrack::Tile> m_tiles;
+
+    std::vector<CompiledTrack::Object> m_objects;
+
+    std::vector<CompiledTrack::Node> m_nodes;
+
+    std::vector<CompiledTrack::String> m_strings;
+
+    QByteArray m_stringData;
+
+    QHash<QString, quint16> m_stringIndices;
+};
+
+#endif // COMPILEDTRACK_HPP
@@ -15,13 +15,16 @@
 
 #include "application.hpp"
 #include "mainwindow.hpp"
+#include "trackio.hpp"
 
+#include "../common/compiledtrack.hpp"
 #include "../common/config.hpp"
 #include "../common/userexception.hpp"
 
 #include <QLocale>
 #include <QSettings>
 
+#include <cstdlib>
 #include <iostream>
 
 static void printHelp()
@@ -32,6 +35,8 @@ static void printHelp()
     std::cout << "Options:" << std::endl;
     std::cout << "--help        Show this help." << std::endl;
     std::cout << "--lang [lang] Force language: fi, fr, it, cs." << std::endl;
+    std::cout << "--compile [trackFile]..." << std::endl;
+    std::cout << "              Write the compiled tracks loaded by the game and exit." << std::endl;
     std::cout << std::endl;
 }
 
@@ -69,6 +74,14 @@ void Application::parseArgs(int argc, char ** argv)
         {
             lang = args[i + 1];
         }
+        else if (args[i] == "--compile")
+        {
+            m_compileOnly = true;
+        }
+        else if (m_compileOnly)
+        {
+            m_compileFiles.push_back(args[i]);
+        }
         else
         {
             m_trackFile = args[i];
@@ -80,18 +93,49 @@ void Application::parseArgs(int argc, char ** argv)
 
 Application::Application(int & argc, char ** argv)
     : m_app(argc, argv)
+    , m_compileOnly(false)
+    , m_mainWindow(nullptr)
 {
     parseArgs(argc, argv);
 
-    m_mainWindow = new MainWindow(m_trackFile);
-    m_mainWindow->show();
+    if (!m_compileOnly)
+    {
+        m_mainWindow = new MainWindow(m_trackFile);
+        m_mainWindow->show();
+    }
 }
 
 int Application::run()
 {
+    if (m_compileOnly)
+    {
+        return compileTracks();
+    }
+
     return m_app.exec();
 }
 
+int Application::compileTracks()
+{
+    TrackIO trackIO;
+    int failures = 0;
+    for (auto && trackFile : m_compileFiles)
+    {
+        const QString compiledFile = CompiledTrack::compiledFileName(trackFile);
+        if (trackIO.compile(trackFile, compiledFile))
+        {
+            std::cout << "Compiled '" << trackFile.toStdString() << "' to '" << compiledFile.toStdString() << "'" << std::endl;
+        }
+        else
+        {
+            std::cerr << "Failed to compile '" << trackFile.toStdString() << "'" << std::endl;
+            failures++;
+        }
+    }
+
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
 Application::~Application()
 {
     delete m_mainWindow;
@@ -19,6 +19,8 @@
 #include <QApplication>
 #include <QTranslator>
 
+#include <vector>
+
 class MainWindow;
 
 class Application
@@ -35,12 +37,19 @@ private:
 
     void parseArgs(int argc, char ** argv);
 
+    //! Compile the track files given with --compile. \return exit code.
+    int compileTracks();
+
     QApplication m_app;
 
     QTranslator m_appTranslator;
 
     QString m_trackFile;
 
+    bool m_compileOnly;
+
+    std::vector<QString> m_compileFiles;
+
     MainWindow * m_mainWindow;
 };
 
@@ -18,6 +18,7 @@ INCLUDEPATH += .
 
 # Input
 HEADERS +=  \
+    ../common/compiledtrack.hpp \
     ../common/config.hpp \
     ../common/mapbase.hpp \
     ../common/objectbase.hpp \
@@ -53,6 +54,7 @@ HEADERS +=  \
     undostack.hpp \
 
 SOURCES += \
+    ../common/compiledtrack.cpp \
     ../common/mapbase.cpp \
     ../common/objectbase.cpp \
     ../common/objects.cpp \
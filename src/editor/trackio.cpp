@@ -29,6 +29,7 @@
 #include "trackio.hpp"
 #include "tracktile.hpp"
 
+#include "../common/compiledtrack.hpp"
 #include "../common/config.hpp"
 #include "../common/objectbase.hpp"
 #include "../common/targetnodebase.hpp"
@@ -197,12 +198,29 @@ bool TrackIO::save(TrackDataPtr trackData, QString path)
         QTextStream out(&file);
         out << doc.toString();
         file.close();
+
+        // The game loads the compiled track instead of the XML, if its source size
+        // matches. Don't leave an outdated one behind if compiling fails.
+        const QString compiledPath = CompiledTrack::compiledFileName(path);
+        if (!compile(path, compiledPath))
+        {
+            QFile::remove(compiledPath);
+        }
+
         return true;
     }
 
     return false;
 }
 
+bool TrackIO::compile(QString trackPath, QString compiledPath)
+{
+    // Compile the saved file instead of the track data, so that the values
+    // are converted exactly like when the game compiles the track.
+    const auto writer = CompiledTrackWriter::fromXml(trackPath);
+    return writer && writer->save(compiledPath);
+}
+
 TrackDataPtr TrackIO::open(QString path)
 {
     QDomDocument doc;
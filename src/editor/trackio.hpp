@@ -26,9 +26,14 @@ class TrackIO
 {
 public:
 
-    //! Save given track data. Returns false if failed.
+    /*! Save given track data. Also writes the compiled track
+     *  loaded by the game, see CompiledTrack. Returns false if failed. */
     bool save(TrackDataPtr trackData, QString path);
 
+    /*! Compile given saved track file to the compiled track
+     *  loaded by the game. Returns false if failed. */
+    bool compile(QString trackPath, QString compiledPath);
+
     /*! Load given track data. Returns the new TrackData object,
      *  or nullptr if failed. */
     TrackDataPtr open(QString path);
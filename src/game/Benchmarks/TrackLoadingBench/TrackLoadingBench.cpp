@@ -0,0 +1,446 @@
+// This file is part of Dust Racing 2D.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// Dust Racing 2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Dust Racing 2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Dust Racing 2D. If not, see <http://www.gnu.org/licenses/>.
+
+// Start-up benchmark of the track loading: writes a synthetic directory of
+// tracks and measures how long it takes to get the metadata of all tracks
+// by parsing every file with QDomDocument like the eager loader did and
+// from the track index, both when the index has to be built and when it's
+// up-to-date. Then measures reading the contents of a single track of
+// growing size from the XML file and from the compiled track.
+// No GL context, window or assets are needed.
+
+#include "../../trackindex.hpp"
+
+#include "../../../common/compiledtrack.hpp"
+#include "../../../common/trackdatabase.hpp"
+
+#include <MCTrigonom>
+
+#include <QDir>
+#include <QDomDocument>
+#include <QDomElement>
+#include <QFile>
+#include <QFileInfo>
+#include <QStringList>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Config
+{
+    int tracks = 400;
+    int cols = 30;
+    int rows = 20;
+    int objects = 300;
+    int runs = 3;
+};
+
+void printUsage()
+{
+    std::printf(
+        "Usage: track-loading-bench [OPTIONS]\n"
+        "  --tracks N       Max number of synthetic tracks (default 400)\n"
+        "  --cols N         Tile columns per track (default 30)\n"
+        "  --rows N         Tile rows per track (default 20)\n"
+        "  --objects N      Objects per track (default 300)\n"
+        "  --runs N         Runs per measurement, the best is reported (default 3)\n");
+}
+
+bool parseArgs(int argc, char ** argv, Config & config)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg(argv[i]);
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--tracks" && hasValue)
+        {
+            config.tracks = std::atoi(argv[++i]);
+        }
+        else if (arg == "--cols" && hasValue)
+        {
+            config.cols = std::atoi(argv[++i]);
+        }
+        else if (arg == "--rows" && hasValue)
+        {
+            config.rows = std::atoi(argv[++i]);
+        }
+        else if (arg == "--objects" && hasValue)
+        {
+            config.objects = std::atoi(argv[++i]);
+        }
+        else if (arg == "--runs" && hasValue)
+        {
+            config.runs = std::atoi(argv[++i]);
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return config.tracks > 0 && config.cols > 0 && config.rows > 0 && config.runs > 0;
+}
+
+//! Write a track file in the format of the editor.
+bool writeTrack(const QString & fileName, int index, const Config & config, std::mt19937 & engine)
+{
+    static const char * tileTypes[] = {"grass", "sand", "straight", "corner90", "straight45Male", "finish"};
+    static const char * objectRoles[] = {"tree", "plant", "rock", "tire", "crate"};
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        return false;
+    }
+
+    std::uniform_int_distribution<int> tileType(0, 5);
+    std::uniform_int_distribution<int> objectRole(0, 4);
+    std::uniform_int_distribution<int> orientation(0, 3);
+    std::uniform_int_distribution<int> x(0, config.cols * 256);
+    std::uniform_int_distribution<int> y(0, config.rows * 256);
+
+    QTextStream out(&file);
+    out << "<track version=\"1.6.3\" cols=\"" << config.cols << "\" rows=\"" << config.rows
+        << "\" index=\"" << index << "\" name=\"Track " << index << "\">\n";
+
+    for (int i = 0; i < config.cols; i++)
+    {
+        for (int j = 0; j < config.rows; j++)
+        {
+            out << " <t i=\"" << i << "\" j=\"" << j << "\" o=\"" << orientation(engine) * 90
+                << "\" t=\"" << tileTypes[tileType(engine)] << "\"/>\n";
+        }
+    }
+
+    for (int i = 0; i < config.objects; i++)
+    {
+        out << " <o c=\"" << objectRoles[objectRole(engine)] << "\" r=\"" << objectRoles[objectRole(engine)]
+            << "\" x=\"" << x(engine) << "\" y=\"" << y(engine) << "\" o=\"" << orientation(engine) * 90 << "\"/>\n";
+    }
+
+    // An elliptic route around the center of the track
+    const int nodes = 2 * (config.cols + config.rows);
+    for (int i = 0; i < nodes; i++)
+    {
+        const float angle = MCTrigonom::degToRad(360.0f * i / nodes);
+        const int nodeX = static_cast<int>(config.cols * 128 * (1 + 0.8 * std::cos(angle)));
+        const int nodeY = static_cast<int>(config.rows * 128 * (1 + 0.8 * std::sin(angle)));
+        out << " <n i=\"" << i << "\" x=\"" << nodeX << "\" y=\"" << nodeY << "\" w=\"256\" h=\"256\"/>\n";
+    }
+
+    out << "</track>\n";
+    return out.status() == QTextStream::Ok;
+}
+
+//! Parse all tracks like the eager loader did, except that no objects are built.
+int parseAllTracks(const QString & path)
+{
+    int count = 0;
+    const QFileInfoList trackFiles(QDir(path).entryInfoList(QStringList("*.trk")));
+    for (auto && trackFile : trackFiles)
+    {
+        QFile file(trackFile.absoluteFilePath());
+        QDomDocument doc;
+        if (!file.open(QIODevice::ReadOnly) || !doc.setContent(&file))
+        {
+            continue;
+        }
+
+        QDomNode node = doc.documentElement().firstChild();
+        while (!node.isNull())
+        {
+            QDomElement element = node.toElement();
+            if (!element.isNull())
+            {
+                element.attribute(TrackDataBase::DataKeywords::Tile::i, "0").toInt();
+                element.attribute(TrackDataBase::DataKeywords::Tile::j, "0").toInt();
+                element.attribute(TrackDataBase::DataKeywords::Tile::type, "clear").toStdString();
+            }
+
+            node = node.nextSibling();
+        }
+
+        count++;
+    }
+
+    return count;
+}
+
+//! Get the metadata of all tracks from the index like TrackLoader::loadTracks().
+int indexAllTracks(const QString & path, const QString & indexFileName)
+{
+    TrackIndex index(indexFileName);
+    index.load();
+
+    int count = 0;
+    const QFileInfoList trackFiles(QDir(path).entryInfoList(QStringList("*.trk")));
+    for (auto && trackFile : trackFiles)
+    {
+        count += index.entry(trackFile) != nullptr;
+    }
+
+    index.save();
+    return count;
+}
+
+//! \return a checksum of the values read from a tile.
+long long tileChecksum(unsigned int i, unsigned int j, const QString & type, int orientation)
+{
+    return i + j * 3 + type.size() * 5 + orientation * 7;
+}
+
+//! \return a checksum of the values read from an object or a node.
+long long objectChecksum(const QString & role, int x, int y, int orientation)
+{
+    return role.size() + x * 3 + y * 5 + orientation * 7;
+}
+
+/*! Read the contents of a track file like CompiledTrackWriter::fromXml() does on the
+ *  first run, except that nothing is stored. \return a checksum of the contents. */
+long long readTrackXml(const QString & fileName)
+{
+    typedef TrackDataBase::DataKeywords Keywords;
+
+    QFile file(fileName);
+    QDomDocument doc;
+    if (!file.open(QIODevice::ReadOnly) || !doc.setContent(&file))
+    {
+        return -1;
+    }
+
+    const QDomElement root = doc.documentElement();
+
+    long long checksum = 0;
+    for (QDomElement element = root.firstChildElement(); !element.isNull(); element = element.nextSiblingElement())
+    {
+        if (element.nodeName() == Keywords::Track::tile)
+        {
+            checksum += tileChecksum(
+                element.attribute(Keywords::Tile::i, "0").toUInt(),
+                element.attribute(Keywords::Tile::j, "0").toUInt(),
+                element.attribute(Keywords::Tile::type, "clear"),
+                element.attribute(Keywords::Tile::orientation, "0").toInt());
+        }
+        else if (element.nodeName() == Keywords::Track::object)
+        {
+            checksum += objectChecksum(
+                element.attribute(Keywords::Object::role, ""),
+                element.attribute(Keywords::Object::x, "0").toInt(),
+                element.attribute(Keywords::Object::y, "0").toInt(),
+                element.attribute(Keywords::Object::orientation, "0").toInt());
+        }
+        else if (element.nodeName() == Keywords::Track::node)
+        {
+            checksum += objectChecksum(QString(),
+                element.attribute(Keywords::Node::x, "0").toInt(),
+                element.attribute(Keywords::Node::y, "0").toInt(),
+                element.attribute(Keywords::Node::index, "0").toInt());
+        }
+    }
+
+    return checksum;
+}
+
+//! Read the contents of a compiled track like TrackLoader::loadCompiledTrack(). \return a checksum of the contents.
+long long readCompiledTrack(const QString & fileName)
+{
+    CompiledTrack track;
+    if (!track.open(fileName))
+    {
+        return -1;
+    }
+
+    std::vector<QString> strings;
+    strings.reserve(track.stringCount());
+    for (unsigned int index = 0; index < track.stringCount(); index++)
+    {
+        strings.push_back(QString::fromUtf8(track.string(index)));
+    }
+
+    long long checksum = 0;
+    for (unsigned int index = 0; index < track.tileCount(); index++)
+    {
+        const CompiledTrack::Tile & tile = track.tiles()[index];
+        checksum += tileChecksum(tile.i, tile.j, strings[tile.type], tile.orientation);
+    }
+
+    for (unsigned int index = 0; index < track.objectCount(); index++)
+    {
+        const CompiledTrack::Object & object = track.objects()[index];
+        checksum += objectChecksum(strings[object.role], object.x, object.y, object.orientation);
+    }
+
+    for (unsigned int index = 0; index < track.nodeCount(); index++)
+    {
+        const CompiledTrack::Node & node = track.nodes()[index];
+        checksum += objectChecksum(QString(), node.x, node.y, node.index);
+    }
+
+    return checksum;
+}
+
+//! \return the best time of the given number of runs in msecs.
+double measure(int runs, const std::function<int ()> & function, int expectedCount, bool & ok)
+{
+    double best = 0;
+    for (int run = 0; run < runs; run++)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        const int count = function();
+        const auto end = std::chrono::steady_clock::now();
+
+        ok = ok && count == expectedCount;
+
+        const double ms = std::chrono::duration<double, std::milli>(end - start).count();
+        best = run ? std::min(best, ms) : ms;
+    }
+
+    return best;
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+    Config config;
+    if (!parseArgs(argc, argv, config))
+    {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    QTemporaryDir tempDir;
+    if (!tempDir.isValid())
+    {
+        std::printf("Couldn't create a temporary directory\n");
+        return EXIT_FAILURE;
+    }
+
+    const QString trackPath = tempDir.path() + QDir::separator() + "tracks";
+    const QString indexFileName = tempDir.path() + QDir::separator() + "tracks.idx";
+    QDir().mkpath(trackPath);
+
+    std::printf("tracks=%d cols=%d rows=%d objects=%d runs=%d\n",
+        config.tracks, config.cols, config.rows, config.objects, config.runs);
+    std::printf("%8s %12s %12s %12s %14s\n", "tracks", "eager ms", "cold ms", "warm ms", "warm us/track");
+
+    // Measure with a growing number of tracks to show how the start-up scales
+    std::mt19937 engine(1234);
+    std::vector<int> trackCounts;
+    for (int count = std::max(config.tracks / 8, 1); count < config.tracks; count *= 2)
+    {
+        trackCounts.push_back(count);
+    }
+
+    trackCounts.push_back(config.tracks);
+
+    bool ok = true;
+    int written = 0;
+    for (int trackCount : trackCounts)
+    {
+        for (; written < trackCount; written++)
+        {
+            const QString fileName = trackPath + QDir::separator() + QString("track%1.trk").arg(written, 4, 10, QChar('0'));
+            if (!writeTrack(fileName, written, config, engine))
+            {
+                std::printf("Couldn't write '%s'\n", fileName.toStdString().c_str());
+                return EXIT_FAILURE;
+            }
+        }
+
+        const double eager = measure(config.runs, [&] () {
+            return parseAllTracks(trackPath);
+        }, trackCount, ok);
+
+        // The index is removed before each run so that every track is scanned
+        const double cold = measure(config.runs, [&] () {
+            QFile::remove(indexFileName);
+            return indexAllTracks(trackPath, indexFileName);
+        }, trackCount, ok);
+
+        const double warm = measure(config.runs, [&] () {
+            return indexAllTracks(trackPath, indexFileName);
+        }, trackCount, ok);
+
+        std::printf("%8d %12.2f %12.2f %12.2f %14.2f\n", trackCount, eager, cold, warm, warm * 1000 / trackCount);
+    }
+
+    if (!ok)
+    {
+        std::printf("Some tracks couldn't be loaded\n");
+        return EXIT_FAILURE;
+    }
+
+    std::printf("\n%8s %8s %10s %12s %12s %10s\n", "cols", "rows", "objects", "xml ms", "compiled ms", "speed-up");
+
+    // The contents of the selected track are loaded when the race starts
+    for (int scale = 1; scale <= 4; scale *= 2)
+    {
+        Config large = config;
+        large.cols *= scale;
+        large.rows *= scale;
+        large.objects *= scale * scale;
+
+        const QString fileName = tempDir.path() + QDir::separator() + QString("large%1.trk").arg(scale);
+        const QString compiledFileName = CompiledTrack::compiledFileName(fileName);
+
+        if (!writeTrack(fileName, 0, large, engine))
+        {
+            std::printf("Couldn't write '%s'\n", fileName.toStdString().c_str());
+            return EXIT_FAILURE;
+        }
+
+        // Like the game does on the first run
+        const auto writer = CompiledTrackWriter::fromXml(fileName);
+        if (!writer || !writer->save(compiledFileName))
+        {
+            std::printf("Couldn't write '%s'\n", fileName.toStdString().c_str());
+            return EXIT_FAILURE;
+        }
+
+        // Both must read the same contents
+        const long long checksum = readTrackXml(fileName);
+        const double xml = measure(config.runs, [&] () {
+            return readTrackXml(fileName) == checksum;
+        }, 1, ok);
+
+        const double compiled = measure(config.runs, [&] () {
+            return readCompiledTrack(compiledFileName) == checksum;
+        }, 1, ok);
+
+        std::printf("%8d %8d %10d %12.3f %12.3f %9.1fx\n",
+            large.cols, large.rows, large.objects, xml, compiled, xml / std::max(compiled, 0.001));
+    }
+
+    if (!ok)
+    {
+        std::printf("The compiled tracks don't match the track files\n");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
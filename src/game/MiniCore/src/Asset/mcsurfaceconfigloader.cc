@@ -67,6 +67,7 @@ void MCSurfaceConfigLoader::parseAttributes(const QDomElement & element, Surface
     newData->handle3 = element.attribute("handle3", "").toStdString();
     newData->xAxisMirror = element.attribute("xAxisMirror", "0").toInt();
     newData->yAxisMirror = element.attribute("yAxisMirror", "0").toInt();
+    newData->atlas = element.attribute("atlas", "0").toInt();
 
     if (element.hasAttribute("z")) // Shorthand z
     {
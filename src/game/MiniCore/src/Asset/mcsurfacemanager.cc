@@ -18,9 +18,12 @@
 //
 
 #include "mcsurfacemanager.hh"
+#include "mcglstate.hh"
 #include "mclogger.hh"
 #include "mcsurface.hh"
 #include "mcsurfaceconfigloader.hh"
+#include "mctextureatlas.hh"
+#include "mcworkerpool.hh"
 
 #include <QByteArray>
 #include <QDir>
@@ -29,9 +32,27 @@
 #include <QSysInfo>
 #include <MCGLEW>
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <exception>
+#include <map>
+#include <thread>
+
+namespace {
+const int ATLAS_PAGE_SIZE = 1024;
+
+// Enough for linear filtering without mipmaps
+const int ATLAS_PADDING = 2;
+}
+
+struct MCSurfaceManager::AtlasSurface
+{
+    MCSurfaceMetaData data;
+
+    //! Image already converted into GL format.
+    MCTextureCache::Entry texture;
+};
 
 inline bool colorMatch(int val1, int val2, int threshold)
 {
@@ -163,6 +184,32 @@ MCSurfaceManager::MCSurfaceManager()
 {
 }
 
+void MCSurfaceManager::setTextureCachePath(const std::string & path)
+{
+    m_textureCachePath = path;
+}
+
+static QImage applySizeDivider(const MCSurfaceMetaData & data, const QImage & image)
+{
+    return image.scaled(image.width() / data.sizeDivider, image.height() / data.sizeDivider);
+}
+
+// Copy the image on the page and fill the padding with the edge pixels of the image,
+// so that filtering near the edges doesn't pick pixels from the neighboring images.
+static void copyToAtlasPage(QImage & page, const QImage & image, int x, int y, int padding)
+{
+    for (int j = -padding; j < image.height() + padding; j++)
+    {
+        const int srcY = std::min(std::max(j, 0), image.height() - 1);
+        const uint * src = reinterpret_cast<const uint *>(image.constScanLine(srcY));
+        uint * dst = reinterpret_cast<uint *>(page.scanLine(y + j));
+        for (int i = -padding; i < image.width() + padding; i++)
+        {
+            dst[x + i] = src[std::min(std::max(i, 0), image.width() - 1)];
+        }
+    }
+}
+
 MCSurface & MCSurfaceManager::createSurfaceFromImage(const MCSurfaceMetaData & data, QImage image)
 {
     if (data.handle.size() == 0)
@@ -170,16 +217,21 @@ MCSurface & MCSurfaceManager::createSurfaceFromImage(const MCSurfaceMetaData & d
         throw std::runtime_error("Cannot create surface with an empty handle!");
     }
 
-    image = image.scaled(image.width() / data.sizeDivider, image.height() / data.sizeDivider);
+    image = applySizeDivider(data, image);
 
+    return createSurface(data, image.width(), image.height(), create2DTextureFromImage(data, image));
+}
+
+MCSurface & MCSurfaceManager::createSurface(const MCSurfaceMetaData & data, int imageWidth, int imageHeight, GLuint texture)
+{
     // Store original width of the image
-    int origH = data.height.second ? data.height.first : image.height();
-    int origW = data.width.second  ? data.width.first  : image.width();
+    int origH = data.height.second ? data.height.first : imageHeight;
+    int origW = data.width.second  ? data.width.first  : imageWidth;
 
     // Create material. Possible secondary textures are taken from surfaces
     // that are initialized before this surface.
     MCGLMaterialPtr material(new MCGLMaterial);
-    material->setTexture(create2DTextureFromImage(data, image), 0);
+    material->setTexture(texture, 0);
     material->setTexture(data.handle2.length() ? surface(data.handle2).material()->texture(0) : 0, 1);
     material->setTexture(data.handle3.length() ? surface(data.handle3).material()->texture(0) : 0, 2);
 
@@ -257,15 +309,21 @@ static QImage forceToNearestPowerOfTwoImage(const MCSurfaceMetaData & data, cons
 GLuint MCSurfaceManager::create2DTextureFromImage(
     const MCSurfaceMetaData & data, const QImage & image)
 {
+    GLint maxTextureSize;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+
 #ifdef __MC_GLES__
-    QImage textureImage = forceToNearestPowerOfTwoImage(data, image);
+    return createTexture(data, createGLFormattedImage(data, forceToNearestPowerOfTwoImage(data, image), maxTextureSize));
 #else
-    QImage textureImage = image;
+    return createTexture(data, createGLFormattedImage(data, image, maxTextureSize));
 #endif
+}
+
+QImage MCSurfaceManager::createGLFormattedImage(const MCSurfaceMetaData & data, const QImage & image, int maxTextureSize) const
+{
+    QImage textureImage = image;
 
     // Take the maximum supported texture size into account
-    GLint maxTextureSize;
-    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
     if (textureImage.width() > maxTextureSize && textureImage.height() > maxTextureSize)
     {
         textureImage = textureImage.scaled(maxTextureSize, maxTextureSize);
@@ -303,12 +361,18 @@ GLuint MCSurfaceManager::create2DTextureFromImage(
     QImage glFormattedImage(textureImage.width(), textureImage.height(), textureImage.format());
     convertToGLFormatHelper(glFormattedImage, textureImage, GL_RGBA);
 
+    return glFormattedImage;
+}
+
+GLuint MCSurfaceManager::createTexture(const MCSurfaceMetaData & data, const QImage & glFormattedImage) const
+{
     // Let OpenGL generate a texture handle
     GLuint textureHandle;
     glGenTextures(1, &textureHandle);
 
-    // Bind the texture object
+    // Bind the texture object. The texture unit isn't known here, so the cached state is reset.
     glBindTexture(GL_TEXTURE_2D, textureHandle);
+    MCGLState::invalidate();
 
     // Set min filter.
     if (data.minFilter.second)
@@ -390,6 +454,104 @@ void MCSurfaceManager::applyAlphaClamp(QImage & textureImage, unsigned int a) co
     }
 }
 
+bool MCSurfaceManager::canUseAtlas(const MCSurfaceMetaData & data, const std::set<std::string> & secondaryHandles) const
+{
+    std::string reason;
+    if (data.handle2.length() || data.handle3.length())
+    {
+        reason = "multitexturing is used";
+    }
+    else if (secondaryHandles.count(data.handle))
+    {
+        reason = "it's used as a secondary texture";
+    }
+    else if ((data.wrapS.second && data.wrapS.first == GL_REPEAT) || (data.wrapT.second && data.wrapT.first == GL_REPEAT))
+    {
+        reason = "repeat wrap is used";
+    }
+    else
+    {
+        return true;
+    }
+
+    MCLogger().warning() << "Surface '" << data.handle << "' can't be on an atlas: " << reason;
+    return false;
+}
+
+void MCSurfaceManager::createAtlasSurfaces(std::vector<AtlasSurface> & surfaces)
+{
+    GLint maxTextureSize;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+    MCTextureAtlas atlas(std::min(ATLAS_PAGE_SIZE, static_cast<int>(maxTextureSize)), ATLAS_PADDING);
+
+    // The filters are texture parameters, so surfaces with different filters can't share a page.
+    // Wrap is always clamp for atlas surfaces.
+    std::map<std::pair<GLint, GLint>, std::vector<AtlasSurface *>> groups;
+    for (auto && surface : surfaces)
+    {
+        const GLint minFilter = surface.data.minFilter.second ? surface.data.minFilter.first : GL_NEAREST;
+        const GLint magFilter = surface.data.magFilter.second ? surface.data.magFilter.first : GL_NEAREST;
+        groups[{minFilter, magFilter}].push_back(&surface);
+    }
+
+    for (auto && group : groups)
+    {
+        std::vector<MCTextureAtlas::Item> items;
+        for (auto && surface : group.second)
+        {
+            MCTextureAtlas::Item item;
+            item.handle = surface->data.handle;
+            item.width = surface->texture.texture.width();
+            item.height = surface->texture.texture.height();
+            items.push_back(item);
+        }
+
+        // Compose the pages. The images are already flipped, so the rows of a page
+        // are uploaded as such and the texture coordinates grow with the pixel coordinates.
+        const int pageCount = atlas.pack(items);
+        std::vector<GLuint> pageTextures;
+        for (int pageIndex = 0; pageIndex < pageCount; pageIndex++)
+        {
+            const MCTextureAtlas::Page & page = atlas.pages().at(pageIndex);
+            QImage pageImage(page.width, page.height, QImage::Format_ARGB32);
+            pageImage.fill(0);
+
+            for (size_t i = 0; i < items.size(); i++)
+            {
+                if (items[i].page == pageIndex)
+                {
+                    copyToAtlasPage(pageImage, group.second[i]->texture.texture, items[i].x, items[i].y, atlas.padding());
+                }
+            }
+
+            pageTextures.push_back(createTexture(group.second.front()->data, pageImage));
+        }
+
+        for (size_t i = 0; i < items.size(); i++)
+        {
+            const MCTextureAtlas::Item & item = items[i];
+            const AtlasSurface & atlasSurface = *group.second[i];
+            const int width = atlasSurface.texture.imageWidth;
+            const int height = atlasSurface.texture.imageHeight;
+
+            if (item.page < 0)
+            {
+                MCLogger().warning() << "Surface '" << item.handle << "' doesn't fit on an atlas page";
+                createSurface(atlasSurface.data, width, height, createTexture(atlasSurface.data, atlasSurface.texture.texture));
+                continue;
+            }
+
+            const MCTextureAtlas::Page & page = atlas.pages().at(item.page);
+            const GLuint texture = pageTextures.at(item.page);
+            MCSurface & surface = createSurface(atlasSurface.data, width, height, texture);
+            surface.setAtlas(
+                texture,
+                {static_cast<GLfloat>(item.x) / page.width, static_cast<GLfloat>(item.y) / page.height},
+                {static_cast<GLfloat>(item.x + item.width) / page.width, static_cast<GLfloat>(item.y + item.height) / page.height});
+        }
+    }
+}
+
 MCSurfaceManager::~MCSurfaceManager()
 {
     // Delete OpenGL textures and Textures
@@ -402,6 +564,7 @@ MCSurfaceManager::~MCSurfaceManager()
             for (unsigned int i = 0; i < MCGLMaterial::MAX_TEXTURES; i++)
             {
                 GLuint dummyHandle1 = p->material()->texture(i);
+                MCGLState::textureDeleted(dummyHandle1);
                 glDeleteTextures(1, &dummyHandle1);
             }
             delete p;
@@ -410,6 +573,70 @@ MCSurfaceManager::~MCSurfaceManager()
     }
 }
 
+MCTextureCache::Entry MCSurfaceManager::loadTexture(
+    const MCSurfaceMetaData & data, const std::string & baseDataPath, const MCTextureCache & cache,
+    int maxTextureSize, bool isAtlasSurface, bool & cacheHit) const
+{
+    // Load the image. Due to possible Android asset URLs, an explicit
+    // QFile-based loading is used instead of directly using QImage::loadFromFile().
+    QString path = QString(baseDataPath.c_str()) + QDir::separator() + data.imagePath.c_str();
+    path.replace("./", "");
+    path.replace("//", "/");
+
+    QFile imageFile(path);
+    if (!imageFile.open(QIODevice::ReadOnly))
+    {
+        throw std::runtime_error("Cannot read file '" + path.toStdString() + "'");
+    }
+    QByteArray blob = imageFile.readAll();
+
+#ifdef __MC_GLES__
+    // Atlas pages are always power of two, but the images on them don't have to be
+    const bool powerOfTwo = !isAtlasSurface;
+#else
+    const bool powerOfTwo = false;
+#endif
+
+    MCTextureCache::Entry entry;
+    std::string key;
+    if (cache.isEnabled())
+    {
+        key = MCTextureCache::key(data, blob.constData(), static_cast<size_t>(blob.size()), maxTextureSize, powerOfTwo);
+        if (cache.load(key, entry))
+        {
+            cacheHit = true;
+            return entry;
+        }
+    }
+
+    cacheHit = false;
+
+    QImage textureImage;
+    textureImage.loadFromData(blob);
+    textureImage = applySizeDivider(data, textureImage);
+
+    entry.imageWidth = textureImage.width();
+    entry.imageHeight = textureImage.height();
+
+#ifdef __MC_GLES__
+    if (powerOfTwo)
+    {
+        textureImage = forceToNearestPowerOfTwoImage(data, textureImage);
+    }
+#else
+    (void)isAtlasSurface;
+#endif
+
+    entry.texture = createGLFormattedImage(data, textureImage, maxTextureSize);
+
+    if (cache.isEnabled() && !cache.save(key, entry))
+    {
+        MCLogger().warning() << "Cannot write texture of '" << data.handle << "' to the cache";
+    }
+
+    return entry;
+}
+
 void MCSurfaceManager::load(
     const std::string & configFilePath, const std::string & baseDataPath)
 {
@@ -418,27 +645,85 @@ void MCSurfaceManager::load(
     // Parse the texture config file
     if (loader.load(configFilePath))
     {
+        // Secondary textures are taken from other surfaces as such, so these need textures of their own
+        std::set<std::string> secondaryHandles;
         for (unsigned int i = 0; i < loader.surfaceCount(); i++)
         {
-            const MCSurfaceMetaData & metaData = loader.surface(i);
+            secondaryHandles.insert(loader.surface(i).handle2);
+            secondaryHandles.insert(loader.surface(i).handle3);
+        }
 
-            // Load the image and create a 2D texture. Due to possible Android asset URLs,
-            // an explicit QFile-based loading is used instead of directly using QImage::loadFromFile().
-            QString path = QString(baseDataPath.c_str()) + QDir::separator() + metaData.imagePath.c_str();
-            path.replace("./", "");
-            path.replace("//", "/");
+        std::vector<char> isAtlasSurface(loader.surfaceCount());
+        for (unsigned int i = 0; i < loader.surfaceCount(); i++)
+        {
+            isAtlasSurface[i] = loader.surface(i).atlas && canUseAtlas(loader.surface(i), secondaryHandles);
+        }
 
-            QFile imageFile(path);
-            if (!imageFile.open(QIODevice::ReadOnly))
+        GLint maxTextureSize;
+        glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+
+        // Reading, decoding and pre-processing the images doesn't need OpenGL, so it's done
+        // in parallel. Only the uploads are left for this thread.
+        MCTextureCache cache(m_textureCachePath);
+        std::vector<MCTextureCache::Entry> textures(loader.surfaceCount());
+        std::vector<char> cacheHits(loader.surfaceCount());
+        std::vector<std::string> errors(loader.surfaceCount());
+        {
+            MCWorkerPool workerPool(std::max(std::thread::hardware_concurrency(), 1u));
+            workerPool.run(loader.surfaceCount(), [&] (unsigned int i) {
+                try
+                {
+                    bool cacheHit = false;
+                    textures[i] = loadTexture(loader.surface(i), baseDataPath, cache, maxTextureSize, isAtlasSurface[i], cacheHit);
+                    cacheHits[i] = cacheHit;
+                }
+                catch (std::exception & e)
+                {
+                    errors[i] = e.what();
+                }
+            });
+        }
+
+        for (auto && error : errors)
+        {
+            if (!error.empty())
             {
-                throw std::runtime_error("Cannot read file '" + path.toStdString() + "'");
+                throw std::runtime_error(error);
             }
-            QByteArray blob = imageFile.readAll();
+        }
 
-            QImage textureImage;
-            textureImage.loadFromData(blob);
-            createSurfaceFromImage(metaData, textureImage);
+        if (cache.isEnabled())
+        {
+            MCLogger().info() << "Texture cache hits: " << std::count(cacheHits.begin(), cacheHits.end(), 1)
+                              << "/" << loader.surfaceCount();
+        }
+
+        // Surfaces are created in the config order, because secondary textures are taken from previous surfaces
+        std::vector<AtlasSurface> atlasSurfaces;
+        for (unsigned int i = 0; i < loader.surfaceCount(); i++)
+        {
+            const MCSurfaceMetaData & metaData = loader.surface(i);
+
+            // Atlas surfaces are created once all images are known
+            if (isAtlasSurface[i])
+            {
+                atlasSurfaces.push_back({metaData, textures[i]});
+            }
+            else
+            {
+                if (metaData.handle.size() == 0)
+                {
+                    throw std::runtime_error("Cannot create surface with an empty handle!");
+                }
+
+                createSurface(metaData, textures[i].imageWidth, textures[i].imageHeight, createTexture(metaData, textures[i].texture));
+            }
+
+            // The pixels aren't needed anymore once uploaded
+            textures[i] = MCTextureCache::Entry();
         }
+
+        createAtlasSurfaces(atlasSurfaces);
     }
     else
     {
@@ -20,11 +20,14 @@
 #ifndef MCSURFACEMANAGER_HH
 #define MCSURFACEMANAGER_HH
 
+#include <set>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "mcmacros.hh"
 #include "mcsurfacemetadata.hh"
+#include "mctexturecache.hh"
 
 class QImage;
 
@@ -41,6 +44,17 @@ class MCSurface;
  *
  * Texture surfaces will also be flipped about X-axis if desired.
  *
+ * Surfaces marked with atlas="1" are packed on shared atlas pages instead of getting
+ * textures of their own. Surfaces on the same page can be drawn with one call by the
+ * batch renderers, see MCSurface::atlasId(). Surfaces using multitexturing, surfaces
+ * used as secondary textures (handle2, handle3) and surfaces with repeat wrap are always
+ * given textures of their own. Surfaces used as mesh textures must not be marked, because
+ * meshes use the texture as such.
+ *
+ * If a texture cache path is set, the pre-processed textures are stored on disk and
+ * re-used on subsequent loads, see MCTextureCache. Images not found in the cache are
+ * decoded and pre-processed in parallel.
+ *
  * MCSurface objects can be accessed via handles specified in the XML-based mapping file
  * and are loaded with MCSurfaceManager::load().
  *
@@ -55,7 +69,7 @@ class MCSurface;
  *     <alphaTest function="greater" threshold="0.5"/>
  *     <alphaBlend src="srcAlpha" dest="oneMinusSrcAlpha"/>
  *   </surface>
- *   <surface handle="wall" image="wall.png"/>
+ *   <surface handle="wall" image="wall.png" atlas="1"/>
  *   <surface handle="wallMultiTexture" image="wall.bmp" handle2="wall"/>
  *   <surface handle="Track" image="track.bmp"/>
  *   <surface handle="Bazooka" image="bazooka.jpg">
@@ -86,6 +100,10 @@ public:
     virtual void load(
         const std::string & configFilePath, const std::string & baseDataPath);
 
+    /*! Sets the directory used to cache the pre-processed textures of load().
+     *  The cache is disabled by default or if the path is empty. */
+    void setTextureCachePath(const std::string & path);
+
     /*! Returns a surface object associated with given strId.
      *  Corresponding OpenGL texture handle can be obtained
      *  by calling handle() of the resulting MCSurface.
@@ -108,16 +126,43 @@ private:
     //! Apply given color key (set alpha values on / off based on the given color).
     void applyColorKey(QImage & textureImage, unsigned int r, unsigned int g, unsigned int b) const;
 
+    /*! Apply mirroring, alpha clamp and colorkey and convert into the format used by OpenGL.
+     *  Doesn't call OpenGL, so this can be run on any thread. */
+    QImage createGLFormattedImage(const MCSurfaceMetaData & data, const QImage & image, int maxTextureSize) const;
+
+    /*! Read the image of the given surface and return the pre-processed texture either from
+     *  the cache or by decoding the image. Can be run on any thread.
+     *  \throws std::runtime_error if the image can't be read. */
+    MCTextureCache::Entry loadTexture(
+        const MCSurfaceMetaData & data, const std::string & baseDataPath, const MCTextureCache & cache,
+        int maxTextureSize, bool isAtlasSurface, bool & cacheHit) const;
+
     //! Helper to create the actual OpenGL texture.
     GLuint create2DTextureFromImage(const MCSurfaceMetaData & data, const QImage & image);
 
+    //! Helper to create an OpenGL texture from an image returned by createGLFormattedImage().
+    GLuint createTexture(const MCSurfaceMetaData & data, const QImage & glFormattedImage) const;
+
+    //! Helper to create the surface object for the given texture.
+    MCSurface & createSurface(const MCSurfaceMetaData & data, int imageWidth, int imageHeight, GLuint texture);
+
     //! Helper to set surface meta data.
     void createSurfaceCommon(MCSurface & surface, const MCSurfaceMetaData & data);
 
+    //! \return true if the surface can be placed on an atlas page.
+    bool canUseAtlas(const MCSurfaceMetaData & data, const std::set<std::string> & secondaryHandles) const;
+
+    struct AtlasSurface;
+
+    //! Pack the given surfaces on atlas pages and create the surfaces.
+    void createAtlasSurfaces(std::vector<AtlasSurface> & surfaces);
+
     //! Map for resulting surface objects
     typedef std::unordered_map<std::string, MCSurface *> SurfaceHash;
     SurfaceHash m_surfaceMap;
 
+    std::string m_textureCachePath;
+
     DISABLE_COPY(MCSurfaceManager);
     DISABLE_ASSI(MCSurfaceManager);
 };
@@ -89,6 +89,10 @@ struct MCSurfaceMetaData
     //! True if Y-Axis mirroring is wanted
     bool yAxisMirror = false;
 
+    /*! True if the surface may be placed on a shared texture atlas page.
+     *  \see MCSurfaceManager. */
+    bool atlas = false;
+
     //! Min filter value
     std::pair<GLint, bool> minFilter;
 
@@ -0,0 +1,122 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#include "mctextureatlas.hh"
+
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+
+namespace {
+int nearestPowerOfTwo(int value)
+{
+    int power = 1;
+    while (power < value)
+    {
+        power *= 2;
+    }
+
+    return power;
+}
+}
+
+MCTextureAtlas::MCTextureAtlas(int maxPageSize, int padding)
+: m_maxPageSize(maxPageSize)
+, m_padding(padding)
+{
+    assert(maxPageSize > 0);
+    assert(padding >= 0);
+}
+
+int MCTextureAtlas::pack(std::vector<Item> & items)
+{
+    m_pages.clear();
+
+    // Place the tallest items first so that the shelves don't waste much space
+    std::vector<size_t> order(items.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&items] (size_t l, size_t r) {
+        return items[l].height > items[r].height;
+    });
+
+    int shelfX = 0;
+    int shelfY = 0;
+    int shelfHeight = 0;
+    int usedWidth = 0;
+
+    for (size_t index : order)
+    {
+        Item & item = items[index];
+        item.page = -1;
+
+        const int paddedWidth = item.width + 2 * m_padding;
+        const int paddedHeight = item.height + 2 * m_padding;
+        if (item.width <= 0 || item.height <= 0 || paddedWidth > m_maxPageSize || paddedHeight > m_maxPageSize)
+        {
+            continue;
+        }
+
+        if (m_pages.empty())
+        {
+            m_pages.push_back({0, 0});
+        }
+
+        // Start a new shelf if the item doesn't fit on the current one
+        if (shelfX + paddedWidth > m_maxPageSize)
+        {
+            shelfX = 0;
+            shelfY += shelfHeight;
+            shelfHeight = 0;
+        }
+
+        // Start a new page if the shelf doesn't fit on the current page
+        if (shelfY + paddedHeight > m_maxPageSize)
+        {
+            m_pages.push_back({0, 0});
+            shelfX = 0;
+            shelfY = 0;
+            shelfHeight = 0;
+            usedWidth = 0;
+        }
+
+        item.page = static_cast<int>(m_pages.size()) - 1;
+        item.x = shelfX + m_padding;
+        item.y = shelfY + m_padding;
+
+        shelfX += paddedWidth;
+        shelfHeight = std::max(shelfHeight, paddedHeight);
+        usedWidth = std::max(usedWidth, shelfX);
+
+        Page & page = m_pages.back();
+        page.width = std::min(nearestPowerOfTwo(usedWidth), m_maxPageSize);
+        page.height = std::min(nearestPowerOfTwo(shelfY + shelfHeight), m_maxPageSize);
+    }
+
+    return static_cast<int>(m_pages.size());
+}
+
+const std::vector<MCTextureAtlas::Page> & MCTextureAtlas::pages() const
+{
+    return m_pages;
+}
+
+int MCTextureAtlas::padding() const
+{
+    return m_padding;
+}
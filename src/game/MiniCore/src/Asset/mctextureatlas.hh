@@ -0,0 +1,101 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#ifndef MCTEXTUREATLAS_HH
+#define MCTEXTUREATLAS_HH
+
+#include "mcmacros.hh"
+
+#include <string>
+#include <vector>
+
+/*! \class MCTextureAtlas
+ *  \brief Packs rectangular images onto a small number of atlas pages.
+ *
+ *  The packer only computes the layout, so it has no dependencies to Qt or OpenGL.
+ *  Items are placed on shelves, tallest first. Every item is surrounded by a padding
+ *  that the user is expected to fill with the edge pixels of the image, so that
+ *  texture filtering doesn't bleed pixels from the neighboring images.
+ *
+ *  The width and the height of a page are the used area rounded up to the nearest
+ *  power of two (but at most the maximum page size), so pages are valid textures
+ *  also on GLES 2. */
+class MCTextureAtlas
+{
+public:
+
+    //! An image to be placed on the atlas.
+    struct Item
+    {
+        //! Identifies the image, not used by the packer.
+        std::string handle;
+
+        //! Width of the image in pixels.
+        int width = 0;
+
+        //! Height of the image in pixels.
+        int height = 0;
+
+        //! Index of the page the image was placed on or -1 if it didn't fit on a page.
+        int page = -1;
+
+        //! X-coordinate of the image on the page (padding excluded).
+        int x = 0;
+
+        //! Y-coordinate of the image on the page (padding excluded).
+        int y = 0;
+    };
+
+    //! Dimensions of a page.
+    struct Page
+    {
+        int width;
+
+        int height;
+    };
+
+    /*! Constructor.
+     *  \param maxPageSize Maximum width and height of a page.
+     *  \param padding Number of pixels reserved around each image. */
+    explicit MCTextureAtlas(int maxPageSize = 1024, int padding = 2);
+
+    /*! Place the given items and set their page and position. Replaces the previous layout.
+     *  Items that are larger than a page (padding included) are left with page == -1.
+     *  \return Number of pages needed. */
+    int pack(std::vector<Item> & items);
+
+    //! \return The pages of the latest layout.
+    const std::vector<Page> & pages() const;
+
+    //! \return Padding around the images.
+    int padding() const;
+
+private:
+
+    DISABLE_COPY(MCTextureAtlas);
+    DISABLE_ASSI(MCTextureAtlas);
+
+    int m_maxPageSize;
+
+    int m_padding;
+
+    std::vector<Page> m_pages;
+};
+
+#endif // MCTEXTUREATLAS_HH
@@ -0,0 +1,209 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#include "mctexturecache.hh"
+#include "mcsurfacemetadata.hh"
+
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+
+// Bump this whenever the pre-processing in MCSurfaceManager changes
+const uint32_t FORMAT_VERSION = 1;
+
+const char MAGIC[4] = {'M', 'C', 'T', 'X'};
+
+// Sanity limit for the dimensions read from a file
+const uint32_t MAX_DIMENSION = 16384;
+
+// Entries are meant to be read back on the same machine, so the header is stored in native byte order
+struct FileHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t imageWidth;
+    uint32_t imageHeight;
+    uint32_t textureWidth;
+    uint32_t textureHeight;
+};
+
+// 64-bit FNV-1a
+class Hash
+{
+public:
+
+    void add(const void * data, size_t size)
+    {
+        const unsigned char * bytes = static_cast<const unsigned char *>(data);
+        for (size_t i = 0; i < size; i++)
+        {
+            m_value = (m_value ^ bytes[i]) * 0x100000001b3ull;
+        }
+    }
+
+    template<typename T>
+    void add(T value)
+    {
+        add(&value, sizeof(T));
+    }
+
+    uint64_t value() const
+    {
+        return m_value;
+    }
+
+private:
+
+    uint64_t m_value = 0xcbf29ce484222325ull;
+};
+
+}
+
+MCTextureCache::MCTextureCache(const std::string & path)
+: m_path(path)
+{
+}
+
+bool MCTextureCache::isEnabled() const
+{
+    return !m_path.empty();
+}
+
+std::string MCTextureCache::key(
+    const MCSurfaceMetaData & data, const char * sourceData, size_t sourceSize, int maxTextureSize, bool powerOfTwo)
+{
+    Hash hash;
+    hash.add(sourceData, sourceSize);
+
+    // Everything that affects MCSurfaceManager::createGLFormattedImage() and the size divider
+    hash.add(FORMAT_VERSION);
+    hash.add(maxTextureSize);
+    hash.add(powerOfTwo);
+    hash.add(data.sizeDivider);
+    hash.add(data.xAxisMirror);
+    hash.add(data.yAxisMirror);
+    hash.add(data.alphaClamp.second);
+    if (data.alphaClamp.second)
+    {
+        hash.add(data.alphaClamp.first);
+    }
+    hash.add(data.colorKeySet);
+    if (data.colorKeySet)
+    {
+        hash.add(data.colorKey.m_r);
+        hash.add(data.colorKey.m_g);
+        hash.add(data.colorKey.m_b);
+    }
+
+    std::ostringstream ss;
+    ss << std::hex << std::setw(16) << std::setfill('0') << hash.value();
+    return ss.str();
+}
+
+std::string MCTextureCache::fileName(const std::string & key) const
+{
+    return m_path + QDir::separator().toLatin1() + key + ".mctex";
+}
+
+bool MCTextureCache::load(const std::string & key, Entry & entry) const
+{
+    if (!isEnabled())
+    {
+        return false;
+    }
+
+    QFile file(fileName(key).c_str());
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    FileHeader header;
+    if (file.read(reinterpret_cast<char *>(&header), sizeof(header)) != sizeof(header) ||
+        std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) || header.version != FORMAT_VERSION ||
+        !header.textureWidth || header.textureWidth > MAX_DIMENSION ||
+        !header.textureHeight || header.textureHeight > MAX_DIMENSION)
+    {
+        return false;
+    }
+
+    const qint64 pixelDataSize = static_cast<qint64>(header.textureWidth) * header.textureHeight * 4;
+    if (file.size() != static_cast<qint64>(sizeof(header)) + pixelDataSize)
+    {
+        return false;
+    }
+
+    // Rows of a 32-bit image are never padded, so the pixels can be read directly into the image
+    QImage texture(header.textureWidth, header.textureHeight, QImage::Format_ARGB32);
+    if (texture.isNull() || file.read(reinterpret_cast<char *>(texture.bits()), pixelDataSize) != pixelDataSize)
+    {
+        return false;
+    }
+
+    entry.imageWidth = header.imageWidth;
+    entry.imageHeight = header.imageHeight;
+    entry.texture = texture;
+
+    return true;
+}
+
+bool MCTextureCache::save(const std::string & key, const Entry & entry) const
+{
+    if (!isEnabled() || entry.texture.format() != QImage::Format_ARGB32)
+    {
+        return false;
+    }
+
+    if (!QDir().mkpath(m_path.c_str()))
+    {
+        return false;
+    }
+
+    FileHeader header;
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = FORMAT_VERSION;
+    header.imageWidth = entry.imageWidth;
+    header.imageHeight = entry.imageHeight;
+    header.textureWidth = entry.texture.width();
+    header.textureHeight = entry.texture.height();
+
+    const qint64 pixelDataSize = static_cast<qint64>(entry.texture.bytesPerLine()) * entry.texture.height();
+
+    QSaveFile file(fileName(key).c_str());
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        return false;
+    }
+
+    if (file.write(reinterpret_cast<const char *>(&header), sizeof(header)) != sizeof(header) ||
+        file.write(reinterpret_cast<const char *>(entry.texture.constBits()), pixelDataSize) != pixelDataSize)
+    {
+        file.cancelWriting();
+        return false;
+    }
+
+    return file.commit();
+}
@@ -0,0 +1,92 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#ifndef MCTEXTURECACHE_HH
+#define MCTEXTURECACHE_HH
+
+#include "mcmacros.hh"
+
+#include <QImage>
+
+#include <string>
+
+struct MCSurfaceMetaData;
+
+/*! \class MCTextureCache
+ *  \brief Stores textures on disk in the format they are uploaded to OpenGL.
+ *
+ *  Decoding the source images, applying the color keys and converting the pixels
+ *  into GL order is the slow part of loading the surfaces. The cache stores the
+ *  result as raw RGBA8 so that it can be read back with a single read and uploaded
+ *  as such.
+ *
+ *  Entries are keyed by the contents of the source image and the settings that
+ *  affect the pre-processing, so editing an image or its settings in the surface
+ *  config simply results in a new entry. Stale entries are not removed. */
+class MCTextureCache
+{
+public:
+
+    //! A pre-processed texture.
+    struct Entry
+    {
+        //! Width of the surface image, i.e. the source image scaled by the size divider.
+        int imageWidth = 0;
+
+        //! Height of the surface image, i.e. the source image scaled by the size divider.
+        int imageHeight = 0;
+
+        //! Texture data in GL order. May differ in size from the surface image.
+        QImage texture;
+    };
+
+    /*! Constructor.
+     *  \param path Directory of the cache files. Created when the first entry is saved.
+     *  The cache is disabled if the path is empty. */
+    explicit MCTextureCache(const std::string & path);
+
+    //! \return true if the cache is enabled.
+    bool isEnabled() const;
+
+    /*! \return Key of the entry for the given source image data and settings.
+     *  \param maxTextureSize Maximum texture size given by OpenGL.
+     *  \param powerOfTwo True if the texture is scaled to power of two dimensions. */
+    static std::string key(
+        const MCSurfaceMetaData & data, const char * sourceData, size_t sourceSize, int maxTextureSize, bool powerOfTwo);
+
+    /*! Load the entry of the given key.
+     *  \return false if the entry doesn't exist or is not valid. */
+    bool load(const std::string & key, Entry & entry) const;
+
+    /*! Save the entry with the given key. The file is replaced atomically, so
+     *  a crash while saving doesn't leave a broken entry behind.
+     *  \return false if the entry couldn't be written. */
+    bool save(const std::string & key, const Entry & entry) const;
+
+private:
+
+    DISABLE_COPY(MCTextureCache);
+    DISABLE_ASSI(MCTextureCache);
+
+    std::string fileName(const std::string & key) const;
+
+    std::string m_path;
+};
+
+#endif // MCTEXTURECACHE_HH
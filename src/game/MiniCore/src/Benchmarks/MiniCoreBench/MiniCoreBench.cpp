@@ -0,0 +1,375 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+// Headless physics benchmark: builds a synthetic world, steps it with a fixed
+// time step and reports per-phase timings, steps/sec and heap allocations.
+// No GL context or window is needed.
+
+#include "../../Core/mcobject.hh"
+#include "../../Core/mcprofiler.hh"
+#include "../../Core/mctrigonom.hh"
+#include "../../Core/mcworld.hh"
+#include "../../Graphics/mcparticle.hh"
+#include "../../Graphics/mcparticlesystem.hh"
+#include "../../Physics/mcforceregistry.hh"
+#include "../../Physics/mcfrictiongenerator.hh"
+#include "../../Physics/mcphysicscomponent.hh"
+#include "../../Physics/mcrectshape.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::atomic<unsigned long> g_allocationCount(0);
+std::atomic<unsigned long> g_allocatedBytes(0);
+
+struct Config
+{
+    int cars = 20;
+    int obstacles = 200;
+    int particles = 1000;
+    int gridSize = 128;
+    int worldSize = 4096;
+    int steps = 1000;
+    int stepMs = 10;
+    int threads = 1;
+    bool batched = false;
+    bool particleSystem = false;
+    std::string traceFile;
+};
+
+//! Car-like object that drives forward and steers slowly.
+class BenchCar : public MCObject
+{
+public:
+
+    BenchCar(float steering)
+    : MCObject(MCShapePtr(new MCRectShape(nullptr, 60, 30)), "car")
+    , m_steering(steering)
+    {
+        physicsComponent().setMass(1000);
+        physicsComponent().preventSleeping(true);
+    }
+
+    virtual void onStepTime(int) override
+    {
+        const float thrust = 20000;
+        physicsComponent().addForce(
+            MCVector3dF(MCTrigonom::cos(angle()) * thrust, MCTrigonom::sin(angle()) * thrust, 0));
+        rotate(angle() + m_steering);
+    }
+
+private:
+
+    float m_steering;
+};
+
+//! Particle that lives its whole life time regardless of the camera and the world boundaries.
+class BenchParticle : public MCParticle
+{
+public:
+
+    BenchParticle()
+    : MCParticle("particle")
+    {
+        setDieWhenOffScreen(false);
+        setDieOnOutOfBoundariesEvent(false);
+    }
+};
+
+void printUsage()
+{
+    std::printf(
+        "Usage: minicore-bench [OPTIONS]\n"
+        "  --cars N         Number of moving cars (default 20)\n"
+        "  --obstacles N    Number of static rect obstacles (default 200)\n"
+        "  --particles N    Number of live particles (default 1000)\n"
+        "  --grid-size N    Object grid cells per side (default 128)\n"
+        "  --world-size N   Width and height of the world (default 4096)\n"
+        "  --steps N        Number of steps (default 1000)\n"
+        "  --step-ms N      Time step in msecs (default 10)\n"
+        "  --threads N      Collision detection threads (default 1)\n"
+        "  --batched        Use batched integration\n"
+        "  --particle-system  Use MCParticleSystem instead of MCParticle objects\n"
+        "  --trace FILE     Profile the measured steps and write a Chrome trace to FILE\n");
+}
+
+bool parseArgs(int argc, char ** argv, Config & config)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg(argv[i]);
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--batched")
+        {
+            config.batched = true;
+        }
+        else if (arg == "--particle-system")
+        {
+            config.particleSystem = true;
+        }
+        else if (arg == "--cars" && hasValue)
+        {
+            config.cars = std::atoi(argv[++i]);
+        }
+        else if (arg == "--obstacles" && hasValue)
+        {
+            config.obstacles = std::atoi(argv[++i]);
+        }
+        else if (arg == "--particles" && hasValue)
+        {
+            config.particles = std::atoi(argv[++i]);
+        }
+        else if (arg == "--grid-size" && hasValue)
+        {
+            config.gridSize = std::atoi(argv[++i]);
+        }
+        else if (arg == "--world-size" && hasValue)
+        {
+            config.worldSize = std::atoi(argv[++i]);
+        }
+        else if (arg == "--steps" && hasValue)
+        {
+            config.steps = std::atoi(argv[++i]);
+        }
+        else if (arg == "--step-ms" && hasValue)
+        {
+            config.stepMs = std::atoi(argv[++i]);
+        }
+        else if (arg == "--threads" && hasValue)
+        {
+            config.threads = std::atoi(argv[++i]);
+        }
+        else if (arg == "--trace" && hasValue)
+        {
+            config.traceFile = argv[++i];
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return config.gridSize > 0 && config.worldSize > 0 && config.steps > 0 && config.stepMs > 0;
+}
+
+void printPhase(const char * name, double totalUs, unsigned int steps, double stepTotalUs)
+{
+    std::printf("  %-16s %12.1f %12.3f %7.1f%%\n",
+        name, totalUs / 1000, totalUs / steps / 1000, stepTotalUs > 0 ? totalUs * 100 / stepTotalUs : 0);
+}
+
+} // namespace
+
+// Count heap allocations of the whole process.
+void * operator new(std::size_t size)
+{
+    g_allocationCount++;
+    g_allocatedBytes += size;
+    if (void * p = std::malloc(size ? size : 1))
+    {
+        return p;
+    }
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void * p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void * p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void * operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete[](void * p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void * p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+int main(int argc, char ** argv)
+{
+    Config config;
+    if (!parseArgs(argc, argv, config))
+    {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    std::mt19937 engine(1234);
+    const float size = static_cast<float>(config.worldSize);
+    std::uniform_real_distribution<float> position(size * 0.05f, size * 0.95f);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+    MCWorld world;
+    world.setDimensions(0, size, 0, size, 0, 100, 0.05f, true, config.gridSize);
+    world.setCollisionDetectionThreadCount(static_cast<unsigned int>(std::max(config.threads, 1)));
+    world.enableBatchedIntegration(config.batched);
+
+    std::vector<std::unique_ptr<MCObject>> objects;
+
+    for (int i = 0; i < config.obstacles; i++)
+    {
+        MCObject * obstacle = new MCObject(MCShapePtr(new MCRectShape(nullptr, 40, 40)), "obstacle");
+        obstacle->physicsComponent().setMass(0, true);
+        obstacle->addToWorld(world);
+        obstacle->translate(MCVector3dF(position(engine), position(engine)));
+        objects.push_back(std::unique_ptr<MCObject>(obstacle));
+    }
+
+    for (int i = 0; i < config.cars; i++)
+    {
+        BenchCar * car = new BenchCar(unit(engine) * 0.5f);
+        car->addToWorld(world);
+        car->translate(MCVector3dF(position(engine), position(engine)));
+        car->rotate(unit(engine) * 180);
+        world.forceRegistry().addForceGenerator(MCForceGeneratorPtr(new MCFrictionGenerator(0.7f, 0.7f, world.gravity())), *car);
+        objects.push_back(std::unique_ptr<MCObject>(car));
+    }
+
+    // Unlike the objects, particles of the system die when they leave the world.
+    // Dead particles of both kinds are respawned before each step.
+    const unsigned long particleBytes = g_allocatedBytes;
+    MCParticle::ParticleFreeList freeParticles;
+    std::unique_ptr<MCParticleSystem> particleSystem;
+    if (config.particleSystem)
+    {
+        particleSystem.reset(new MCParticleSystem(static_cast<unsigned int>(std::max(config.particles, 0))));
+        particleSystem->setDieWhenOffScreen(false);
+        world.addParticleSystem(*particleSystem);
+    }
+    else
+    {
+        for (int i = 0; i < config.particles; i++)
+        {
+            BenchParticle * particle = new BenchParticle;
+            particle->setFreeList(freeParticles);
+            freeParticles.push_back(particle);
+            objects.push_back(std::unique_ptr<MCObject>(particle));
+        }
+    }
+    const double bytesPerParticle = config.particles > 0 ? double(g_allocatedBytes - particleBytes) / config.particles : 0;
+
+    const auto spawnParticles = [&] () {
+        if (particleSystem)
+        {
+            while (particleSystem->count() < particleSystem->capacity())
+            {
+                particleSystem->emit(MCVector3dF(position(engine), position(engine), 10),
+                    MCVector3dF(unit(engine) * 2, unit(engine) * 2, 0), 4, 500 + (engine() % 2000), MCGLColor());
+            }
+
+            return;
+        }
+
+        while (!freeParticles.empty())
+        {
+            MCParticle * particle = freeParticles.back();
+            freeParticles.pop_back();
+            particle->init(MCVector3dF(position(engine), position(engine), 10), 4, 500 + (engine() % 2000));
+            particle->physicsComponent().setVelocity(MCVector3dF(unit(engine) * 2, unit(engine) * 2, 0));
+            particle->addToWorld(world);
+        }
+    };
+
+    // Warm up so that containers have reached their steady state sizes
+    for (int i = 0; i < 10; i++)
+    {
+        spawnParticles();
+        world.stepTime(config.stepMs);
+    }
+
+    world.resetPhaseTimes();
+    const unsigned long allocationCount = g_allocationCount;
+    const unsigned long allocatedBytes = g_allocatedBytes;
+
+    MCProfiler::setEnabled(!config.traceFile.empty());
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < config.steps; i++)
+    {
+        spawnParticles();
+        world.stepTime(config.stepMs);
+    }
+    const auto end = std::chrono::steady_clock::now();
+
+    MCProfiler::setEnabled(false);
+
+    const unsigned long allocations = g_allocationCount - allocationCount;
+    const unsigned long bytes = g_allocatedBytes - allocatedBytes;
+    const double totalUs = std::chrono::duration<double, std::micro>(end - start).count();
+    const MCWorld::PhaseTimes & times = world.phaseTimes();
+
+    std::printf("cars=%d obstacles=%d particles=%d grid-size=%d world-size=%d steps=%d step-ms=%d threads=%d batched=%d particle-system=%d\n",
+        config.cars, config.obstacles, config.particles, config.gridSize, config.worldSize,
+        config.steps, config.stepMs, config.threads, config.batched ? 1 : 0, config.particleSystem ? 1 : 0);
+    std::printf("  %-16s %12s %12s %8s\n", "phase", "total ms", "ms/step", "share");
+    printPhase("force registry", times.forceRegistry, times.steps, totalUs);
+    printPhase("integrate", times.integrate, times.steps, totalUs);
+    printPhase("broadphase", times.broadPhase, times.steps, totalUs);
+    printPhase("narrowphase", times.narrowPhase, times.steps, totalUs);
+    printPhase("impulse", times.impulses, times.steps, totalUs);
+    printPhase("resolve", times.resolve, times.steps, totalUs);
+    printPhase("particles", times.particles, times.steps, totalUs);
+    printPhase("total", totalUs, times.steps, totalUs);
+    std::printf("steps/sec: %.1f\n", config.steps * 1000000.0 / totalUs);
+    std::printf("particle memory: %.1f bytes/particle\n", bytesPerParticle);
+    std::printf("allocations: %lu (%.1f/step, %lu bytes)\n", allocations, double(allocations) / config.steps, bytes);
+
+    if (!config.traceFile.empty())
+    {
+        if (!MCProfiler::writeChromeTrace(config.traceFile))
+        {
+            std::printf("failed to write trace to %s\n", config.traceFile.c_str());
+            return EXIT_FAILURE;
+        }
+
+        std::printf("trace: %s\n", config.traceFile.c_str());
+    }
+
+    world.clear();
+
+    if (particleSystem)
+    {
+        world.removeParticleSystem(*particleSystem);
+    }
+
+    return EXIT_SUCCESS;
+}
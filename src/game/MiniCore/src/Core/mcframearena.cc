@@ -0,0 +1,87 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#include "mcframearena.hh"
+
+#include <algorithm>
+#include <cassert>
+
+MCFrameArena::MCFrameArena(std::size_t blockSize)
+: m_blockSize(blockSize)
+, m_currentBlock(0)
+, m_offset(0)
+, m_usedSize(0)
+{
+    assert(blockSize);
+}
+
+void * MCFrameArena::allocate(std::size_t size, std::size_t alignment)
+{
+    assert(alignment && !(alignment & (alignment - 1)));
+
+    for (; m_currentBlock < m_blocks.size(); m_currentBlock++, m_offset = 0)
+    {
+        Block & block = m_blocks[m_currentBlock];
+        const std::size_t address = reinterpret_cast<std::size_t>(block.data) + m_offset;
+        const std::size_t offset = m_offset + ((alignment - address % alignment) % alignment);
+        if (offset + size <= block.size)
+        {
+            m_offset = offset + size;
+            m_usedSize += size;
+            return block.data + offset;
+        }
+    }
+
+    // None of the blocks had room: add a new one. Blocks are kept for the following steps.
+    const std::size_t blockSize = std::max(m_blockSize, size + alignment);
+    m_blocks.push_back({static_cast<char *>(::operator new(blockSize)), blockSize});
+    m_offset = 0;
+    return allocate(size, alignment);
+}
+
+void MCFrameArena::reset()
+{
+    m_currentBlock = 0;
+    m_offset = 0;
+    m_usedSize = 0;
+}
+
+std::size_t MCFrameArena::usedSize() const
+{
+    return m_usedSize;
+}
+
+std::size_t MCFrameArena::capacity() const
+{
+    std::size_t capacity = 0;
+    for (auto && block : m_blocks)
+    {
+        capacity += block.size;
+    }
+
+    return capacity;
+}
+
+MCFrameArena::~MCFrameArena()
+{
+    for (auto && block : m_blocks)
+    {
+        ::operator delete(block.data);
+    }
+}
@@ -0,0 +1,94 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#ifndef MCFRAMEARENA_HH
+#define MCFRAMEARENA_HH
+
+#include "mcmacros.hh"
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/*! \class MCFrameArena
+ *  \brief Bump allocator for data that lives for a single world step.
+ *
+ *  Memory is handed out linearly from large blocks. Nothing is freed individually:
+ *  reset() rewinds the arena in O(1) and keeps the blocks, so once the arena has
+ *  grown to the size a step needs, allocating from it doesn't touch the heap anymore.
+ *
+ *  Only trivially destructible objects can be created, because destructors are never run.
+ *  MCFrameArena is not thread-safe. */
+class MCFrameArena
+{
+public:
+
+    /*! Constructor.
+     *  \param blockSize Size of the blocks in bytes. Larger allocations get a block of their own. */
+    explicit MCFrameArena(std::size_t blockSize = 64 * 1024);
+
+    //! Destructor. Releases all blocks.
+    ~MCFrameArena();
+
+    //! Allocate uninitialized memory that stays valid until the next reset().
+    void * allocate(std::size_t size, std::size_t alignment);
+
+    //! Construct a new object that stays valid until the next reset().
+    template <typename T, typename ... Args>
+    T * create(Args && ... args)
+    {
+        static_assert(std::is_trivially_destructible<T>::value, "MCFrameArena never runs destructors");
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args) ...);
+    }
+
+    //! Invalidate all allocations. Keeps the blocks for reuse.
+    void reset();
+
+    //! \return Number of bytes allocated since the last reset().
+    std::size_t usedSize() const;
+
+    //! \return Total size of the blocks.
+    std::size_t capacity() const;
+
+private:
+
+    DISABLE_COPY(MCFrameArena);
+    DISABLE_ASSI(MCFrameArena);
+
+    struct Block
+    {
+        char * data;
+
+        std::size_t size;
+    };
+
+    std::vector<Block> m_blocks;
+
+    std::size_t m_blockSize;
+
+    std::size_t m_currentBlock;
+
+    std::size_t m_offset;
+
+    std::size_t m_usedSize;
+};
+
+#endif // MCFRAMEARENA_HH
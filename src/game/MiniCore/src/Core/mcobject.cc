@@ -34,6 +34,7 @@
 #include "mcworld.hh"
 #include "mcworldrenderer.hh"
 
+#include <algorithm>
 #include <cassert>
 
 namespace {
@@ -43,10 +44,13 @@ const int renderableBit       = 4;
 const int bypassCollisionsBit = 8;
 const int removingBit         = 32;
 const int isParticleBit       = 128;
+const int inObjectGridBit     = 256;
+const int inStaticLayerBit    = 512;
 }
 
 MCTypeRegistry MCObject::m_typeRegistry;
 MCObject::TimerEventObjectsList MCObject::m_timerEventObjects;
+std::mutex MCObject::m_timerEventMutex;
 
 MCObject::MCObject(const std::string & typeName)
     : m_typeId(MCObject::m_typeRegistry.registerType(typeName))
@@ -150,6 +154,11 @@ void MCObject::onStepTime(int)
 
 void MCObject::checkBoundaries()
 {
+    if (!m_world)
+    {
+        return;
+    }
+
     // Use shape bbox if shape is defined.
     if (m_shape)
     {
@@ -168,7 +177,7 @@ void MCObject::checkBoundaries()
 
 void MCObject::checkXBoundariesAndSendEvent(float minX, float maxX)
 {
-    const MCWorld & world = MCWorld::instance();
+    const MCWorld & world = *m_world;
     if (minX < world.minX())
     {
         MCOutOfBoundariesEvent e(MCOutOfBoundariesEvent::West, *this);
@@ -183,7 +192,7 @@ void MCObject::checkXBoundariesAndSendEvent(float minX, float maxX)
 
 void MCObject::checkYBoundariesAndSendEvent(float minY, float maxY)
 {
-    const MCWorld & world = MCWorld::instance();
+    const MCWorld & world = *m_world;
     if (minY < world.minY())
     {
         MCOutOfBoundariesEvent e(MCOutOfBoundariesEvent::South, *this);
@@ -198,7 +207,7 @@ void MCObject::checkYBoundariesAndSendEvent(float minY, float maxY)
 
 void MCObject::checkZBoundariesAndSendEvent()
 {
-    const MCWorld & world = MCWorld::instance();
+    const MCWorld & world = *m_world;
     if (m_location.k() < world.minZ())
     {
         m_physicsComponent->resetZ();
@@ -260,6 +269,8 @@ void MCObject::sendEvent(MCObject & object, MCEvent & event)
 
 void MCObject::subscribeTimerEvent(MCObject & object)
 {
+    std::lock_guard<std::mutex> lock(m_timerEventMutex);
+
     if (object.m_timerEventObjectsIndex == -1)
     {
         m_timerEventObjects.push_back(&object);
@@ -269,6 +280,8 @@ void MCObject::subscribeTimerEvent(MCObject & object)
 
 void MCObject::unsubscribeTimerEvent(MCObject & object)
 {
+    std::lock_guard<std::mutex> lock(m_timerEventMutex);
+
     if (object.m_timerEventObjectsIndex > -1)
     {
         m_timerEventObjects.back()->m_timerEventObjectsIndex =
@@ -282,60 +295,64 @@ void MCObject::unsubscribeTimerEvent(MCObject & object)
 
 void MCObject::sendTimerEvent(MCTimerEvent & event)
 {
+    std::lock_guard<std::mutex> lock(m_timerEventMutex);
+
     for (MCObject * obj : m_timerEventObjects)
     {
         MCObject::sendEvent(*obj, event);
     }
 }
 
-void MCObject::addToWorld()
+void MCObject::addToWorld(MCWorld & world)
 {
-    MCWorld::instance().addObject(*this);
+    world.addObject(*this);
 
     for (auto child : m_children)
     {
-        MCWorld::instance().addObject(*child);
+        world.addObject(*child);
     }
 }
 
-void MCObject::addToWorld(float x, float y, float z)
+void MCObject::addToWorld(MCWorld & world, float x, float y, float z)
 {
-    MCWorld::instance().addObject(*this);
-
-    for (auto child : m_children)
-    {
-        MCWorld::instance().addObject(*child);
-    }
+    addToWorld(world);
 
     translate(MCVector3dF(x, y, z));
 }
 
 void MCObject::removeFromWorld()
 {
-    if (MCWorld::hasInstance())
+    if (m_world)
     {
-        MCWorld::instance().removeObject(*this);
+        MCWorld & world = *m_world;
+        world.removeObject(*this);
 
         for (auto child : m_children)
         {
-            MCWorld::instance().removeObjectNow(*child);
+            world.removeObjectNow(*child);
         }
     }
 }
 
 void MCObject::removeFromWorldNow()
 {
-    if (MCWorld::hasInstance())
+    if (m_world)
     {
-        MCWorld::instance().removeObjectNow(*this);
+        MCWorld & world = *m_world;
+        world.removeObjectNow(*this);
 
         for (auto child : m_children)
         {
-            MCWorld::instance().removeObjectNow(*child);
+            world.removeObjectNow(*child);
         }
     }
 }
 
+MCWorld * MCObject::world() const
+{
+    return m_world;
+}
+
 void MCObject::render(MCCamera * p)
 {
     if (m_shape)
@@ -429,6 +446,26 @@ bool MCObject::removing() const
     return testStatus(removingBit);
 }
 
+void MCObject::setIsInObjectGrid(bool flag)
+{
+    setStatus(inObjectGridBit, flag);
+}
+
+bool MCObject::isInObjectGrid() const
+{
+    return testStatus(inObjectGridBit);
+}
+
+void MCObject::setIsInStaticLayer(bool flag)
+{
+    setStatus(inStaticLayerBit, flag);
+}
+
+bool MCObject::isInStaticLayer() const
+{
+    return testStatus(inStaticLayerBit);
+}
+
 void MCObject::translateRelative(const MCVector3dF & newLocation)
 {
     m_relativeLocation = newLocation;
@@ -444,8 +481,6 @@ void MCObject::translate(const MCVector3dF & newLocation)
     }
     else
     {
-        const bool wasInWorld = !removing() && MCWorld::instance().objectGrid().remove(*this);
-
         // Calculate velocity if this object is a child object and is thus moved
         // by the parent. This way we'll automatically get linear velocity +
         // possible orbital velocity.
@@ -463,9 +498,9 @@ void MCObject::translate(const MCVector3dF & newLocation)
 
         updateChildTransforms();
 
-        if (wasInWorld)
+        if (m_world && !removing())
         {
-            MCWorld::instance().objectGrid().insert(*this);
+            m_world->objectGrid().update(*this);
         }
     }
 }
@@ -530,14 +565,12 @@ void MCObject::rotateShape(float angle)
         }
         else
         {
-            const bool wasInWorld = MCWorld::instance().objectGrid().remove(*this);
-
             m_shape->rotate(angle);
             m_shape->translate(m_location - MCVector3dF(m_center));
 
-            if (wasInWorld)
+            if (m_world)
             {
-                MCWorld::instance().objectGrid().insert(*this);
+                m_world->objectGrid().update(*this);
             }
         }
     }
@@ -617,38 +650,43 @@ void MCObject::restoreIndexRange(unsigned int * i0, unsigned int * i1, unsigned
 
 void MCObject::addContact(MCContact & contact)
 {
-    m_contacts[&contact.object()].push_back(&contact);
+    m_contacts.push_back(&contact);
 }
 
-const MCObject::ContactHash & MCObject::contacts() const
+const MCObject::ContactVector & MCObject::contacts() const
 {
     return m_contacts;
 }
 
-void MCObject::deleteContacts()
+MCContact * MCObject::deepestContact(const MCObject & object) const
 {
-    auto i(m_contacts.begin());
-    for (; i != m_contacts.end(); i++)
+    float maxDepth = 0;
+    MCContact * deepest = nullptr;
+    for (MCContact * contact : m_contacts)
     {
-        for (unsigned int j = 0; j < i->second.size(); j++)
+        if (&contact->object() == &object && contact->interpenetrationDepth() > maxDepth)
         {
-            i->second[j]->free();
+            maxDepth = contact->interpenetrationDepth();
+            deepest = contact;
         }
     }
+
+    return deepest;
+}
+
+void MCObject::deleteContacts()
+{
+    // The contacts themselves are owned by the frame arena
     m_contacts.clear();
 }
 
 void MCObject::deleteContacts(MCObject & object)
 {
-    auto i(m_contacts.find(&object));
-    if (i != m_contacts.end())
-    {
-        for (unsigned int j = 0; j < i->second.size(); j++)
-        {
-            i->second[j]->free();
-        }
-        i->second.clear();
-    }
+    m_contacts.erase(
+        std::remove_if(m_contacts.begin(), m_contacts.end(), [&object] (MCContact * contact) {
+            return &contact->object() == &object;
+        }),
+        m_contacts.end());
 }
 
 void MCObject::setInitialLocation(const MCVector3dF & location)
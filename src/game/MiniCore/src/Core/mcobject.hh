@@ -31,6 +31,7 @@
 
 #include <map>
 #include <memory>
+#include <mutex>
 #include <unordered_map>
 #include <vector>
 #include <string>
@@ -43,6 +44,7 @@ class MCOutOfBoundariesEvent;
 class MCPhysicsComponent;
 class MCTimerEvent;
 class MCCamera;
+class MCWorld;
 
 typedef std::shared_ptr<MCObject> MCObjectPtr;
 
@@ -54,8 +56,9 @@ class MCObject
 {
 public:
 
-    //! Hash container for contacts. Prefer map here for iteration performance.
-    typedef std::map<MCObject *, std::vector<MCContact *> > ContactHash;
+    //! Contacts of an object in the order they were added. An object has only a few contacts
+    //! at a time, so a flat vector is used. It keeps its capacity when the contacts are deleted.
+    typedef std::vector<MCContact *> ContactVector;
 
     /*! Constructor.
      *  \param typeId Type name string e.g. "CAR". All identical objects should have the same typeName. */
@@ -106,14 +109,16 @@ public:
      *  \param event Event to be sent. */
     static void sendEvent(MCObject & object, MCEvent & event);
 
-    //! Subscribe the given object to timer events.
+    /*! Subscribe the given object to timer events. The subscriptions are
+     *  shared by all worlds and can be changed from any thread. */
     static void subscribeTimerEvent(MCObject & object);
 
     //! Subscribe the given object from timer events.
     static void unsubscribeTimerEvent(MCObject & object);
 
     /*! Send the given timer event to all objects that
-     *  have subscribed to timer events. */
+     *  have subscribed to timer events. The event handlers
+     *  must not subscribe or unsubscribe. */
     static void sendTimerEvent(MCTimerEvent & event);
 
     /*! Render the object.
@@ -131,24 +136,29 @@ public:
     //! \brief Return whether the object should be automatically rendered.
     bool isRenderable() const;
 
-    /*! \brief Add object to the World.
-     *  Convenience method to add object to the MCWorld instance.
+    /*! \brief Add object to the given world.
+     *  Convenience method to add object and its children to the world.
      *  Composite objects may override this and add all their sub-objects. */
-    virtual void addToWorld();
+    virtual void addToWorld(MCWorld & world);
 
     //! \brief Combined addToWorld() and translate.
-    virtual void addToWorld(float x, float y, float z = 0);
+    virtual void addToWorld(MCWorld & world, float x, float y, float z = 0);
 
-    /*! \brief Remove object from the World.
-     *  Convenience method to remove object from the MCWorld instance.
+    /*! \brief Remove object from the world it has been added to.
+     *  Convenience method to remove object from its MCWorld. Does nothing if
+     *  the object is not in a world.
      *  Composite objects may re-implement this and remove all their sub-objects. */
     virtual void removeFromWorld();
 
-    /*! \brief Remove object from the World immediately.
-     *  Convenience method to remove object from the MCWorld instance.
+    /*! \brief Remove object from the world immediately.
+     *  Convenience method to remove object from its MCWorld. Does nothing if
+     *  the object is not in a world.
      *  Composite objects may re-implement this and remove all their sub-objects. */
     virtual void removeFromWorldNow();
 
+    //! \return The world the object has been added to or nullptr.
+    MCWorld * world() const;
+
     /*! \brief Sets whether the physics of the object should be updated.
      *  True is the default. */
     void setIsPhysicsObject(bool flag);
@@ -241,11 +251,15 @@ public:
     //! Return the collision layer.
     int collisionLayer() const;
 
-    //! Add a collision contact.
+    /*! Add a collision contact. The contacts are allocated from the frame arena
+     *  of MCWorld, so they must be deleted before the arena is reset. */
     void addContact(MCContact & contact);
 
-    //! Get collision contact hash.
-    const ContactHash & contacts() const;
+    //! Get collision contacts.
+    const ContactVector & contacts() const;
+
+    //! \return The deepest contact with the given object or nullptr if none of them interpenetrates.
+    MCContact * deepestContact(const MCObject & object) const;
 
     //! Delete current contacts.
     void deleteContacts();
@@ -331,6 +345,22 @@ private:
      *  Used by MCWorld. */
     bool removing() const;
 
+    /*! Set whether the object is stored in MCObjectGrid.
+     *  Used by MCObjectGrid. */
+    void setIsInObjectGrid(bool flag);
+
+    /*! Return true, if the object is stored in MCObjectGrid.
+     *  Used by MCObjectGrid. */
+    bool isInObjectGrid() const;
+
+    /*! Set whether the object is stored in the static layer of MCObjectGrid.
+     *  Used by MCObjectGrid. */
+    void setIsInStaticLayer(bool flag);
+
+    /*! Return true, if the object is stored in the static layer of MCObjectGrid.
+     *  Used by MCObjectGrid. */
+    bool isInStaticLayer() const;
+
     /*! Get cached index range.
      *  Used by MCObjectGrid. */
     void restoreIndexRange(unsigned int * i0, unsigned int * i1, unsigned int * j0, unsigned int * j1);
@@ -369,6 +399,8 @@ private:
 
     int m_index = -1;
 
+    MCWorld * m_world = nullptr;
+
     unsigned int m_i0 = 0;
 
     unsigned int m_i1 = 0;
@@ -397,7 +429,9 @@ private:
 
     static TimerEventObjectsList m_timerEventObjects;
 
-    MCObject::ContactHash m_contacts;
+    static std::mutex m_timerEventMutex;
+
+    MCObject::ContactVector m_contacts;
 
     int m_timerEventObjectsIndex = -1;
 
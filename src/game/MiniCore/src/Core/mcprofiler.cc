@@ -0,0 +1,270 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#include "mcprofiler.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+
+std::atomic<bool> MCProfiler::m_enabled(false);
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// One spare slot, so that the slot being written is never one of the EVENTS_PER_THREAD readable events.
+const unsigned int SLOTS_PER_THREAD = MCProfiler::EVENTS_PER_THREAD + 1;
+
+//! Ring buffer written only by its owner thread.
+struct ThreadBuffer
+{
+    explicit ThreadBuffer(unsigned int index)
+    : index(index)
+    , head(0)
+    , inUse(true)
+    , events(SLOTS_PER_THREAD)
+    {}
+
+    const unsigned int index;
+
+    //! Total number of events ever written. Only the owner thread writes this.
+    std::atomic<uint64_t> head;
+
+    //! False after the owner thread has exited so that the buffer can be reused.
+    std::atomic<bool> inUse;
+
+    MCProfiler::EventVector events;
+};
+
+typedef std::vector<std::unique_ptr<ThreadBuffer>> ThreadBufferVector;
+
+Clock::time_point epoch()
+{
+    static const Clock::time_point epoch = Clock::now();
+    return epoch;
+}
+
+std::mutex & registryMutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+ThreadBufferVector & registry()
+{
+    static ThreadBufferVector buffers;
+    return buffers;
+}
+
+std::atomic<int64_t> clearTime(0);
+
+//! Releases the buffer of the thread when the thread exits.
+struct ThreadRegistration
+{
+    ~ThreadRegistration()
+    {
+        if (buffer)
+        {
+            buffer->inUse = false;
+        }
+    }
+
+    ThreadBuffer * buffer = nullptr;
+};
+
+thread_local ThreadRegistration threadRegistration;
+
+ThreadBuffer & threadBuffer()
+{
+    if (!threadRegistration.buffer)
+    {
+        std::lock_guard<std::mutex> lock(registryMutex());
+        for (auto && buffer : registry())
+        {
+            bool inUse = false;
+            if (buffer->inUse.compare_exchange_strong(inUse, true))
+            {
+                threadRegistration.buffer = buffer.get();
+                break;
+            }
+        }
+
+        if (!threadRegistration.buffer)
+        {
+            registry().push_back(std::unique_ptr<ThreadBuffer>(new ThreadBuffer(static_cast<unsigned int>(registry().size()))));
+            threadRegistration.buffer = registry().back().get();
+        }
+    }
+
+    return *threadRegistration.buffer;
+}
+
+struct NameCompare
+{
+    bool operator()(const char * lhs, const char * rhs) const
+    {
+        return std::strcmp(lhs, rhs) < 0;
+    }
+};
+
+void writeJsonString(std::ostream & out, const char * str)
+{
+    out << '"';
+    for (; *str; str++)
+    {
+        if (*str == '"' || *str == '\\')
+        {
+            out << '\\';
+        }
+
+        out << *str;
+    }
+    out << '"';
+}
+
+} // namespace
+
+void MCProfiler::setEnabled(bool enable)
+{
+    epoch(); // Make sure that the epoch is initialized before the first zone
+    m_enabled = enable;
+}
+
+int64_t MCProfiler::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - epoch()).count();
+}
+
+void MCProfiler::record(const char * name, int64_t start, int64_t end)
+{
+    ThreadBuffer & buffer = threadBuffer();
+    const uint64_t head = buffer.head.load(std::memory_order_relaxed);
+
+    Event & event = buffer.events[head % SLOTS_PER_THREAD];
+    event.name = name;
+    event.start = start;
+    event.duration = end - start;
+    event.thread = buffer.index;
+
+    buffer.head.store(head + 1, std::memory_order_release);
+}
+
+MCProfiler::EventVector MCProfiler::events(int64_t since)
+{
+    since = std::max(since, clearTime.load());
+
+    EventVector result;
+
+    std::lock_guard<std::mutex> lock(registryMutex());
+    for (auto && buffer : registry())
+    {
+        const uint64_t head = buffer->head.load(std::memory_order_acquire);
+        const uint64_t first = head > EVENTS_PER_THREAD ? head - EVENTS_PER_THREAD : 0;
+        const size_t offset = result.size();
+        for (uint64_t i = first; i < head; i++)
+        {
+            result.push_back(buffer->events[i % SLOTS_PER_THREAD]);
+        }
+
+        // The owner may have wrapped around while copying. Drop the events it may have overwritten.
+        const uint64_t newHead = buffer->head.load(std::memory_order_acquire);
+        const uint64_t firstValid = newHead > EVENTS_PER_THREAD ? newHead - EVENTS_PER_THREAD : 0;
+        if (firstValid > first)
+        {
+            const uint64_t invalid = std::min(firstValid - first, head - first);
+            result.erase(result.begin() + offset, result.begin() + offset + invalid);
+        }
+    }
+
+    result.erase(std::remove_if(result.begin(), result.end(), [since] (const Event & event) {
+        return event.start < since;
+    }), result.end());
+
+    std::stable_sort(result.begin(), result.end(), [] (const Event & lhs, const Event & rhs) {
+        return lhs.start < rhs.start;
+    });
+
+    return result;
+}
+
+MCProfiler::SummaryVector MCProfiler::summary(int64_t since)
+{
+    std::map<const char *, Summary, NameCompare> summaries;
+    for (auto && event : events(since))
+    {
+        auto iter = summaries.find(event.name);
+        if (iter == summaries.end())
+        {
+            summaries[event.name] = {event.name, 1, event.duration, event.duration};
+        }
+        else
+        {
+            iter->second.count++;
+            iter->second.total += event.duration;
+            iter->second.longest = std::max(iter->second.longest, event.duration);
+        }
+    }
+
+    SummaryVector result;
+    for (auto && iter : summaries)
+    {
+        result.push_back(iter.second);
+    }
+
+    return result;
+}
+
+void MCProfiler::clear()
+{
+    // The buffers are owned by the recording threads, so just hide the old events.
+    clearTime = now();
+}
+
+bool MCProfiler::writeChromeTrace(const std::string & fileName)
+{
+    std::ofstream out(fileName);
+    if (!out)
+    {
+        return false;
+    }
+
+    out << "{\"traceEvents\":[";
+    out << std::fixed << std::setprecision(3);
+
+    bool first = true;
+    for (auto && event : events())
+    {
+        out << (first ? "\n" : ",\n");
+        out << "{\"name\":";
+        writeJsonString(out, event.name);
+        out << ",\"cat\":\"MiniCore\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread
+            << ",\"ts\":" << event.start / 1000.0 << ",\"dur\":" << event.duration / 1000.0 << "}";
+        first = false;
+    }
+
+    out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+    return static_cast<bool>(out);
+}
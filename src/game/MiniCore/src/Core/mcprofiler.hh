@@ -0,0 +1,168 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#ifndef MCPROFILER_HH
+#define MCPROFILER_HH
+
+#include "mcmacros.hh"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*! \class MCProfiler
+ *  \brief Lightweight scoped timer for profiling zones of code.
+ *
+ *  Zones are recorded into a fixed-size ring buffer owned by the recording thread,
+ *  so recording doesn't lock or allocate. When the buffer is full, the oldest events
+ *  are overwritten. The profiler is disabled by default and a disabled zone costs
+ *  a single relaxed atomic load.
+ *
+ *  Use the MC_PROFILE_ZONE macro to time the rest of the enclosing scope:
+ *
+ *  \code
+ *  void MCWorld::integrate(int step)
+ *  {
+ *      MC_PROFILE_ZONE("MCWorld::integrate");
+ *      ...
+ *  }
+ *  \endcode
+ *
+ *  Zone names must be string literals or otherwise outlive the profiler.
+ *  Defining MC_NO_PROFILER compiles the zones out completely. */
+class MCProfiler
+{
+public:
+
+    //! A finished zone.
+    struct Event
+    {
+        //! Name of the zone.
+        const char * name;
+
+        //! Start time in nanoseconds since the profiler epoch.
+        int64_t start;
+
+        //! Duration in nanoseconds.
+        int64_t duration;
+
+        //! Index of the recording thread in the order the threads recorded their first event.
+        unsigned int thread;
+    };
+
+    typedef std::vector<Event> EventVector;
+
+    //! Accumulated statistics of all events with the same name.
+    struct Summary
+    {
+        const char * name;
+
+        unsigned int count;
+
+        //! Total duration in nanoseconds.
+        int64_t total;
+
+        //! Longest duration in nanoseconds.
+        int64_t longest;
+    };
+
+    typedef std::vector<Summary> SummaryVector;
+
+    //! RAII timer that records an event when it goes out of scope.
+    class Zone
+    {
+    public:
+
+        //! Start the zone if the profiler is enabled.
+        explicit Zone(const char * name)
+        : m_name(MCProfiler::isEnabled() ? name : nullptr)
+        , m_start(m_name ? MCProfiler::now() : 0)
+        {}
+
+        //! Stop the zone and record the event.
+        ~Zone()
+        {
+            if (m_name)
+            {
+                MCProfiler::record(m_name, m_start, MCProfiler::now());
+            }
+        }
+
+    private:
+
+        DISABLE_COPY(Zone);
+        DISABLE_ASSI(Zone);
+
+        const char * m_name;
+
+        int64_t m_start;
+    };
+
+    //! Number of events each thread keeps before overwriting the oldest ones.
+    static const unsigned int EVENTS_PER_THREAD = 8192;
+
+    //! Enable or disable recording. Disabled by default.
+    static void setEnabled(bool enable);
+
+    //! \return true if recording is enabled.
+    static bool isEnabled()
+    {
+        return m_enabled.load(std::memory_order_relaxed);
+    }
+
+    //! \return Current time in nanoseconds since the profiler epoch.
+    static int64_t now();
+
+    //! Record a finished zone for the calling thread.
+    static void record(const char * name, int64_t start, int64_t end);
+
+    /*! \return Events of all threads that have been recorded since the given time,
+     *  sorted by the start time. Events that are being overwritten while reading are skipped. */
+    static EventVector events(int64_t since = 0);
+
+    /*! \return Events since the given time summarized by the zone name,
+     *  sorted by the name. */
+    static SummaryVector summary(int64_t since);
+
+    //! Forget all recorded events.
+    static void clear();
+
+    /*! Write the currently buffered events as Chrome trace event JSON that can be
+     *  opened with chrome://tracing or Perfetto.
+     *  \return true on success. */
+    static bool writeChromeTrace(const std::string & fileName);
+
+private:
+
+    MCProfiler() = delete;
+
+    static std::atomic<bool> m_enabled;
+};
+
+#ifdef MC_NO_PROFILER
+#define MC_PROFILE_ZONE(name)
+#else
+#define MC_PROFILE_ZONE_CONCAT_IMPL(a, b) a ## b
+#define MC_PROFILE_ZONE_CONCAT(a, b) MC_PROFILE_ZONE_CONCAT_IMPL(a, b)
+//! Time the rest of the enclosing scope as a zone with the given name.
+#define MC_PROFILE_ZONE(name) MCProfiler::Zone MC_PROFILE_ZONE_CONCAT(mcProfileZone, __LINE__)(name)
+#endif
+
+#endif // MCPROFILER_HH
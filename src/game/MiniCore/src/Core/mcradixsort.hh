@@ -0,0 +1,107 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#ifndef MCRADIXSORT_HH
+#define MCRADIXSORT_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+/*! \class MCRadixSort
+ *  \brief Sorts values by a float key with an LSD radix sort of 8-bit digits.
+ *
+ *  The sort is stable. The buffers are kept between calls, so sorting doesn't allocate
+ *  once they have grown to the largest count sorted. Digits that are equal for all keys,
+ *  e.g. when all particles lie on the same plane, are skipped. */
+template <typename T>
+class MCRadixSort
+{
+public:
+
+    //! \return an unsigned integer with the same order as the given float.
+    static uint32_t key(float value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits & 0x80000000u ? ~bits : bits | 0x80000000u;
+    }
+
+    /*! Sort the given values in ascending order of their keys.
+     *  \param keyOf Returns the float key of a value. */
+    template <typename KeyFunction>
+    void sort(std::vector<T> & values, KeyFunction keyOf)
+    {
+        const size_t count = values.size();
+        if (count < 2)
+        {
+            return;
+        }
+
+        m_items.resize(count);
+        m_scratch.resize(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            m_items[i] = {key(keyOf(values[i])), values[i]};
+        }
+
+        for (int shift = 0; shift < 32; shift += 8)
+        {
+            size_t offsets[257] = {};
+            for (auto && item : m_items)
+            {
+                offsets[((item.first >> shift) & 0xff) + 1]++;
+            }
+
+            if (offsets[((m_items[0].first >> shift) & 0xff) + 1] == count)
+            {
+                continue;
+            }
+
+            for (int digit = 1; digit < 257; digit++)
+            {
+                offsets[digit] += offsets[digit - 1];
+            }
+
+            for (auto && item : m_items)
+            {
+                m_scratch[offsets[(item.first >> shift) & 0xff]++] = item;
+            }
+
+            m_items.swap(m_scratch);
+        }
+
+        for (size_t i = 0; i < count; i++)
+        {
+            values[i] = m_items[i].second;
+        }
+    }
+
+private:
+
+    typedef std::pair<uint32_t, T> Item;
+
+    std::vector<Item> m_items;
+
+    std::vector<Item> m_scratch;
+};
+
+#endif // MCRADIXSORT_HH
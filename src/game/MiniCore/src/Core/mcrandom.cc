@@ -20,8 +20,10 @@
 #include "mcrandom.hh"
 #include "mccast.hh"
 
+#include <atomic>
 #include <cstdlib>
 #include <limits>
+#include <mutex>
 #include <random>
 #include <vector>
 
@@ -41,10 +43,11 @@ public:
 private:
   void buildLUT();
 
-  mutable unsigned int m_valPtr;
+  // Shared by all worlds, which may be stepped in different threads
+  std::atomic<unsigned int> m_valPtr;
   std::vector<float> m_data;
   int m_seed;
-  bool m_isBuilt;
+  std::once_flag m_buildFlag;
   friend class MCRandom;
 };
 
@@ -53,8 +56,7 @@ std::unique_ptr<MCRandomImpl> const MCRandom::m_impl(new MCRandomImpl);
 MCRandomImpl::MCRandomImpl() :
     m_valPtr(0),
     m_data(LUT_SIZE, 0),
-    m_seed(0),
-    m_isBuilt(false)
+    m_seed(0)
 {
 }
 
@@ -66,15 +68,11 @@ void MCRandomImpl::buildLUT()
     for (unsigned int i = 0; i < LUT_SIZE; i++) {
         m_data[i] = dist(engine);
     }
-
-    m_isBuilt = true;
 }
 
 float MCRandomImpl::getValue()
 {
-    if (!MCRandomImpl::m_isBuilt) {
-        MCRandomImpl::buildLUT();
-    }
+    std::call_once(m_buildFlag, &MCRandomImpl::buildLUT, this);
 
     return MCRandomImpl::m_data[++m_valPtr & MOD_MASK];
 }
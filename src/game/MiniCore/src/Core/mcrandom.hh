@@ -30,7 +30,7 @@
 
 class MCRandomImpl;
 
-//! MCRandom number LUT.
+//! MCRandom number LUT. Can be used from any thread.
 class MCRandom
 {
 public:
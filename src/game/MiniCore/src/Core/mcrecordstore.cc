@@ -0,0 +1,147 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#include "mcrecordstore.hh"
+
+#include <cassert>
+
+MCRecordStore::MCRecordStore(std::unique_ptr<Backend> backend)
+    : m_backend(std::move(backend))
+    , m_writer(&MCRecordStore::writerLoop, this)
+{
+    assert(m_backend);
+}
+
+void MCRecordStore::load()
+{
+    waitForFlush();
+
+    m_records = m_backend->read();
+    m_dirty.clear();
+}
+
+int MCRecordStore::value(const std::string & key, int defaultValue) const
+{
+    auto && iter = m_records.find(key);
+    return iter != m_records.end() ? iter->second : defaultValue;
+}
+
+void MCRecordStore::setValue(const std::string & key, int value)
+{
+    m_records[key] = value;
+
+    Change & change = m_dirty[key];
+    change.key = key;
+    change.value = value;
+    change.removed = false;
+}
+
+void MCRecordStore::remove(const std::string & prefix)
+{
+    auto iter = m_records.lower_bound(prefix);
+    while (iter != m_records.end() && !iter->first.compare(0, prefix.size(), prefix))
+    {
+        Change & change = m_dirty[iter->first];
+        change.key = iter->first;
+        change.value = 0;
+        change.removed = true;
+
+        iter = m_records.erase(iter);
+    }
+}
+
+size_t MCRecordStore::dirtyCount() const
+{
+    return m_dirty.size();
+}
+
+void MCRecordStore::flush()
+{
+    if (m_dirty.empty())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        // Newer changes of the same key replace the ones not yet written
+        for (auto && change : m_dirty)
+        {
+            m_pending[change.first] = change.second;
+        }
+    }
+
+    m_dirty.clear();
+    m_writeCondition.notify_one();
+}
+
+void MCRecordStore::waitForFlush()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_doneCondition.wait(lock, [this] () {
+        return m_pending.empty() && !m_writing;
+    });
+}
+
+void MCRecordStore::writerLoop()
+{
+    ChangeList changes;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_writing = false;
+            m_doneCondition.notify_all();
+
+            m_writeCondition.wait(lock, [this] () {
+                return m_exit || !m_pending.empty();
+            });
+
+            if (m_pending.empty())
+            {
+                return;
+            }
+
+            changes.clear();
+            for (auto && change : m_pending)
+            {
+                changes.push_back(change.second);
+            }
+
+            m_pending.clear();
+            m_writing = true;
+        }
+
+        m_backend->write(changes);
+    }
+}
+
+MCRecordStore::~MCRecordStore()
+{
+    flush();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_exit = true;
+    }
+
+    m_writeCondition.notify_one();
+    m_writer.join();
+}
@@ -0,0 +1,133 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#ifndef MCRECORDSTORE_HH
+#define MCRECORDSTORE_HH
+
+#include "mcmacros.hh"
+
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*! \class MCRecordStore
+ *  \brief An in-memory key-value store with write-behind persistence.
+ *
+ *  All records are read from the backend once by load(). After that reads are
+ *  answered from memory and writes only mark the records dirty. flush() hands the
+ *  dirty records over to a writer thread, so the caller never waits for disk I/O.
+ *  Call flush() at safe points, e.g. when a race ends. The destructor writes
+ *  the remaining dirty records.
+ *
+ *  The store itself must be used from one thread only. */
+class MCRecordStore
+{
+public:
+
+    typedef std::map<std::string, int> RecordMap;
+
+    //! A change to be written by the backend.
+    struct Change
+    {
+        std::string key;
+
+        int value = 0;
+
+        //! True if the key has been removed.
+        bool removed = false;
+    };
+
+    typedef std::vector<Change> ChangeList;
+
+    //! Reads and writes the records, e.g. using QSettings.
+    class Backend
+    {
+    public:
+
+        virtual ~Backend() {}
+
+        //! \return All stored records. Called by load() in the thread of the store.
+        virtual RecordMap read() = 0;
+
+        //! Write the given changes. Called in the writer thread.
+        virtual void write(const ChangeList & changes) = 0;
+    };
+
+    //! Constructor. Starts the writer thread.
+    explicit MCRecordStore(std::unique_ptr<Backend> backend);
+
+    //! Destructor. Writes the dirty records and joins the writer thread.
+    ~MCRecordStore();
+
+    //! Read all records from the backend. Replaces the records in memory.
+    void load();
+
+    //! \return value of the given key or defaultValue if the key doesn't exist.
+    int value(const std::string & key, int defaultValue) const;
+
+    //! Set the value of the given key. The change is written on the next flush().
+    void setValue(const std::string & key, int value);
+
+    //! Remove all keys that begin with the given prefix.
+    void remove(const std::string & prefix);
+
+    //! \return Number of changes not yet handed over to the writer thread.
+    size_t dirtyCount() const;
+
+    //! Hand the dirty records over to the writer thread. Doesn't block on I/O.
+    void flush();
+
+    //! Block until all flushed changes have been written.
+    void waitForFlush();
+
+private:
+
+    DISABLE_COPY(MCRecordStore);
+    DISABLE_ASSI(MCRecordStore);
+
+    void writerLoop();
+
+    std::unique_ptr<Backend> m_backend;
+
+    RecordMap m_records;
+
+    //! Changes since the latest flush() by key.
+    std::map<std::string, Change> m_dirty;
+
+    //! Flushed changes not yet taken by the writer thread.
+    std::map<std::string, Change> m_pending;
+
+    std::mutex m_mutex;
+
+    std::condition_variable m_writeCondition;
+
+    std::condition_variable m_doneCondition;
+
+    bool m_writing = false;
+
+    bool m_exit = false;
+
+    std::thread m_writer;
+};
+
+#endif // MCRECORDSTORE_HH
@@ -23,9 +23,11 @@
 
 
 
+#include <mutex>
 #include <string>
 #include <unordered_map>
 
+//! Maps type names to unique ids. Thread-safe, because objects of different worlds may be created in parallel.
 class MCTypeRegistry
 {
 public:
@@ -44,6 +46,8 @@ private:
     TypeHash m_typeHash;
 
     unsigned int m_typeIdCount;
+
+    std::mutex m_mutex;
 };
 
 #endif // MCTYPEREGISTRY_HH
@@ -0,0 +1,122 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#include "mcworkerpool.hh"
+
+MCWorkerPool::MCWorkerPool(unsigned int threadCount)
+    : m_nextJob(0)
+{
+    for (unsigned int i = 1; i < threadCount; i++)
+    {
+        m_threads.push_back(std::thread(&MCWorkerPool::workerLoop, this));
+    }
+}
+
+unsigned int MCWorkerPool::threadCount() const
+{
+    return static_cast<unsigned int>(m_threads.size()) + 1;
+}
+
+void MCWorkerPool::processJobs()
+{
+    unsigned int index;
+    while ((index = m_nextJob.fetch_add(1)) < m_jobCount)
+    {
+        (*m_job)(index);
+    }
+}
+
+void MCWorkerPool::workerLoop()
+{
+    unsigned int generation = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_startCondition.wait(lock, [&] () {
+                return m_exit || m_generation != generation;
+            });
+
+            if (m_exit)
+            {
+                return;
+            }
+
+            generation = m_generation;
+        }
+
+        processJobs();
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!--m_busyWorkers)
+            {
+                m_doneCondition.notify_one();
+            }
+        }
+    }
+}
+
+void MCWorkerPool::run(unsigned int jobCount, const Job & job)
+{
+    if (m_threads.empty() || jobCount < 2)
+    {
+        for (unsigned int i = 0; i < jobCount; i++)
+        {
+            job(i);
+        }
+
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_job = &job;
+        m_jobCount = jobCount;
+        m_nextJob = 0;
+        m_busyWorkers = static_cast<unsigned int>(m_threads.size());
+        m_generation++;
+    }
+
+    m_startCondition.notify_all();
+
+    processJobs();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_doneCondition.wait(lock, [this] () {
+        return m_busyWorkers == 0;
+    });
+
+    m_job = nullptr;
+}
+
+MCWorkerPool::~MCWorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_exit = true;
+    }
+
+    m_startCondition.notify_all();
+
+    for (auto && thread : m_threads)
+    {
+        thread.join();
+    }
+}
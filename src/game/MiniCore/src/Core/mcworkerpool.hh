@@ -0,0 +1,90 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#ifndef MCWORKERPOOL_HH
+#define MCWORKERPOOL_HH
+
+#include "mcmacros.hh"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*! \class MCWorkerPool
+ *  \brief A minimal pool of persistent worker threads.
+ *
+ *  MCWorkerPool runs a batch of independent jobs in parallel and blocks until
+ *  all of them have been finished. The calling thread participates in the work,
+ *  so a pool of N threads creates N - 1 worker threads. The jobs must not
+ *  touch shared state without synchronization. */
+class MCWorkerPool
+{
+public:
+
+    //! Job function. The argument is the index of the job in the batch.
+    typedef std::function<void (unsigned int)> Job;
+
+    /*! Constructor.
+     *  \param threadCount Total number of threads including the calling thread. */
+    explicit MCWorkerPool(unsigned int threadCount);
+
+    //! Destructor. Stops and joins the worker threads.
+    ~MCWorkerPool();
+
+    //! \return total number of threads including the calling thread.
+    unsigned int threadCount() const;
+
+    /*! Run job(0) .. job(jobCount - 1) and return when all of them are finished.
+     *  The order in which the jobs are executed is undefined. */
+    void run(unsigned int jobCount, const Job & job);
+
+private:
+
+    DISABLE_COPY(MCWorkerPool);
+    DISABLE_ASSI(MCWorkerPool);
+
+    void workerLoop();
+
+    void processJobs();
+
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_mutex;
+
+    std::condition_variable m_startCondition;
+
+    std::condition_variable m_doneCondition;
+
+    const Job * m_job = nullptr;
+
+    unsigned int m_jobCount = 0;
+
+    std::atomic<unsigned int> m_nextJob;
+
+    unsigned int m_generation = 0;
+
+    unsigned int m_busyWorkers = 0;
+
+    bool m_exit = false;
+};
+
+#endif // MCWORKERPOOL_HH
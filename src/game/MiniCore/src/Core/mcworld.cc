@@ -22,37 +22,67 @@
 #include "mcbbox.hh"
 #include "mccamera.hh"
 #include "mccollisiondetector.hh"
+#include "mccontactcache.hh"
 #include "mcforcegenerator.hh"
 #include "mcforceregistry.hh"
+#include "mcframearena.hh"
 #include "mcfrictiongenerator.hh"
 #include "mcimpulsegenerator.hh"
 #include "mcmathutil.hh"
 #include "mcobject.hh"
 #include "mcobjectgrid.hh"
 #include "mcparticle.hh"
+#include "mcparticlesystem.hh"
 #include "mcphysicscomponent.hh"
+#include "mcprofiler.hh"
 #include "mcshape.hh"
 #include "mcshapeview.hh"
 #include "mcrectshape.hh"
+#include "mcrigidbodystore.hh"
+#include "mcsleepislands.hh"
 #include "mctrigonom.hh"
 #include "mcworldrenderer.hh"
 
+#include <algorithm>
 #include <cassert>
-
-MCWorld * MCWorld::m_instance             = nullptr;
-float   MCWorld::m_metersPerUnit        = 1.0;
-float   MCWorld::m_metersPerUnitSquared = 1.0;
+#include <chrono>
 
 namespace {
 const int REMOVED_INDEX = -1;
+
+typedef std::chrono::steady_clock Clock;
+
+//! Add microseconds elapsed since start to time and restart.
+void accumulate(double & time, Clock::time_point & start)
+{
+    const Clock::time_point now = Clock::now();
+    time += std::chrono::duration<double, std::micro>(now - start).count();
+    start = now;
 }
+}
+
+MCWorld::PhaseTimes::PhaseTimes()
+: forceRegistry(0)
+, integrate(0)
+, broadPhase(0)
+, narrowPhase(0)
+, impulses(0)
+, resolve(0)
+, particles(0)
+, steps(0)
+{}
 
 MCWorld::MCWorld()
-: m_renderer(new MCWorldRenderer)
+: m_renderer(new MCWorldRenderer(*this))
 , m_forceRegistry(new MCForceRegistry)
-, m_collisionDetector(new MCCollisionDetector)
+, m_frameArena(new MCFrameArena)
+, m_collisionDetector(new MCCollisionDetector(*m_frameArena))
 , m_impulseGenerator(new MCImpulseGenerator)
+, m_contactCache(new MCContactCache)
 , m_objectGrid(nullptr)
+, m_rigidBodyStore(new MCRigidBodyStore)
+, m_sleepIslands(new MCSleepIslands)
+, m_metersPerUnit(1.0f)
 , m_minX(0)
 , m_maxX(0)
 , m_minY(0)
@@ -65,19 +95,13 @@ MCWorld::MCWorld()
 , m_bottomWallObject(nullptr)
 , m_numCollisions(0)
 , m_resolverLoopCount(5)
-, m_resolverStep(1.0 / m_resolverLoopCount)
+, m_resolverTolerance(0.01f)
+, m_isBatchedIntegrationEnabled(false)
+, m_stepCount(0)
+, m_isStepping(false)
+, m_renderInterpolation(1.0f)
 , m_gravity(MCVector3dF(0, 0, -9.81))
 {
-    if (!MCWorld::m_instance)
-    {
-        MCWorld::m_instance = this;
-    }
-    else
-    {
-        std::cerr << "ERROR!!: Only one MCWorld can exist!" << std::endl;
-        exit(EXIT_FAILURE);
-    }
-
     // Default dimensions. Creates also MCObjectGrid.
     setDimensions(0.0, 1.0, 0.0, 1.0, 0.0, 1.0, 1.0);
 }
@@ -86,13 +110,20 @@ MCWorld::~MCWorld()
 {
     clear();
 
+    for (auto && particleSystem : m_particleSystems)
+    {
+        particleSystem->m_world = nullptr;
+    }
+
     delete m_renderer;
     delete m_forceRegistry;
     delete m_collisionDetector;
+    delete m_frameArena;
     delete m_impulseGenerator;
+    delete m_contactCache;
     delete m_objectGrid;
-
-    MCWorld::m_instance = nullptr;
+    delete m_rigidBodyStore;
+    delete m_sleepIslands;
 
     delete m_leftWallObject;
     delete m_rightWallObject;
@@ -102,33 +133,82 @@ MCWorld::~MCWorld()
 
 void MCWorld::integrate(int step)
 {
+    MC_PROFILE_ZONE("MCWorld::integrate");
+
+    Clock::time_point start = Clock::now();
+
     // Integrate and update all registered objects
     m_forceRegistry->update();
-    for (auto && object : m_objs)
+    accumulate(m_phaseTimes.forceRegistry, start);
+
+    if (m_isBatchedIntegrationEnabled)
+    {
+        integrateBatched(step);
+    }
+    else
     {
-        if (object->isPhysicsObject() && !object->physicsComponent().isStationary())
+        for (auto && object : m_objs)
         {
-            object->physicsComponent().stepTime(step);
+            if (object->isPhysicsObject() && !object->physicsComponent().isStationary())
+            {
+                object->physicsComponent().stepTime(step);
+            }
+
+            object->onStepTime(step);
         }
+    }
+
+    accumulate(m_phaseTimes.integrate, start);
+}
+
+void MCWorld::stepParticleSystems(int step)
+{
+    Clock::time_point start = Clock::now();
+
+    for (auto && particleSystem : m_particleSystems)
+    {
+        particleSystem->stepTime(step);
+    }
+
+    accumulate(m_phaseTimes.particles, start);
+}
+
+void MCWorld::integrateBatched(int step)
+{
+    m_rigidBodyStore->gather(m_objs);
+    m_rigidBodyStore->integrate(float(step) / 1000);
 
+    for (unsigned int i = 0; i < m_rigidBodyStore->bodyCount(); i++)
+    {
+        m_rigidBodyStore->writeBack(i);
+    }
+
+    for (auto && object : m_objs)
+    {
         object->onStepTime(step);
     }
 }
 
 void MCWorld::detectCollisions()
 {
+    Clock::time_point start = Clock::now();
+
+    const auto & possibleCollisions = m_objectGrid->getPossibleCollisions();
+    accumulate(m_phaseTimes.broadPhase, start);
+
     // Check collisions for all registered objects
-    m_numCollisions = m_collisionDetector->detectCollisions(*m_objectGrid);
+    m_numCollisions = m_collisionDetector->detectCollisions(possibleCollisions);
+    accumulate(m_phaseTimes.narrowPhase, start);
 }
 
 void MCWorld::generateImpulses()
 {
-    m_impulseGenerator->generateImpulsesFromDeepestContacts(m_objs);
+    m_impulseGenerator->generateImpulsesFromDeepestContacts(m_objs, m_metersPerUnit);
 }
 
-void MCWorld::resolvePositions(float accuracy)
+void MCWorld::resolvePositions()
 {
-    m_impulseGenerator->resolvePositions(m_objs, accuracy);
+    m_impulseGenerator->resolvePositions(*m_contactCache, m_resolverLoopCount, m_resolverTolerance);
 }
 
 void MCWorld::prepareRendering(MCCamera * camera)
@@ -141,22 +221,6 @@ void MCWorld::render(MCCamera * camera, MCRenderGroup renderGroup)
     m_renderer->render(camera, renderGroup);
 }
 
-bool MCWorld::hasInstance()
-{
-    return MCWorld::m_instance;
-}
-
-MCWorld & MCWorld::instance()
-{
-    if (!MCWorld::m_instance)
-    {
-        std::cerr << "ERROR!!: MCWorld instance not created!" << std::endl;
-        exit(EXIT_FAILURE);
-    }
-
-    return *MCWorld::m_instance;
-}
-
 void MCWorld::clear()
 {
     // This does the same as removeObject(), but the removal
@@ -165,8 +229,10 @@ void MCWorld::clear()
     for (MCObject * object : m_objs)
     {
         object->deleteContacts();
+        object->physicsComponent().leaveIsland();
         object->physicsComponent().reset();
         object->setIndex(REMOVED_INDEX);
+        object->m_world = nullptr;
 
         if (object->isParticle())
         {
@@ -174,8 +240,24 @@ void MCWorld::clear()
         }
     }
 
+    // Sleeping objects are not integrated, but they are still in the grid
+    for (MCObject * object : m_objectGrid->objects())
+    {
+        object->physicsComponent().leaveIsland();
+        object->m_world = nullptr;
+    }
+
+    // Particle systems stay in the world, only their particles are removed
+    for (auto && particleSystem : m_particleSystems)
+    {
+        particleSystem->clear();
+    }
+
     m_renderer->clear();
     m_objectGrid->removeAll();
+    m_contactCache->clear();
+    m_collisionDetector->releaseContacts();
+    m_frameArena->reset();
     m_objs.clear();
     m_removeObjs.clear();
 }
@@ -188,7 +270,7 @@ void MCWorld::setDimensions(
     assert(maxY - minY > 0);
     assert(maxZ - minZ > 0);
 
-    MCWorld::setMetersPerUnit(metersPerUnit);
+    setMetersPerUnit(metersPerUnit);
 
     // Set dimensions
     m_minX = minX;
@@ -225,7 +307,7 @@ void MCWorld::setDimensions(
         m_leftWallObject->setShape(MCShapePtr(new MCRectShape(nullptr, w, h)));
         m_leftWallObject->physicsComponent().setMass(0, true);
         m_leftWallObject->physicsComponent().setRestitution(wallRestitution);
-        m_leftWallObject->addToWorld();
+        m_leftWallObject->addToWorld(*this);
         m_leftWallObject->translate(MCVector3dF(-w / 2, h / 2, 0));
 
         if (m_rightWallObject)
@@ -238,7 +320,7 @@ void MCWorld::setDimensions(
         m_rightWallObject->setShape(MCShapePtr(new MCRectShape(nullptr, w, h)));
         m_rightWallObject->physicsComponent().setMass(0, true);
         m_rightWallObject->physicsComponent().setRestitution(wallRestitution);
-        m_rightWallObject->addToWorld();
+        m_rightWallObject->addToWorld(*this);
         m_rightWallObject->translate(MCVector3dF(w + w / 2, h / 2, 0));
 
         if (m_topWallObject)
@@ -251,7 +333,7 @@ void MCWorld::setDimensions(
         m_topWallObject->setShape(MCShapePtr(new MCRectShape(nullptr, w, h)));
         m_topWallObject->physicsComponent().setMass(0, true);
         m_topWallObject->physicsComponent().setRestitution(wallRestitution);
-        m_topWallObject->addToWorld();
+        m_topWallObject->addToWorld(*this);
         m_topWallObject->translate(MCVector3dF(w / 2, h + h / 2, 0));
 
         if (m_bottomWallObject)
@@ -264,7 +346,7 @@ void MCWorld::setDimensions(
         m_bottomWallObject->setShape(MCShapePtr(new MCRectShape(nullptr, w, h)));
         m_bottomWallObject->physicsComponent().setMass(0, true);
         m_bottomWallObject->physicsComponent().setRestitution(wallRestitution);
-        m_bottomWallObject->addToWorld();
+        m_bottomWallObject->addToWorld(*this);
         m_bottomWallObject->translate(MCVector3dF(w / 2, -h / 2, 0));
     }
 }
@@ -306,10 +388,14 @@ int MCWorld::objectCount() const
 
 void MCWorld::addObject(MCObject & object)
 {
+    assert(!object.m_world || object.m_world == this);
+
     if (!object.removing())
     {
         if (object.index() == REMOVED_INDEX)
         {
+            object.m_world = this;
+
             m_renderer->addObject(object);
 
             // Add to object vector (O(1))
@@ -324,7 +410,7 @@ void MCWorld::addObject(MCObject & object)
             {
                 m_forceRegistry->addForceGenerator(
                     MCForceGeneratorPtr(new MCFrictionGenerator(
-                        object.physicsComponent().xyFriction(), object.physicsComponent().xyFriction())), object);
+                        object.physicsComponent().xyFriction(), object.physicsComponent().xyFriction(), m_gravity)), object);
             }
         }
     }
@@ -366,20 +452,51 @@ void MCWorld::removeObjectNow(MCObject & object)
 void MCWorld::doRemoveObject(MCObject & object)
 {
     // Reset motion
+    object.physicsComponent().leaveIsland();
     object.physicsComponent().reset();
 
     m_renderer->removeObject(object);
 
+    m_collisionDetector->releaseContacts(object);
+
+    m_contactCache->removeObject(object);
+
     // Remove from object vector (O(1))
     removeObjectFromIntegration(object);
 
-    // Remove from ObjectTree
-    if (object.isPhysicsObject() && !object.bypassCollisions())
+    // Remove from ObjectGrid. All objects are inserted regardless of the flags,
+    // so always remove in order not to leave dead objects (e.g. particles) behind.
+    m_objectGrid->remove(object);
+
+    object.setRemoving(false);
+
+    object.m_world = nullptr;
+}
+
+void MCWorld::addParticleSystem(MCParticleSystem & particleSystem)
+{
+    assert(!particleSystem.m_world || particleSystem.m_world == this);
+
+    if (!particleSystem.m_world)
     {
-        m_objectGrid->remove(object);
+        particleSystem.m_world = this;
+        m_particleSystems.push_back(&particleSystem);
     }
+}
 
-    object.setRemoving(false);
+void MCWorld::removeParticleSystem(MCParticleSystem & particleSystem)
+{
+    if (particleSystem.m_world == this)
+    {
+        particleSystem.m_world = nullptr;
+        m_renderer->removeParticleSystem(particleSystem);
+        m_particleSystems.erase(std::find(m_particleSystems.begin(), m_particleSystems.end(), &particleSystem));
+    }
+}
+
+const MCWorld::ParticleSystemVector & MCWorld::particleSystems() const
+{
+    return m_particleSystems;
 }
 
 void MCWorld::removeObjectFromIntegration(MCObject & object)
@@ -423,17 +540,25 @@ void MCWorld::processCollisions()
 
     if (m_numCollisions)
     {
+        Clock::time_point start = Clock::now();
+
+        // Cache the deepest contacts before the impulse generator consumes them
+        m_contactCache->update(m_objs);
+
         generateImpulses();
+        accumulate(m_phaseTimes.impulses, start);
 
-        // Process contacts and generate impulses
-        m_collisionDetector->enablePrimaryCollisionEvents(false);
-        for (unsigned int i = 0; i < m_resolverLoopCount && m_numCollisions > 0; i++)
-        {
-            detectCollisions();
-            resolvePositions(m_resolverStep);
-        }
-        m_collisionDetector->enablePrimaryCollisionEvents(true);
+        // Resolve positions iteratively using the cached contacts
+        resolvePositions();
+        accumulate(m_phaseTimes.resolve, start);
     }
+    else
+    {
+        m_contactCache->clear();
+    }
+
+    // Objects at rest fall asleep together with the objects they are touching
+    m_sleepIslands->update(m_objs, m_contactCache->manifolds());
 }
 
 MCForceRegistry & MCWorld::forceRegistry() const
@@ -444,6 +569,14 @@ MCForceRegistry & MCWorld::forceRegistry() const
 
 void MCWorld::stepTime(int step)
 {
+    MC_PROFILE_ZONE("MCWorld::stepTime");
+
+    m_stepCount++;
+    m_isStepping = true;
+
+    // Particles emitted during the previous step are moved for the first time here
+    stepParticleSystems(step);
+
     // Integrate physics
     integrate(step);
 
@@ -452,6 +585,34 @@ void MCWorld::stepTime(int step)
 
     // Remove objects that are marked to be removed
     processRemovedObjects();
+
+    // All contacts have been consumed by now
+    m_collisionDetector->releaseContacts();
+    m_frameArena->reset();
+
+    m_isStepping = false;
+
+    m_phaseTimes.steps++;
+}
+
+unsigned int MCWorld::stepCount() const
+{
+    return m_stepCount;
+}
+
+bool MCWorld::isStepping() const
+{
+    return m_isStepping;
+}
+
+void MCWorld::setRenderInterpolation(float alpha)
+{
+    m_renderInterpolation = std::min(std::max(alpha, 0.0f), 1.0f);
+}
+
+float MCWorld::renderInterpolation() const
+{
+    return m_renderInterpolation;
 }
 
 MCWorld::ObjectVector MCWorld::objects() const
@@ -483,33 +644,55 @@ const MCVector3dF & MCWorld::gravity() const
 
 void MCWorld::setMetersPerUnit(float value)
 {
-    MCWorld::m_metersPerUnit        = value;
-    MCWorld::m_metersPerUnitSquared = value * value;
+    m_metersPerUnit = value;
 }
 
-float MCWorld::metersPerUnit()
+float MCWorld::metersPerUnit() const
 {
-    assert(MCWorld::m_instance);
-    return MCWorld::m_metersPerUnit;
+    return m_metersPerUnit;
 }
 
-void MCWorld::toMeters(float & units)
+void MCWorld::toMeters(float & units) const
 {
-    units *= MCWorld::m_metersPerUnit;
+    units *= m_metersPerUnit;
 }
 
-void MCWorld::toMeters(MCVector2dF & units)
+void MCWorld::toMeters(MCVector2dF & units) const
 {
-    units *= MCWorld::m_metersPerUnit;
+    units *= m_metersPerUnit;
 }
 
-void MCWorld::toMeters(MCVector3dF & units)
+void MCWorld::toMeters(MCVector3dF & units) const
 {
-    units *= MCWorld::m_metersPerUnit;
+    units *= m_metersPerUnit;
 }
 
 void MCWorld::setResolverLoopCount(unsigned int resolverLoopCount)
 {
-    m_resolverLoopCount = resolverLoopCount;
-    m_resolverStep = 1.0f / resolverLoopCount;
+    m_resolverLoopCount = std::max(resolverLoopCount, 1u);
+}
+
+void MCWorld::setResolverTolerance(float resolverTolerance)
+{
+    m_resolverTolerance = resolverTolerance;
+}
+
+void MCWorld::enableBatchedIntegration(bool enable)
+{
+    m_isBatchedIntegrationEnabled = enable;
+}
+
+const MCWorld::PhaseTimes & MCWorld::phaseTimes() const
+{
+    return m_phaseTimes;
+}
+
+void MCWorld::resetPhaseTimes()
+{
+    m_phaseTimes = PhaseTimes();
+}
+
+void MCWorld::setCollisionDetectionThreadCount(unsigned int threadCount)
+{
+    m_collisionDetector->setThreadCount(threadCount);
 }
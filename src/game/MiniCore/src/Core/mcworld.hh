@@ -30,10 +30,15 @@
 class MCCamera;
 class MCCollisionDetector;
 class MCContact;
+class MCContactCache;
 class MCForceRegistry;
+class MCFrameArena;
 class MCImpulseGenerator;
 class MCObject;
 class MCObjectGrid;
+class MCParticleSystem;
+class MCRigidBodyStore;
+class MCSleepIslands;
 class MCWorldRenderer;
 
 /*! \class World base class.
@@ -47,6 +52,13 @@ class MCWorldRenderer;
  * move on the XY-plane. Direction of the gravity can be freely set.
  *
  * MCWorld uses MCWorldRenderer to render the scene.
+ *
+ * Any number of worlds can exist at the same time and an object can belong
+ * to one world at a time. Each world has its own objects, physics and collision
+ * state. The state shared by all worlds, i.e. MCRandom, the timer event
+ * subscriptions of MCObject and the type registries, is thread-safe, so separate
+ * worlds can be stepped in parallel in different threads. Rendering must still
+ * happen in the thread that owns the GL context.
  */
 class MCWorld
 {
@@ -54,17 +66,37 @@ public:
 
     typedef std::vector<MCObject *> ObjectVector;
 
+    typedef std::vector<MCParticleSystem *> ParticleSystemVector;
+
+    //! Accumulated wall-clock times of the phases of stepTime() in microseconds.
+    struct PhaseTimes
+    {
+        PhaseTimes();
+
+        double forceRegistry;
+
+        double integrate;
+
+        double broadPhase;
+
+        double narrowPhase;
+
+        double impulses;
+
+        double resolve;
+
+        double particles;
+
+        //! Number of steps the times are accumulated over.
+        unsigned int steps;
+    };
+
     //! Constructor.
     MCWorld();
 
     //! Destructor.
     virtual ~MCWorld();
 
-    //! Return the one-and-only MCWorld instance.
-    static MCWorld & instance();
-
-    static bool hasInstance();
-
     //! Remove all objects.
     void clear();
 
@@ -96,19 +128,19 @@ public:
     const MCVector3dF & gravity() const;
 
     //! Set how many meters equal one unit in the scene.
-    static void setMetersPerUnit(float value);
+    void setMetersPerUnit(float value);
 
     //! Get how many meters equal one unit in the scene.
-    static float metersPerUnit();
+    float metersPerUnit() const;
 
     //! Convert scene units to meters.
-    static void toMeters(float & units);
+    void toMeters(float & units) const;
 
     //! Convert scene units to meters.
-    static void toMeters(MCVector2dF & units);
+    void toMeters(MCVector2dF & units) const;
 
     //! Convert scene units to meters.
-    static void toMeters(MCVector3dF & units);
+    void toMeters(MCVector3dF & units) const;
 
     /*! Add object to the world. Object's current location is used.
      *  \param object Object to be added. */
@@ -126,6 +158,17 @@ public:
      *  \param object Object to be removed. */
     void removeObjectNow(MCObject & object);
 
+    /*! Add a particle system to the world. The system is stepped before the objects
+     *  on each call to stepTime() and rendered by MCWorldRenderer. The world doesn't
+     *  take the ownership. A system can belong to one world at a time. */
+    void addParticleSystem(MCParticleSystem & particleSystem);
+
+    //! Remove a particle system from the world. Its particles are not removed.
+    void removeParticleSystem(MCParticleSystem & particleSystem);
+
+    //! \return The particle systems in the order they were added in.
+    const ParticleSystemVector & particleSystems() const;
+
     //! Stop integrating the given object.
     void removeObjectFromIntegration(MCObject & object);
 
@@ -140,6 +183,23 @@ public:
      *  \param step Time step to be updated in msecs. */
     void stepTime(int step);
 
+    //! \return Number of steps taken. The step being run counts during stepTime().
+    unsigned int stepCount() const;
+
+    //! \return true while stepTime() is running.
+    bool isStepping() const;
+
+    /*! \brief Set the point between the two latest steps that is rendered.
+     *  Objects that moved during the latest step are drawn at their previous pose
+     *  blended towards the current one by the given amount. This allows rendering at
+     *  a higher rate than the physics is stepped at. Moves done outside stepTime()
+     *  are not interpolated. The default is 1.0, which renders the current poses.
+     *  \param alpha Blend factor [0.0, 1.0]. */
+    void setRenderInterpolation(float alpha);
+
+    //! \return The current render interpolation factor.
+    float renderInterpolation() const;
+
     /*! \brief Call this (once) before calling render() or renderShadows().
      *  \param camera The camera window to be used. If nullptr, then
      *         no any translations or clipping done. */
@@ -180,6 +240,26 @@ public:
      *  Lower loop count results in faster collision calculations, but lower accuracy. */
     void setResolverLoopCount(unsigned int resolverLoopCount = 5);
 
+    /*! \brief Set the interpenetration depth the collision resolver accepts.
+     *  The resolver stops iterating when all contacts are within the tolerance. */
+    void setResolverTolerance(float resolverTolerance = 0.01f);
+
+    /*! \brief Set the number of threads used in the narrow phase of the collision detection.
+     *  The default is 1. The results don't depend on the thread count. */
+    void setCollisionDetectionThreadCount(unsigned int threadCount = 1);
+
+    /*! \brief Integrate the awake bodies in batches using a structure-of-arrays store.
+     *  This scales better with many moving objects, e.g. particles. All bodies
+     *  are integrated before MCObject::onStepTime() is called for any object.
+     *  The default is false. */
+    void enableBatchedIntegration(bool enable);
+
+    //! \return Accumulated phase times since construction or the previous call to resetPhaseTimes().
+    const PhaseTimes & phaseTimes() const;
+
+    //! Reset the accumulated phase times.
+    void resetPhaseTimes();
+
 protected:
 
     //! Get registered objects
@@ -192,6 +272,10 @@ private:
 
     void integrate(int step);
 
+    void stepParticleSystems(int step);
+
+    void integrateBatched(int step);
+
     void processRemovedObjects();
 
     void processCollisions();
@@ -202,25 +286,30 @@ private:
 
     void generateImpulses();
 
-    void resolvePositions(float accuracy);
+    void resolvePositions();
 
     MCContact * getDeepestInterpenetration(const std::vector<MCContact *> & contacts);
 
-    static MCWorld * m_instance;
-
     MCWorldRenderer * m_renderer;
 
     MCForceRegistry * m_forceRegistry;
 
+    //! Backs the contacts and contact lists of the current step. Reset at the end of each step.
+    MCFrameArena * m_frameArena;
+
     MCCollisionDetector * m_collisionDetector;
 
     MCImpulseGenerator * m_impulseGenerator;
 
+    MCContactCache * m_contactCache;
+
     MCObjectGrid * m_objectGrid;
 
-    static float m_metersPerUnit;
+    MCRigidBodyStore * m_rigidBodyStore;
+
+    MCSleepIslands * m_sleepIslands;
 
-    static float m_metersPerUnitSquared;
+    float m_metersPerUnit;
 
     float m_minX, m_maxX, m_minY, m_maxY, m_minZ, m_maxZ;
 
@@ -228,6 +317,8 @@ private:
 
     MCWorld::ObjectVector m_removeObjs;
 
+    ParticleSystemVector m_particleSystems;
+
     MCObject * m_leftWallObject;
 
     MCObject * m_rightWallObject;
@@ -240,7 +331,17 @@ private:
 
     unsigned int m_resolverLoopCount;
 
-    float m_resolverStep;
+    float m_resolverTolerance;
+
+    bool m_isBatchedIntegrationEnabled;
+
+    unsigned int m_stepCount;
+
+    bool m_isStepping;
+
+    float m_renderInterpolation;
+
+    PhaseTimes m_phaseTimes;
 
     MCVector3dF m_gravity;
 };
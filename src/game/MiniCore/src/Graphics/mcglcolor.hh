@@ -71,6 +71,16 @@ public:
         m_a = a;
     }
 
+    inline bool operator==(const MCGLColor & other) const
+    {
+        return m_r == other.m_r && m_g == other.m_g && m_b == other.m_b && m_a == other.m_a;
+    }
+
+    inline bool operator!=(const MCGLColor & other) const
+    {
+        return !(*this == other);
+    }
+
 private:
 
     GLfloat m_r, m_g, m_b, m_a;
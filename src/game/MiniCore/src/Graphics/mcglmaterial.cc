@@ -18,6 +18,8 @@
 //
 
 #include "mcglmaterial.hh"
+#include "mcglstate.hh"
+
 #include <cassert>
 
 MCGLMaterial::MCGLMaterial()
@@ -76,12 +78,31 @@ void MCGLMaterial::doAlphaBlend()
 {
     if (m_useAlphaBlend)
     {
-        glEnable(GL_BLEND);
-        glBlendFunc(m_src, m_dst);
+        MCGLState::enableBlend(m_src, m_dst);
     }
     else
     {
-        glDisable(GL_BLEND);
+        MCGLState::disableBlend();
+    }
+}
+
+bool MCGLMaterial::operator==(const MCGLMaterial & other) const
+{
+    for (unsigned int i = 0; i < MAX_TEXTURES; i++)
+    {
+        if (m_textures[i] != other.m_textures[i])
+        {
+            return false;
+        }
     }
+
+    return m_specularCoeff == other.m_specularCoeff &&
+        m_diffuseCoeff == other.m_diffuseCoeff &&
+        m_useAlphaBlend == other.m_useAlphaBlend &&
+        (!m_useAlphaBlend || (m_src == other.m_src && m_dst == other.m_dst));
 }
 
+bool MCGLMaterial::operator!=(const MCGLMaterial & other) const
+{
+    return !(*this == other);
+}
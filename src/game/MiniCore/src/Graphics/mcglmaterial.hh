@@ -63,6 +63,11 @@ public:
      *  handle and wants to run the configured alpha blending. */
     void doAlphaBlend();
 
+    //! \return true if the materials have the same textures and settings.
+    bool operator==(const MCGLMaterial & other) const;
+
+    bool operator!=(const MCGLMaterial & other) const;
+
 private:
 
     GLuint m_textures[MAX_TEXTURES];
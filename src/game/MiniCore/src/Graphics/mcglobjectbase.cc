@@ -21,13 +21,12 @@
 
 #include "mccamera.hh"
 #include "mcglscene.hh"
+#include "mcglstate.hh"
 #include "mclogger.hh"
 
 #include <cassert>
 #include <exception>
 
-GLuint MCGLObjectBase::m_boundVbo = 0;
-
 MCGLObjectBase::MCGLObjectBase(std::string handle)
     : m_handle(handle)
     , m_program(MCGLScene::instance().defaultShaderProgram())
@@ -65,33 +64,45 @@ void MCGLObjectBase::bindVAO()
 #ifdef __MC_QOPENGLFUNCTIONS__
     if (m_hasVao)
     {
-        m_vao.bind();
+        if (MCGLState::bindVertexArray(m_vao.objectId()))
+        {
+            m_vao.bind();
+        }
     }
     else
     {
         setAttributePointers();
     }
 #else
-    glBindVertexArray(m_vao);
+    if (MCGLState::bindVertexArray(m_vao))
+    {
+        glBindVertexArray(m_vao);
+    }
 #endif
 }
 
 void MCGLObjectBase::releaseVAO()
 {
 #ifdef __MC_QOPENGLFUNCTIONS__
-    if (m_hasVao)
+    if (m_hasVao && MCGLState::bindVertexArray(0))
     {
         m_vao.release();
     }
 #else
-    glBindVertexArray(0);
+    if (MCGLState::bindVertexArray(0))
+    {
+        glBindVertexArray(0);
+    }
 #endif
 }
 
 bool MCGLObjectBase::createVAO()
 {
 #ifdef __MC_QOPENGLFUNCTIONS__
-    m_hasVao = m_vao.create();
+    if (!m_vao.isCreated())
+    {
+        m_hasVao = m_vao.create();
+    }
     return m_hasVao;
 #else
     if (m_vao == 0)
@@ -104,14 +115,18 @@ bool MCGLObjectBase::createVAO()
 
 void MCGLObjectBase::bindVBO()
 {
-    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-    MCGLObjectBase::m_boundVbo = m_vbo;
+    if (MCGLState::bindArrayBuffer(m_vbo))
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    }
 }
 
 void MCGLObjectBase::releaseVBO()
 {
-    MCGLObjectBase::m_boundVbo = 0;
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    if (MCGLState::bindArrayBuffer(0))
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
 }
 
 void MCGLObjectBase::createVBO()
@@ -491,12 +506,19 @@ MCGLObjectBase::~MCGLObjectBase()
 {
     if (m_vbo != 0)
     {
+        MCGLState::bufferDeleted(m_vbo);
         glDeleteBuffers(1, &m_vbo);
         m_vbo = 0;
     }
-#ifndef __MC_QOPENGLFUNCTIONS__
+#ifdef __MC_QOPENGLFUNCTIONS__
+    if (m_hasVao)
+    {
+        MCGLState::vertexArrayDeleted(m_vao.objectId());
+    }
+#else
     if (m_vao != 0)
     {
+        MCGLState::vertexArrayDeleted(m_vao);
         glDeleteVertexArrays(1, &m_vao);
         m_vao = 0;
     }
@@ -224,8 +224,6 @@ protected:
 
 private:
 
-    static GLuint m_boundVbo;
-
     std::string m_handle;
 
 #ifdef __MC_QOPENGLFUNCTIONS__
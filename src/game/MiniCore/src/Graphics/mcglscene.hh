@@ -87,6 +87,12 @@ public:
     //! \return default shadow shader program.
     MCGLShaderProgramPtr defaultShadowShaderProgram();
 
+    //! \return default shader program for particles expanded in the vertex shader.
+    MCGLShaderProgramPtr defaultParticleShaderProgram();
+
+    //! \return default shadow shader program for particles expanded in the vertex shader.
+    MCGLShaderProgramPtr defaultParticleShadowShaderProgram();
+
     //! \return default shader program for text.
     MCGLShaderProgramPtr defaultTextShaderProgram();
 
@@ -158,6 +164,10 @@ private:
 
     MCGLShaderProgramPtr m_defaultShadowShader;
 
+    MCGLShaderProgramPtr m_defaultParticleShader;
+
+    MCGLShaderProgramPtr m_defaultParticleShadowShader;
+
     MCGLShaderProgramPtr m_defaultTextShader;
 
     MCGLShaderProgramPtr m_defaultTextShadowShader;
@@ -19,6 +19,7 @@
 
 #include "mcglshaderprogram.hh"
 #include "mcglscene.hh"
+#include "mcglstate.hh"
 
 #ifdef __MC_GLES__
 #include "mcshadersGLES.hh"
@@ -31,9 +32,34 @@
 #include <MCLogger>
 #include <MCTrigonom>
 
+#include <algorithm>
 #include <cassert>
 #include <exception>
 
+// Uniform names used in the shaders in the order of MCGLShaderProgram::Uniform
+static const char * UNIFORM_NAMES[] =
+{
+    "ac",
+    "camera",
+    "color",
+    "dd",
+    "dc",
+    "fade",
+    "dCoeff",
+    "sCoeff",
+    "tex0",
+    "tex1",
+    "tex2",
+    "model",
+    "scale",
+    "sd",
+    "sc",
+    "vp",
+    "v",
+    "userData1",
+    "userData2"
+};
+
 MCGLShaderProgram * MCGLShaderProgram::m_activeProgram = nullptr;
 
 std::vector<MCGLShaderProgram *> MCGLShaderProgram::m_programStack;
@@ -49,7 +75,8 @@ MCGLShaderProgram::MCGLShaderProgram()
 #ifdef __MC_QOPENGLFUNCTIONS__
     initializeOpenGLFunctions();
 #endif
-    initUniformNameMap();
+    std::fill(m_uniformLocations, m_uniformLocations + UniformCount, -1);
+    invalidateUniformValues();
 
     m_program = glCreateProgram();
     m_fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
@@ -68,7 +95,8 @@ MCGLShaderProgram::MCGLShaderProgram(
 #ifdef __MC_QOPENGLFUNCTIONS__
     initializeOpenGLFunctions();
 #endif
-    initUniformNameMap();
+    std::fill(m_uniformLocations, m_uniformLocations + UniformCount, -1);
+    invalidateUniformValues();
 
     m_program = glCreateProgram();
     m_fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
@@ -79,58 +107,74 @@ MCGLShaderProgram::MCGLShaderProgram(
     link();
 }
 
-void MCGLShaderProgram::initUniformNameMap()
-{
-    // Map uniform enums to uniform names used in the shaders
-    m_uniforms[AmbientLightColor] = "ac";
-    m_uniforms[Camera] = "camera";
-    m_uniforms[Color] = "color";
-    m_uniforms[DiffuseLightDir] = "dd";
-    m_uniforms[DiffuseLightColor] = "dc";
-    m_uniforms[FadeValue] = "fade";
-    m_uniforms[MaterialDiffuseCoeff] = "dCoeff";
-    m_uniforms[MaterialSpecularCoeff] = "sCoeff";
-    m_uniforms[MaterialTex0] = "tex0";
-    m_uniforms[MaterialTex1] = "tex1";
-    m_uniforms[MaterialTex2] = "tex2";
-    m_uniforms[Model] = "model";
-    m_uniforms[Scale] = "scale";
-    m_uniforms[SpecularLightDir] = "sd";
-    m_uniforms[SpecularLightColor] = "sc";
-    m_uniforms[UserData1] = "userData1";
-    m_uniforms[UserData2] = "userData2";
-    m_uniforms[ViewProjection] = "vp";
-    m_uniforms[View] = "v";
-}
-
 MCGLShaderProgram::~MCGLShaderProgram()
 {
+    if (MCGLShaderProgram::m_activeProgram == this)
+    {
+        MCGLShaderProgram::m_activeProgram = nullptr;
+    }
+
+    MCGLState::programDeleted(m_program);
+
     glDeleteProgram(m_program);
     glDeleteShader(m_vertexShader);
     glDeleteShader(m_fragmentShader);
 }
 
-int MCGLShaderProgram::getUniformLocation(Uniform uniform)
+int MCGLShaderProgram::getUniformLocation(Uniform uniform) const
 {
-    return m_uniformLocationHash[uniform];
+    return m_uniformLocations[uniform];
 }
 
 void MCGLShaderProgram::initUniformLocationCache()
 {
     assert(isLinked());
 
-    auto iter = m_uniforms.begin();
-    while (iter != m_uniforms.end())
+    static_assert(sizeof(UNIFORM_NAMES) / sizeof(UNIFORM_NAMES[0]) == UniformCount, "Uniform name missing");
+
+    for (int uniform = 0; uniform < UniformCount; uniform++)
     {
-        m_uniformLocationHash[iter->first] = glGetUniformLocation(m_program, iter->second.c_str());
-        iter++;
+        m_uniformLocations[uniform] = glGetUniformLocation(m_program, UNIFORM_NAMES[uniform]);
     }
+
+    invalidateUniformValues();
+}
+
+void MCGLShaderProgram::invalidateUniformValues()
+{
+    for (auto && value : m_uniformValues)
+    {
+        value.isSet = false;
+    }
+}
+
+bool MCGLShaderProgram::updateUniform(Uniform uniform, GLfloat x, GLfloat y, GLfloat z, GLfloat w)
+{
+    if (m_uniformLocations[uniform] == -1)
+    {
+        return false;
+    }
+
+    UniformValue & current = m_uniformValues[uniform];
+    if (current.isSet &&
+        current.values[0] == x && current.values[1] == y && current.values[2] == z && current.values[3] == w)
+    {
+        MCGLState::addRedundantCall();
+        return false;
+    }
+
+    current = {{x, y, z, w}, true};
+    return true;
 }
 
 void MCGLShaderProgram::bind()
 {
     MCGLShaderProgram::m_activeProgram = this;
-    glUseProgram(m_program);
+
+    if (MCGLState::useProgram(m_program))
+    {
+        glUseProgram(m_program);
+    }
 
     setPendingAmbientLight();
     setPendingDiffuseLight();
@@ -259,6 +303,16 @@ const char * MCGLShaderProgram::getDefaultShadowFragmentShaderSource()
     return MCDefaultShadowFsh;
 }
 
+const char * MCGLShaderProgram::getDefaultParticleVertexShaderSource()
+{
+    return MCDefaultParticleVsh;
+}
+
+const char * MCGLShaderProgram::getDefaultParticleShadowVertexShaderSource()
+{
+    return MCDefaultParticleShadowVsh;
+}
+
 const char * MCGLShaderProgram::getDefaultTextVertexShaderSource()
 {
     return MCDefaultTextVsh;
@@ -342,34 +396,53 @@ void MCGLShaderProgram::setPendingViewMatrix()
 
 void MCGLShaderProgram::setTransform(GLfloat angle, const MCVector3dF & pos)
 {
-    glm::mat4 translate = glm::translate(glm::mat4(1.0f), glm::vec3(pos.i(), pos.j(), pos.k()));
-    glm::mat4 rotation  = glm::rotate(translate, angle, glm::vec3(0.0f, 0.0f, 1.0f));
-    glUniformMatrix4fv(getUniformLocation(Model), 1, GL_FALSE, &rotation[0][0]);
+    // The model matrix is cached as the angle and the position it's made of
+    if (updateUniform(Model, angle, pos.i(), pos.j(), pos.k()))
+    {
+        glm::mat4 translate = glm::translate(glm::mat4(1.0f), glm::vec3(pos.i(), pos.j(), pos.k()));
+        glm::mat4 rotation  = glm::rotate(translate, angle, glm::vec3(0.0f, 0.0f, 1.0f));
+        glUniformMatrix4fv(getUniformLocation(Model), 1, GL_FALSE, &rotation[0][0]);
+    }
 }
 
 void MCGLShaderProgram::setUserData1(const MCVector2dF & data)
 {
-    glUniform2f(getUniformLocation(UserData1), data.i(), data.j());
+    if (updateUniform(UserData1, data.i(), data.j()))
+    {
+        glUniform2f(getUniformLocation(UserData1), data.i(), data.j());
+    }
 }
 
 void MCGLShaderProgram::setUserData2(const MCVector2dF & data)
 {
-    glUniform2f(getUniformLocation(UserData2), data.i(), data.j());
+    if (updateUniform(UserData2, data.i(), data.j()))
+    {
+        glUniform2f(getUniformLocation(UserData2), data.i(), data.j());
+    }
 }
 
 void MCGLShaderProgram::setCamera(const MCVector2dF & camera)
 {
-    glUniform2f(getUniformLocation(Camera), camera.i(), camera.j());
+    if (updateUniform(Camera, camera.i(), camera.j()))
+    {
+        glUniform2f(getUniformLocation(Camera), camera.i(), camera.j());
+    }
 }
 
 void MCGLShaderProgram::setColor(const MCGLColor & color)
 {
-    glUniform4f(getUniformLocation(Color), color.r(), color.g(), color.b(), color.a());
+    if (updateUniform(Color, color.r(), color.g(), color.b(), color.a()))
+    {
+        glUniform4f(getUniformLocation(Color), color.r(), color.g(), color.b(), color.a());
+    }
 }
 
 void MCGLShaderProgram::setScale(GLfloat x, GLfloat y, GLfloat z)
 {
-    glUniform4f(getUniformLocation(Scale), x, y, z, 1);
+    if (updateUniform(Scale, x, y, z, 1))
+    {
+        glUniform4f(getUniformLocation(Scale), x, y, z, 1);
+    }
 }
 
 void MCGLShaderProgram::setFadeValue(GLfloat value)
@@ -391,12 +464,17 @@ void MCGLShaderProgram::setPendingDiffuseLight()
 {
     if (m_diffuseLightPending) {
         m_diffuseLightPending = false;
-        glUniform4f(
-            getUniformLocation(DiffuseLightDir),
-                m_diffuseLight.direction().i(), m_diffuseLight.direction().j(), m_diffuseLight.direction().k(), 1);
-        glUniform4f(
-            getUniformLocation(DiffuseLightColor),
-                m_diffuseLight.r(), m_diffuseLight.g(), m_diffuseLight.b(), m_diffuseLight.i());
+
+        const MCVector3dF & direction = m_diffuseLight.direction();
+        if (updateUniform(DiffuseLightDir, direction.i(), direction.j(), direction.k(), 1)) {
+            glUniform4f(getUniformLocation(DiffuseLightDir), direction.i(), direction.j(), direction.k(), 1);
+        }
+
+        if (updateUniform(DiffuseLightColor, m_diffuseLight.r(), m_diffuseLight.g(), m_diffuseLight.b(), m_diffuseLight.i())) {
+            glUniform4f(
+                getUniformLocation(DiffuseLightColor),
+                    m_diffuseLight.r(), m_diffuseLight.g(), m_diffuseLight.b(), m_diffuseLight.i());
+        }
     }
 }
 
@@ -414,12 +492,17 @@ void MCGLShaderProgram::setPendingSpecularLight()
 {
     if (m_specularLightPending) {
         m_specularLightPending = false;
-        glUniform4f(
-            getUniformLocation(SpecularLightDir),
-                m_specularLight.direction().i(), m_specularLight.direction().j(), m_specularLight.direction().k(), 1);
-        glUniform4f(
-            getUniformLocation(SpecularLightColor),
-                m_specularLight.r(), m_specularLight.g(), m_specularLight.b(), m_specularLight.i());
+
+        const MCVector3dF & direction = m_specularLight.direction();
+        if (updateUniform(SpecularLightDir, direction.i(), direction.j(), direction.k(), 1)) {
+            glUniform4f(getUniformLocation(SpecularLightDir), direction.i(), direction.j(), direction.k(), 1);
+        }
+
+        if (updateUniform(SpecularLightColor, m_specularLight.r(), m_specularLight.g(), m_specularLight.b(), m_specularLight.i())) {
+            glUniform4f(
+                getUniformLocation(SpecularLightColor),
+                    m_specularLight.r(), m_specularLight.g(), m_specularLight.b(), m_specularLight.i());
+        }
     }
 }
 
@@ -437,9 +520,12 @@ void MCGLShaderProgram::setPendingAmbientLight()
 {
     if (m_ambientLightPending) {
         m_ambientLightPending = false;
-        glUniform4f(
-            getUniformLocation(AmbientLightColor),
-                m_ambientLight.r(), m_ambientLight.g(), m_ambientLight.b(), m_ambientLight.i());
+
+        if (updateUniform(AmbientLightColor, m_ambientLight.r(), m_ambientLight.g(), m_ambientLight.b(), m_ambientLight.i())) {
+            glUniform4f(
+                getUniformLocation(AmbientLightColor),
+                    m_ambientLight.r(), m_ambientLight.g(), m_ambientLight.b(), m_ambientLight.i());
+        }
     }
 }
 
@@ -458,19 +544,32 @@ void MCGLShaderProgram::bindMaterial(MCGLMaterialPtr material)
 
     material->doAlphaBlend();
 
-    const GLuint texture1 = material->texture(0);
-    const GLuint texture2 = material->texture(1);
-    const GLuint texture3 = material->texture(2);
+    for (GLuint unit = 0; unit < MCGLMaterial::MAX_TEXTURES; unit++)
+    {
+        const GLuint texture = material->texture(unit);
+        if (MCGLState::bindTexture(unit, texture))
+        {
+            if (MCGLState::activeTexture(unit))
+            {
+                glActiveTexture(GL_TEXTURE0 + unit);
+            }
+
+            glBindTexture(GL_TEXTURE_2D, texture);
+        }
+    }
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, texture1);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, texture2);
-    glActiveTexture(GL_TEXTURE2);
-    glBindTexture(GL_TEXTURE_2D, texture3);
+    if (MCGLState::activeTexture(0))
+    {
+        glActiveTexture(GL_TEXTURE0);
+    }
 
-    glActiveTexture(GL_TEXTURE0);
+    if (updateUniform(MaterialSpecularCoeff, material->specularCoeff()))
+    {
+        glUniform1f(getUniformLocation(MaterialSpecularCoeff), material->specularCoeff());
+    }
 
-    glUniform1f(getUniformLocation(MaterialSpecularCoeff), material->specularCoeff());
-    glUniform1f(getUniformLocation(MaterialDiffuseCoeff), material->diffuseCoeff());
+    if (updateUniform(MaterialDiffuseCoeff, material->diffuseCoeff()))
+    {
+        glUniform1f(getUniformLocation(MaterialDiffuseCoeff), material->diffuseCoeff());
+    }
 }
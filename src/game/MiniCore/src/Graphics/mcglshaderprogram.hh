@@ -31,7 +31,6 @@
 
 #include "mcvector3d.hh"
 
-#include <map>
 #include <memory>
 #include <string>
 #include <vector>
@@ -112,6 +111,12 @@ public:
     /*! Get the default shadow fragment shader source. Defining __MC_GLES__ will select GLES version. */
     static const char * getDefaultShadowFragmentShaderSource();
 
+    /*! Get the default particle vertex shader source. Defining __MC_GLES__ will select GLES version. */
+    static const char * getDefaultParticleVertexShaderSource();
+
+    /*! Get the default particle shadow vertex shader source. Defining __MC_GLES__ will select GLES version. */
+    static const char * getDefaultParticleShadowVertexShaderSource();
+
     /*! Get the default text vertex shader source. Defining __MC_GLES__ will select GLES version. */
     static const char * getDefaultTextVertexShaderSource();
 
@@ -199,6 +204,15 @@ private:
         View,
         UserData1,
         UserData2,
+        UniformCount
+    };
+
+    //! Current value of a uniform as set by this program.
+    struct UniformValue
+    {
+        GLfloat values[4];
+
+        bool isSet;
     };
 
     void bindPendingMaterial();
@@ -207,12 +221,17 @@ private:
 
     std::string getShaderLog(GLuint obj);
 
-    int getUniformLocation(Uniform uniform);
-
-    void initUniformNameMap();
+    int getUniformLocation(Uniform uniform) const;
 
     void initUniformLocationCache();
 
+    void invalidateUniformValues();
+
+    /*! Store the given value as the current value of the uniform.
+     *  \return true if the uniform is used by the program and the value differs from the
+     *  current one, so that the uniform needs to be set. */
+    bool updateUniform(Uniform uniform, GLfloat x, GLfloat y = 0, GLfloat z = 0, GLfloat w = 0);
+
     void setPendingAmbientLight();
 
     void setPendingDiffuseLight();
@@ -227,11 +246,10 @@ private:
 
     static std::vector<MCGLShaderProgram *> m_programStack;
 
-    typedef std::map<Uniform, int> UniformLocationHash;
-    UniformLocationHash m_uniformLocationHash;
+    //! Resolved when linked. -1 if the uniform is not used by the program.
+    int m_uniformLocations[UniformCount];
 
-    typedef std::map<Uniform, std::string> Uniforms;
-    Uniforms m_uniforms;
+    UniformValue m_uniformValues[UniformCount];
 
     MCGLScene & m_scene;
 
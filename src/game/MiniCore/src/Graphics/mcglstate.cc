@@ -0,0 +1,220 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#include "mcglstate.hh"
+
+GLuint MCGLState::m_program = MCGLState::UNKNOWN;
+
+GLuint MCGLState::m_vao = MCGLState::UNKNOWN;
+
+GLuint MCGLState::m_vbo = MCGLState::UNKNOWN;
+
+GLuint MCGLState::m_activeTexture = MCGLState::UNKNOWN;
+
+GLuint MCGLState::m_textures[MCGLState::MAX_TEXTURE_UNITS] =
+{
+    MCGLState::UNKNOWN, MCGLState::UNKNOWN, MCGLState::UNKNOWN, MCGLState::UNKNOWN,
+    MCGLState::UNKNOWN, MCGLState::UNKNOWN, MCGLState::UNKNOWN, MCGLState::UNKNOWN
+};
+
+MCGLState::Capability MCGLState::m_blend = MCGLState::Capability::Unknown;
+
+GLenum MCGLState::m_blendSrc = MCGLState::UNKNOWN;
+
+GLenum MCGLState::m_blendDst = MCGLState::UNKNOWN;
+
+MCGLState::Capability MCGLState::m_depthTest = MCGLState::Capability::Unknown;
+
+MCGLState::Capability MCGLState::m_depthMask = MCGLState::Capability::Unknown;
+
+unsigned int MCGLState::m_redundantCallCount = 0;
+
+bool MCGLState::update(GLuint & current, GLuint value)
+{
+    if (current == value)
+    {
+        m_redundantCallCount++;
+        return false;
+    }
+
+    current = value;
+    return true;
+}
+
+bool MCGLState::update(Capability & current, bool enable)
+{
+    const Capability value = enable ? Capability::Enabled : Capability::Disabled;
+    if (current == value)
+    {
+        m_redundantCallCount++;
+        return false;
+    }
+
+    current = value;
+    return true;
+}
+
+bool MCGLState::useProgram(GLuint program)
+{
+    return update(m_program, program);
+}
+
+bool MCGLState::bindVertexArray(GLuint vao)
+{
+    return update(m_vao, vao);
+}
+
+bool MCGLState::bindArrayBuffer(GLuint vbo)
+{
+    return update(m_vbo, vbo);
+}
+
+bool MCGLState::activeTexture(GLuint unit)
+{
+    return update(m_activeTexture, unit);
+}
+
+bool MCGLState::bindTexture(GLuint unit, GLuint texture)
+{
+    if (unit >= MAX_TEXTURE_UNITS)
+    {
+        return true;
+    }
+
+    return update(m_textures[unit], texture);
+}
+
+void MCGLState::enableBlend(GLenum src, GLenum dst)
+{
+    if (update(m_blend, true))
+    {
+        glEnable(GL_BLEND);
+    }
+
+    if (m_blendSrc != src || m_blendDst != dst)
+    {
+        m_blendSrc = src;
+        m_blendDst = dst;
+        glBlendFunc(src, dst);
+    }
+    else
+    {
+        m_redundantCallCount++;
+    }
+}
+
+void MCGLState::disableBlend()
+{
+    if (update(m_blend, false))
+    {
+        glDisable(GL_BLEND);
+    }
+}
+
+void MCGLState::setDepthTest(bool enable)
+{
+    if (update(m_depthTest, enable))
+    {
+        if (enable)
+        {
+            glEnable(GL_DEPTH_TEST);
+        }
+        else
+        {
+            glDisable(GL_DEPTH_TEST);
+        }
+    }
+}
+
+void MCGLState::setDepthMask(bool enable)
+{
+    if (update(m_depthMask, enable))
+    {
+        glDepthMask(enable ? GL_TRUE : GL_FALSE);
+    }
+}
+
+void MCGLState::programDeleted(GLuint program)
+{
+    if (m_program == program)
+    {
+        m_program = UNKNOWN;
+    }
+}
+
+void MCGLState::vertexArrayDeleted(GLuint vao)
+{
+    if (m_vao == vao)
+    {
+        m_vao = UNKNOWN;
+    }
+}
+
+void MCGLState::bufferDeleted(GLuint vbo)
+{
+    if (m_vbo == vbo)
+    {
+        m_vbo = UNKNOWN;
+    }
+}
+
+void MCGLState::textureDeleted(GLuint texture)
+{
+    for (auto && boundTexture : m_textures)
+    {
+        if (boundTexture == texture)
+        {
+            boundTexture = UNKNOWN;
+        }
+    }
+}
+
+void MCGLState::invalidate()
+{
+    m_program = UNKNOWN;
+    m_vao = UNKNOWN;
+    m_vbo = UNKNOWN;
+    m_activeTexture = UNKNOWN;
+
+    for (auto && texture : m_textures)
+    {
+        texture = UNKNOWN;
+    }
+
+    m_blend = Capability::Unknown;
+    m_blendSrc = UNKNOWN;
+    m_blendDst = UNKNOWN;
+    m_depthTest = Capability::Unknown;
+    m_depthMask = Capability::Unknown;
+}
+
+void MCGLState::addRedundantCall()
+{
+    m_redundantCallCount++;
+}
+
+unsigned int MCGLState::redundantCallCount()
+{
+    return m_redundantCallCount;
+}
+
+void MCGLState::resetRedundantCallCount()
+{
+    m_redundantCallCount = 0;
+}
@@ -0,0 +1,125 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#ifndef MCGLSTATE_HH
+#define MCGLSTATE_HH
+
+#include <MCGLEW>
+
+/*! Shadow copy of the GL state that MiniCore changes when rendering: the program,
+ *  the VAO, the array buffer, the textures, blending and depth testing.
+ *  Redundant changes are skipped and counted.
+ *
+ *  The binding functions only update the shadow copy and return true if the actual
+ *  GL call is needed, because the GL functions are owned by the callers.
+ *  Code that changes this state with direct GL calls (e.g. Qt when creating FBOs)
+ *  must call invalidate() afterwards. */
+class MCGLState
+{
+public:
+
+    //! \return true if the program is not already in use.
+    static bool useProgram(GLuint program);
+
+    //! \return true if the VAO is not already bound.
+    static bool bindVertexArray(GLuint vao);
+
+    //! \return true if the buffer is not already bound to GL_ARRAY_BUFFER.
+    static bool bindArrayBuffer(GLuint vbo);
+
+    //! \return true if the texture unit (0, 1, ...) is not already active.
+    static bool activeTexture(GLuint unit);
+
+    /*! \return true if the texture is not already bound to GL_TEXTURE_2D of the given unit.
+     *  The caller must make the unit active before binding. */
+    static bool bindTexture(GLuint unit, GLuint texture);
+
+    //! Enable blending with the given function.
+    static void enableBlend(GLenum src, GLenum dst);
+
+    static void disableBlend();
+
+    static void setDepthTest(bool enable);
+
+    static void setDepthMask(bool enable);
+
+    //! Forget a deleted program, so that a new program with the same name gets bound.
+    static void programDeleted(GLuint program);
+
+    //! Forget a deleted VAO, so that a new VAO with the same name gets bound.
+    static void vertexArrayDeleted(GLuint vao);
+
+    //! Forget a deleted buffer, so that a new buffer with the same name gets bound.
+    static void bufferDeleted(GLuint vbo);
+
+    //! Forget a deleted texture, so that a new texture with the same name gets bound.
+    static void textureDeleted(GLuint texture);
+
+    //! Forget the whole state. The next changes will be made unconditionally.
+    static void invalidate();
+
+    //! Count a GL call that was skipped, because it wouldn't have changed anything.
+    static void addRedundantCall();
+
+    //! \return number of skipped GL calls since the last reset.
+    static unsigned int redundantCallCount();
+
+    static void resetRedundantCallCount();
+
+private:
+
+    static const GLuint UNKNOWN = static_cast<GLuint>(-1);
+
+    static const GLuint MAX_TEXTURE_UNITS = 8;
+
+    enum class Capability
+    {
+        Unknown,
+        Enabled,
+        Disabled
+    };
+
+    static bool update(GLuint & current, GLuint value);
+
+    static bool update(Capability & current, bool enable);
+
+    static GLuint m_program;
+
+    static GLuint m_vao;
+
+    static GLuint m_vbo;
+
+    static GLuint m_activeTexture;
+
+    static GLuint m_textures[MAX_TEXTURE_UNITS];
+
+    static Capability m_blend;
+
+    static GLenum m_blendSrc;
+
+    static GLenum m_blendDst;
+
+    static Capability m_depthTest;
+
+    static Capability m_depthMask;
+
+    static unsigned int m_redundantCallCount;
+};
+
+#endif // MCGLSTATE_HH
@@ -55,6 +55,9 @@ public:
     //! \return True if shadow needs to be rendered
     bool hasShadow() const;
 
+    //! \return Max number of objects that a batch can have.
+    int maxBatchSize() const;
+
 protected:
 
     //! Set current batch size
@@ -63,8 +66,6 @@ protected:
     //! Get current batch size
     int batchSize() const;
 
-    //! Set max batch size
-    int maxBatchSize() const;
 
     bool useAlphaBlend() const;
 
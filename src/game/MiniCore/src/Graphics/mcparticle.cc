@@ -20,7 +20,7 @@
 #include "mcparticle.hh"
 #include "mccircleshape.hh"
 
-int MCParticle::m_numActiveParticles = 0;
+std::atomic<int> MCParticle::m_numActiveParticles(0);
 
 MCParticle::MCParticle(const std::string & typeId)
 : MCObject(typeId)
@@ -24,6 +24,7 @@
 #include "mcrecycler.hh"
 #include "mcworldrenderer.hh"
 
+#include <atomic>
 #include <functional>
 #include <vector>
 
@@ -128,7 +129,8 @@ protected:
 
 private:
 
-    static int m_numActiveParticles;
+    //! Shared by all worlds.
+    static std::atomic<int> m_numActiveParticles;
 
     DISABLE_COPY(MCParticle);
     DISABLE_ASSI(MCParticle);
@@ -29,6 +29,8 @@
 
 #include <memory>
 
+class MCParticleSystem;
+
 class MCParticleRendererBase : public MCGLObjectBase
 {
 public:
@@ -43,6 +45,12 @@ public:
     typedef std::vector<MCObject *> ParticleVector;
     virtual void setBatch(MCRenderLayer::ObjectBatch & batch, MCCamera * camera = nullptr, bool isShadow = false) = 0;
 
+    /*! Populate the current batch with particles of a particle system.
+     *  \param indices Indices of the particles in rendering order.
+     *  \param count Number of indices. At most maxBatchSize() particles are taken. */
+    virtual void setBatch(
+        MCParticleSystem & particleSystem, const unsigned int * indices, int count, MCCamera * camera = nullptr, bool isShadow = false) = 0;
+
     //! Render the current particle batch.
     virtual void render() = 0;
 
@@ -58,6 +66,9 @@ public:
     //! \return True if shadow needs to be rendered
     bool hasShadow() const;
 
+    //! Get max batch size
+    int maxBatchSize() const;
+
 protected:
 
     //! Set current batch size
@@ -66,9 +77,6 @@ protected:
     //! Get current batch size
     int batchSize() const;
 
-    //! Set max batch size
-    int maxBatchSize() const;
-
     bool useAlphaBlend() const;
 
     GLenum alphaSrc() const;
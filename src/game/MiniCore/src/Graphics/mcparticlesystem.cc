@@ -0,0 +1,325 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#include "mcparticlesystem.hh"
+
+#include "mcprofiler.hh"
+#include "mcshape.hh"
+#include "mcworld.hh"
+
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+MCParticleSystem::MCParticleSystem(unsigned int capacity)
+    : m_count(0)
+    , m_capacity(capacity)
+    , m_x(capacity)
+    , m_y(capacity)
+    , m_z(capacity)
+    , m_previousX(capacity)
+    , m_previousY(capacity)
+    , m_previousZ(capacity)
+    , m_velocityX(capacity)
+    , m_velocityY(capacity)
+    , m_velocityZ(capacity)
+    , m_angle(capacity)
+    , m_previousAngle(capacity)
+    , m_angularVelocity(capacity)
+    , m_radius(capacity)
+    , m_age(capacity)
+    , m_lifeTime(capacity)
+    , m_color(capacity)
+    , m_surface(nullptr)
+    , m_useAlphaBlend(false)
+    , m_src(GL_SRC_ALPHA)
+    , m_dst(GL_ONE_MINUS_SRC_ALPHA)
+    , m_hasShadow(false)
+    , m_shadowOffset(MCShape::defaultShadowOffset())
+    , m_animationStyle(MCParticle::AnimationStyle::None)
+    , m_damping(0.999f)
+    , m_dieWhenOffScreen(true)
+    , m_world(nullptr)
+{
+}
+
+MCParticleSystem::~MCParticleSystem()
+{
+    if (m_world)
+    {
+        m_world->removeParticleSystem(*this);
+    }
+}
+
+void MCParticleSystem::setSurface(MCSurface & surface)
+{
+    m_surface = &surface;
+}
+
+MCSurface * MCParticleSystem::surface() const
+{
+    return m_surface;
+}
+
+void MCParticleSystem::setAlphaBlend(bool useAlphaBlend, GLenum src, GLenum dst)
+{
+    m_useAlphaBlend = useAlphaBlend;
+    m_src = src;
+    m_dst = dst;
+}
+
+bool MCParticleSystem::useAlphaBlend() const
+{
+    return m_useAlphaBlend;
+}
+
+GLenum MCParticleSystem::alphaSrc() const
+{
+    return m_src;
+}
+
+GLenum MCParticleSystem::alphaDst() const
+{
+    return m_dst;
+}
+
+void MCParticleSystem::setHasShadow(bool hasShadow)
+{
+    m_hasShadow = hasShadow;
+}
+
+bool MCParticleSystem::hasShadow() const
+{
+    return m_hasShadow;
+}
+
+void MCParticleSystem::setShadowOffset(MCVector3dFR shadowOffset)
+{
+    m_shadowOffset = shadowOffset;
+}
+
+const MCVector3dF & MCParticleSystem::shadowOffset() const
+{
+    return m_shadowOffset;
+}
+
+void MCParticleSystem::setAnimationStyle(MCParticle::AnimationStyle style)
+{
+    m_animationStyle = style;
+}
+
+MCParticle::AnimationStyle MCParticleSystem::animationStyle() const
+{
+    return m_animationStyle;
+}
+
+void MCParticleSystem::setAcceleration(MCVector3dFR acceleration)
+{
+    m_acceleration = acceleration;
+}
+
+const MCVector3dF & MCParticleSystem::acceleration() const
+{
+    return m_acceleration;
+}
+
+void MCParticleSystem::setDamping(float damping)
+{
+    m_damping = damping;
+}
+
+void MCParticleSystem::setDieWhenOffScreen(bool flag)
+{
+    m_dieWhenOffScreen = flag;
+}
+
+bool MCParticleSystem::dieWhenOffScreen() const
+{
+    return m_dieWhenOffScreen;
+}
+
+bool MCParticleSystem::emit(
+    MCVector3dFR location, MCVector3dFR velocity, float radius, unsigned int lifeTime,
+    const MCGLColor & color, float angle, float angularVelocity)
+{
+    if (m_count == m_capacity || !lifeTime)
+    {
+        return false;
+    }
+
+    const unsigned int i = m_count++;
+
+    m_x[i] = m_previousX[i] = location.i();
+    m_y[i] = m_previousY[i] = location.j();
+    m_z[i] = m_previousZ[i] = location.k();
+
+    m_velocityX[i] = velocity.i();
+    m_velocityY[i] = velocity.j();
+    m_velocityZ[i] = velocity.k();
+
+    m_angle[i] = m_previousAngle[i] = angle;
+    m_angularVelocity[i] = angularVelocity;
+
+    m_radius[i] = radius;
+    m_age[i] = 0;
+    m_lifeTime[i] = lifeTime;
+    m_color[i] = color;
+
+    return true;
+}
+
+void MCParticleSystem::stepTime(int step)
+{
+    MC_PROFILE_ZONE("MCParticleSystem::stepTime");
+
+    const float seconds = float(step) / 1000;
+    const float deltaVelocityX = m_acceleration.i() * seconds;
+    const float deltaVelocityY = m_acceleration.j() * seconds;
+    const float deltaVelocityZ = m_acceleration.k() * seconds;
+
+    const float max = std::numeric_limits<float>::max();
+    const float minX = m_world ? m_world->minX() : -max;
+    const float maxX = m_world ? m_world->maxX() : max;
+    const float minY = m_world ? m_world->minY() : -max;
+    const float maxY = m_world ? m_world->maxY() : max;
+    const float minZ = m_world ? m_world->minZ() : -max;
+    const float maxZ = m_world ? m_world->maxZ() : max;
+
+    // The live particles are compacted to the front in the same pass
+    unsigned int alive = 0;
+    for (unsigned int i = 0; i < m_count; i++)
+    {
+        const unsigned int age = m_age[i] + static_cast<unsigned int>(step);
+
+        const float velocityX = (m_velocityX[i] + deltaVelocityX) * m_damping;
+        const float velocityY = (m_velocityY[i] + deltaVelocityY) * m_damping;
+        const float velocityZ = (m_velocityZ[i] + deltaVelocityZ) * m_damping;
+
+        const float x = m_x[i] + velocityX;
+        const float y = m_y[i] + velocityY;
+        const float z = m_z[i] + velocityZ;
+
+        if (age >= m_lifeTime[i] || x < minX || x > maxX || y < minY || y > maxY || z <= minZ || z > maxZ)
+        {
+            continue;
+        }
+
+        const float angularVelocity = m_angularVelocity[i] * m_damping;
+
+        m_previousX[alive] = m_x[i];
+        m_previousY[alive] = m_y[i];
+        m_previousZ[alive] = m_z[i];
+        m_previousAngle[alive] = m_angle[i];
+
+        m_x[alive] = x;
+        m_y[alive] = y;
+        m_z[alive] = z;
+        m_angle[alive] = m_angle[i] + angularVelocity * seconds;
+
+        m_velocityX[alive] = velocityX;
+        m_velocityY[alive] = velocityY;
+        m_velocityZ[alive] = velocityZ;
+        m_angularVelocity[alive] = angularVelocity;
+
+        m_radius[alive] = m_radius[i];
+        m_age[alive] = age;
+        m_lifeTime[alive] = m_lifeTime[i];
+        m_color[alive] = m_color[i];
+
+        alive++;
+    }
+
+    m_count = alive;
+}
+
+void MCParticleSystem::kill(unsigned int index)
+{
+    assert(index < m_count);
+    m_age[index] = m_lifeTime[index];
+}
+
+void MCParticleSystem::clear()
+{
+    m_count = 0;
+}
+
+unsigned int MCParticleSystem::count() const
+{
+    return m_count;
+}
+
+unsigned int MCParticleSystem::capacity() const
+{
+    return m_capacity;
+}
+
+MCWorld * MCParticleSystem::world() const
+{
+    return m_world;
+}
+
+MCVector3dF MCParticleSystem::location(unsigned int index) const
+{
+    return MCVector3dF(m_x[index], m_y[index], m_z[index]);
+}
+
+MCVector3dF MCParticleSystem::renderLocation(unsigned int index) const
+{
+    const float alpha = m_world ? m_world->renderInterpolation() : 1.0f;
+    return MCVector3dF(
+        m_previousX[index] + (m_x[index] - m_previousX[index]) * alpha,
+        m_previousY[index] + (m_y[index] - m_previousY[index]) * alpha,
+        m_previousZ[index] + (m_z[index] - m_previousZ[index]) * alpha);
+}
+
+float MCParticleSystem::renderAngle(unsigned int index) const
+{
+    const float alpha = m_world ? m_world->renderInterpolation() : 1.0f;
+    return m_previousAngle[index] + std::remainder(m_angle[index] - m_previousAngle[index], 360.0f) * alpha;
+}
+
+float MCParticleSystem::radius(unsigned int index) const
+{
+    switch (m_animationStyle)
+    {
+    case MCParticle::AnimationStyle::Shrink:
+        return scale(index) * m_radius[index];
+    case MCParticle::AnimationStyle::FadeOutAndExpand:
+        return (2.0f - scale(index)) * m_radius[index];
+    default:
+        return m_radius[index];
+    }
+}
+
+float MCParticleSystem::scale(unsigned int index) const
+{
+    return float(m_lifeTime[index] - m_age[index]) / m_lifeTime[index];
+}
+
+const MCGLColor & MCParticleSystem::color(unsigned int index) const
+{
+    return m_color[index];
+}
+
+void MCParticleSystem::sortByZ(std::vector<unsigned int> & indices)
+{
+    m_sorter.sort(indices, [this] (unsigned int index) {
+        return m_z[index];
+    });
+}
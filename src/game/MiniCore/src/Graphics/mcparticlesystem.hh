@@ -0,0 +1,217 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#ifndef MCPARTICLESYSTEM_HH
+#define MCPARTICLESYSTEM_HH
+
+#include <MCGLEW>
+
+#include "mcglcolor.hh"
+#include "mcmacros.hh"
+#include "mcparticle.hh"
+#include "mcradixsort.hh"
+#include "mcvector3d.hh"
+
+#include <vector>
+
+class MCSurface;
+class MCWorld;
+
+/*! \class MCParticleSystem
+ *  \brief A pool of lightweight surface particles of one kind.
+ *
+ *  Unlike MCParticle, the particles are not objects: the state of the particles is kept
+ *  in flat arrays, all particles are updated in one loop per step and they never enter the
+ *  object grid or the collision detection. The surface, the acceleration, the animation style
+ *  and the blending are shared by all particles of the system.
+ *
+ *  A particle dies when its life time has passed or when it leaves the box of the world.
+ *  Reaching the minimum Z (the floor) counts as leaving the box.
+ *
+ *  Add the system to a world with MCWorld::addParticleSystem(). The world steps the system
+ *  and MCWorldRenderer renders it with the particle render groups.
+ */
+class MCParticleSystem
+{
+public:
+
+    /*! Constructor.
+     *  \param capacity Max number of live particles. All storage is allocated here. */
+    explicit MCParticleSystem(unsigned int capacity);
+
+    //! Destructor. Removes the system from its world.
+    ~MCParticleSystem();
+
+    //! Set the surface the particles are rendered with. Systems without a surface are not rendered.
+    void setSurface(MCSurface & surface);
+
+    MCSurface * surface() const;
+
+    //! Enable/disable blending.
+    void setAlphaBlend(bool useAlphaBlend, GLenum src = GL_SRC_ALPHA, GLenum dst = GL_ONE_MINUS_SRC_ALPHA);
+
+    bool useAlphaBlend() const;
+
+    GLenum alphaSrc() const;
+
+    GLenum alphaDst() const;
+
+    //! Set if shadows need to be rendered. Default is false.
+    void setHasShadow(bool hasShadow);
+
+    bool hasShadow() const;
+
+    //! Set offset for the fake shadows. Default is MCShape::defaultShadowOffset().
+    void setShadowOffset(MCVector3dFR shadowOffset);
+
+    const MCVector3dF & shadowOffset() const;
+
+    //! Set the animation performed linearly during the life time. Default is None.
+    void setAnimationStyle(MCParticle::AnimationStyle style);
+
+    MCParticle::AnimationStyle animationStyle() const;
+
+    //! Set the acceleration of all particles, e.g. gravity. Default is zero.
+    void setAcceleration(MCVector3dFR acceleration);
+
+    const MCVector3dF & acceleration() const;
+
+    //! Set the factor the velocities are multiplied with on each step. Default is 0.999.
+    void setDamping(float damping);
+
+    /*! Optimization: if set to true, particles that are not visible in any
+     *  visibility camera of MCWorldRenderer are killed. Default is true. */
+    void setDieWhenOffScreen(bool flag);
+
+    bool dieWhenOffScreen() const;
+
+    /*! Emit a new particle.
+     *  \param location Initial location.
+     *  \param velocity Initial velocity. Like with MCPhysicsComponent, the velocity is added
+     *         to the location on each step.
+     *  \param radius Initial radius.
+     *  \param lifeTime Life time in msecs.
+     *  \param color Color of the particle.
+     *  \param angle Initial rotation in degrees.
+     *  \param angularVelocity Angular velocity in degrees per second.
+     *  \return false if the system is full or the life time is zero. */
+    bool emit(
+        MCVector3dFR location,
+        MCVector3dFR velocity,
+        float radius,
+        unsigned int lifeTime,
+        const MCGLColor & color,
+        float angle = 0,
+        float angularVelocity = 0);
+
+    /*! Move the particles, advance their life times and remove the dead ones.
+     *  The remaining particles keep their order, so the indices of dead particles
+     *  are reused by the following particles.
+     *  \param step Time step in msecs. */
+    void stepTime(int step);
+
+    //! Kill the particle at the given index. It is removed on the next step.
+    void kill(unsigned int index);
+
+    //! Remove all particles.
+    void clear();
+
+    //! \return Number of live particles.
+    unsigned int count() const;
+
+    unsigned int capacity() const;
+
+    //! \return The world the system has been added to or nullptr.
+    MCWorld * world() const;
+
+    //! \return Location of the particle after the latest step.
+    MCVector3dF location(unsigned int index) const;
+
+    //! \return Location of the particle interpolated according to MCWorld::renderInterpolation().
+    MCVector3dF renderLocation(unsigned int index) const;
+
+    //! \return Rotation of the particle in degrees interpolated like renderLocation().
+    float renderAngle(unsigned int index) const;
+
+    //! \return Radius of the particle with Shrink and FadeOutAndExpand applied like in MCParticle::radius().
+    float radius(unsigned int index) const;
+
+    //! \return Remaining share of the life time from 1.0 to 0.0.
+    float scale(unsigned int index) const;
+
+    const MCGLColor & color(unsigned int index) const;
+
+    /*! Sort the given particle indices by the Z-coordinates of the particles.
+     *  Indices of particles with equal Z-coordinates keep their order. */
+    void sortByZ(std::vector<unsigned int> & indices);
+
+private:
+
+    DISABLE_COPY(MCParticleSystem);
+    DISABLE_ASSI(MCParticleSystem);
+
+    unsigned int m_count;
+
+    unsigned int m_capacity;
+
+    std::vector<float> m_x, m_y, m_z;
+
+    //! Locations before the latest step for the render interpolation.
+    std::vector<float> m_previousX, m_previousY, m_previousZ;
+
+    std::vector<float> m_velocityX, m_velocityY, m_velocityZ;
+
+    std::vector<float> m_angle, m_previousAngle, m_angularVelocity;
+
+    std::vector<float> m_radius;
+
+    //! Ages and life times in msecs.
+    std::vector<unsigned int> m_age, m_lifeTime;
+
+    std::vector<MCGLColor> m_color;
+
+    //! Sorter of sortByZ().
+    MCRadixSort<unsigned int> m_sorter;
+
+    MCSurface * m_surface;
+
+    bool m_useAlphaBlend;
+
+    GLenum m_src;
+
+    GLenum m_dst;
+
+    bool m_hasShadow;
+
+    MCVector3dF m_shadowOffset;
+
+    MCParticle::AnimationStyle m_animationStyle;
+
+    MCVector3dF m_acceleration;
+
+    float m_damping;
+
+    bool m_dieWhenOffScreen;
+
+    MCWorld * m_world;
+
+    friend class MCWorld;
+};
+
+#endif // MCPARTICLESYSTEM_HH
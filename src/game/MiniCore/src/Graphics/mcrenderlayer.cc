@@ -21,6 +21,9 @@
 #include "mccamera.hh"
 #include "mcobject.hh"
 
+#include <algorithm>
+#include <cassert>
+
 MCRenderLayer::MCRenderLayer()
     : m_depthTestEnabled(true)
     , m_depthMaskEnabled(true)
@@ -31,6 +34,7 @@ void MCRenderLayer::clear()
 {
     m_objectBatches.clear();
     m_particleBatches.clear();
+    m_particleSystemBatches.clear();
 }
 
 void MCRenderLayer::setDepthTestEnabled(bool enable)
@@ -62,3 +66,78 @@ MCRenderLayer::CameraBatchMap & MCRenderLayer::particleBatches()
 {
     return m_particleBatches;
 }
+
+MCRenderLayer::CameraParticleSystemBatchMap & MCRenderLayer::particleSystemBatches()
+{
+    return m_particleSystemBatches;
+}
+
+void MCRenderLayer::BatchList::reset()
+{
+    for (size_t index : m_order)
+    {
+        m_batches[index].objects.clear();
+    }
+
+    m_order.clear();
+}
+
+void MCRenderLayer::BatchList::add(int objectViewId, MCObject * object, float priority)
+{
+    // Consecutive objects often share the batch
+    if (objectViewId != m_lastViewId)
+    {
+        assert(objectViewId >= 0);
+        if (static_cast<size_t>(objectViewId) >= m_slots.size())
+        {
+            m_slots.resize(objectViewId + 1, -1);
+        }
+
+        int & slot = m_slots[objectViewId];
+        if (slot < 0)
+        {
+            slot = static_cast<int>(m_batches.size());
+            m_batches.push_back(ObjectBatch());
+            m_batches.back().objectViewId = objectViewId;
+        }
+
+        m_lastViewId = objectViewId;
+        m_lastIndex = slot;
+    }
+
+    ObjectBatch & batch = m_batches[m_lastIndex];
+    if (batch.objects.empty())
+    {
+        batch.priority = priority;
+        batch.sequence = m_order.size();
+        m_order.push_back(m_lastIndex);
+    }
+    else
+    {
+        batch.priority = std::max(priority, batch.priority);
+    }
+
+    batch.objects.push_back(object);
+}
+
+void MCRenderLayer::BatchList::sort()
+{
+    // The sequence keeps batches of equal priority in the order they were added in,
+    // so std::sort can be used instead of the allocating std::stable_sort.
+    std::sort(m_order.begin(), m_order.end(), [this] (size_t lhs, size_t rhs) {
+        const ObjectBatch & left = m_batches[lhs];
+        const ObjectBatch & right = m_batches[rhs];
+        return left.priority < right.priority ||
+            (left.priority == right.priority && left.sequence < right.sequence);
+    });
+}
+
+size_t MCRenderLayer::BatchList::size() const
+{
+    return m_order.size();
+}
+
+MCRenderLayer::ObjectBatch & MCRenderLayer::BatchList::operator[](size_t index)
+{
+    return m_batches[m_order[index]];
+}
@@ -20,6 +20,7 @@
 #ifndef MCRENDERLAYER_HH
 #define MCRENDERLAYER_HH
 
+#include <cstddef>
 #include <map>
 #include <set>
 #include <vector>
@@ -27,6 +28,7 @@
 class MCCamera;
 class MCObject;
 class MCParticle;
+class MCParticleSystem;
 
 class MCRenderLayer
 {
@@ -48,15 +50,70 @@ public:
     {
         int objectViewId = -1;
         float priority = 0;
+
+        //! Position in the order the batches were first added in during the frame.
+        size_t sequence = 0;
+
         std::vector<MCObject *> objects;
     };
 
-    typedef std::map<MCCamera *, std::vector<ObjectBatch> > CameraBatchMap;
+    /*! Batches of one camera in rendering order. The batches and their object vectors
+     *  are kept between frames, so that rebuilding and sorting them doesn't allocate once the
+     *  capacities have grown. A batch is found by indexing a slot table with its view id. */
+    class BatchList
+    {
+    public:
+
+        //! Empty all batches, but keep their storage.
+        void reset();
+
+        //! Add an object to the batch of the given view id. The batch priority is the max priority of its objects.
+        void add(int objectViewId, MCObject * object, float priority);
+
+        //! Sort the batches by priority. Batches with equal priorities stay in the order they were added in.
+        void sort();
+
+        //! \return number of non-empty batches.
+        size_t size() const;
+
+        //! \return the batch at the given position of the rendering order.
+        ObjectBatch & operator[](size_t index);
+
+    private:
+
+        std::vector<ObjectBatch> m_batches;
+
+        //! Indices of m_batches indexed by view id, -1 if the view id has no batch.
+        std::vector<int> m_slots;
+
+        //! Indices of the non-empty batches in the rendering order.
+        std::vector<size_t> m_order;
+
+        int m_lastViewId = -1;
+
+        size_t m_lastIndex = 0;
+    };
+
+    typedef std::map<MCCamera *, BatchList> CameraBatchMap;
 
     CameraBatchMap & objectBatches();
 
     CameraBatchMap & particleBatches();
 
+    //! Visible particles of a particle system.
+    struct ParticleSystemBatch
+    {
+        MCParticleSystem * particleSystem = nullptr;
+        float priority = 0;
+        std::vector<unsigned int> indices;
+    };
+
+    /*! Particle system batches of one camera. The batches are sorted by priority.
+     *  The vector and the index vectors are reused between frames. */
+    typedef std::map<MCCamera *, std::vector<ParticleSystemBatch>> CameraParticleSystemBatchMap;
+
+    CameraParticleSystemBatchMap & particleSystemBatches();
+
 private:
 
     bool m_depthTestEnabled;
@@ -66,6 +123,8 @@ private:
     CameraBatchMap m_objectBatches;
 
     CameraBatchMap m_particleBatches;
+
+    CameraParticleSystemBatchMap m_particleSystemBatches;
 };
 
 #endif // MCRENDERLAYER_HH
@@ -154,6 +154,56 @@ static const char * MCDefaultShadowFsh =
 "    }\n"
 "}\n";
 
+static const char * MCDefaultParticleVsh =
+"#version 130\n"
+"in      vec3  inVertex;\n"
+"in      vec3  inNormal;\n"
+"in      vec2  inTexCoord;\n"
+"in      vec4  inColor;\n"
+"uniform vec4  color = vec4(1, 1, 1, 1);\n"
+"uniform mat4  vp;\n"
+"uniform mat4  model;\n"
+"uniform vec4  dd = vec4(1, 1, 1, 1);\n"
+"uniform vec4  dc = vec4(1, 1, 1, 1);\n"
+"uniform float dCoeff = 1;\n"
+"uniform vec4  ac = vec4(1, 1, 1, 1);\n"
+"out     vec2  texCoord0;\n"
+"out     vec4  vColor;\n"
+""
+"void main()\n"
+"{\n"
+"    float s = sin(inNormal.z);\n"
+"    float c = cos(inNormal.z);\n"
+"    vec2 corner = vec2(c * inNormal.x - s * inNormal.y, s * inNormal.x + c * inNormal.y);\n"
+"    gl_Position = vp * model * vec4(inVertex.xy + corner, inVertex.z, 1);\n"
+""
+"    float di = dot(dd.xyz, vec3(0, 0, -1)) * dc.a;\n"
+"    vColor = inColor * color * (\n"
+"        vec4(ac.rgb * ac.a, 1.0) +\n"
+"        vec4(dc.rgb * di * dCoeff, 1.0));\n"
+""
+"    texCoord0 = inTexCoord;\n"
+"}\n";
+
+static const char * MCDefaultParticleShadowVsh =
+"#version 130\n"
+""
+"in      vec3 inVertex;\n"
+"in      vec3 inNormal;\n"
+"in      vec2 inTexCoord;\n"
+"uniform mat4 vp;\n"
+"uniform mat4 model;\n"
+"out     vec2 texCoord0;\n"
+""
+"void main()\n"
+"{\n"
+"    float s = sin(inNormal.z);\n"
+"    float c = cos(inNormal.z);\n"
+"    vec2 corner = vec2(c * inNormal.x - s * inNormal.y, s * inNormal.x + c * inNormal.y);\n"
+"    gl_Position = vp * model * vec4(inVertex.xy + corner, 0, 1);\n"
+"    texCoord0   = inTexCoord;\n"
+"}\n";
+
 static const char * MCDefaultTextVsh =
 "#version 130\n"
 ""
@@ -164,6 +164,61 @@ static const char * MCDefaultShadowFsh =
 "    }\n"
 "}\n";
 
+static const char * MCDefaultParticleVsh =
+"#version 100\n"
+""
+"precision mediump float;\n"
+"precision mediump int;\n"
+"attribute vec3    inVertex;\n"
+"attribute vec3    inNormal;\n"
+"attribute vec2    inTexCoord;\n"
+"attribute vec4    inColor;\n"
+"uniform   vec4    color;\n"
+"uniform   mat4    vp;\n"
+"uniform   mat4    model;\n"
+"uniform   vec4    dd;\n"
+"uniform   vec4    dc;\n"
+"uniform   vec4    ac;\n"
+"uniform   float   dCoeff;\n"
+"varying   vec2    texCoord0;\n"
+"varying   vec4    vColor;\n"
+""
+"void main()\n"
+"{\n"
+"    float s = sin(inNormal.z);\n"
+"    float c = cos(inNormal.z);\n"
+"    vec2 corner = vec2(c * inNormal.x - s * inNormal.y, s * inNormal.x + c * inNormal.y);\n"
+"    gl_Position = vp * model * vec4(inVertex.xy + corner, inVertex.z, 1);\n"
+""
+"    float di = dot(dd.xyz, vec3(0, 0, -1)) * dc.a;\n"
+"    vColor = inColor * color * (\n"
+"        vec4(ac.rgb * ac.a, 1.0) +\n"
+"        vec4(dc.rgb * di * dCoeff, 1.0));\n"
+""
+"    texCoord0 = inTexCoord;\n"
+"}\n";
+
+static const char * MCDefaultParticleShadowVsh =
+"#version 100\n"
+""
+"precision mediump float;\n"
+"precision mediump int;\n"
+"attribute vec3    inVertex;\n"
+"attribute vec3    inNormal;\n"
+"attribute vec2    inTexCoord;\n"
+"uniform   mat4    vp;\n"
+"uniform   mat4    model;\n"
+"varying   vec2    texCoord0;\n"
+""
+"void main()\n"
+"{\n"
+"    float s = sin(inNormal.z);\n"
+"    float c = cos(inNormal.z);\n"
+"    vec2 corner = vec2(c * inNormal.x - s * inNormal.y, s * inNormal.x + c * inNormal.y);\n"
+"    gl_Position = vp * model * vec4(inVertex.xy + corner, 0, 1);\n"
+"    texCoord0   = inTexCoord;\n"
+"}\n";
+
 static const char * MCDefaultTextVsh =
 "#version 100\n"
 ""
@@ -55,6 +55,9 @@ MCSurface::MCSurface(
     float z2,
     float z3)
     : MCGLObjectBase(handle)
+    , m_atlasId(0)
+    , m_atlasMin({0, 0})
+    , m_atlasMax({1, 1})
 {
     setMaterial(material);
 
@@ -126,6 +129,9 @@ MCSurface::MCSurface(std::string handle, MCGLMaterialPtr material, float width,
 MCSurface::MCSurface(
     std::string handle, MCGLMaterialPtr material, float width, float height, const MCGLTexCoord texCoords[4])
     : MCGLObjectBase(handle)
+    , m_atlasId(0)
+    , m_atlasMin({0, 0})
+    , m_atlasMax({1, 1})
 {
     setMaterial(material);
 
@@ -194,3 +200,53 @@ void MCSurface::updateTexCoords(const MCGLTexCoord texCoords[4])
     glBufferSubData(
         GL_ARRAY_BUFFER, VERTEX_DATA_SIZE + NORMAL_DATA_SIZE, TEXCOORD_DATA_SIZE, texCoordsAll);
 }
+
+void MCSurface::setAtlas(GLuint atlasId, const MCGLTexCoord & min, const MCGLTexCoord & max)
+{
+    // Undo the mapping of a possible previous page
+    TexCoordVector texCoords;
+    for (int i = 0; i < NUM_VERTICES; i++)
+    {
+        const MCGLTexCoord & mapped = texCoord(i);
+        texCoords.push_back({
+            (mapped.u - m_atlasMin.u) / (m_atlasMax.u - m_atlasMin.u),
+            (mapped.v - m_atlasMin.v) / (m_atlasMax.v - m_atlasMin.v)});
+    }
+
+    m_atlasId = atlasId;
+    m_atlasMin = min;
+    m_atlasMax = max;
+
+    material()->setTexture(atlasId, 0);
+
+    // The batch renderers read the texture coordinates from the CPU side copy
+    for (auto && texCoord : texCoords)
+    {
+        texCoord = mapTexCoord(texCoord);
+    }
+
+    setTexCoords(texCoords);
+
+    const MCGLTexCoord corners[4] =
+    {
+        texCoords[0],
+        texCoords[2],
+        texCoords[1],
+        texCoords[4]
+    };
+
+    updateTexCoords(corners);
+}
+
+GLuint MCSurface::atlasId() const
+{
+    return m_atlasId;
+}
+
+MCGLTexCoord MCSurface::mapTexCoord(const MCGLTexCoord & texCoord) const
+{
+    return {
+        m_atlasMin.u + texCoord.u * (m_atlasMax.u - m_atlasMin.u),
+        m_atlasMin.v + texCoord.v * (m_atlasMax.v - m_atlasMin.v)
+    };
+}
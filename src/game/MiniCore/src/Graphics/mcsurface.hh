@@ -26,6 +26,7 @@
 #include "mcbbox.hh"
 #include "mcglobjectbase.hh"
 #include "mcglmaterial.hh"
+#include "mcgltexcoord.hh"
 #include "mcvector2d.hh"
 #include "mcvector3d.hh"
 
@@ -34,7 +35,6 @@
 
 class  MCCamera;
 class  MCGLShaderProgram;
-struct MCGLTexCoord;
 class  MCGLVertex;
 
 /*! MCSurface is a (2D) renderable object bound to an OpenGL texture handle.
@@ -93,12 +93,33 @@ public:
     //! Update texture coordinates.
     void updateTexCoords(const MCGLTexCoord texCoords[4]);
 
+    /*! Place the surface on a texture atlas page. The texture of the material is set
+     *  to the page and the texture coordinates are mapped into the given sub-rectangle.
+     *  \param atlasId Texture handle of the atlas page.
+     *  \param min Texture coordinate of the bottom left corner of the image on the page.
+     *  \param max Texture coordinate of the top right corner of the image on the page. */
+    void setAtlas(GLuint atlasId, const MCGLTexCoord & min, const MCGLTexCoord & max);
+
+    /*! \return Texture handle of the atlas page the surface is on or 0 if the surface
+     *  has a texture of its own. Surfaces on the same page can be drawn with one call. */
+    GLuint atlasId() const;
+
+    /*! Map a texture coordinate in the [0, 1] range of the surface image into the texture
+     *  of the surface. Returns the given coordinate as such if the surface is not on an atlas. */
+    MCGLTexCoord mapTexCoord(const MCGLTexCoord & texCoord) const;
+
 private:
 
     DISABLE_COPY(MCSurface);
     DISABLE_ASSI(MCSurface);
 
     void initVBOs();
+
+    GLuint m_atlasId;
+
+    MCGLTexCoord m_atlasMin;
+
+    MCGLTexCoord m_atlasMax;
 };
 
 #endif // MCSURFACE_HH
@@ -79,15 +79,17 @@ void MCSurfaceObjectRenderer::setBatch(MCRenderLayer::ObjectBatch & batch, MCCam
     const int TEXCOORD_DATA_SIZE = sizeof(MCGLTexCoord) * NUM_VERTICES;
     const int COLOR_DATA_SIZE  = sizeof(MCGLColor) * NUM_VERTICES;
 
-    // Take common properties from the first Object in the batch
+    // Take common properties from the first Object in the batch. The objects may have
+    // different surfaces, if the surfaces are on the same atlas page.
     MCObject * object = batch.objects.at(0);
     MCSurfaceView * view = dynamic_cast<MCSurfaceView *>(object->shape()->view().get());
     assert(view);
 
     m_surface = view->surface();
 
-    setShaderProgram(view->shaderProgram());
-    setShadowShaderProgram(view->shadowShaderProgram());
+    // Use the programs of the surface like MCSurfaceView::render() does
+    setShaderProgram(m_surface->shaderProgram());
+    setShadowShaderProgram(m_surface->shadowShaderProgram());
 
     setMaterial(m_surface->material());
     setHasShadow(view->hasShadow());
@@ -97,7 +99,9 @@ void MCSurfaceObjectRenderer::setBatch(MCRenderLayer::ObjectBatch & batch, MCCam
     {
         object = batch.objects[i];
         MCSurfaceView * view = static_cast<MCSurfaceView *>(object->shape()->view().get());
-        MCVector3dF location(object->shape()->location());
+        MCSurface * surface = view->surface();
+        MCVector3dF location(object->shape()->renderLocation());
+        const float angle = object->shape()->renderAngle();
 
         float x, y, z;
         if (isShadow)
@@ -120,19 +124,27 @@ void MCSurfaceObjectRenderer::setBatch(MCRenderLayer::ObjectBatch & batch, MCCam
 
         for (int j = 0; j < NUM_VERTICES_PER_SURFACE; j++)
         {
-            m_colors[vertexIndex] = static_cast<MCGLObjectBase *>(m_surface)->color(j);
+            m_colors[vertexIndex] = static_cast<MCGLObjectBase *>(surface)->color(j);
 
-            auto vertex = m_surface->vertex(j);
+            // Do the transformations of the vertex shader here, because all objects are drawn at once
+            auto vertex = surface->vertex(j);
+            const float scaledX = vertex.x() * view->scale().i();
+            const float scaledY = vertex.y() * view->scale().j();
 
             m_vertices[vertexIndex] =
                     MCGLVertex(
-                        x + MCMathUtil::rotatedX(vertex.x(), vertex.y(), object->angle()) * view->scale().i(),
-                        y + MCMathUtil::rotatedY(vertex.x(), vertex.y(), object->angle()) * view->scale().j(),
-                        !isShadow ? z + vertex.z() : z);
+                        x + MCMathUtil::rotatedX(scaledX, scaledY, angle),
+                        y + MCMathUtil::rotatedY(scaledX, scaledY, angle),
+                        !isShadow ? z + vertex.z() * view->scale().k() : z);
 
-            m_normals[vertexIndex] = m_surface->normal(j);
+            auto normal = surface->normal(j);
+            m_normals[vertexIndex] =
+                    MCGLVertex(
+                        MCMathUtil::rotatedX(normal.x(), normal.y(), angle),
+                        MCMathUtil::rotatedY(normal.x(), normal.y(), angle),
+                        normal.z());
 
-            m_texCoords[vertexIndex] = m_surface->texCoord(j);
+            m_texCoords[vertexIndex] = surface->texCoord(j);
 
             vertexIndex++;
         }
@@ -167,7 +179,7 @@ void MCSurfaceObjectRenderer::render()
 
     material()->doAlphaBlend();
 
-    shaderProgram()->setTransform(0, MCVector3dF(0, 0, 1));
+    shaderProgram()->setTransform(0, MCVector3dF(0, 0, 0));
     shaderProgram()->setScale(1.0f, 1.0f, 1.0f);
     shaderProgram()->setColor(m_surface->color());
 
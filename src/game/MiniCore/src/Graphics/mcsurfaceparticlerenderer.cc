@@ -19,13 +19,15 @@
 
 #include "mcsurfaceparticlerenderer.hh"
 
-#include "mcmathutil.hh"
+#include "mcglscene.hh"
+#include "mcglstate.hh"
+#include "mcparticlesystem.hh"
+#include "mcsurface.hh"
 #include "mcsurfaceparticle.hh"
 #include "mctrigonom.hh"
 
 #include <algorithm>
-
-#include <QDebug>
+#include <cstddef>
 
 namespace {
 #ifdef __MC_GLES__
@@ -33,36 +35,85 @@ const int NUM_VERTICES_PER_PARTICLE = 6;
 #else
 const int NUM_VERTICES_PER_PARTICLE = 4;
 #endif
+
+// Size of the ring buffer as multiples of the max batch size
+const int RING_BATCHES = 4;
+
+// Texture coordinates of a quad. The corners are at (2u - 1, 2v - 1).
+const MCGLTexCoord TEX_COORDS[NUM_VERTICES_PER_PARTICLE] =
+{
+#ifdef __MC_GLES__
+    {0, 0},
+    {1, 1},
+#endif
+    {0, 1},
+    {0, 0},
+    {1, 0},
+    {1, 1}
+};
+
+// Apply the disappear animation to the radius and the color
+void animate(MCParticle::AnimationStyle style, float scale, float & radius, MCGLColor & color)
+{
+    if (style == MCParticle::AnimationStyle::FadeOut)
+    {
+        color.setA(color.a() * scale);
+    }
+    else if (style == MCParticle::AnimationStyle::FadeOutAndExpand)
+    {
+        color.setA(color.a() * scale);
+        radius *= scale;
+    }
+    else if (style == MCParticle::AnimationStyle::Shrink)
+    {
+        radius *= scale;
+    }
+}
 }
 
 MCSurfaceParticleRenderer::MCSurfaceParticleRenderer(int maxBatchSize)
     : MCParticleRendererBase(maxBatchSize)
-    , m_vertices(new MCGLVertex[maxBatchSize * NUM_VERTICES_PER_PARTICLE])
-    , m_normals(new MCGLVertex[maxBatchSize * NUM_VERTICES_PER_PARTICLE])
-    , m_texCoords(new MCGLTexCoord[maxBatchSize * NUM_VERTICES_PER_PARTICLE])
-    , m_colors(new MCGLColor[maxBatchSize * NUM_VERTICES_PER_PARTICLE])
+    , m_vertices(maxBatchSize * NUM_VERTICES_PER_PARTICLE)
+    , m_surfaceTexCoords(NUM_VERTICES_PER_PARTICLE)
+    , m_ringCapacity(maxBatchSize * RING_BATCHES)
+    , m_ringHead(0)
+    , m_firstVertex(0)
 {
-    const int NUM_VERTICES = maxBatchSize * NUM_VERTICES_PER_PARTICLE;
-    const int VERTEX_DATA_SIZE = sizeof(MCGLVertex) * NUM_VERTICES;
-    const int NORMAL_DATA_SIZE = sizeof(MCGLVertex) * NUM_VERTICES;
-    const int TEXCOORD_DATA_SIZE = sizeof(MCGLTexCoord) * NUM_VERTICES;
-    const int COLOR_DATA_SIZE = sizeof(MCGLColor) * NUM_VERTICES;
-    const int TOTAL_DATA_SIZE = VERTEX_DATA_SIZE + NORMAL_DATA_SIZE + TEXCOORD_DATA_SIZE + COLOR_DATA_SIZE;
-
-    initBufferData(TOTAL_DATA_SIZE, GL_DYNAMIC_DRAW);
-
-    addBufferSubData(
-        MCGLShaderProgram::VAL_Vertex, VERTEX_DATA_SIZE, reinterpret_cast<const GLfloat *>(m_vertices));
-    addBufferSubData(
-        MCGLShaderProgram::VAL_Normal, NORMAL_DATA_SIZE, reinterpret_cast<const GLfloat *>(m_normals));
-    addBufferSubData(
-        MCGLShaderProgram::VAL_TexCoords, TEXCOORD_DATA_SIZE, reinterpret_cast<const GLfloat *>(m_texCoords));
-    addBufferSubData(
-        MCGLShaderProgram::VAL_Color, COLOR_DATA_SIZE, reinterpret_cast<const GLfloat *>(m_colors));
+    static_assert(sizeof(ParticleVertex) == 12 * sizeof(GLfloat), "ParticleVertex must be tightly packed");
+
+    setShaderProgram(MCGLScene::instance().defaultParticleShaderProgram());
+    setShadowShaderProgram(MCGLScene::instance().defaultParticleShadowShaderProgram());
 
+    initBufferData(sizeof(ParticleVertex) * NUM_VERTICES_PER_PARTICLE * m_ringCapacity, GL_DYNAMIC_DRAW);
     finishBufferData();
 }
 
+void MCSurfaceParticleRenderer::setAttributePointers()
+{
+    enableAttributePointers();
+
+    const GLsizei stride = sizeof(ParticleVertex);
+
+    glVertexAttribPointer(MCGLShaderProgram::VAL_Vertex, 3, GL_FLOAT, GL_FALSE, stride,
+        reinterpret_cast<GLvoid *>(offsetof(ParticleVertex, center)));
+
+    glVertexAttribPointer(MCGLShaderProgram::VAL_Normal, 3, GL_FLOAT, GL_FALSE, stride,
+        reinterpret_cast<GLvoid *>(offsetof(ParticleVertex, corner)));
+
+    glVertexAttribPointer(MCGLShaderProgram::VAL_TexCoords, 2, GL_FLOAT, GL_FALSE, stride,
+        reinterpret_cast<GLvoid *>(offsetof(ParticleVertex, texCoord)));
+
+    glVertexAttribPointer(MCGLShaderProgram::VAL_Color, 4, GL_FLOAT, GL_FALSE, stride,
+        reinterpret_cast<GLvoid *>(offsetof(ParticleVertex, color)));
+}
+
+void MCSurfaceParticleRenderer::sortBatch(MCRenderLayer::ObjectBatch & batch)
+{
+    m_sorter.sort(batch.objects, [] (MCObject * object) {
+        return object->location().k();
+    });
+}
+
 void MCSurfaceParticleRenderer::setBatch(MCRenderLayer::ObjectBatch & batch, MCCamera * camera, bool isShadow)
 {
     if (!batch.objects.size()) {
@@ -70,65 +121,20 @@ void MCSurfaceParticleRenderer::setBatch(MCRenderLayer::ObjectBatch & batch, MCC
     }
 
     setBatchSize(std::min(static_cast<int>(batch.objects.size()), maxBatchSize()));
-    std::sort(batch.objects.begin(), batch.objects.end(), [] (const MCObject * l, const MCObject * r) {
-        return l->location().k() < r->location().k();
-    });
-
-    const int NUM_VERTICES = batchSize() * NUM_VERTICES_PER_PARTICLE;
-    const int VERTEX_DATA_SIZE = sizeof(MCGLVertex) * NUM_VERTICES;
-    const int NORMAL_DATA_SIZE = sizeof(MCGLVertex) * NUM_VERTICES;
-    const int TEXCOORD_DATA_SIZE = sizeof(MCGLTexCoord) * NUM_VERTICES;
-    const int COLOR_DATA_SIZE  = sizeof(MCGLColor) * NUM_VERTICES;
-
-    // Init vertice data for a quad
-
-    static const MCGLVertex vertices[NUM_VERTICES_PER_PARTICLE] =
-    {
-    #ifdef __MC_GLES__
-        {-1, -1, 0},
-        { 1,  1, 0},
-    #endif
-        {-1,  1, 0},
-        {-1, -1, 0},
-        { 1, -1, 0},
-        { 1,  1, 0}
-    };
-
-    static const MCGLVertex normals[NUM_VERTICES_PER_PARTICLE] =
-    {
-    #ifdef __MC_GLES__
-        { 0, 0, 1},
-        { 0, 0, 1},
-    #endif
-        { 0, 0, 1},
-        { 0, 0, 1},
-        { 0, 0, 1},
-        { 0, 0, 1}
-    };
-
-    const MCGLTexCoord texCoords[NUM_VERTICES_PER_PARTICLE] =
-    {
-    #ifdef __MC_GLES__
-        {0, 0},
-        {1, 1},
-    #endif
-        {0, 1},
-        {0, 0},
-        {1, 0},
-        {1, 1}
-    };
+    sortBatch(batch);
 
     // Take common properties from the first particle in the batch
     MCSurfaceParticle * particle = dynamic_cast<MCSurfaceParticle *>(batch.objects.at(0));
     setMaterial(particle->surface().material());
+
+    mapTexCoords(particle->surface());
     setHasShadow(particle->hasShadow());
     setAlphaBlend(particle->useAlphaBlend(), particle->alphaSrc(), particle->alphaDst());
 
-    int vertexIndex = 0;
     for (int i = 0; i < batchSize(); i++)
     {
         MCSurfaceParticle * particle = static_cast<MCSurfaceParticle *>(batch.objects[i]);
-        MCVector3dF location(particle->location());
+        MCVector3dF location(particle->shape()->renderLocation());
 
         float x, y, z;
 
@@ -150,61 +156,106 @@ void MCSurfaceParticleRenderer::setBatch(MCRenderLayer::ObjectBatch & batch, MCC
             camera->mapToCamera(x, y);
         }
 
-        for (int j = 0; j < NUM_VERTICES_PER_PARTICLE; j++)
+        float radius = particle->radius();
+        MCGLColor color = particle->color();
+        animate(particle->animationStyle(), particle->scale(), radius, color);
+
+        setParticle(i, MCGLVertex(x, y, z), radius, particle->shape()->renderAngle(), color);
+    }
+
+    uploadBatch();
+}
+
+void MCSurfaceParticleRenderer::setBatch(
+    MCParticleSystem & particleSystem, const unsigned int * indices, int count, MCCamera * camera, bool isShadow)
+{
+    if (!count || !particleSystem.surface()) {
+        return;
+    }
+
+    setBatchSize(std::min(count, maxBatchSize()));
+
+    setMaterial(particleSystem.surface()->material());
+    mapTexCoords(*particleSystem.surface());
+    setHasShadow(particleSystem.hasShadow());
+    setAlphaBlend(particleSystem.useAlphaBlend(), particleSystem.alphaSrc(), particleSystem.alphaDst());
+
+    const MCVector3dF & shadowOffset = particleSystem.shadowOffset();
+    for (int i = 0; i < batchSize(); i++)
+    {
+        const unsigned int index = indices[i];
+        const MCVector3dF location(particleSystem.renderLocation(index));
+
+        float x = location.i();
+        float y = location.j();
+        float z = location.k();
+
+        if (isShadow)
         {
-            float vertexX = vertices[j].x() * particle->radius();
-            float vertexY = vertices[j].y() * particle->radius();
-
-            m_colors[vertexIndex] = particle->color();
-            if (particle->animationStyle() == MCParticle::AnimationStyle::FadeOut)
-            {
-                m_colors[vertexIndex].setA(m_colors[vertexIndex].a() * particle->scale());
-            }
-            else if (particle->animationStyle() == MCParticle::AnimationStyle::FadeOutAndExpand)
-            {
-                m_colors[vertexIndex].setA(m_colors[vertexIndex].a() * particle->scale());
-                vertexX *= particle->scale();
-                vertexY *= particle->scale();
-            }
-            else if (particle->animationStyle() == MCParticle::AnimationStyle::Shrink)
-            {
-                vertexX *= particle->scale();
-                vertexY *= particle->scale();
-            }
-
-            m_vertices[vertexIndex] =
-                MCGLVertex(
-                    x + MCMathUtil::rotatedX(vertexX, vertexY, particle->angle()),
-                    y + MCMathUtil::rotatedY(vertexX, vertexY, particle->angle()),
-                    z);
-
-            m_normals[vertexIndex] = normals[j];
-
-            m_texCoords[vertexIndex] = texCoords[j];
-
-            vertexIndex++;
+            x += shadowOffset.i();
+            y += shadowOffset.j();
+            z = shadowOffset.k();
         }
+
+        if (camera)
+        {
+            camera->mapToCamera(x, y);
+        }
+
+        float radius = particleSystem.radius(index);
+        MCGLColor color = particleSystem.color(index);
+        animate(particleSystem.animationStyle(), particleSystem.scale(index), radius, color);
+
+        setParticle(i, MCGLVertex(x, y, z), radius, particleSystem.renderAngle(index), color);
     }
 
-    initUpdateBufferData();
+    uploadBatch();
+}
+
+void MCSurfaceParticleRenderer::mapTexCoords(MCSurface & surface)
+{
+    // Map the texture coordinates in case the surface is on an atlas
+    for (int j = 0; j < NUM_VERTICES_PER_PARTICLE; j++)
+    {
+        m_surfaceTexCoords[j] = surface.mapTexCoord(TEX_COORDS[j]);
+    }
+}
+
+void MCSurfaceParticleRenderer::setParticle(int index, const MCGLVertex & center, float radius, float angle, const MCGLColor & color)
+{
+    const float angleRad = MCTrigonom::degToRad(angle);
 
-    const int MAX_VERTEX_DATA_SIZE = sizeof(MCGLVertex) * maxBatchSize() * NUM_VERTICES_PER_PARTICLE;
-    addBufferSubData(
-        MCGLShaderProgram::VAL_Vertex, VERTEX_DATA_SIZE, MAX_VERTEX_DATA_SIZE,
-                reinterpret_cast<const GLfloat *>(m_vertices));
+    ParticleVertex * vertex = &m_vertices[index * NUM_VERTICES_PER_PARTICLE];
+    for (int j = 0; j < NUM_VERTICES_PER_PARTICLE; j++)
+    {
+        vertex->center = center;
+        vertex->corner = MCGLVertex(
+            (2 * TEX_COORDS[j].u - 1) * radius, (2 * TEX_COORDS[j].v - 1) * radius, angleRad);
+        vertex->texCoord = m_surfaceTexCoords[j];
+        vertex->color = color;
+        vertex++;
+    }
+}
 
-    const int MAX_NORMAL_DATA_SIZE = sizeof(MCGLVertex) * maxBatchSize() * NUM_VERTICES_PER_PARTICLE;
-    addBufferSubData(
-        MCGLShaderProgram::VAL_Normal, NORMAL_DATA_SIZE, MAX_NORMAL_DATA_SIZE,
-                reinterpret_cast<const GLfloat *>(m_normals));
+void MCSurfaceParticleRenderer::uploadBatch()
+{
+    // Reallocate the storage only when the ring buffer wraps, so that the ranges
+    // still used by the previous draw calls don't need to be waited for.
+    if (m_ringHead + batchSize() > m_ringCapacity)
+    {
+        initUpdateBufferData();
+        m_ringHead = 0;
+    }
+    else
+    {
+        bindVBO();
+    }
 
-    const int MAX_TEXCOORD_DATA_SIZE = sizeof(MCGLTexCoord) * maxBatchSize() * NUM_VERTICES_PER_PARTICLE;
-    addBufferSubData(
-        MCGLShaderProgram::VAL_TexCoords, TEXCOORD_DATA_SIZE, MAX_TEXCOORD_DATA_SIZE,
-                reinterpret_cast<const GLfloat *>(m_texCoords));
+    m_firstVertex = m_ringHead * NUM_VERTICES_PER_PARTICLE;
+    glBufferSubData(GL_ARRAY_BUFFER, sizeof(ParticleVertex) * m_firstVertex,
+        sizeof(ParticleVertex) * batchSize() * NUM_VERTICES_PER_PARTICLE, m_vertices.data());
 
-    addBufferSubData(
-        MCGLShaderProgram::VAL_Color, COLOR_DATA_SIZE, reinterpret_cast<const GLfloat *>(m_colors));
+    m_ringHead += batchSize();
 }
 
 void MCSurfaceParticleRenderer::render()
@@ -214,15 +265,14 @@ void MCSurfaceParticleRenderer::render()
     bind();
 
     shaderProgram()->setTransform(0, MCVector3dF(0, 0, 1));
-    shaderProgram()->setScale(1.0f, 1.0f, 1.0f);
     shaderProgram()->setColor(MCGLColor(1.0f, 1.0f, 1.0f, 1.0f));
 
 #ifdef __MC_GLES__
-    glDrawArrays(GL_TRIANGLES, 0, batchSize() * NUM_VERTICES_PER_PARTICLE);
+    glDrawArrays(GL_TRIANGLES, m_firstVertex, batchSize() * NUM_VERTICES_PER_PARTICLE);
 #else
-    glDrawArrays(GL_QUADS, 0, batchSize() * NUM_VERTICES_PER_PARTICLE);
+    glDrawArrays(GL_QUADS, m_firstVertex, batchSize() * NUM_VERTICES_PER_PARTICLE);
 #endif
-    glDisable(GL_BLEND);
+    MCGLState::disableBlend();
 
     releaseVBO();
     releaseVAO();
@@ -235,12 +285,11 @@ void MCSurfaceParticleRenderer::renderShadows()
     bindShadow();
 
     shadowShaderProgram()->setTransform(0, MCVector3dF(0, 0, 0));
-    shadowShaderProgram()->setScale(1.0f, 1.0f, 1.0f);
 
 #ifdef __MC_GLES__
-    glDrawArrays(GL_TRIANGLES, 0, batchSize() * NUM_VERTICES_PER_PARTICLE);
+    glDrawArrays(GL_TRIANGLES, m_firstVertex, batchSize() * NUM_VERTICES_PER_PARTICLE);
 #else
-    glDrawArrays(GL_QUADS, 0, batchSize() * NUM_VERTICES_PER_PARTICLE);
+    glDrawArrays(GL_QUADS, m_firstVertex, batchSize() * NUM_VERTICES_PER_PARTICLE);
 #endif
 
     releaseVBO();
@@ -249,9 +298,4 @@ void MCSurfaceParticleRenderer::renderShadows()
 
 MCSurfaceParticleRenderer::~MCSurfaceParticleRenderer()
 {
-    delete [] m_vertices;
-    delete [] m_normals;
-    delete [] m_texCoords;
-    delete [] m_colors;
 }
-
@@ -24,6 +24,7 @@
 
 #include "mcmacros.hh"
 #include "mcparticlerendererbase.hh"
+#include "mcradixsort.hh"
 #include "mcworldrenderer.hh"
 
 #include <vector>
@@ -31,10 +32,16 @@
 class MCSurfaceParticle;
 class MCCamera;
 class MCObject;
+class MCSurface;
 
 /*! Renders surface particle (textured particles) batches.
  *  Each MCSurfaceParticle id should have a corresponding MCSurfaceParticleRenderer
- *  registered to MCWorldRenderer. */
+ *  registered to MCWorldRenderer.
+ *
+ *  Only one record (center, angle, radius, color) is calculated per particle and it's
+ *  copied to the corners of the quad. The quads are rotated and scaled in the vertex
+ *  shader, see MCGLScene::defaultParticleShaderProgram(). The batches are streamed to
+ *  consecutive ranges of a ring buffer so that the buffer is reallocated only when it wraps. */
 class MCSurfaceParticleRenderer : public MCParticleRendererBase
 {
 public:
@@ -54,19 +61,59 @@ private:
      *  \param camera The camera window. */
     void setBatch(MCRenderLayer::ObjectBatch & batch, MCCamera * camera = nullptr, bool isShadow = false) override;
 
+    //! \reimp
+    void setBatch(
+        MCParticleSystem & particleSystem, const unsigned int * indices, int count, MCCamera * camera = nullptr, bool isShadow = false) override;
+
     //! Render the current particle batch.
     void render() override;
 
     //! Render the current particle batch as shadows.
     void renderShadows() override;
 
-    MCGLVertex * m_vertices;
+    //! Sort the batch by the Z-coordinate with a radix sort.
+    void sortBatch(MCRenderLayer::ObjectBatch & batch);
+
+    //! Map the corners of the quad to the texture coordinates of the given surface.
+    void mapTexCoords(MCSurface & surface);
+
+    //! Write the vertices of the particle at the given index of the batch. The angle is in degrees.
+    void setParticle(int index, const MCGLVertex & center, float radius, float angle, const MCGLColor & color);
+
+    //! Copy the vertices of the current batch to the next range of the ring buffer.
+    void uploadBatch();
+
+    //! Set the pointers of the interleaved vertex format.
+    void setAttributePointers() override;
+
+    //! One corner of a particle quad.
+    struct ParticleVertex
+    {
+        MCGLVertex center;
+
+        //! Corner offset scaled by the radius in x and y, angle in radians in z.
+        MCGLVertex corner;
+
+        MCGLTexCoord texCoord;
+
+        MCGLColor color;
+    };
+
+    std::vector<ParticleVertex> m_vertices;
+
+    //! Texture coordinates of the quad corners mapped by mapTexCoords().
+    std::vector<MCGLTexCoord> m_surfaceTexCoords;
+
+    MCRadixSort<MCObject *> m_sorter;
 
-    MCGLVertex * m_normals;
+    //! Capacity of the ring buffer in particles.
+    int m_ringCapacity;
 
-    MCGLTexCoord * m_texCoords;
+    //! Next free particle in the ring buffer.
+    int m_ringHead;
 
-    MCGLColor * m_colors;
+    //! First vertex of the current batch in the ring buffer.
+    int m_firstVertex;
 
     friend class MCWorldRenderer;
 };
@@ -19,7 +19,10 @@
 
 #include "mcsurfaceparticlerendererlegacy.hh"
 
+#include "mcglstate.hh"
 #include "mcmathutil.hh"
+#include "mcparticlesystem.hh"
+#include "mcsurface.hh"
 #include "mcsurfaceparticle.hh"
 #include "mctrigonom.hh"
 
@@ -94,6 +97,13 @@ void MCSurfaceParticleRendererLegacy::setBatch(MCRenderLayer::ObjectBatch & batc
     // Take common properties from the first particle in the batch
     MCSurfaceParticle * particle = dynamic_cast<MCSurfaceParticle *>(batch.objects.at(0));
     setMaterial(particle->surface().material());
+
+    // Map the texture coordinates in case the surface is on an atlas
+    MCGLTexCoord surfaceTexCoords[NUM_VERTICES_PER_PARTICLE];
+    for (int j = 0; j < NUM_VERTICES_PER_PARTICLE; j++)
+    {
+        surfaceTexCoords[j] = particle->surface().mapTexCoord(texCoords[j]);
+    }
     setHasShadow(particle->hasShadow());
     setAlphaBlend(particle->useAlphaBlend(), particle->alphaSrc(), particle->alphaDst());
 
@@ -101,7 +111,8 @@ void MCSurfaceParticleRendererLegacy::setBatch(MCRenderLayer::ObjectBatch & batc
     for (int i = 0; i < batchSize(); i++)
     {
         MCSurfaceParticle * particle = static_cast<MCSurfaceParticle *>(batch.objects[i]);
-        MCVector3dF location(particle->location());
+        MCVector3dF location(particle->shape()->renderLocation());
+        const float angle = particle->shape()->renderAngle();
 
         float x, y, z;
 
@@ -147,13 +158,118 @@ void MCSurfaceParticleRendererLegacy::setBatch(MCRenderLayer::ObjectBatch & batc
 
             m_vertices[vertexIndex] =
                 MCGLVertex(
-                    x + MCMathUtil::rotatedX(vertexX, vertexY, particle->angle()),
-                    y + MCMathUtil::rotatedY(vertexX, vertexY, particle->angle()),
+                    x + MCMathUtil::rotatedX(vertexX, vertexY, angle),
+                    y + MCMathUtil::rotatedY(vertexX, vertexY, angle),
                     z);
 
             m_normals[vertexIndex] = normals[j];
 
-            m_texCoords[vertexIndex] = texCoords[j];
+            m_texCoords[vertexIndex] = surfaceTexCoords[j];
+
+            vertexIndex++;
+        }
+    }
+}
+
+void MCSurfaceParticleRendererLegacy::setBatch(
+    MCParticleSystem & particleSystem, const unsigned int * indices, int count, MCCamera * camera, bool isShadow)
+{
+    if (!count || !particleSystem.surface()) {
+        return;
+    }
+
+    setBatchSize(std::min(count, maxBatchSize()));
+
+    static const MCGLVertex corners[NUM_VERTICES_PER_PARTICLE] =
+    {
+    #ifdef __MC_GLES__
+        {-1, -1, 0},
+        { 1,  1, 0},
+    #endif
+        {-1,  1, 0},
+        {-1, -1, 0},
+        { 1, -1, 0},
+        { 1,  1, 0}
+    };
+
+    static const MCGLTexCoord texCoords[NUM_VERTICES_PER_PARTICLE] =
+    {
+    #ifdef __MC_GLES__
+        {0, 0},
+        {1, 1},
+    #endif
+        {0, 1},
+        {0, 0},
+        {1, 0},
+        {1, 1}
+    };
+
+    MCSurface & surface = *particleSystem.surface();
+    setMaterial(surface.material());
+
+    // Map the texture coordinates in case the surface is on an atlas
+    MCGLTexCoord surfaceTexCoords[NUM_VERTICES_PER_PARTICLE];
+    for (int j = 0; j < NUM_VERTICES_PER_PARTICLE; j++)
+    {
+        surfaceTexCoords[j] = surface.mapTexCoord(texCoords[j]);
+    }
+    setHasShadow(particleSystem.hasShadow());
+    setAlphaBlend(particleSystem.useAlphaBlend(), particleSystem.alphaSrc(), particleSystem.alphaDst());
+
+    const MCParticle::AnimationStyle style = particleSystem.animationStyle();
+    const MCVector3dF & shadowOffset = particleSystem.shadowOffset();
+    int vertexIndex = 0;
+    for (int i = 0; i < batchSize(); i++)
+    {
+        const unsigned int index = indices[i];
+        const MCVector3dF location(particleSystem.renderLocation(index));
+        const float angle = particleSystem.renderAngle(index);
+
+        float x = location.i();
+        float y = location.j();
+        float z = location.k();
+
+        if (isShadow)
+        {
+            x += shadowOffset.i();
+            y += shadowOffset.j();
+            z = shadowOffset.k();
+        }
+
+        if (camera)
+        {
+            camera->mapToCamera(x, y);
+        }
+
+        const float scale = particleSystem.scale(index);
+        float radius = particleSystem.radius(index);
+        MCGLColor color = particleSystem.color(index);
+        if (style == MCParticle::AnimationStyle::FadeOut || style == MCParticle::AnimationStyle::FadeOutAndExpand)
+        {
+            color.setA(color.a() * scale);
+        }
+
+        if (style == MCParticle::AnimationStyle::Shrink || style == MCParticle::AnimationStyle::FadeOutAndExpand)
+        {
+            radius *= scale;
+        }
+
+        for (int j = 0; j < NUM_VERTICES_PER_PARTICLE; j++)
+        {
+            const float vertexX = corners[j].x() * radius;
+            const float vertexY = corners[j].y() * radius;
+
+            m_vertices[vertexIndex] =
+                MCGLVertex(
+                    x + MCMathUtil::rotatedX(vertexX, vertexY, angle),
+                    y + MCMathUtil::rotatedY(vertexX, vertexY, angle),
+                    z);
+
+            m_normals[vertexIndex] = MCGLVertex(0, 0, 1);
+
+            m_texCoords[vertexIndex] = surfaceTexCoords[j];
+
+            m_colors[vertexIndex] = color;
 
             vertexIndex++;
         }
@@ -184,7 +300,7 @@ void MCSurfaceParticleRendererLegacy::render()
     shaderProgram()->setColor(MCGLColor(1.0f, 1.0f, 1.0f, 1.0f));
 
     // Be sure active VBO is disabled because we are using client-side arrays here for dynamic data
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    releaseVBO();
 
     enableAttributePointers();
     setAttributePointers();
@@ -194,7 +310,7 @@ void MCSurfaceParticleRendererLegacy::render()
 #else
     glDrawArrays(GL_QUADS, 0, batchSize() * NUM_VERTICES_PER_PARTICLE);
 #endif
-    glDisable(GL_BLEND);
+    MCGLState::disableBlend();
 }
 
 void MCSurfaceParticleRendererLegacy::renderShadows()
@@ -208,7 +324,7 @@ void MCSurfaceParticleRendererLegacy::renderShadows()
     shadowShaderProgram()->setScale(1.0f, 1.0f, 1.0f);
 
     // Be sure active VBO is disabled because we are using client-side arrays here for dynamic data
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    releaseVBO();
 
     enableAttributePointers();
     setAttributePointers();
@@ -58,6 +58,10 @@ private:
      *  \param camera The camera window. */
     void setBatch(MCRenderLayer::ObjectBatch & batch, MCCamera * camera = nullptr, bool isShadow = false) override;
 
+    //! \reimp
+    void setBatch(
+        MCParticleSystem & particleSystem, const unsigned int * indices, int count, MCCamera * camera = nullptr, bool isShadow = false) override;
+
     //! Render the current particle batch.
     void render() override;
 
@@ -20,82 +20,107 @@
 #include "mcworldrenderer.hh"
 
 #include "mccamera.hh"
+#include "mcglstate.hh"
 #include "mclogger.hh"
+#include "mcsurfaceobjectrenderer.hh"
+#include "mcsurfaceobjectrendererlegacy.hh"
 #include "mcsurfaceparticle.hh"
 #include "mcsurfaceparticlerenderer.hh"
 #include "mcsurfaceparticlerendererlegacy.hh"
 #include "mcobject.hh"
 #include "mcparticle.hh"
+#include "mcparticlesystem.hh"
+#include "mcprofiler.hh"
 #include "mcshape.hh"
 #include "mcshapeview.hh"
+#include "mcsurface.hh"
 #include "mcsurfaceview.hh"
 
 #include <algorithm>
+#include <cassert>
+#include <mutex>
 
 #include <MCGLEW>
 
-MCWorldRenderer::MCWorldRenderer()
-    : m_surfaceParticleRenderer(nullptr)
+namespace {
+std::mutex & glSceneMutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+//! Return the scene of the renderers that are still alive or create a new one.
+std::shared_ptr<MCGLScene> sharedGLScene()
+{
+    static std::weak_ptr<MCGLScene> scene;
+
+    std::lock_guard<std::mutex> lock(glSceneMutex());
+    std::shared_ptr<MCGLScene> result = scene.lock();
+    if (!result)
+    {
+        // Delete under the lock so that a new scene is never created before the old one is gone
+        result.reset(new MCGLScene, [] (MCGLScene * oldScene) {
+            std::lock_guard<std::mutex> lock(glSceneMutex());
+            delete oldScene;
+        });
+        scene = result;
+    }
+
+    return result;
+}
+}
+
+MCWorldRenderer::MCWorldRenderer(MCWorld & world)
+    : m_world(world)
+    , m_surfaceObjectRenderer(nullptr)
+    , m_surfaceParticleRenderer(nullptr)
+    , m_drawCallCount(0)
+    , m_glScene(sharedGLScene())
 {
 }
 
 MCGLScene & MCWorldRenderer::glScene()
 {
-    return m_glScene;
+    return *m_glScene;
 }
 
 void MCWorldRenderer::buildObjectBatches(MCCamera * camera)
 {
-    m_defaultLayer.objectBatches()[camera].clear();
-    auto & batchVector = m_defaultLayer.objectBatches()[camera];
-    static std::vector<MCObject *> childStack;
-    childStack.clear();
-    for (auto && object : MCWorld::instance().objectGrid().getObjectsWithinBBox(camera->bbox()))
+    MC_PROFILE_ZONE("MCWorldRenderer::buildObjectBatches");
+
+    auto & batches = m_defaultLayer.objectBatches()[camera];
+    batches.reset();
+    m_childStack.clear();
+    for (auto && object : m_world.objectGrid().getObjectsWithinBBox(camera->bbox()))
     {
-        childStack.push_back(object);
-        while (childStack.size())
+        m_childStack.push_back(object);
+        while (m_childStack.size())
         {
-            auto parent = childStack.back();
-            childStack.pop_back();
+            auto parent = m_childStack.back();
+            m_childStack.pop_back();
 
             if (parent->isRenderable() && parent->shape() && parent->shape()->view())
             {
                 const int objectViewId = object->typeId() * 1024 + parent->shape()->view()->viewId();
-                auto batchIter = std::find_if(batchVector.begin(), batchVector.end(), [&](const MCRenderLayer::ObjectBatch & batch) {
-                    return batch.objectViewId == objectViewId;
-                });
-                if (batchIter != batchVector.end())
-                {
-                    auto & batch = (*batchIter);
-                    batch.objects.push_back(parent);
-                    batch.priority = std::max(parent->location().k(), batch.priority);
-                }
-                else
-                {
-                    MCRenderLayer::ObjectBatch batch;
-                    batch.objectViewId = objectViewId;
-                    batch.objects.push_back(parent);
-                    batch.priority = parent->location().k();
-                    batchVector.push_back(batch);
-                }
+                batches.add(objectViewId, parent, parent->location().k());
             }
 
             for (auto child : parent->children())
             {
-                childStack.push_back(child.get());
+                m_childStack.push_back(child.get());
             }
         }
     }
 
-    std::stable_sort(batchVector.begin(), batchVector.end(), [](const MCRenderLayer::ObjectBatch & l, const MCRenderLayer::ObjectBatch & r) {
-        return l.priority < r.priority;
-    });
+    batches.sort();
 }
 
 void MCWorldRenderer::buildParticleBatches(MCCamera * camera)
 {
-    m_defaultLayer.particleBatches()[camera].clear();
-    auto & batchVector = m_defaultLayer.particleBatches()[camera];
+    MC_PROFILE_ZONE("MCWorldRenderer::buildParticleBatches");
+
+    auto & batches = m_defaultLayer.particleBatches()[camera];
+    batches.reset();
     for (auto && particleIter : m_particleSet)
     {
         MCParticle & particle = *particleIter;
@@ -107,50 +132,83 @@ void MCWorldRenderer::buildParticleBatches(MCCamera * camera)
 
         if (camera->isVisible(bbox))
         {
-            auto batchIter = std::find_if(batchVector.begin(), batchVector.end(), [&](const MCRenderLayer::ObjectBatch & batch) {
-                return batch.objectViewId == static_cast<int>(particle.typeId());
-            });
-            if (batchIter != batchVector.end())
-            {
-                auto & batch = (*batchIter);
-                batch.objects.push_back(&particle);
-                batch.priority = std::max(particle.location().k(), batch.priority);
-            }
-            else
-            {
-                MCRenderLayer::ObjectBatch batch;
-                batch.objectViewId = particle.typeId();
-                batch.objects.push_back(&particle);
-                batch.priority = particle.location().k();
-                batchVector.push_back(batch);
-            }
+            batches.add(static_cast<int>(particle.typeId()), &particle, particle.location().k());
         }
         else
         {
             // Optimization that kills non-visible particles.
-            if (particle.dieWhenOffScreen())
+            if (particle.dieWhenOffScreen() && !isVisibleInOtherCamera(bbox, camera))
             {
-                bool isVisibleInAnyCamera = false;
-                for (MCCamera * visibilityCamera : m_visibilityCameras)
-                {
-                    if (visibilityCamera != camera && visibilityCamera->isVisible(bbox))
-                    {
-                        isVisibleInAnyCamera = true;
-                        break;
-                    }
-                }
+                particle.die();
+            }
+        }
+    }
 
-                if (!isVisibleInAnyCamera)
-                {
-                    particle.die();
-                }
+    batches.sort();
+}
+
+void MCWorldRenderer::buildParticleSystemBatches(MCCamera * camera)
+{
+    MC_PROFILE_ZONE("MCWorldRenderer::buildParticleSystemBatches");
+
+    auto & batches = m_defaultLayer.particleSystemBatches()[camera];
+    const auto & particleSystems = m_world.particleSystems();
+    batches.resize(particleSystems.size());
+
+    for (size_t i = 0; i < particleSystems.size(); i++)
+    {
+        MCParticleSystem & particleSystem = *particleSystems[i];
+        MCRenderLayer::ParticleSystemBatch & batch = batches[i];
+        batch.particleSystem = &particleSystem;
+        batch.indices.clear();
+
+        if (!particleSystem.surface())
+        {
+            continue;
+        }
+
+        for (unsigned int index = 0; index < particleSystem.count(); index++)
+        {
+            const MCVector3dF location(particleSystem.location(index));
+            const float radius = particleSystem.radius(index);
+            const MCBBoxF bbox(location.i() - radius, location.j() - radius, location.i() + radius, location.j() + radius);
+
+            if (camera->isVisible(bbox))
+            {
+                batch.priority = batch.indices.empty() ? location.k() : std::max(location.k(), batch.priority);
+                batch.indices.push_back(index);
+            }
+            else if (particleSystem.dieWhenOffScreen() && !isVisibleInOtherCamera(bbox, camera))
+            {
+                // Killed particles stay until the next step, so the indices remain valid
+                particleSystem.kill(index);
             }
         }
+
+        particleSystem.sortByZ(batch.indices);
     }
 
-    std::stable_sort(batchVector.begin(), batchVector.end(), [](const MCRenderLayer::ObjectBatch & l, const MCRenderLayer::ObjectBatch & r) {
-        return l.priority < r.priority;
-    });
+    // Insertion sort is stable and doesn't allocate. Swapping the batches only swaps the index vectors.
+    for (size_t i = 1; i < batches.size(); i++)
+    {
+        for (size_t j = i; j > 0 && batches[j].priority < batches[j - 1].priority; j--)
+        {
+            std::swap(batches[j], batches[j - 1]);
+        }
+    }
+}
+
+bool MCWorldRenderer::isVisibleInOtherCamera(const MCBBoxF & bbox, MCCamera * camera) const
+{
+    for (MCCamera * visibilityCamera : m_visibilityCameras)
+    {
+        if (visibilityCamera != camera && visibilityCamera->isVisible(bbox))
+        {
+            return true;
+        }
+    }
+
+    return false;
 }
 
 void MCWorldRenderer::buildBatches(MCCamera * camera)
@@ -168,6 +226,11 @@ void MCWorldRenderer::buildBatches(MCCamera * camera)
         return;
     }
 
+    if (!m_surfaceObjectRenderer)
+    {
+        createSurfaceObjectRenderer();
+    }
+
     if (!m_surfaceParticleRenderer)
     {
         createSurfaceParticleRenderer();
@@ -176,6 +239,8 @@ void MCWorldRenderer::buildBatches(MCCamera * camera)
     buildObjectBatches(camera);
 
     buildParticleBatches(camera);
+
+    buildParticleSystemBatches(camera);
 }
 
 void MCWorldRenderer::render(MCCamera * camera, MCRenderGroup renderGroup)
@@ -201,47 +266,45 @@ void MCWorldRenderer::render(MCCamera * camera, MCRenderGroup renderGroup)
 
 void MCWorldRenderer::renderObjects(MCCamera * camera)
 {
-    if (m_defaultLayer.depthTestEnabled())
-    {
-        glEnable(GL_DEPTH_TEST);
-    }
-    else
-    {
-        glDisable(GL_DEPTH_TEST);
-    }
+    MC_PROFILE_ZONE("MCWorldRenderer::renderObjects");
 
-    glDepthMask(m_defaultLayer.depthMaskEnabled());
+    MCGLState::setDepthTest(m_defaultLayer.depthTestEnabled());
+    MCGLState::setDepthMask(m_defaultLayer.depthMaskEnabled());
 
     renderObjectBatches(camera, m_defaultLayer);
 
-    glDepthMask(GL_TRUE);
+    MCGLState::setDepthMask(true);
 }
 
 void MCWorldRenderer::renderParticles(MCCamera * camera)
 {
-    if (m_defaultLayer.depthTestEnabled())
-    {
-        glEnable(GL_DEPTH_TEST);
-    }
-    else
-    {
-        glDisable(GL_DEPTH_TEST);
-    }
+    MC_PROFILE_ZONE("MCWorldRenderer::renderParticles");
 
-    glDepthMask(m_defaultLayer.depthMaskEnabled());
+    MCGLState::setDepthTest(m_defaultLayer.depthTestEnabled());
+    MCGLState::setDepthMask(m_defaultLayer.depthMaskEnabled());
 
     renderParticleBatches(camera, m_defaultLayer);
 
-    glDepthMask(GL_TRUE);
+    renderParticleSystemBatches(camera, m_defaultLayer, false);
+
+    MCGLState::setDepthMask(true);
 }
 
 void MCWorldRenderer::renderObjectBatches(MCCamera * camera, MCRenderLayer & layer)
 {
-    for (auto && batch : layer.objectBatches()[camera])
+    auto & batches = layer.objectBatches()[camera];
+    for (size_t index = 0; index < batches.size(); index++)
     {
+        auto & batch = batches[index];
         const int itemCountInBatch = static_cast<const int>(batch.objects.size());
         if (itemCountInBatch > 0)
         {
+            if (batchSurface(batch))
+            {
+                renderSurfaceObjectBatch(camera, mergeSurfaceBatches(batches, index, false), false);
+                continue;
+            }
+
             MCObject * object = batch.objects[0];
             std::shared_ptr<MCShapeView> view = object->shape()->view();
 
@@ -256,10 +319,116 @@ void MCWorldRenderer::renderObjectBatches(MCCamera * camera, MCRenderLayer & lay
             object = batch.objects[itemCountInBatch - 1];
             object->render(camera);
             view->release();
+
+            m_drawCallCount += itemCountInBatch;
         }
     }
 }
 
+MCSurface * MCWorldRenderer::batchSurface(const MCRenderLayer::ObjectBatch & batch) const
+{
+    // Objects can be drawn with a single call only if they all use the same surface
+    const MCSurfaceView * view = dynamic_cast<const MCSurfaceView *>(batch.objects[0]->shape()->view().get());
+    if (!view)
+    {
+        return nullptr;
+    }
+
+    MCSurface * surface = view->surface();
+    const bool isShared = std::all_of(batch.objects.begin(), batch.objects.end(), [surface] (const MCObject * object) {
+        return object->shape()->view()->object() == surface;
+    });
+
+    return isShared ? surface : nullptr;
+}
+
+bool MCWorldRenderer::canShareDrawCall(const MCSurface & l, const MCSurface & r) const
+{
+    // Everything but the vertex data must be the same
+    return l.atlasId() && l.atlasId() == r.atlasId() &&
+        l.shaderProgram() == r.shaderProgram() &&
+        l.shadowShaderProgram() == r.shadowShaderProgram() &&
+        l.color() == r.color() &&
+        *l.material() == *r.material();
+}
+
+MCRenderLayer::ObjectBatch & MCWorldRenderer::mergeSurfaceBatches(
+    MCRenderLayer::BatchList & batches, size_t & index, bool isShadow)
+{
+    const MCSurface * surface = batchSurface(batches[index]);
+    assert(surface);
+
+    size_t last = index;
+    while (last + 1 < batches.size())
+    {
+        const auto & next = batches[last + 1];
+        if (!next.objects.size() || (isShadow && !next.objects[0]->shape()->view()->hasShadow()))
+        {
+            break;
+        }
+
+        const MCSurface * nextSurface = batchSurface(next);
+        if (!nextSurface || !canShareDrawCall(*surface, *nextSurface))
+        {
+            break;
+        }
+
+        last++;
+    }
+
+    if (last == index)
+    {
+        return batches[index];
+    }
+
+    m_mergedBatch.objects.clear();
+    for (; index <= last; index++)
+    {
+        m_mergedBatch.objects.insert(m_mergedBatch.objects.end(), batches[index].objects.begin(), batches[index].objects.end());
+    }
+
+    index = last;
+    return m_mergedBatch;
+}
+
+void MCWorldRenderer::renderSurfaceObjectBatch(MCCamera * camera, MCRenderLayer::ObjectBatch & batch, bool isShadow)
+{
+    const size_t chunkSize = static_cast<size_t>(m_surfaceObjectRenderer->maxBatchSize());
+    for (size_t first = 0; first < batch.objects.size(); first += chunkSize)
+    {
+        MCRenderLayer::ObjectBatch * chunk = &batch;
+        if (batch.objects.size() > chunkSize)
+        {
+            m_batchChunk.objects.assign(
+                batch.objects.begin() + first, batch.objects.begin() + std::min(first + chunkSize, batch.objects.size()));
+            chunk = &m_batchChunk;
+        }
+
+        m_surfaceObjectRenderer->setBatch(*chunk, camera, isShadow);
+        if (isShadow)
+        {
+            m_surfaceObjectRenderer->renderShadows();
+        }
+        else
+        {
+            m_surfaceObjectRenderer->render();
+        }
+
+        m_drawCallCount++;
+    }
+}
+
+void MCWorldRenderer::createSurfaceObjectRenderer()
+{
+#ifdef __MC_GLES__
+    MCLogger().info() << "Object renderer using vertex arrays.";
+    m_surfaceObjectRenderer = new MCSurfaceObjectRendererLegacy;
+#else
+    MCLogger().info() << "Object renderer using VAO.";
+    m_surfaceObjectRenderer = new MCSurfaceObjectRenderer;
+#endif
+}
+
 void MCWorldRenderer::createSurfaceParticleRenderer()
 {
 #ifdef __MC_GLES__
@@ -273,14 +442,17 @@ void MCWorldRenderer::createSurfaceParticleRenderer()
 
 void MCWorldRenderer::renderParticleBatches(MCCamera * camera, MCRenderLayer & layer)
 {
-    for (auto && batch : layer.particleBatches()[camera])
+    auto & batches = layer.particleBatches()[camera];
+    for (size_t index = 0; index < batches.size(); index++)
     {
+        auto & batch = batches[index];
         if (batch.objects.size())
         {
             if (dynamic_cast<MCSurfaceParticle *>(batch.objects[0]))
             {
                 m_surfaceParticleRenderer->setBatch(batch, camera);
                 m_surfaceParticleRenderer->render();
+                m_drawCallCount++;
             }
         }
     }
@@ -288,33 +460,39 @@ void MCWorldRenderer::renderParticleBatches(MCCamera * camera, MCRenderLayer & l
 
 void MCWorldRenderer::renderObjectShadows(MCCamera * camera)
 {
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_DST_COLOR);
+    MC_PROFILE_ZONE("MCWorldRenderer::renderObjectShadows");
+
+    MCGLState::setDepthTest(true);
+    MCGLState::enableBlend(GL_SRC_ALPHA, GL_DST_COLOR);
 
     renderObjectShadowBatches(camera, m_defaultLayer);
 
-    glDisable(GL_BLEND);
-    glDisable(GL_DEPTH_TEST);
+    MCGLState::disableBlend();
+    MCGLState::setDepthTest(false);
 }
 
 void MCWorldRenderer::renderParticleShadows(MCCamera * camera)
 {
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_DST_COLOR);
+    MC_PROFILE_ZONE("MCWorldRenderer::renderParticleShadows");
+
+    MCGLState::setDepthTest(true);
+    MCGLState::enableBlend(GL_SRC_ALPHA, GL_DST_COLOR);
 
     renderParticleShadowBatches(camera, m_defaultLayer);
 
-    glDisable(GL_BLEND);
-    glDisable(GL_DEPTH_TEST);
+    renderParticleSystemBatches(camera, m_defaultLayer, true);
+
+    MCGLState::disableBlend();
+    MCGLState::setDepthTest(false);
 }
 
 void MCWorldRenderer::renderObjectShadowBatches(MCCamera * camera, MCRenderLayer & layer)
 {
     // Render batches
-    for (auto && batch : layer.objectBatches()[camera])
+    auto & batches = layer.objectBatches()[camera];
+    for (size_t index = 0; index < batches.size(); index++)
     {
+        auto & batch = batches[index];
         const int itemCountInBatch = static_cast<const int>(batch.objects.size());
         if (itemCountInBatch > 0)
         {
@@ -322,6 +500,12 @@ void MCWorldRenderer::renderObjectShadowBatches(MCCamera * camera, MCRenderLayer
             std::shared_ptr<MCShapeView> view = object->shape()->view();
             if (view && view->hasShadow())
             {
+                if (batchSurface(batch))
+                {
+                    renderSurfaceObjectBatch(camera, mergeSurfaceBatches(batches, index, true), true);
+                    continue;
+                }
+
                 view->bindShadow();
                 object->renderShadow(camera);
 
@@ -333,6 +517,8 @@ void MCWorldRenderer::renderObjectShadowBatches(MCCamera * camera, MCRenderLayer
                 object = batch.objects[itemCountInBatch - 1];
                 object->renderShadow(camera);
                 view->releaseShadow();
+
+                m_drawCallCount += itemCountInBatch;
             }
         }
     }
@@ -340,8 +526,10 @@ void MCWorldRenderer::renderObjectShadowBatches(MCCamera * camera, MCRenderLayer
 
 void MCWorldRenderer::renderParticleShadowBatches(MCCamera * camera, MCRenderLayer & layer)
 {
-    for (auto && batch : layer.particleBatches()[camera])
+    auto & batches = layer.particleBatches()[camera];
+    for (size_t index = 0; index < batches.size(); index++)
     {
+        auto & batch = batches[index];
         if (batch.objects.size())
         {
             // Currently support shadows only for surface particles.
@@ -351,12 +539,42 @@ void MCWorldRenderer::renderParticleShadowBatches(MCCamera * camera, MCRenderLay
                 {
                     m_surfaceParticleRenderer->setBatch(batch, camera, true);
                     m_surfaceParticleRenderer->renderShadows();
+                    m_drawCallCount++;
                 }
             }
         }
     }
 }
 
+void MCWorldRenderer::renderParticleSystemBatches(MCCamera * camera, MCRenderLayer & layer, bool isShadow)
+{
+    const size_t chunkSize = static_cast<size_t>(m_surfaceParticleRenderer->maxBatchSize());
+    for (auto && batch : layer.particleSystemBatches()[camera])
+    {
+        if (isShadow && !batch.particleSystem->hasShadow())
+        {
+            continue;
+        }
+
+        // Batches larger than the renderer can take are drawn in sorted chunks
+        for (size_t first = 0; first < batch.indices.size(); first += chunkSize)
+        {
+            const int count = static_cast<int>(std::min(chunkSize, batch.indices.size() - first));
+            m_surfaceParticleRenderer->setBatch(*batch.particleSystem, &batch.indices[first], count, camera, isShadow);
+            if (isShadow)
+            {
+                m_surfaceParticleRenderer->renderShadows();
+            }
+            else
+            {
+                m_surfaceParticleRenderer->render();
+            }
+
+            m_drawCallCount++;
+        }
+    }
+}
+
 void MCWorldRenderer::enableDepthTest(bool enable)
 {
     m_defaultLayer.setDepthTestEnabled(enable);
@@ -395,6 +613,17 @@ void MCWorldRenderer::removeObject(MCObject & object)
     }
 }
 
+void MCWorldRenderer::removeParticleSystem(MCParticleSystem & particleSystem)
+{
+    for (auto && cameraBatches : m_defaultLayer.particleSystemBatches())
+    {
+        auto & batches = cameraBatches.second;
+        batches.erase(std::remove_if(batches.begin(), batches.end(), [&particleSystem] (const MCRenderLayer::ParticleSystemBatch & batch) {
+            return batch.particleSystem == &particleSystem;
+        }), batches.end());
+    }
+}
+
 void MCWorldRenderer::addParticleVisibilityCamera(MCCamera & camera)
 {
     m_visibilityCameras.push_back(&camera);
@@ -416,7 +645,18 @@ void MCWorldRenderer::clear()
     m_particleSet.clear();
 }
 
+unsigned int MCWorldRenderer::drawCallCount() const
+{
+    return m_drawCallCount;
+}
+
+void MCWorldRenderer::resetDrawCallCount()
+{
+    m_drawCallCount = 0;
+}
+
 MCWorldRenderer::~MCWorldRenderer()
 {
+    delete m_surfaceObjectRenderer;
     delete m_surfaceParticleRenderer;
 }
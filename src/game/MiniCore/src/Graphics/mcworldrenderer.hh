@@ -24,8 +24,10 @@
 #include "mcrenderlayer.hh"
 #include "mcrendergroup.hh"
 
+#include "mcbbox.hh"
 #include "mcworld.hh"
 
+#include <memory>
 #include <set>
 #include <vector>
 
@@ -33,13 +35,16 @@ class MCCamera;
 class MCObject;
 class MCObjectRendererBase;
 class MCParticleRendererBase;
+class MCParticleSystem;
+class MCSurface;
 
 //! Helper class used by MCWorld. Renders all objects in the scene.
 class MCWorldRenderer
 {
 public:
 
-    MCWorldRenderer();
+    //! Constructor.
+    explicit MCWorldRenderer(MCWorld & world);
 
     ~MCWorldRenderer();
 
@@ -66,6 +71,9 @@ public:
 
     void removeObject(MCObject & object);
 
+    //! Forget the batches of the given particle system. Called by MCWorld when the system is removed.
+    void removeParticleSystem(MCParticleSystem & particleSystem);
+
     /*! Must be called before calls to render() or renderShadows() */
     void buildBatches(MCCamera * camera);
 
@@ -74,14 +82,43 @@ public:
 
     void clear();
 
+    /*! \return Number of object and particle draw calls issued by render() since the
+     *  latest call to resetDrawCallCount(). Batches of objects that share a surface are drawn
+     *  with one call and consecutive batches of surfaces on the same atlas page are merged,
+     *  other objects are drawn one by one. */
+    unsigned int drawCallCount() const;
+
+    //! Reset the draw call count. Call once per frame, before rendering the first camera.
+    void resetDrawCallCount();
+
 private:
 
     void buildObjectBatches(MCCamera * camera);
 
     void buildParticleBatches(MCCamera * camera);
 
+    void buildParticleSystemBatches(MCCamera * camera);
+
+    //! \return true if the box is visible in a visibility camera other than the given one.
+    bool isVisibleInOtherCamera(const MCBBoxF & bbox, MCCamera * camera) const;
+
+    void createSurfaceObjectRenderer();
+
     void createSurfaceParticleRenderer();
 
+    //! \return The surface shared by all objects of the batch or nullptr.
+    MCSurface * batchSurface(const MCRenderLayer::ObjectBatch & batch) const;
+
+    //! \return true if objects of the given surfaces can be drawn with the same call.
+    bool canShareDrawCall(const MCSurface & l, const MCSurface & r) const;
+
+    /*! Merge the batches following batches[index] that can be drawn with the same call.
+     *  \return The merged batch. index is moved to the last batch included in it. */
+    MCRenderLayer::ObjectBatch & mergeSurfaceBatches(
+        MCRenderLayer::BatchList & batches, size_t & index, bool isShadow);
+
+    void renderSurfaceObjectBatch(MCCamera * camera, MCRenderLayer::ObjectBatch & batch, bool isShadow);
+
     void renderObjects(MCCamera * camera);
 
     void renderObjectShadows(MCCamera * camera);
@@ -98,6 +135,8 @@ private:
 
     void renderParticleShadowBatches(MCCamera * camera, MCRenderLayer & layer);
 
+    void renderParticleSystemBatches(MCCamera * camera, MCRenderLayer & layer, bool isShadow);
+
     MCRenderLayer m_defaultLayer;
 
     typedef std::vector<MCParticle *> ParticleSet;
@@ -105,9 +144,25 @@ private:
 
     std::vector<MCCamera *> m_visibilityCameras;
 
+    MCWorld & m_world;
+
+    //! Scratch stack used when traversing object hierarchies. Keeps its capacity between frames.
+    std::vector<MCObject *> m_childStack;
+
+    MCObjectRendererBase * m_surfaceObjectRenderer;
+
+    //! Scratch batch used when a batch doesn't fit in the object renderer at once.
+    MCRenderLayer::ObjectBatch m_batchChunk;
+
+    //! Scratch batch for batches merged by mergeSurfaceBatches().
+    MCRenderLayer::ObjectBatch m_mergedBatch;
+
     MCParticleRendererBase * m_surfaceParticleRenderer;
 
-    MCGLScene m_glScene;
+    unsigned int m_drawCallCount;
+
+    //! There's only one GL context, so all worlds share the same scene.
+    std::shared_ptr<MCGLScene> m_glScene;
 
     friend class MCObject;
 };
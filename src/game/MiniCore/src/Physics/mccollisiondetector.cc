@@ -19,77 +19,93 @@
 
 #include "mccollisiondetector.hh"
 #include "mccontact.hh"
+#include "mcframearena.hh"
 #include "mcobject.hh"
+#include "mcprofiler.hh"
 #include "mcsegment.hh"
 #include "mcshape.hh"
 #include "mccircleshape.hh"
 #include "mcrectshape.hh"
 #include "mccollisionevent.hh"
+#include "mcworkerpool.hh"
 
-MCCollisionDetector::MCCollisionDetector()
-: m_arePrimaryCollisionEventsEnabled(true)
+#include <algorithm>
+
+namespace {
+// Don't bother waking up worker threads for just a few possible collisions.
+const unsigned int MIN_POSSIBLE_COLLISIONS_PER_THREAD = 64;
+}
+
+MCCollisionDetector::MCCollisionDetector(MCFrameArena & frameArena)
+: m_frameArena(frameArena)
+, m_batches(1)
 {}
 
-void MCCollisionDetector::enablePrimaryCollisionEvents(bool enable)
+void MCCollisionDetector::setThreadCount(unsigned int threadCount)
 {
-    m_arePrimaryCollisionEventsEnabled = enable;
+    threadCount = std::max(threadCount, 1u);
+    if (threadCount != this->threadCount())
+    {
+        m_workerPool.reset(threadCount > 1 ? new MCWorkerPool(threadCount) : nullptr);
+        m_batches.resize(threadCount);
+    }
 }
 
-bool MCCollisionDetector::testRectAgainstRect(MCRectShape & rect1, MCRectShape & rect2)
+unsigned int MCCollisionDetector::threadCount() const
 {
-    const MCOBBox<float> & obbox1(rect1.obbox());
+    return m_workerPool ? m_workerPool->threadCount() : 1;
+}
 
-    bool collided = false;
+void MCCollisionDetector::addContact(MCObject & object, MCContact & contact)
+{
+    if (object.contacts().empty())
+    {
+        m_objectsWithContacts.push_back(&object);
+    }
 
-    // Loop thru all vertices of rect1 and generate contacts for colliding vertices.
-    for (unsigned int i = 0; i < 4; i++)
+    object.addContact(contact);
+}
+
+void MCCollisionDetector::releaseContacts()
+{
+    for (MCObject * object : m_objectsWithContacts)
     {
-        if (rect2.contains(obbox1.vertex(i)))
-        {
-            const bool triggerObjectInvolved = rect1.parent().isTriggerObject() || rect2.parent().isTriggerObject();
+        object->deleteContacts();
+    }
 
-            // Send collision event to owner of rect1
-            MCCollisionEvent ev1(rect2.parent(), obbox1.vertex(i), m_arePrimaryCollisionEventsEnabled);
-            MCObject::sendEvent(rect1.parent(), ev1);
+    m_objectsWithContacts.clear();
+}
 
-            // Send collision event to owner of rect2
-            MCCollisionEvent ev2(rect1.parent(), obbox1.vertex(i), m_arePrimaryCollisionEventsEnabled);
-            MCObject::sendEvent(rect2.parent(), ev2);
+void MCCollisionDetector::releaseContacts(MCObject & object)
+{
+    object.deleteContacts();
 
-            if (!triggerObjectInvolved && (ev1.accepted() && ev2.accepted())) // Trigger objects should only trigger events
-            {
-                MCVector2dF contactNormal;
-                MCVector2dF vertex = obbox1.vertex(i);
-                float depth = rect2.interpenetrationDepth(
-                    MCSegment<float>(vertex, rect1.location()), contactNormal);
-
-                {
-                    MCContact & contact = MCContact::create();
-                    contact.init(rect2.parent(), vertex, contactNormal, depth);
-                    rect1.parent().addContact(contact);
-                }
-
-                {
-                    MCContact & contact = MCContact::create();
-                    contact.init(rect1.parent(), vertex, -contactNormal, depth);
-                    rect2.parent().addContact(contact);
-                }
-
-                collided = true;
-            }
+    // The object may be deleted before the step ends
+    m_objectsWithContacts.erase(
+        std::remove(m_objectsWithContacts.begin(), m_objectsWithContacts.end(), &object),
+        m_objectsWithContacts.end());
+}
 
-            // Don't break here in the case of a collision, because we don't know
-            // yet which contact is the deepest. MCImpulseGenerator handles that.
+void MCCollisionDetector::testRectAgainstRect(const MCRectShape & rect1, const MCRectShape & rect2, HitVector & hits)
+{
+    const MCOBBox<float> & obbox1(rect1.obbox());
+
+    // Loop thru all vertices of rect1 and generate contacts for colliding vertices.
+    for (unsigned int i = 0; i < 4; i++)
+    {
+        if (rect2.contains(obbox1.vertex(i)))
+        {
+            Hit hit;
+            hit.point = obbox1.vertex(i);
+            hit.depth = rect2.interpenetrationDepth(
+                MCSegment<float>(hit.point, rect1.location()), hit.normal);
+            hits.push_back(hit);
         }
     }
-
-    return collided;
 }
 
-bool MCCollisionDetector::testRectAgainstCircle(MCRectShape & rect, MCCircleShape & circle)
+void MCCollisionDetector::testRectAgainstCircle(const MCRectShape & rect, const MCCircleShape & circle, HitVector & hits)
 {
-    bool collided = false;
-
     const MCOBBox<float> & obbox(rect.obbox());
 
     // Loop through all vertices of the rect and find possible contact points with
@@ -111,76 +127,185 @@ bool MCCollisionDetector::testRectAgainstCircle(MCRectShape & rect, MCCircleShap
         circleVertex += MCVector2dF(circle.location());
         if (rect.contains(circleVertex))
         {
-            const bool triggerObjectInvolved = rect.parent().isTriggerObject() || circle.parent().isTriggerObject();
+            Hit hit;
+            hit.point = circleVertex;
+            hit.depth = rect.interpenetrationDepth(
+                MCSegment<float>(circleVertex, circle.location()), hit.normal);
+            hits.push_back(hit);
+        }
+    }
+}
+
+void MCCollisionDetector::testCircleAgainstCircle(const MCCircleShape & circle1, const MCCircleShape & circle2, HitVector & hits)
+{
+    Hit hit;
+    hit.depth = circle2.interpenetrationDepth(circle1, hit.normal);
+    if (hit.depth > 0)
+    {
+        hit.point = MCVector2dF(circle1.location()) - hit.normal * circle1.radius();
+        hits.push_back(hit);
+    }
+}
+
+void MCCollisionDetector::testPossibleCollision(
+    MCObject & object1, MCObject & object2, HitVector & hits, PairResult & result) const
+{
+    const unsigned int id1 = object1.shape()->instanceTypeId();
+    const unsigned int id2 = object2.shape()->instanceTypeId();
+
+    result.firstHit = static_cast<unsigned int>(hits.size());
+    result.numHits = 0;
+    result.numReverseHits = 0;
+
+    // Rect against rect
+    if (id1 == MCRectShape::typeId() && id2 == MCRectShape::typeId())
+    {
+        // Static cast because we know the types now.
+        const MCRectShape & rect1 = *static_cast<MCRectShape *>(object1.shape().get());
+        const MCRectShape & rect2 = *static_cast<MCRectShape *>(object2.shape().get());
+
+        // We must test first object1 against object2 and then
+        // the other way around.
+        testRectAgainstRect(rect1, rect2, hits);
+        result.numHits = static_cast<unsigned int>(hits.size()) - result.firstHit;
+
+        testRectAgainstRect(rect2, rect1, hits);
+        result.numReverseHits = static_cast<unsigned int>(hits.size()) - result.firstHit - result.numHits;
+    }
+    // Rect against circle
+    else if (id1 == MCRectShape::typeId() && id2 == MCCircleShape::typeId())
+    {
+        // Static cast because we know the types now.
+        testRectAgainstCircle(
+            *static_cast<MCRectShape *>(object1.shape().get()),
+            *static_cast<MCCircleShape *>(object2.shape().get()), hits);
+        result.numHits = static_cast<unsigned int>(hits.size()) - result.firstHit;
+    }
+    // Circle against circle
+    else if (id1 == MCCircleShape::typeId() && id2 == MCCircleShape::typeId())
+    {
+        // Static cast because we know the types now.
+        testCircleAgainstCircle(
+            *static_cast<MCCircleShape *>(object1.shape().get()),
+            *static_cast<MCCircleShape *>(object2.shape().get()), hits);
+        result.numHits = static_cast<unsigned int>(hits.size()) - result.firstHit;
+    }
+}
+
+bool MCCollisionDetector::processRectAgainstRect(
+    MCRectShape & rect1, MCRectShape & rect2, const Hit * hits, unsigned int numHits)
+{
+    bool collided = false;
+
+    for (unsigned int i = 0; i < numHits; i++)
+    {
+        const Hit & hit = hits[i];
+        const bool triggerObjectInvolved = rect1.parent().isTriggerObject() || rect2.parent().isTriggerObject();
+
+        // Send collision event to owner of rect1
+        MCCollisionEvent ev1(rect2.parent(), hit.point);
+        MCObject::sendEvent(rect1.parent(), ev1);
+
+        // Send collision event to owner of rect2
+        MCCollisionEvent ev2(rect1.parent(), hit.point);
+        MCObject::sendEvent(rect2.parent(), ev2);
+
+        if (!triggerObjectInvolved && (ev1.accepted() && ev2.accepted())) // Trigger objects should only trigger events
+        {
+            {
+                MCContact & contact = MCContact::create(m_frameArena);
+                contact.init(rect2.parent(), hit.point, hit.normal, hit.depth);
+                addContact(rect1.parent(), contact);
+            }
+
+            {
+                MCContact & contact = MCContact::create(m_frameArena);
+                contact.init(rect1.parent(), hit.point, -hit.normal, hit.depth);
+                addContact(rect2.parent(), contact);
+            }
+
+            collided = true;
+        }
 
-            // Send collision event to owner of circle
-            MCCollisionEvent ev1(rect.parent(), circleVertex, m_arePrimaryCollisionEventsEnabled);
-            MCObject::sendEvent(circle.parent(), ev1);
+        // Don't break here in the case of a collision, because we don't know
+        // yet which contact is the deepest. MCImpulseGenerator handles that.
+    }
+
+    return collided;
+}
 
-            // Send collision event to owner of rect
-            MCCollisionEvent ev2(circle.parent(), circleVertex, m_arePrimaryCollisionEventsEnabled);
-            MCObject::sendEvent(rect.parent(), ev2);
+bool MCCollisionDetector::processRectAgainstCircle(
+    MCRectShape & rect, MCCircleShape & circle, const Hit * hits, unsigned int numHits)
+{
+    bool collided = false;
+
+    for (unsigned int i = 0; i < numHits; i++)
+    {
+        const Hit & hit = hits[i];
+        const bool triggerObjectInvolved = rect.parent().isTriggerObject() || circle.parent().isTriggerObject();
+
+        // Send collision event to owner of circle
+        MCCollisionEvent ev1(rect.parent(), hit.point);
+        MCObject::sendEvent(circle.parent(), ev1);
+
+        // Send collision event to owner of rect
+        MCCollisionEvent ev2(circle.parent(), hit.point);
+        MCObject::sendEvent(rect.parent(), ev2);
+
+        if (!triggerObjectInvolved && (ev1.accepted() && ev2.accepted())) // Trigger objects should only trigger events
+        {
+            {
+                MCContact & contact = MCContact::create(m_frameArena);
+                contact.init(rect.parent(), hit.point, hit.normal, hit.depth);
+                addContact(circle.parent(), contact);
+            }
 
-            if (!triggerObjectInvolved && (ev1.accepted() && ev2.accepted())) // Trigger objects should only trigger events
             {
-                MCVector2dF contactNormal;
-                float depth = rect.interpenetrationDepth(
-                    MCSegment<float>(circleVertex, circle.location()), contactNormal);
-
-                {
-                    MCContact & contact = MCContact::create();
-                    contact.init(rect.parent(), circleVertex, contactNormal, depth);
-                    circle.parent().addContact(contact);
-                }
-
-                {
-                    MCContact & contact = MCContact::create();
-                    contact.init(circle.parent(), circleVertex, -contactNormal, depth);
-                    rect.parent().addContact(contact);
-                }
-
-                collided = true;
+                MCContact & contact = MCContact::create(m_frameArena);
+                contact.init(circle.parent(), hit.point, -hit.normal, hit.depth);
+                addContact(rect.parent(), contact);
             }
 
-            // Don't break here in the case of a collision, because we don't know
-            // yet which contact is the deepest. MCImpulseGenerator handles that.
+            collided = true;
         }
+
+        // Don't break here in the case of a collision, because we don't know
+        // yet which contact is the deepest. MCImpulseGenerator handles that.
     }
 
     return collided;
 }
 
-bool MCCollisionDetector::testCircleAgainstCircle(MCCircleShape & circle1, MCCircleShape & circle2)
+bool MCCollisionDetector::processCircleAgainstCircle(
+    MCCircleShape & circle1, MCCircleShape & circle2, const Hit * hits, unsigned int numHits)
 {
     bool collided = false;
-    MCVector2dF contactNormal;
-    const float depth = circle2.interpenetrationDepth(circle1, contactNormal);
-    const MCVector2dF contactPoint(MCVector2dF(circle1.location()) - contactNormal * circle1.radius());
 
-    if (depth > 0)
+    for (unsigned int i = 0; i < numHits; i++)
     {
+        const Hit & hit = hits[i];
         const bool triggerObjectInvolved = circle1.parent().isTriggerObject() || circle2.parent().isTriggerObject();
 
         // Send collision event to owner of circle2
-        MCCollisionEvent ev1(circle1.parent(), contactPoint, m_arePrimaryCollisionEventsEnabled);
+        MCCollisionEvent ev1(circle1.parent(), hit.point);
         MCObject::sendEvent(circle2.parent(), ev1);
 
         // Send collision event to owner of circle1
-        MCCollisionEvent ev2(circle2.parent(), contactPoint, m_arePrimaryCollisionEventsEnabled);
+        MCCollisionEvent ev2(circle2.parent(), hit.point);
         MCObject::sendEvent(circle1.parent(), ev2);
 
         if (!triggerObjectInvolved && (ev1.accepted() && ev2.accepted())) // Trigger objects should only trigger events
         {
             {
-                MCContact & contact = MCContact::create();
-                contact.init(circle1.parent(), contactPoint, -contactNormal, depth);
-                circle2.parent().addContact(contact);
+                MCContact & contact = MCContact::create(m_frameArena);
+                contact.init(circle1.parent(), hit.point, -hit.normal, hit.depth);
+                addContact(circle2.parent(), contact);
             }
 
             {
-                MCContact & contact = MCContact::create();
-                contact.init(circle1.parent(), contactPoint, contactNormal, depth);
-                circle1.parent().addContact(contact);
+                MCContact & contact = MCContact::create(m_frameArena);
+                contact.init(circle1.parent(), hit.point, hit.normal, hit.depth);
+                addContact(circle1.parent(), contact);
             }
 
             collided = true;
@@ -190,60 +315,109 @@ bool MCCollisionDetector::testCircleAgainstCircle(MCCircleShape & circle1, MCCir
     return collided;
 }
 
-bool MCCollisionDetector::processPossibleCollision(MCObject & object1, MCObject & object2)
+bool MCCollisionDetector::processPossibleCollision(
+    MCObject & object1, MCObject & object2, const HitVector & hits, const PairResult & result)
 {
+    if (!result.numHits && !result.numReverseHits)
+    {
+        return false;
+    }
+
     const unsigned int id1 = object1.shape()->instanceTypeId();
     const unsigned int id2 = object2.shape()->instanceTypeId();
+    const Hit * pairHits = hits.data() + result.firstHit;
 
     // Rect against rect
     if (id1 == MCRectShape::typeId() && id2 == MCRectShape::typeId())
     {
-        // We must test first object1 against object2 and then
-        // the other way around.
-        if (testRectAgainstRect(
-            // Static cast because we know the types now.
-            *static_cast<MCRectShape *>(object1.shape().get()),
-            *static_cast<MCRectShape *>(object2.shape().get())))
-        {
-            return true;
-        }
-        else if (testRectAgainstRect(
-            // Static cast because we know the types now.
-            *static_cast<MCRectShape *>(object2.shape().get()),
-            *static_cast<MCRectShape *>(object1.shape().get())))
-        {
-            return true;
-        }
+        // Static cast because we know the types now.
+        MCRectShape & rect1 = *static_cast<MCRectShape *>(object1.shape().get());
+        MCRectShape & rect2 = *static_cast<MCRectShape *>(object2.shape().get());
+
+        // The other way around is processed only if object1 didn't collide with object2.
+        return processRectAgainstRect(rect1, rect2, pairHits, result.numHits) ||
+            processRectAgainstRect(rect2, rect1, pairHits + result.numHits, result.numReverseHits);
     }
     // Rect against circle
     else if (id1 == MCRectShape::typeId() && id2 == MCCircleShape::typeId())
     {
         // Static cast because we know the types now.
-        return testRectAgainstCircle(
+        return processRectAgainstCircle(
             *static_cast<MCRectShape *>(object1.shape().get()),
-            *static_cast<MCCircleShape *>(object2.shape().get()));
+            *static_cast<MCCircleShape *>(object2.shape().get()), pairHits, result.numHits);
     }
     // Circle against circle
     else if (id1 == MCCircleShape::typeId() && id2 == MCCircleShape::typeId())
     {
         // Static cast because we know the types now.
-        return testCircleAgainstCircle(
+        return processCircleAgainstCircle(
             *static_cast<MCCircleShape *>(object1.shape().get()),
-            *static_cast<MCCircleShape *>(object2.shape().get()));
+            *static_cast<MCCircleShape *>(object2.shape().get()), pairHits, result.numHits);
     }
 
     return false;
 }
 
-unsigned int MCCollisionDetector::detectCollisions(MCObjectGrid & objectGrid)
+unsigned int MCCollisionDetector::detectCollisions(const MCObjectGrid::CollisionVector & possibleCollisions)
 {
+    MC_PROFILE_ZONE("MCCollisionDetector::detectCollisions");
+
     unsigned int numCollisions = 0;
 
-    for (auto && iter : objectGrid.getPossibleCollisions())
+    const unsigned int numPossibleCollisions = static_cast<unsigned int>(possibleCollisions.size());
+    const unsigned int numBatches = std::min(
+        threadCount(), numPossibleCollisions / MIN_POSSIBLE_COLLISIONS_PER_THREAD);
+
+    if (numBatches < 2)
     {
-        numCollisions += processPossibleCollision(*iter.first, *iter.second);
+        // Serial mode: test and process each possible collision right away.
+        HitVector & hits = m_batches[0].hits;
+        PairResult result;
+        for (auto && iter : possibleCollisions)
+        {
+            hits.clear();
+            testPossibleCollision(*iter.first, *iter.second, hits, result);
+            numCollisions += processPossibleCollision(*iter.first, *iter.second, hits, result);
+        }
+
+        return numCollisions;
+    }
+
+    // Parallel mode: test contiguous ranges of possible collisions in parallel..
+    const unsigned int batchSize = (numPossibleCollisions + numBatches - 1) / numBatches;
+    m_workerPool->run(numBatches, [&] (unsigned int batchIndex) {
+        MC_PROFILE_ZONE("MCCollisionDetector::testBatch");
+
+        Batch & batch = m_batches[batchIndex];
+        batch.hits.clear();
+        batch.pairs.clear();
+
+        const unsigned int begin = batchIndex * batchSize;
+        const unsigned int end = std::min(begin + batchSize, numPossibleCollisions);
+        for (unsigned int i = begin; i < end; i++)
+        {
+            PairResult result;
+            testPossibleCollision(*possibleCollisions[i].first, *possibleCollisions[i].second, batch.hits, result);
+            batch.pairs.push_back(result);
+        }
+    });
+
+    // ..and then send events and create contacts in the original order.
+    for (unsigned int batchIndex = 0; batchIndex < numBatches; batchIndex++)
+    {
+        const Batch & batch = m_batches[batchIndex];
+        const unsigned int begin = batchIndex * batchSize;
+        for (unsigned int i = 0; i < batch.pairs.size(); i++)
+        {
+            const auto & possibleCollision = possibleCollisions[begin + i];
+            numCollisions += processPossibleCollision(
+                *possibleCollision.first, *possibleCollision.second, batch.hits, batch.pairs[i]);
+        }
     }
 
     return numCollisions;
 }
 
+MCCollisionDetector::~MCCollisionDetector()
+{
+}
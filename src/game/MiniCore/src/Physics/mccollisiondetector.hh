@@ -21,44 +21,115 @@
 #define MCCOLLISIONDETECTOR_HH
 
 #include "mcmacros.hh"
+#include "mcobjectgrid.hh"
+#include "mcvector2d.hh"
 
-
-
+#include <memory>
 #include <vector>
 
 class MCCircleShape;
+class MCContact;
+class MCFrameArena;
 class MCObject;
-class MCObjectGrid;
 class MCRectShape;
-
-//! Collision detector and contact generator.
+class MCWorkerPool;
+
+/*! Collision detector and contact generator.
+ *
+ *  The narrow phase is done in two steps: first the possible collisions are
+ *  tested geometrically, which can be done in parallel as it doesn't modify
+ *  any objects. Then collision events are sent and contacts are created in the
+ *  calling thread in the order of the possible collisions. Thus the results
+ *  are identical regardless of the thread count as long as collision event
+ *  handlers don't move objects on the XY-plane. */
 class MCCollisionDetector
 {
 public:
-    //! Constructor.
-    MCCollisionDetector();
+    /*! Constructor.
+     *  \param frameArena Arena the contacts are allocated from. */
+    explicit MCCollisionDetector(MCFrameArena & frameArena);
 
     //! Destructor.
-    virtual ~MCCollisionDetector() {};
+    virtual ~MCCollisionDetector();
+
+    /*! Detect collisions and generate contacts. Contacts are stored to MCObject.
+     *  \param possibleCollisions Possible collisions from MCObjectGrid::getPossibleCollisions(). */
+    unsigned int detectCollisions(const MCObjectGrid::CollisionVector & possibleCollisions);
+
+    /*! Set the number of threads used to test possible collisions.
+     *  The default is 1 i.e. everything is done in the calling thread. */
+    void setThreadCount(unsigned int threadCount);
+
+    //! \return the number of threads used to test possible collisions.
+    unsigned int threadCount() const;
 
-    //! Detect collisions and generate contacts. Contacts are stored to MCObject.
-    unsigned int detectCollisions(MCObjectGrid & objectGrid);
+    /*! Delete the remaining contacts of all objects that got contacts since the last call.
+     *  This must be called before the frame arena is reset, because also objects that are
+     *  not integrated (e.g. sleeping objects) may have got contacts. */
+    void releaseContacts();
 
-    /*! Turn primary collision events on/off. This is used by MCWorld when iterating
-     *  the collision resolution. */
-    void enablePrimaryCollisionEvents(bool enable);
+    //! Delete the contacts of the given object and forget it. Called when the object is removed from the world.
+    void releaseContacts(MCObject & object);
 
 private:
 
-    bool processPossibleCollision(MCObject & object1, MCObject & object2);
+    //! Geometric contact of a possible collision.
+    struct Hit
+    {
+        MCVector2dF point;
+
+        MCVector2dF normal;
+
+        float depth;
+    };
+
+    typedef std::vector<Hit> HitVector;
+
+    //! Hits of a possible collision stored in a HitVector.
+    struct PairResult
+    {
+        unsigned int firstHit;
+
+        unsigned int numHits;
+
+        //! Rect against rect only: the hits when the shapes are tested the other way around.
+        unsigned int numReverseHits;
+    };
+
+    //! Results of a contiguous range of possible collisions.
+    struct Batch
+    {
+        HitVector hits;
+
+        std::vector<PairResult> pairs;
+    };
+
+    void testPossibleCollision(MCObject & object1, MCObject & object2, HitVector & hits, PairResult & result) const;
+
+    bool processPossibleCollision(MCObject & object1, MCObject & object2, const HitVector & hits, const PairResult & result);
+
+    static void testRectAgainstRect(const MCRectShape & rect1, const MCRectShape & rect2, HitVector & hits);
+
+    static void testRectAgainstCircle(const MCRectShape & rect, const MCCircleShape & circle, HitVector & hits);
+
+    static void testCircleAgainstCircle(const MCCircleShape & circle1, const MCCircleShape & circle2, HitVector & hits);
+
+    bool processRectAgainstRect(MCRectShape & rect1, MCRectShape & rect2, const Hit * hits, unsigned int numHits);
+
+    bool processRectAgainstCircle(MCRectShape & rect, MCCircleShape & circle, const Hit * hits, unsigned int numHits);
+
+    bool processCircleAgainstCircle(MCCircleShape & circle1, MCCircleShape & circle2, const Hit * hits, unsigned int numHits);
+
+    void addContact(MCObject & object, MCContact & contact);
 
-    bool testRectAgainstRect(MCRectShape & object1, MCRectShape & object2);
+    MCFrameArena & m_frameArena;
 
-    bool testRectAgainstCircle(MCRectShape & object1, MCCircleShape & object2);
+    std::unique_ptr<MCWorkerPool> m_workerPool;
 
-    bool testCircleAgainstCircle(MCCircleShape & object1, MCCircleShape & object2);
+    std::vector<Batch> m_batches;
 
-    bool m_arePrimaryCollisionEventsEnabled;
+    //! Objects that have got contacts since the last releaseContacts().
+    std::vector<MCObject *> m_objectsWithContacts;
 
     DISABLE_COPY(MCCollisionDetector);
     DISABLE_ASSI(MCCollisionDetector);
@@ -18,11 +18,10 @@
 //
 
 #include "mccontact.hh"
+#include "mcframearena.hh"
 #include "mcobject.hh"
 #include <cassert>
 
-MCRecycler<MCContact> MCContact::m_recycler;
-
 MCContact::MCContact()
 : m_pObject(nullptr)
 , m_interpenetrationDepth(0.0)
@@ -60,16 +59,7 @@ float MCContact::interpenetrationDepth() const
     return m_interpenetrationDepth;
 }
 
-MCContact & MCContact::create()
-{
-    return *MCContact::m_recycler.newObject();
-}
-
-void MCContact::free()
-{
-    return MCContact::m_recycler.freeObject(this);
-}
-
-MCContact::~MCContact()
+MCContact & MCContact::create(MCFrameArena & arena)
 {
+    return *arena.create<MCContact>();
 }
@@ -21,27 +21,27 @@
 #define MCCONTACT_HH
 
 #include "mcvector2d.hh"
-#include "mcrecycler.hh"
 #include "mcmacros.hh"
 
+class MCFrameArena;
 class MCObject;
 
 /*! \class MCContact
  *  \brief MCContact is a class representing a collision contact.
  *
  * MCContact is added to object (A) to notify a contact with object(B) using
- * MCObject::addContact(MCContact * p). MCWorld then processes the contacts
+ * MCObject::addContact(). MCWorld then processes the contacts
  * on every world update.
+ *
+ * Contacts are allocated from the frame arena of MCWorld, so they are valid
+ * only until the end of the current world step.
  */
 class MCContact
 {
 public:
 
-    //! Return a new (empty) contact
-    static MCContact & create();
-
-    //! Move contact to the list of free contacts
-    void free();
+    //! Return a new (empty) contact allocated from the given arena
+    static MCContact & create(MCFrameArena & arena);
 
     /*! \brief Init the contact.
      *  \param object The contacting object
@@ -71,9 +71,6 @@ private:
     //! Constructor disabled: use MCContact::create()
     MCContact();
 
-    //! Destructor disabled: use MCContact::free()
-    ~MCContact();
-
     DISABLE_COPY(MCContact);
     DISABLE_ASSI(MCContact);
 
@@ -81,8 +78,7 @@ private:
     MCVector2d<float> m_contactPoint;
     MCVector2d<float> m_contactNormal;
     float m_interpenetrationDepth;
-    static MCRecycler<MCContact> m_recycler;
-    friend class MCRecycler<MCContact>;
+    friend class MCFrameArena;
 };
 
 #endif // MCCONTACT_HH
@@ -0,0 +1,181 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#include "mccontactcache.hh"
+#include "mccontact.hh"
+#include "mcobject.hh"
+#include "mcprofiler.hh"
+
+#include <algorithm>
+
+namespace {
+const unsigned int STALE_INDEX = static_cast<unsigned int>(-1);
+}
+
+float MCContactCache::Manifold::depth() const
+{
+    const MCVector2dF displacement1(object1->location() - location1);
+    const MCVector2dF displacement2(object2->location() - location2);
+    return detectedDepth - normal.dot(displacement1 - displacement2);
+}
+
+MCContactCache::MCContactCache()
+: m_stamp(0)
+{}
+
+MCContactCache::Key MCContactCache::makeKey(MCObject & object1, MCObject & object2)
+{
+    return &object1 < &object2 ? Key(&object1, &object2) : Key(&object2, &object1);
+}
+
+void MCContactCache::update(const std::vector<MCObject *> & objs)
+{
+    MC_PROFILE_ZONE("MCContactCache::update");
+
+    m_stamp++;
+
+    for (MCObject * object : objs)
+    {
+        const MCObject::ContactVector & contacts = object->contacts();
+        for (auto iter = contacts.begin(); iter != contacts.end(); iter++)
+        {
+            // Handle each other object at its first contact
+            MCObject & other = (*iter)->object();
+            if (std::find_if(contacts.begin(), iter, [&other] (const MCContact * contact) {
+                    return &contact->object() == &other;
+                }) != iter)
+            {
+                continue;
+            }
+
+            const MCContact * deepest = object->deepestContact(other);
+            if (!deepest)
+            {
+                continue;
+            }
+
+            const Key key = makeKey(*object, deepest->object());
+            auto indexIter = m_index.find(key);
+            if (indexIter == m_index.end())
+            {
+                indexIter = m_index.insert(std::make_pair(key, static_cast<unsigned int>(m_manifolds.size()))).first;
+                m_manifolds.push_back(Manifold());
+            }
+            else
+            {
+                Manifold & manifold = m_manifolds[indexIter->second];
+                if (manifold.stamp == m_stamp)
+                {
+                    continue; // Already handled from the other object
+                }
+            }
+
+            Manifold & manifold = m_manifolds[indexIter->second];
+            manifold.object1 = object;
+            manifold.object2 = &deepest->object();
+            manifold.location1 = object->location();
+            manifold.location2 = deepest->object().location();
+            manifold.normal = deepest->contactNormal();
+            manifold.detectedDepth = deepest->interpenetrationDepth();
+            manifold.stamp = m_stamp;
+        }
+    }
+
+    removeStaleManifolds();
+}
+
+void MCContactCache::removeStaleManifolds()
+{
+    // Keep the order of the remaining manifolds so that the results are deterministic.
+    m_newIndices.resize(m_manifolds.size());
+    unsigned int count = 0;
+    for (unsigned int i = 0; i < m_manifolds.size(); i++)
+    {
+        if (m_manifolds[i].stamp == m_stamp)
+        {
+            if (count != i)
+            {
+                m_manifolds[count] = m_manifolds[i];
+            }
+
+            m_newIndices[i] = count++;
+        }
+        else
+        {
+            m_newIndices[i] = STALE_INDEX;
+        }
+    }
+
+    if (count != m_manifolds.size())
+    {
+        m_manifolds.resize(count);
+
+        // Patch the index in place so that the nodes of the remaining pairs are not reallocated
+        auto iter = m_index.begin();
+        while (iter != m_index.end())
+        {
+            const unsigned int newIndex = m_newIndices[iter->second];
+            if (newIndex == STALE_INDEX)
+            {
+                iter = m_index.erase(iter);
+            }
+            else
+            {
+                iter->second = newIndex;
+                iter++;
+            }
+        }
+    }
+}
+
+void MCContactCache::removeObject(MCObject & object)
+{
+    // Another object may later get the same address and must not inherit the manifolds
+    bool found = false;
+    for (Manifold & manifold : m_manifolds)
+    {
+        if (manifold.object1 == &object || manifold.object2 == &object)
+        {
+            manifold.stamp = m_stamp - 1;
+            found = true;
+        }
+    }
+
+    if (found)
+    {
+        removeStaleManifolds();
+    }
+}
+
+void MCContactCache::clear()
+{
+    m_manifolds.clear();
+    m_index.clear();
+}
+
+MCContactCache::ManifoldVector & MCContactCache::manifolds()
+{
+    return m_manifolds;
+}
+
+const MCContactCache::Manifold * MCContactCache::manifold(MCObject & object1, MCObject & object2) const
+{
+    const auto iter = m_index.find(makeKey(object1, object2));
+    return iter != m_index.end() ? &m_manifolds[iter->second] : nullptr;
+}
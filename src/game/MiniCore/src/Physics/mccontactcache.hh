@@ -0,0 +1,116 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#ifndef MCCONTACTCACHE_HH
+#define MCCONTACTCACHE_HH
+
+#include "mcmacros.hh"
+#include "mcvector2d.hh"
+#include "mcvector3d.hh"
+
+#include <map>
+#include <utility>
+#include <vector>
+
+class MCObject;
+
+/*! \class MCContactCache
+ *  \brief Pair-keyed cache of the deepest contacts of colliding objects.
+ *
+ * The cache is updated from the MCContacts generated by MCCollisionDetector
+ * once per world step. Each colliding pair gets a manifold that stores the
+ * deepest contact and the locations of the objects at the time of the detection.
+ * The remaining interpenetration depth can then be derived from the displacements
+ * of the objects, so the position resolver doesn't need to re-run the narrow phase.
+ *
+ * Manifolds of pairs that stay in contact are kept in place between steps.
+ * The pairs are keyed by the object addresses, so the manifolds of an object
+ * must be removed with removeObject() when it leaves the world.
+ */
+class MCContactCache
+{
+public:
+
+    struct Manifold
+    {
+        //! \return Current interpenetration depth based on the displacements since the detection.
+        float depth() const;
+
+        MCObject * object1;
+
+        MCObject * object2;
+
+        //! Location of object1 at the time of the detection.
+        MCVector3dF location1;
+
+        //! Location of object2 at the time of the detection.
+        MCVector3dF location2;
+
+        //! Contact normal as seen by object1.
+        MCVector2dF normal;
+
+        //! Interpenetration depth at the time of the detection.
+        float detectedDepth;
+
+        unsigned int stamp;
+    };
+
+    typedef std::vector<Manifold> ManifoldVector;
+
+    //! Constructor.
+    MCContactCache();
+
+    /*! Update manifolds from the current contacts of the given objects.
+     *  Manifolds of pairs that are not in contact anymore are removed. Doesn't delete the contacts. */
+    void update(const std::vector<MCObject *> & objs);
+
+    //! Remove the manifolds of the given object.
+    void removeObject(MCObject & object);
+
+    //! Remove all manifolds.
+    void clear();
+
+    //! \return Manifolds in the order of the detection.
+    ManifoldVector & manifolds();
+
+    //! \return Manifold for the given pair or nullptr if the objects are not in contact.
+    const Manifold * manifold(MCObject & object1, MCObject & object2) const;
+
+private:
+
+    DISABLE_COPY(MCContactCache);
+    DISABLE_ASSI(MCContactCache);
+
+    typedef std::pair<MCObject *, MCObject *> Key;
+
+    static Key makeKey(MCObject & object1, MCObject & object2);
+
+    void removeStaleManifolds();
+
+    ManifoldVector m_manifolds;
+
+    std::map<Key, unsigned int> m_index;
+
+    //! New positions of the manifolds when removing the stale ones.
+    std::vector<unsigned int> m_newIndices;
+
+    unsigned int m_stamp;
+};
+
+#endif // MCCONTACTCACHE_HH
@@ -27,9 +27,9 @@
 
 static const float ROTATION_DECAY = 0.01f;
 
-MCFrictionGenerator::MCFrictionGenerator(float coeffLin, float coeffRot)
-    : m_coeffLinTot(std::fabs(coeffLin * MCWorld::instance().gravity().k()))
-    , m_coeffRotTot(std::fabs(coeffRot * MCWorld::instance().gravity().k() * ROTATION_DECAY))
+MCFrictionGenerator::MCFrictionGenerator(float coeffLin, float coeffRot, const MCVector3dF & gravity)
+    : m_coeffLinTot(std::fabs(coeffLin * gravity.k()))
+    , m_coeffRotTot(std::fabs(coeffRot * gravity.k() * ROTATION_DECAY))
 {}
 
 void MCFrictionGenerator::updateForce(MCObject & object)
@@ -22,7 +22,7 @@
 
 #include "mcforcegenerator.hh"
 #include "mcmacros.hh"
-#include "mcworld.hh"
+#include "mcvector3d.hh"
 
 #include <memory>
 
@@ -42,8 +42,9 @@ public:
 
     /*! Constructor.
      * \param coeffLin Linear friction coefficient.
-     * \param coeffRot Rotational friction coefficient. */
-    explicit MCFrictionGenerator(float coeffLin, float coeffRot);
+     * \param coeffRot Rotational friction coefficient.
+     * \param gravity Gravity of the world, usually MCWorld::gravity(). */
+    MCFrictionGenerator(float coeffLin, float coeffRot, const MCVector3dF & gravity);
 
     //! Destructor.
     virtual ~MCFrictionGenerator();
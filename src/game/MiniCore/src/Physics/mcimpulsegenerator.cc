@@ -19,30 +19,16 @@
 
 #include "mcimpulsegenerator.hh"
 #include "mccontact.hh"
+#include "mccontactcache.hh"
 #include "mcobject.hh"
 #include "mcphysicscomponent.hh"
+#include "mcprofiler.hh"
 #include "mcmathutil.hh"
 #include "mcshape.hh"
 
 MCImpulseGenerator::MCImpulseGenerator()
 {}
 
-MCContact * MCImpulseGenerator::getDeepestInterpenetration(
-    const std::vector<MCContact *> & contacts)
-{
-    float maxDepth = 0;
-    MCContact * bestContact = nullptr;
-    for (MCContact * contact : contacts)
-    {
-        if (contact->interpenetrationDepth() > maxDepth)
-        {
-            maxDepth = contact->interpenetrationDepth();
-            bestContact = contact;
-        }
-    }
-    return bestContact;
-}
-
 void MCImpulseGenerator::displace(
      MCObject & pa, MCObject & pb, const MCVector3dF & displacement)
 {
@@ -59,7 +45,7 @@ void MCImpulseGenerator::displace(
 void MCImpulseGenerator::generateImpulsesFromContact(
     MCObject & pa, MCObject & pb, const MCContact & contact,
     const MCVector3dF & linearImpulse,
-    float restitution)
+    float restitution, float metersPerUnit)
 {
     if (!pa.physicsComponent().isStationary())
     {
@@ -74,49 +60,59 @@ void MCImpulseGenerator::generateImpulsesFromContact(
         pa.physicsComponent().addImpulse(linearImpulse * effRestitution * massScaling, true);
 
         // Angular component
-        const MCVector3dF armA = (contactPoint - pa.location()) * MCWorld::metersPerUnit();
+        const MCVector3dF armA = (contactPoint - pa.location()) * metersPerUnit;
         const MCVector3dF rotationalImpulse = linearImpulse % armA;
         const float calibration = 0.5;
         pa.physicsComponent().addAngularImpulse(-rotationalImpulse.k() * effRestitution * massScaling * calibration, true);
     }
 }
 
-void MCImpulseGenerator::resolvePositions(std::vector<MCObject *> & objs, float accuracy)
+unsigned int MCImpulseGenerator::resolvePositions(
+    MCContactCache & contactCache, unsigned int maxIterations, float tolerance)
 {
-    for (MCObject * object : objs)
+    MC_PROFILE_ZONE("MCImpulseGenerator::resolvePositions");
+
+    const float accuracy = 1.0f / maxIterations;
+    for (unsigned int i = 0; i < maxIterations; i++)
     {
-        auto iter(object->contacts().begin());
-        for (; iter != object->contacts().end(); iter++)
+        bool resolved = true;
+        for (auto && manifold : contactCache.manifolds())
         {
-            const MCContact * contact = getDeepestInterpenetration(iter->second);
-            if (contact)
+            // The depth is updated from the displacements, so the narrow phase is not needed here.
+            const float depth = manifold.depth();
+            if (depth > tolerance)
             {
-                MCObject & pa(*object);
-                MCObject & pb(contact->object());
+                MCObject & pa(*manifold.object1);
+                MCObject & pb(*manifold.object2);
 
-                const MCVector3dF displacement(
-                    contact->contactNormal() * contact->interpenetrationDepth() * accuracy);
+                const MCVector3dF displacement(manifold.normal * depth * accuracy);
 
                 displace(pa, pb, displacement);
                 displace(pb, pa, -displacement);
 
-                pb.deleteContacts(pa);
-                pa.deleteContacts(pb);
+                resolved = false;
             }
         }
 
-        object->deleteContacts();
+        if (resolved)
+        {
+            return i;
+        }
     }
+
+    return maxIterations;
 }
 
-void MCImpulseGenerator::generateImpulsesFromDeepestContacts(std::vector<MCObject *> & objs)
+void MCImpulseGenerator::generateImpulsesFromDeepestContacts(std::vector<MCObject *> & objs, float metersPerUnit)
 {
+    MC_PROFILE_ZONE("MCImpulseGenerator::generateImpulsesFromDeepestContacts");
+
     for (MCObject * object : objs)
     {
-        auto iter(object->contacts().begin());
-        for (; iter != object->contacts().end(); iter++)
+        // Handle the deepest contact with the first object that interpenetrates
+        for (const MCContact * anyContact : object->contacts())
         {
-            const MCContact * contact = getDeepestInterpenetration(iter->second);
+            const MCContact * contact = object->deepestContact(anyContact->object());
             if (contact)
             {
                 MCObject & pa(*object);
@@ -134,8 +130,8 @@ void MCImpulseGenerator::generateImpulsesFromDeepestContacts(std::vector<MCObjec
                         contact->contactNormal() *
                         contact->contactNormal().dot(velocityDelta));
 
-                    generateImpulsesFromContact(pa, pb, *contact, linearImpulse, restitution);
-                    generateImpulsesFromContact(pb, pa, *contact, -linearImpulse, restitution);
+                    generateImpulsesFromContact(pa, pb, *contact, linearImpulse, restitution, metersPerUnit);
+                    generateImpulsesFromContact(pb, pa, *contact, -linearImpulse, restitution, metersPerUnit);
                 }
 
                 // Remove contact with pa from pb, because it was already handled here.
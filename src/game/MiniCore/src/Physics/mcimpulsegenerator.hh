@@ -22,11 +22,12 @@
 
 
 
+#include "mcobject.hh"
 #include "mcvector3d.hh"
 #include <vector>
 
-class MCObject;
 class MCContact;
+class MCContactCache;
 
 //! Generates impulses due to detected collisions.
 class MCImpulseGenerator
@@ -41,22 +42,23 @@ public:
 
     //! Generate impulses to the given objects according to current contacts.
     //! Delete contacts.
-    void generateImpulsesFromDeepestContacts(std::vector<MCObject *> & objs);
+    //! \param metersPerUnit Scale of the world the objects belong to.
+    void generateImpulsesFromDeepestContacts(std::vector<MCObject *> & objs, float metersPerUnit);
 
-    //! Resolve positions of the given objects according to current contacts.
-    //! Delete contacts.
-    void resolvePositions(std::vector<MCObject *> & objs, float accuracy);
+    /*! Resolve positions of the objects according to the cached contacts. Each iteration
+     *  moves the objects of every pair by 1 / maxIterations of the remaining interpenetration.
+     *  Stops when no pair penetrates deeper than the given tolerance.
+     *  \return Number of iterations done. */
+    unsigned int resolvePositions(MCContactCache & contactCache, unsigned int maxIterations, float tolerance);
 
 private:
 
     void generateImpulsesFromContact(
         MCObject & pa, MCObject & pb, const MCContact & contact,
         const MCVector3dF & linearImpulse,
-        float restitution);
+        float restitution, float metersPerUnit);
 
     void displace(MCObject & pa, MCObject & pb, const MCVector3dF & displacement);
-
-    MCContact * getDeepestInterpenetration(const std::vector<MCContact *> & contacts);
 };
 
 #endif // MCIMPULSEGENERATOR_HH
@@ -19,10 +19,37 @@
 
 #include "mcobjectgrid.hh"
 #include "mcphysicscomponent.hh"
+#include "mcprofiler.hh"
 #include "mcshape.hh"
 
 #include <algorithm>
 
+namespace {
+const unsigned int BITS_PER_WORD = 64;
+
+bool rangeContains(
+    unsigned int i0, unsigned int i1, unsigned int j0, unsigned int j1, unsigned int i, unsigned int j)
+{
+    return i >= i0 && i <= i1 && j >= j0 && j <= j1;
+}
+
+bool isCollidable(const MCObject & object)
+{
+    return (object.isPhysicsObject() || object.isTriggerObject()) && !object.bypassCollisions();
+}
+
+bool mayCollide(MCObject & obj1, MCObject & obj2)
+{
+    return &obj1.parent() != &obj2 &&
+        &obj2.parent() != &obj1 &&
+        isCollidable(obj2) &&
+        obj1.physicsComponent().neverCollideWithTag() != obj2.physicsComponent().collisionTag() &&
+        obj2.physicsComponent().neverCollideWithTag() != obj1.physicsComponent().collisionTag() &&
+        (obj1.collisionLayer() == obj2.collisionLayer() || obj1.collisionLayer() == -1 || obj2.collisionLayer() == -1) &&
+        obj1.shape()->mayIntersect(*obj2.shape().get());
+}
+}
+
 MCObjectGrid::MCObjectGrid(
     float x1, float y1, float x2, float y2,
     float leafMaxW, float leafMaxH)
@@ -39,10 +66,7 @@ MCObjectGrid::MCObjectGrid(
 
 MCObjectGrid::~MCObjectGrid()
 {
-    for (GridCell * cell : m_matrix)
-    {
-        delete cell;
-    }
+    removeAll();
 }
 
 void MCObjectGrid::setIndexRange(const MCBBox<float> & bbox)
@@ -68,6 +92,78 @@ void MCObjectGrid::setIndexRange(const MCBBox<float> & bbox)
     m_j1 = static_cast<unsigned int>(temp);
 }
 
+void MCObjectGrid::setCellDirty(unsigned int index)
+{
+    m_dirtyCellBits[index / BITS_PER_WORD] |= uint64_t(1) << (index % BITS_PER_WORD);
+}
+
+void MCObjectGrid::setCellClean(unsigned int index)
+{
+    m_dirtyCellBits[index / BITS_PER_WORD] &= ~(uint64_t(1) << (index % BITS_PER_WORD));
+}
+
+void MCObjectGrid::setCellsDirty(unsigned int i0, unsigned int i1, unsigned int j0, unsigned int j1)
+{
+    for (unsigned int j = j0; j <= j1; j++)
+    {
+        for (unsigned int i = i0; i <= i1; i++)
+        {
+            setCellDirty(j * m_horSize + i);
+        }
+    }
+}
+
+void MCObjectGrid::insertToCells(MCObject & object,
+    unsigned int i0, unsigned int i1, unsigned int j0, unsigned int j1)
+{
+    for (unsigned int j = j0; j <= j1; j++)
+    {
+        for (unsigned int i = i0; i <= i1; i++)
+        {
+            const unsigned int index = j * m_horSize + i;
+            layer(m_matrix[index], object).push_back(&object);
+            setCellDirty(index);
+        }
+    }
+}
+
+void MCObjectGrid::removeFromCells(MCObject & object)
+{
+    unsigned int i0, i1, j0, j1;
+    object.restoreIndexRange(&i0, &i1, &j0, &j1);
+
+    for (unsigned int j = j0; j <= j1; j++)
+    {
+        for (unsigned int i = i0; i <= i1; i++)
+        {
+            removeFromCell(object, j * m_horSize + i);
+        }
+    }
+}
+
+void MCObjectGrid::removeFromCell(MCObject & object, unsigned int index)
+{
+    GridCell & cell = m_matrix[index];
+    auto & objects = layer(cell, object);
+    const auto iter = std::find(objects.begin(), objects.end(), &object);
+    if (iter != objects.end())
+    {
+        // Order of the objects doesn't matter so just swap with the last one.
+        *iter = objects.back();
+        objects.pop_back();
+
+        if (cell.m_objects.empty() && cell.m_staticObjects.empty())
+        {
+            setCellClean(index);
+        }
+    }
+}
+
+MCObjectGrid::ObjectVector & MCObjectGrid::layer(GridCell & cell, const MCObject & object)
+{
+    return object.isInStaticLayer() ? cell.m_staticObjects : cell.m_objects;
+}
+
 void MCObjectGrid::insert(MCObject & object)
 {
     if (!object.shape())
@@ -75,174 +171,275 @@ void MCObjectGrid::insert(MCObject & object)
         return;
     }
 
+    if (object.isInObjectGrid())
+    {
+        update(object);
+        return;
+    }
+
     setIndexRange(object.shape()->bbox());
     object.cacheIndexRange(m_i0, m_i1, m_j0, m_j1);
+    object.setIsInObjectGrid(true);
+    object.setIsInStaticLayer(object.physicsComponent().isStationary());
 
-    for (unsigned int j = m_j0; j <= m_j1; j++)
+    insertToCells(object, m_i0, m_i1, m_j0, m_j1);
+}
+
+bool MCObjectGrid::remove(MCObject & object)
+{
+    if (!object.shape() || !object.isInObjectGrid())
     {
-        for (unsigned int i = m_i0; i <= m_i1; i++)
-        {
-            const int index = j * m_horSize + i;
-            GridCell * cell = m_matrix[index];
-            cell->m_objects.insert(&object);
-            m_dirtyCellCache.insert(cell);
-        }
+        return false;
     }
+
+    removeFromCells(object);
+    object.setIsInObjectGrid(false);
+
+    return true;
 }
 
-bool MCObjectGrid::remove(MCObject & object)
+bool MCObjectGrid::update(MCObject & object)
 {
-    if (!object.shape())
+    if (!object.shape() || !object.isInObjectGrid())
     {
         return false;
     }
 
-    bool removed = false;
-    object.restoreIndexRange(&m_i0, &m_i1, &m_j0, &m_j1);
+    if (object.isInStaticLayer() != object.physicsComponent().isStationary())
+    {
+        // The mass has been changed after the insertion
+        remove(object);
+        insert(object);
+        return true;
+    }
 
-    for (unsigned int j = m_j0; j <= m_j1; j++)
+    unsigned int oldI0, oldI1, oldJ0, oldJ1;
+    object.restoreIndexRange(&oldI0, &oldI1, &oldJ0, &oldJ1);
+
+    setIndexRange(object.shape()->bbox());
+
+    if (m_i0 == oldI0 && m_i1 == oldI1 && m_j0 == oldJ0 && m_j1 == oldJ1)
     {
-        for (unsigned int i = m_i0; i <= m_i1; i++)
+        // The usual case: the object moved within the cells it already covers.
+        setCellsDirty(m_i0, m_i1, m_j0, m_j1);
+        return true;
+    }
+
+    const unsigned int i0 = m_i0, i1 = m_i1, j0 = m_j0, j1 = m_j1;
+    object.cacheIndexRange(i0, i1, j0, j1);
+
+    // Remove from cells that are not covered anymore
+    for (unsigned int j = oldJ0; j <= oldJ1; j++)
+    {
+        for (unsigned int i = oldI0; i <= oldI1; i++)
         {
-            const int index = j * m_horSize + i;
-            GridCell * cell = m_matrix[index];
-            const auto iter = cell->m_objects.find(&object);
-            if (iter != cell->m_objects.end())
+            if (!rangeContains(i0, i1, j0, j1, i, j))
             {
-                cell->m_objects.erase(iter);
-                removed = true;
+                removeFromCell(object, j * m_horSize + i);
+            }
+        }
+    }
 
-                if (!cell->m_objects.size())
-                {
-                    m_dirtyCellCache.erase(cell);
-                }
+    // Add to newly covered cells and mark all covered cells dirty
+    for (unsigned int j = j0; j <= j1; j++)
+    {
+        for (unsigned int i = i0; i <= i1; i++)
+        {
+            const unsigned int index = j * m_horSize + i;
+            if (!rangeContains(oldI0, oldI1, oldJ0, oldJ1, i, j))
+            {
+                layer(m_matrix[index], object).push_back(&object);
             }
+
+            setCellDirty(index);
         }
     }
-    return removed;
+
+    return true;
 }
 
 void MCObjectGrid::removeAll()
 {
-    for (unsigned int j = 0; j < m_verSize; j++)
+    for (auto && cell : m_matrix)
     {
-        for (unsigned int i = 0; i < m_horSize; i++)
+        for (auto && object : cell.m_objects)
         {
-            const int index = j * m_horSize + i;
-            m_matrix[index]->m_objects.clear();
+            object->setIsInObjectGrid(false);
         }
+
+        for (auto && object : cell.m_staticObjects)
+        {
+            object->setIsInObjectGrid(false);
+        }
+
+        cell.m_objects.clear();
+        cell.m_staticObjects.clear();
     }
 
-    m_dirtyCellCache.clear();
+    std::fill(m_dirtyCellBits.begin(), m_dirtyCellBits.end(), 0);
 }
 
 void MCObjectGrid::build()
 {
-    m_dirtyCellCache.clear();
+    removeAll();
+
+    m_matrix.clear();
+    m_matrix.resize(m_horSize * m_verSize);
+
+    m_dirtyCellBits.clear();
+    m_dirtyCellBits.resize((m_matrix.size() + BITS_PER_WORD - 1) / BITS_PER_WORD, 0);
+}
+
+bool MCObjectGrid::addPossibleCollisions(const GridCell & cell)
+{
+    const auto & objects = cell.m_objects;
 
-    for (GridCell * cell : m_matrix)
+    m_awakeIndices.clear();
+    for (unsigned int i = 0; i < objects.size(); i++)
     {
-        delete cell;
+        if (!objects[i]->physicsComponent().isSleeping() && isCollidable(*objects[i]))
+        {
+            m_awakeIndices.push_back(i);
+        }
     }
 
-    m_matrix.clear();
-
-    for (unsigned int j = 0; j < m_verSize; j++)
+    bool hadCollisions = false;
+    for (unsigned int i : m_awakeIndices)
     {
-        for (unsigned int i = 0; i < m_horSize; i++)
+        MCObject & obj1 = *objects[i];
+        for (unsigned int j = 0; j < objects.size(); j++)
+        {
+            // Pairs of two awake objects are tested only once
+            MCObject & obj2 = *objects[j];
+            if (j == i || (j < i && !obj2.physicsComponent().isSleeping()))
+            {
+                continue;
+            }
+
+            if (mayCollide(obj1, obj2))
+            {
+                m_possibleCollisions.push_back({&obj1, &obj2});
+                m_possibleCollisions.push_back({&obj2, &obj1});
+                hadCollisions = true;
+            }
+        }
+
+        for (MCObject * obj2 : cell.m_staticObjects)
         {
-            m_matrix.push_back(new GridCell);
+            if (mayCollide(obj1, *obj2))
+            {
+                m_possibleCollisions.push_back({&obj1, obj2});
+                m_possibleCollisions.push_back({obj2, &obj1});
+                hadCollisions = true;
+            }
         }
     }
+
+    return hadCollisions;
 }
 
 const MCObjectGrid::CollisionVector & MCObjectGrid::getPossibleCollisions()
 {
-    static MCObjectGrid::CollisionVector collisions;
-    collisions.clear();
+    MC_PROFILE_ZONE("MCObjectGrid::getPossibleCollisions");
 
-    // Optimization: ignore collisions between sleeping objects.
-    // Note that stationary objects are also sleeping objects.
+    m_possibleCollisions.clear();
 
-    auto cellIter = m_dirtyCellCache.begin();
-    while (cellIter != m_dirtyCellCache.end())
+    for (unsigned int word = 0; word < m_dirtyCellBits.size(); word++)
     {
-        bool hadCollisions = false;
-        auto & objects = (*cellIter)->m_objects;
+        if (!m_dirtyCellBits[word])
+        {
+            continue;
+        }
 
-        const auto end = objects.end();
-        for (auto && objIter1 = objects.begin(); objIter1 != end; objIter1++)
+        for (unsigned int bit = 0; bit < BITS_PER_WORD; bit++)
         {
-            auto * obj1 = *objIter1;
-            for (auto && objIter2 = std::next(objIter1); objIter2 != end; objIter2++)
+            if (!(m_dirtyCellBits[word] & (uint64_t(1) << bit)))
             {
-                auto * obj2 = *objIter2; // Note that ob1 != obj2 always holds
-                if (&obj1->parent() != obj2 &&
-                    &obj2->parent() != obj1 &&
-                    (!obj1->physicsComponent().isSleeping() || !obj2->physicsComponent().isSleeping()) &&
-                    (obj1->isPhysicsObject() || obj1->isTriggerObject()) && !obj1->bypassCollisions() &&
-                    (obj2->isPhysicsObject() || obj2->isTriggerObject()) && !obj2->bypassCollisions() &&
-                    obj1->physicsComponent().neverCollideWithTag() != obj2->physicsComponent().collisionTag() &&
-                    obj2->physicsComponent().neverCollideWithTag() != obj1->physicsComponent().collisionTag() &&
-                    (obj1->collisionLayer() == obj2->collisionLayer() || obj1->collisionLayer() == -1 || obj2->collisionLayer() == -1) &&
-                    obj1->shape()->mayIntersect(*obj2->shape().get()))
-                {
-                    collisions.push_back({obj1, obj2});
-                    collisions.push_back({obj2, obj1});
-                    hadCollisions = true;
-                }
+                continue;
             }
-        }
 
-        if (!hadCollisions)
-        {
-            cellIter = m_dirtyCellCache.erase(cellIter);
+            const unsigned int index = word * BITS_PER_WORD + bit;
+            if (!addPossibleCollisions(m_matrix[index]))
+            {
+                setCellClean(index);
+            }
         }
-        else
+    }
+
+    return m_possibleCollisions;
+}
+
+const MCObjectGrid::ObjectVector & MCObjectGrid::objects()
+{
+    m_queryResult.clear();
+
+    for (unsigned int j = 0; j < m_verSize; j++)
+    {
+        for (unsigned int i = 0; i < m_horSize; i++)
         {
-            cellIter++;
+            const GridCell & cell = m_matrix[j * m_horSize + i];
+            for (auto && cellObjects : {&cell.m_objects, &cell.m_staticObjects})
+            {
+                for (auto && obj : *cellObjects)
+                {
+                    // Accept an object that spans multiple cells only in its first cell
+                    if (i == obj->m_i0 && j == obj->m_j0)
+                    {
+                        m_queryResult.push_back(obj);
+                    }
+                }
+            }
         }
     }
 
-    return collisions;
+    return m_queryResult;
 }
 
-const MCObjectGrid::ObjectSet & MCObjectGrid::getObjectsWithinDistance(const MCVector2dF & p, float d)
+const MCObjectGrid::ObjectVector & MCObjectGrid::getObjectsWithinDistance(const MCVector2dF & p, float d)
 {
     return getObjectsWithinDistance(p.i(), p.j(), d);
 }
 
-const MCObjectGrid::ObjectSet & MCObjectGrid::getObjectsWithinDistance(float x, float y, float d)
+const MCObjectGrid::ObjectVector & MCObjectGrid::getObjectsWithinDistance(float x, float y, float d)
 {
     return getObjectsWithinBBox(MCBBox<float>(x - d, y - d, x + d, y + d));
 }
 
-const MCObjectGrid::ObjectSet & MCObjectGrid::getObjectsWithinBBox(const MCBBox<float> & bbox)
+const MCObjectGrid::ObjectVector & MCObjectGrid::getObjectsWithinBBox(const MCBBox<float> & bbox)
 {
     setIndexRange(bbox);
 
-    static ObjectSet resultObjs;
-    resultObjs.clear();
+    m_queryResult.clear();
 
     for (unsigned int j = m_j0; j <= m_j1; j++)
     {
         for (unsigned int i = m_i0; i <= m_i1; i++)
         {
-            const int index = j * m_horSize + i;
-            for (auto && obj : m_matrix[index]->m_objects)
+            const GridCell & cell = m_matrix[j * m_horSize + i];
+            for (auto && cellObjects : {&cell.m_objects, &cell.m_staticObjects})
             {
-                if (obj->shape()->view())
+                for (auto && obj : *cellObjects)
                 {
-                    if (bbox.intersects(obj->shape()->view()->bbox().translated(MCVector2dF(obj->location()))))
+                    // An object can span multiple cells: accept it only in the first
+                    // cell where its cell range and the query range overlap.
+                    if (i != std::max(obj->m_i0, m_i0) || j != std::max(obj->m_j0, m_j0))
+                    {
+                        continue;
+                    }
+
+                    if (obj->shape()->view())
                     {
-                        resultObjs.insert(obj);
+                        if (bbox.intersects(obj->shape()->view()->bbox().translated(MCVector2dF(obj->location()))))
+                        {
+                            m_queryResult.push_back(obj);
+                        }
                     }
                 }
             }
         }
     }
 
-    return resultObjs;
+    return m_queryResult;
 }
 
 const MCBBox<float> & MCObjectGrid::bbox() const
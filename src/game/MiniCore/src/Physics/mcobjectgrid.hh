@@ -24,25 +24,35 @@
 #include "mcmacros.hh"
 #include "mcobject.hh"
 
-#include <map>
-#include <set>
+#include <cstdint>
+#include <utility>
 #include <vector>
 
 /*! A grid used for fast collision detection.
- *  The tree stores objects inherited from MCObject -class.
- *  A (2d) collision test for a given object can be requested against all
- *  objects of a given typeid. */
+ *  The grid stores objects inherited from MCObject -class.
+ *  Each cell stores its objects in a contiguous vector and the set of cells
+ *  that need to be checked for collisions is tracked with a bitset.
+ *  Moving objects are updated incrementally: cells are touched only if the
+ *  range of cells covered by the object changes.
+ *
+ *  Stationary objects are stored in a separate static layer of the cells.
+ *  The static layer is only tested against awake objects, so static geometry
+ *  doesn't cost anything when there are no awake objects near it. */
 class MCObjectGrid
 {
 public:
 
-    typedef std::set<MCObject *> ObjectSet;
+    typedef std::vector<MCObject *> ObjectVector;
     typedef std::vector<std::pair<MCObject *, MCObject *> > CollisionVector;
 
     //! Container for objects.
     struct GridCell
     {
-        ObjectSet m_objects;
+        //! Objects that can move.
+        ObjectVector m_objects;
+
+        //! Stationary objects.
+        ObjectVector m_staticObjects;
     };
 
     /*! Constructor.
@@ -55,30 +65,47 @@ public:
     //! Destructor.
     ~MCObjectGrid();
 
-    /*! Insert an object into the tree (O(1)).
+    /*! Insert an object into the grid (O(1)). Inserting an object that
+     *  is already in the grid is equal to update(). Stationary objects
+     *  are inserted into the static layer.
      *  \param object is the object to be inserted. */
     void insert(MCObject & object);
 
-    /*! Remove an object from the tree (O(1)).
+    /*! Remove an object from the grid (O(1)).
      *  \param object is the object to be removed.
      *  \return true if was removed. */
     bool remove(MCObject & object);
 
+    /*! Update the cells of an object that has been moved or rotated (O(1)).
+     *  Cells are modified only if the covered cell range has changed, otherwise
+     *  the covered cells are just marked to be checked for collisions.
+     *  An object that has become stationary or non-stationary is moved to the right layer.
+     *  \param object is the object to be updated.
+     *  \return true if the object is in the grid. */
+    bool update(MCObject & object);
+
     //! Remove all objects.
     void removeAll();
 
-    //! Get objects within given distance.
-    const ObjectSet & getObjectsWithinDistance(const MCVector2dF & p, float d);
+    /*! Get all objects in the grid. Each object is returned only once.
+     *  The returned vector is reused and valid until the next query. */
+    const ObjectVector & objects();
+
+    /*! Get objects within given distance.
+     *  The returned vector is reused and valid until the next query. */
+    const ObjectVector & getObjectsWithinDistance(const MCVector2dF & p, float d);
 
     //! Get objects within given distance.
-    const ObjectSet & getObjectsWithinDistance(float x, float y, float d);
+    const ObjectVector & getObjectsWithinDistance(float x, float y, float d);
 
-    //! Get all objects of given type overlapping given BBox.
-    const ObjectSet & getObjectsWithinBBox(const MCBBox<float> & bbox);
+    /*! Get all objects overlapping given BBox. Each object is returned only once.
+     *  The returned vector is reused and valid until the next query. */
+    const ObjectVector & getObjectsWithinBBox(const MCBBox<float> & bbox);
 
-    /*! Get possible collisions. Collisions between sleeping objects are ignored,
-     *  because that gives a huge performance boost.
-     *  \return possible collisions. */
+    /*! Get possible collisions. Only awake objects are tested against the other objects
+     *  of their cells, so collisions between sleeping objects are ignored. Note that
+     *  stationary objects are also sleeping objects.
+     *  \return possible collisions. The vector is reused and valid until the next call. */
     const CollisionVector & getPossibleCollisions();
 
     //! Get bounding box
@@ -93,6 +120,25 @@ private:
 
     void build();
 
+    void insertToCells(MCObject & object,
+        unsigned int i0, unsigned int i1, unsigned int j0, unsigned int j1);
+
+    void removeFromCells(MCObject & object);
+
+    void removeFromCell(MCObject & object, unsigned int index);
+
+    //! \return the layer of the cell the object belongs to.
+    ObjectVector & layer(GridCell & cell, const MCObject & object);
+
+    //! \return true if possible collisions were found in the cell.
+    bool addPossibleCollisions(const GridCell & cell);
+
+    void setCellsDirty(unsigned int i0, unsigned int i1, unsigned int j0, unsigned int j1);
+
+    void setCellDirty(unsigned int index);
+
+    void setCellClean(unsigned int index);
+
     MCBBox<float> m_bbox;
 
     float m_leafMaxW;
@@ -109,10 +155,18 @@ private:
 
     float m_helpVer;
 
-    std::vector<GridCell *> m_matrix;
+    std::vector<GridCell> m_matrix;
+
+    //! One bit per cell. Set bits mark cells to be checked for collisions.
+    typedef std::vector<uint64_t> DirtyCellBits;
+    DirtyCellBits m_dirtyCellBits;
+
+    //! Result buffers that keep their capacity between the calls.
+    CollisionVector m_possibleCollisions;
+
+    ObjectVector m_queryResult;
 
-    typedef std::set<GridCell *> DirtyCellCache;
-    DirtyCellCache m_dirtyCellCache;
+    std::vector<unsigned int> m_awakeIndices;
 };
 
 #endif // MCOBJECTGRID_HH
@@ -41,6 +41,7 @@ MCPhysicsComponent::MCPhysicsComponent()
     , m_linearSleepLimit(0.01f)
     , m_angularSleepLimit(0.01f)
     , m_sleepCount(0)
+    , m_nextInIsland(nullptr)
     , m_collisionTag(0)
     , m_neverCollideWithTag(-1)
 {
@@ -261,20 +262,56 @@ void MCPhysicsComponent::toggleSleep(bool sleep)
         m_isSleeping = sleep;
 
         // Optimization: dynamically remove from the integration vector
-        if (!object().isParticle())
+        MCWorld * world = object().world();
+        if (world && !object().isParticle())
         {
             if (sleep)
             {
-                MCWorld::instance().removeObjectFromIntegration(object());
+                world->removeObjectFromIntegration(object());
             }
             else
             {
-                MCWorld::instance().restoreObjectToIntegration(object());
+                world->restoreObjectToIntegration(object());
+            }
+        }
+
+        if (!sleep)
+        {
+            // Wake up the rest of the island. The ring is dissolved first so that it's not walked again.
+            MCPhysicsComponent * member = m_nextInIsland;
+            m_nextInIsland = nullptr;
+            while (member && member != this)
+            {
+                MCPhysicsComponent * next = member->m_nextInIsland;
+                member->m_nextInIsland = nullptr;
+                member->toggleSleep(false);
+                member = next;
             }
         }
     }
 }
 
+void MCPhysicsComponent::leaveIsland()
+{
+    if (m_nextInIsland)
+    {
+        MCPhysicsComponent * previous = m_nextInIsland;
+        while (previous->m_nextInIsland != this)
+        {
+            previous = previous->m_nextInIsland;
+        }
+
+        // The last remaining object is not in an island anymore
+        previous->m_nextInIsland = m_nextInIsland != previous ? m_nextInIsland : nullptr;
+        m_nextInIsland = nullptr;
+    }
+}
+
+bool MCPhysicsComponent::isReadyToSleep() const
+{
+    return m_sleepCount > 1 && !m_isSleepingPrevented;
+}
+
 void MCPhysicsComponent::preventSleeping(bool flag)
 {
     m_isSleepingPrevented = flag;
@@ -299,34 +336,45 @@ void MCPhysicsComponent::integrate(float step)
         m_isIntegrating = true;
 
         integrateLinear(step);
-        const float angleDiff = integrateAngular(step);
-        object().checkBoundaries();
+        finishIntegration(integrateAngular(step));
+    }
+}
 
-        const float speed = m_velocity.lengthFast();
-        if (speed < m_linearSleepLimit && m_angularVelocity < m_angularSleepLimit)
-        {
-            if (++m_sleepCount > 1)
-            {
-                toggleSleep(true);
-                reset();
-            }
-        }
-        else
-        {
-            m_velocity.clampFast(m_maxSpeed);
+void MCPhysicsComponent::finishIntegration(float angleDiff)
+{
+    object().checkBoundaries();
 
-            m_forces.setZero();
-            m_linearImpulse.setZero();
-            m_angularImpulse = 0.0f;
+    // The forces and impulses have been applied, also if the object doesn't move
+    m_forces.setZero();
+    m_linearImpulse.setZero();
+    m_angularImpulse = 0.0f;
 
-            object().rotate(object().angle() + angleDiff, false);
-            object().translate(object().location() + m_velocity);
+    const float speed = m_velocity.lengthFast();
+    if (speed < m_linearSleepLimit && m_angularVelocity < m_angularSleepLimit)
+    {
+        if (m_sleepCount < 2)
+        {
+            m_sleepCount++;
+        }
 
-            m_sleepCount = 0;
+        // Objects in a world fall asleep together with their island after the collisions have been processed
+        if (isReadyToSleep() && !object().world())
+        {
+            toggleSleep(true);
+            reset();
         }
+    }
+    else
+    {
+        m_velocity.clampFast(m_maxSpeed);
 
-        m_isIntegrating = false;
+        object().rotate(object().angle() + angleDiff, false);
+        object().translate(object().location() + m_velocity);
+
+        m_sleepCount = 0;
     }
+
+    m_isIntegrating = false;
 }
 
 void MCPhysicsComponent::integrateLinear(float step)
@@ -413,4 +461,5 @@ void MCPhysicsComponent::setLinearDamping(float linearDamping)
 
 MCPhysicsComponent::~MCPhysicsComponent()
 {
+    leaveIsland();
 }
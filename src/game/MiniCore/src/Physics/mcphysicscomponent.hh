@@ -148,8 +148,12 @@ public:
     //! The object won't sleep if enabled.
     void preventSleeping(bool flag);
 
+    //! Put the object to sleep or wake it up. Waking up wakes up the whole sleeping island.
     void toggleSleep(bool state);
 
+    //! Detach the object from its sleeping island without waking up the others.
+    void leaveIsland();
+
     //! \return true if object is stationary.
     bool isStationary() const;
 
@@ -188,12 +192,21 @@ public:
 
 private:
 
+    friend class MCRigidBodyStore;
+    friend class MCSleepIslands;
+
+    //! \return true if the object has been at rest long enough to fall asleep.
+    bool isReadyToSleep() const;
+
     void integrate(float step);
 
     void integrateLinear(float step);
 
     float integrateAngular(float step);
 
+    //! Check boundaries, detect sleeping and update the object transform.
+    void finishIntegration(float angleDiff);
+
     float m_damping;
 
     MCVector3dF m_acceleration;
@@ -244,6 +257,9 @@ private:
 
     int m_sleepCount;
 
+    //! Next object in the ring of a sleeping island or nullptr if not in an island.
+    MCPhysicsComponent * m_nextInIsland;
+
     int m_collisionTag;
 
     int m_neverCollideWithTag;
@@ -0,0 +1,144 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#include "mcrigidbodystore.hh"
+#include "mcobject.hh"
+#include "mcphysicscomponent.hh"
+#include "mctrigonom.hh"
+
+#include <cassert>
+
+MCRigidBodyStore::MCRigidBodyStore()
+{}
+
+float * MCRigidBodyStore::field(Field field)
+{
+    return m_fields[field].data();
+}
+
+void MCRigidBodyStore::gather(const std::vector<MCObject *> & objs)
+{
+    // Same conditions as in MCWorld::integrate() and MCPhysicsComponent::integrate()
+    m_components.clear();
+    for (MCObject * object : objs)
+    {
+        if (object->isPhysicsObject() && !object->physicsComponent().isStationary() &&
+            !object->physicsComponent().isSleeping() && &object->parent() == object)
+        {
+            m_components.push_back(&object->physicsComponent());
+        }
+    }
+
+    for (auto && values : m_fields)
+    {
+        values.resize(m_components.size());
+    }
+
+    for (unsigned int i = 0; i < m_components.size(); i++)
+    {
+        const MCPhysicsComponent & component = *m_components[i];
+
+        m_fields[VelocityX][i] = component.m_velocity.i();
+        m_fields[VelocityY][i] = component.m_velocity.j();
+        m_fields[VelocityZ][i] = component.m_velocity.k();
+        m_fields[AccelerationX][i] = component.m_acceleration.i();
+        m_fields[AccelerationY][i] = component.m_acceleration.j();
+        m_fields[AccelerationZ][i] = component.m_acceleration.k();
+        m_fields[ForceX][i] = component.m_forces.i();
+        m_fields[ForceY][i] = component.m_forces.j();
+        m_fields[ForceZ][i] = component.m_forces.k();
+        m_fields[LinearImpulseX][i] = component.m_linearImpulse.i();
+        m_fields[LinearImpulseY][i] = component.m_linearImpulse.j();
+        m_fields[LinearImpulseZ][i] = component.m_linearImpulse.k();
+        m_fields[InvMass][i] = component.m_invMass;
+        m_fields[LinearDamping][i] = component.m_linearDamping;
+        m_fields[AngularVelocity][i] = component.m_angularVelocity;
+
+        // Use neutral values for bodies without angular motion so that the kernel needs no branches
+        const bool hasAngularMotion = component.object().shape() && component.m_momentOfInertia > 0.0f;
+        m_fields[AngularAcceleration][i] = hasAngularMotion ? component.m_angularAcceleration : 0.0f;
+        m_fields[Torque][i] = hasAngularMotion ? component.m_torque : 0.0f;
+        m_fields[InvMomentOfInertia][i] = hasAngularMotion ? component.m_invMomentOfInertia : 0.0f;
+        m_fields[AngularDamping][i] = hasAngularMotion ? component.m_angularDamping : 1.0f;
+        m_fields[AngularImpulse][i] = hasAngularMotion ? component.m_angularImpulse : 0.0f;
+        m_fields[HasAngularMotion][i] = hasAngularMotion ? 1.0f : 0.0f;
+    }
+}
+
+void MCRigidBodyStore::integrate(float step)
+{
+    const unsigned int count = bodyCount();
+    const float radToDeg = MCTrigonom::radToDeg(1.0f);
+
+    // Linear motion. Keep the operation order of MCPhysicsComponent::integrateLinear().
+    for (Field axis : {VelocityX, VelocityY, VelocityZ})
+    {
+        const int offset = axis - VelocityX;
+        float * velocity = field(axis);
+        const float * acceleration = field(static_cast<Field>(AccelerationX + offset));
+        const float * force = field(static_cast<Field>(ForceX + offset));
+        const float * impulse = field(static_cast<Field>(LinearImpulseX + offset));
+        const float * invMass = field(InvMass);
+        const float * damping = field(LinearDamping);
+
+        for (unsigned int i = 0; i < count; i++)
+        {
+            velocity[i] = (velocity[i] + ((acceleration[i] + force[i] * invMass[i]) * step + impulse[i])) * damping[i];
+        }
+    }
+
+    // Angular motion. Keep the operation order of MCPhysicsComponent::integrateAngular().
+    float * angularVelocity = field(AngularVelocity);
+    float * angleDiff = field(AngleDiff);
+    const float * angularAcceleration = field(AngularAcceleration);
+    const float * torque = field(Torque);
+    const float * invMomentOfInertia = field(InvMomentOfInertia);
+    const float * angularImpulse = field(AngularImpulse);
+    const float * damping = field(AngularDamping);
+    const float * hasAngularMotion = field(HasAngularMotion);
+
+    for (unsigned int i = 0; i < count; i++)
+    {
+        angularVelocity[i] =
+            (angularVelocity[i] + ((angularAcceleration[i] + torque[i] * invMomentOfInertia[i]) * step + angularImpulse[i])) * damping[i];
+    }
+
+    // Separate loop keeps the number of runtime aliasing checks low enough for the vectorizer.
+    for (unsigned int i = 0; i < count; i++)
+    {
+        angleDiff[i] = angularVelocity[i] * step * radToDeg * hasAngularMotion[i];
+    }
+}
+
+void MCRigidBodyStore::writeBack(unsigned int index)
+{
+    assert(index < bodyCount());
+
+    MCPhysicsComponent & component = *m_components[index];
+    component.m_isIntegrating = true;
+    component.m_velocity.set(m_fields[VelocityX][index], m_fields[VelocityY][index], m_fields[VelocityZ][index]);
+    component.m_angularVelocity = m_fields[AngularVelocity][index];
+    component.m_torque = 0.0f;
+    component.finishIntegration(m_fields[AngleDiff][index]);
+}
+
+unsigned int MCRigidBodyStore::bodyCount() const
+{
+    return static_cast<unsigned int>(m_components.size());
+}
@@ -0,0 +1,99 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#ifndef MCRIGIDBODYSTORE_HH
+#define MCRIGIDBODYSTORE_HH
+
+#include "mcmacros.hh"
+
+#include <vector>
+
+class MCObject;
+class MCPhysicsComponent;
+
+/*! \class MCRigidBodyStore
+ *  \brief Structure-of-arrays store used to integrate MCPhysicsComponents in batches.
+ *
+ * The motion state of the awake bodies is gathered into contiguous float arrays
+ * so that the linear and angular integration runs as simple loops that the
+ * compiler can vectorize. The results are then written back one body at a time,
+ * which also runs the boundary checks, the sleep detection and the speed clamping
+ * exactly like MCPhysicsComponent::stepTime() does.
+ *
+ * Note that MCPhysicsComponent::stepTime() is not called for batched bodies.
+ */
+class MCRigidBodyStore
+{
+public:
+
+    //! Constructor.
+    MCRigidBodyStore();
+
+    //! Gather the bodies of the given objects that need to be integrated.
+    void gather(const std::vector<MCObject *> & objs);
+
+    //! Integrate the gathered bodies over the given time step (seconds).
+    void integrate(float step);
+
+    //! Write the integrated state of the given body back to its component and object.
+    void writeBack(unsigned int index);
+
+    //! \return Number of gathered bodies.
+    unsigned int bodyCount() const;
+
+private:
+
+    DISABLE_COPY(MCRigidBodyStore);
+    DISABLE_ASSI(MCRigidBodyStore);
+
+    enum Field
+    {
+        VelocityX,
+        VelocityY,
+        VelocityZ,
+        AccelerationX,
+        AccelerationY,
+        AccelerationZ,
+        ForceX,
+        ForceY,
+        ForceZ,
+        LinearImpulseX,
+        LinearImpulseY,
+        LinearImpulseZ,
+        InvMass,
+        LinearDamping,
+        AngularVelocity,
+        AngularAcceleration,
+        Torque,
+        InvMomentOfInertia,
+        AngularDamping,
+        AngularImpulse,
+        HasAngularMotion,
+        AngleDiff,
+        FieldCount
+    };
+
+    float * field(Field field);
+
+    std::vector<MCPhysicsComponent *> m_components;
+
+    std::vector<float> m_fields[FieldCount];
+};
+
+#endif // MCRIGIDBODYSTORE_HH
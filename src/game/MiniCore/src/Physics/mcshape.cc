@@ -19,6 +19,10 @@
 
 #include "mcshape.hh"
 #include "mccamera.hh"
+#include "mcobject.hh"
+#include "mcworld.hh"
+
+#include <cmath>
 
 unsigned int MCShape::m_typeCount = 0;
 
@@ -27,6 +31,8 @@ MCVector3dF MCShape::m_defaultShadowOffset = MCVector3dF(2, -2, 0.5f);
 MCShape::MCShape(MCShapeViewPtr view)
     : m_parent(nullptr)
     , m_angle(0)
+    , m_previousAngle(0)
+    , m_snapshotStep(0)
     , m_radius(0)
 {
     if (view)
@@ -70,7 +76,7 @@ void MCShape::render(MCCamera * p)
 {
     if (m_view)
     {
-        m_view->render(m_location, m_angle, p);
+        m_view->render(renderLocation(), renderAngle(), p);
     }
 }
 
@@ -78,18 +84,47 @@ void MCShape::renderShadow(MCCamera * p)
 {
     if (m_view)
     {
+        const MCVector3dF location(renderLocation());
         const MCVector3dF shadowLocation(
-            m_shadowOffset.i() + m_location.i(),
-            m_shadowOffset.j() + m_location.j(),
+            m_shadowOffset.i() + location.i(),
+            m_shadowOffset.j() + location.j(),
             m_shadowOffset.k()
         );
 
-        m_view->renderShadow(shadowLocation, m_angle, p);
+        m_view->renderShadow(shadowLocation, renderAngle(), p);
+    }
+}
+
+bool MCShape::takeSnapshot()
+{
+    const MCWorld * world = m_parent ? m_parent->world() : nullptr;
+    if (!world || !world->isStepping())
+    {
+        return false;
+    }
+
+    if (m_snapshotStep != world->stepCount())
+    {
+        m_previousLocation = m_location;
+        m_previousAngle = m_angle;
+        m_snapshotStep = world->stepCount();
     }
+
+    return true;
+}
+
+bool MCShape::hasSnapshot(const MCWorld * world) const
+{
+    return world && m_snapshotStep && m_snapshotStep == world->stepCount();
 }
 
 void MCShape::translate(const MCVector3dF & p)
 {
+    if (!takeSnapshot())
+    {
+        m_previousLocation = p;
+    }
+
     m_location = p;
 }
 
@@ -98,6 +133,17 @@ const MCVector3dF & MCShape::location() const
     return m_location;
 }
 
+MCVector3dF MCShape::renderLocation() const
+{
+    const MCWorld * world = m_parent ? m_parent->world() : nullptr;
+    if (hasSnapshot(world))
+    {
+        return m_previousLocation + (m_location - m_previousLocation) * world->renderInterpolation();
+    }
+
+    return m_location;
+}
+
 void MCShape::setShadowOffset(const MCVector3dF & p)
 {
     m_shadowOffset = p;
@@ -108,6 +154,11 @@ void MCShape::setDefaultShadowOffset(const MCVector3dF & p)
     MCShape::m_defaultShadowOffset = p;
 }
 
+const MCVector3dF & MCShape::defaultShadowOffset()
+{
+    return MCShape::m_defaultShadowOffset;
+}
+
 const MCVector3dF & MCShape::shadowOffset() const
 {
     return m_shadowOffset;
@@ -115,6 +166,11 @@ const MCVector3dF & MCShape::shadowOffset() const
 
 void MCShape::rotate(float newAngle)
 {
+    if (!takeSnapshot())
+    {
+        m_previousAngle = newAngle;
+    }
+
     m_angle = newAngle;
 }
 
@@ -123,6 +179,18 @@ float MCShape::angle() const
     return m_angle;
 }
 
+float MCShape::renderAngle() const
+{
+    const MCWorld * world = m_parent ? m_parent->world() : nullptr;
+    if (hasSnapshot(world))
+    {
+        // Turn the shorter way around
+        return m_previousAngle + std::remainder(m_angle - m_previousAngle, 360.0f) * world->renderInterpolation();
+    }
+
+    return m_angle;
+}
+
 float MCShape::radius() const
 {
     return m_radius;
@@ -34,6 +34,7 @@
 
 class MCObject;
 class MCCamera;
+class MCWorld;
 
 /*! \class MCShape.
  *  \brief MCShape is abstract base class for different shape models used by MCObject.
@@ -76,6 +77,10 @@ public:
     //! Get the current location.
     const MCVector3dF & location() const;
 
+    /*! \return The location to render at. This is interpolated between the two latest
+     *  steps of the world according to MCWorld::renderInterpolation(). */
+    MCVector3dF renderLocation() const;
+
     /*! Set offset for the fake shadow.
      * \param p The new offset. */
     void setShadowOffset(const MCVector3dF & p);
@@ -87,6 +92,9 @@ public:
       * \param p The new offset. */
     static void setDefaultShadowOffset(const MCVector3dF & p);
 
+    //! \return The global default shadow offset.
+    static const MCVector3dF & defaultShadowOffset();
+
     /*! Rotate.
      * \param a The new rotation angle in degrees */
     virtual void rotate(float a);
@@ -94,6 +102,9 @@ public:
     //! Return the current angle.
     float angle() const;
 
+    //! Return the angle to render at. \see renderLocation().
+    float renderAngle() const;
+
     //! Return non-rotated, translated bounding box of the shape in 2d.
     virtual MCBBoxF bbox() const = 0;
 
@@ -138,18 +149,32 @@ private:
     DISABLE_COPY(MCShape);
     DISABLE_ASSI(MCShape);
 
+    /*! Store the pose of the previous step before the first move of the current step.
+     *  \return false if the move isn't done in MCWorld::stepTime() and shouldn't be interpolated. */
+    bool takeSnapshot();
+
+    //! \return true if the previous pose is from the step just before the latest one.
+    bool hasSnapshot(const MCWorld * world) const;
+
     static unsigned int m_typeCount;
 
     MCObject * m_parent;
 
     MCVector3dF m_location;
 
+    MCVector3dF m_previousLocation;
+
     MCVector3dF m_shadowOffset;
 
     static MCVector3dF m_defaultShadowOffset;
 
     float m_angle;
 
+    float m_previousAngle;
+
+    //! World step during which the previous pose was stored.
+    unsigned int m_snapshotStep;
+
     float m_radius;
 
     MCShapeViewPtr m_view;
@@ -0,0 +1,131 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#include "mcsleepislands.hh"
+#include "mcobject.hh"
+#include "mcphysicscomponent.hh"
+#include "mcprofiler.hh"
+
+MCSleepIslands::MCSleepIslands()
+{}
+
+int MCSleepIslands::islandIndex(MCObject & object, const std::vector<MCObject *> & objs)
+{
+    // Contacts of child objects connect their parents
+    MCObject & body = object.parent();
+    const int index = body.index();
+    if (index < 0 || index >= static_cast<int>(objs.size()) || objs[index] != &body)
+    {
+        return -1;
+    }
+
+    const MCPhysicsComponent & component = body.physicsComponent();
+    if (!body.isPhysicsObject() || body.isParticle() || component.isStationary() || component.isSleeping())
+    {
+        return -1;
+    }
+
+    return index;
+}
+
+unsigned int MCSleepIslands::find(unsigned int index)
+{
+    while (m_parents[index] != index)
+    {
+        // Path halving
+        m_parents[index] = m_parents[m_parents[index]];
+        index = m_parents[index];
+    }
+
+    return index;
+}
+
+void MCSleepIslands::unite(unsigned int index1, unsigned int index2)
+{
+    const unsigned int root1 = find(index1);
+    const unsigned int root2 = find(index2);
+    if (root1 != root2)
+    {
+        m_parents[root2] = root1;
+    }
+}
+
+void MCSleepIslands::update(const std::vector<MCObject *> & objs, const MCContactCache::ManifoldVector & manifolds)
+{
+    MC_PROFILE_ZONE("MCSleepIslands::update");
+
+    const unsigned int count = static_cast<unsigned int>(objs.size());
+    m_parents.resize(count);
+    for (unsigned int i = 0; i < count; i++)
+    {
+        m_parents[i] = i;
+    }
+
+    for (auto && manifold : manifolds)
+    {
+        const int index1 = islandIndex(*manifold.object1, objs);
+        const int index2 = islandIndex(*manifold.object2, objs);
+        if (index1 >= 0 && index2 >= 0)
+        {
+            unite(static_cast<unsigned int>(index1), static_cast<unsigned int>(index2));
+        }
+    }
+
+    // An island can fall asleep only if all of its objects are ready to sleep
+    m_canSleep.assign(count, true);
+    for (unsigned int i = 0; i < count; i++)
+    {
+        if (!objs[i]->physicsComponent().isReadyToSleep())
+        {
+            m_canSleep[find(i)] = false;
+        }
+    }
+
+    // Link the objects of each sleeping island into a ring
+    m_firstMembers.assign(count, -1);
+    m_sleepers.clear();
+    for (unsigned int i = 0; i < count; i++)
+    {
+        const unsigned int root = find(i);
+        if (!m_canSleep[root])
+        {
+            continue;
+        }
+
+        MCPhysicsComponent & component = objs[i]->physicsComponent();
+        if (m_firstMembers[root] < 0)
+        {
+            m_firstMembers[root] = static_cast<int>(i);
+        }
+        else
+        {
+            MCPhysicsComponent & first = objs[m_firstMembers[root]]->physicsComponent();
+            component.m_nextInIsland = first.m_nextInIsland ? first.m_nextInIsland : &first;
+            first.m_nextInIsland = &component;
+        }
+
+        m_sleepers.push_back(objs[i]);
+    }
+
+    for (MCObject * object : m_sleepers)
+    {
+        object->physicsComponent().toggleSleep(true);
+        object->physicsComponent().reset();
+    }
+}
@@ -0,0 +1,75 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#ifndef MCSLEEPISLANDS_HH
+#define MCSLEEPISLANDS_HH
+
+#include "mccontactcache.hh"
+#include "mcmacros.hh"
+
+#include <vector>
+
+class MCObject;
+
+/*! \class MCSleepIslands
+ *  \brief Puts groups of touching objects to sleep together.
+ *
+ * The awake objects that are in contact with each other form an island. Stationary
+ * objects don't join islands, otherwise everything touching the same wall would
+ * end up in one island. An island falls asleep only when all of its objects are
+ * ready to sleep, and the objects of a sleeping island are linked into a ring so
+ * that waking up any of them wakes up the whole island.
+ */
+class MCSleepIslands
+{
+public:
+
+    //! Constructor.
+    MCSleepIslands();
+
+    /*! Build the islands of the given objects from the current contacts and put the
+     *  islands that are at rest to sleep. Note that sleeping objects are removed from
+     *  the integration of their world, so objs may change if it's the world's vector. */
+    void update(const std::vector<MCObject *> & objs, const MCContactCache::ManifoldVector & manifolds);
+
+private:
+
+    DISABLE_COPY(MCSleepIslands);
+    DISABLE_ASSI(MCSleepIslands);
+
+    //! \return Index of the object's body in objs or -1 if it cannot join an island.
+    static int islandIndex(MCObject & object, const std::vector<MCObject *> & objs);
+
+    unsigned int find(unsigned int index);
+
+    void unite(unsigned int index1, unsigned int index2);
+
+    //! Union-find forest over the indices of the objects.
+    std::vector<unsigned int> m_parents;
+
+    //! Whether the island of a root can fall asleep.
+    std::vector<bool> m_canSleep;
+
+    //! Index of the first sleeping object of the island of a root or -1.
+    std::vector<int> m_firstMembers;
+
+    std::vector<MCObject *> m_sleepers;
+};
+
+#endif // MCSLEEPISLANDS_HH
@@ -18,8 +18,14 @@
 //
 
 #include "mctexturefont.hh"
+#include "mctexturetextmesh.hh"
 #include "mcsurface.hh"
 
+#include <algorithm>
+#include <functional>
+
+static const unsigned int MAX_TEXT_MESHES = 256;
+
 MCTextureFont::MCTextureFont(MCSurface & surface)
 : m_default(
       MCTextureGlyph::UV(0, 0),
@@ -28,11 +34,24 @@ MCTextureFont::MCTextureFont(MCSurface & surface)
 , m_xDensity(1.0f)
 , m_yDensity(1.0f)
 , m_surface(surface)
+, m_textMeshUseCount(0)
+{
+}
+
+MCTextureFont::~MCTextureFont()
+{
+}
+
+size_t MCTextureFont::TextMeshKeyHash::operator()(const TextMeshKey & key) const
 {
+    return std::hash<std::wstring>()(key.text) ^
+        (std::hash<float>()(key.glyphWidth) << 1) ^ (std::hash<float>()(key.glyphHeight) << 2);
 }
 
 void MCTextureFont::addGlyphMapping(wchar_t glyphId, MCTextureGlyph textureGlyph)
 {
+    m_textMeshes.clear();
+
     if (static_cast<unsigned int>(glyphId) < m_glyphLookUp.size())
     {
         m_glyphLookUp[glyphId] = textureGlyph;
@@ -74,17 +93,29 @@ MCSurface & MCTextureFont::surface() const
 void MCTextureFont::setShaderProgram(MCGLShaderProgramPtr program)
 {
     surface().setShaderProgram(program);
+
+    for (auto && textMesh : m_textMeshes)
+    {
+        textMesh.second.mesh->setShaderProgram(program);
+    }
 }
 
 void MCTextureFont::setShadowShaderProgram(MCGLShaderProgramPtr program)
 {
     surface().setShadowShaderProgram(program);
+
+    for (auto && textMesh : m_textMeshes)
+    {
+        textMesh.second.mesh->setShadowShaderProgram(program);
+    }
 }
 
 void MCTextureFont::setDensities(float xDensity, float yDensity)
 {
     m_xDensity = xDensity;
     m_yDensity = yDensity;
+
+    m_textMeshes.clear();
 }
 
 float MCTextureFont::xDensity() const
@@ -96,3 +127,38 @@ float MCTextureFont::yDensity() const
 {
     return m_yDensity;
 }
+
+MCTextureTextMesh & MCTextureFont::textMesh(const std::wstring & text, float glyphWidth, float glyphHeight)
+{
+    TextMeshKey key = {text, glyphWidth, glyphHeight};
+
+    auto iter = m_textMeshes.find(key);
+    if (iter != m_textMeshes.end())
+    {
+        iter->second.lastUsed = ++m_textMeshUseCount;
+        return *iter->second.mesh;
+    }
+
+    std::unique_ptr<MCTextureTextMesh> mesh;
+    if (m_textMeshes.size() >= MAX_TEXT_MESHES)
+    {
+        // Re-use the buffers of the least recently used mesh
+        auto oldest = std::min_element(m_textMeshes.begin(), m_textMeshes.end(),
+            [] (const TextMeshHash::value_type & l, const TextMeshHash::value_type & r) {
+            return l.second.lastUsed < r.second.lastUsed;
+        });
+
+        mesh = std::move(oldest->second.mesh);
+        m_textMeshes.erase(oldest);
+    }
+    else
+    {
+        mesh.reset(new MCTextureTextMesh);
+    }
+
+    mesh->build(text, *this, glyphWidth, glyphHeight);
+
+    MCTextureTextMesh & result = *mesh;
+    m_textMeshes[std::move(key)] = {std::move(mesh), ++m_textMeshUseCount};
+    return result;
+}
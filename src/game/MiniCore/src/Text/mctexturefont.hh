@@ -23,10 +23,13 @@
 #include "mctextureglyph.hh"
 #include "mcglshaderprogram.hh"
 
+#include <memory>
+#include <string>
 #include <unordered_map>
 #include <vector>
 
 class MCSurface;
+class MCTextureTextMesh;
 
 //! Textured monospace font.
 class MCTextureFont
@@ -38,6 +41,9 @@ public:
      * all the monospace glyphs. */
     MCTextureFont(MCSurface & surface);
 
+    //! Destructor.
+    ~MCTextureFont();
+
     /*! Add a mapping from given glyph to given MCTextureGlyph.
      *  MCTextureGlyph includes e.g. uv-coordinates. */
     void addGlyphMapping(wchar_t glyph, MCTextureGlyph textureGlyph);
@@ -65,8 +71,44 @@ public:
 
     float yDensity() const;
 
+    /*! \return a mesh containing the glyphs of the given text. Meshes are cached until
+     *  the text is not used anymore: when the cache is full, the least recently used
+     *  mesh is rebuilt for the new text. */
+    MCTextureTextMesh & textMesh(const std::wstring & text, float glyphWidth, float glyphHeight);
+
 private:
 
+    struct TextMeshKey
+    {
+        std::wstring text;
+
+        float glyphWidth;
+
+        float glyphHeight;
+
+        bool operator==(const TextMeshKey & other) const
+        {
+            return text == other.text && glyphWidth == other.glyphWidth && glyphHeight == other.glyphHeight;
+        }
+    };
+
+    struct TextMeshKeyHash
+    {
+        size_t operator()(const TextMeshKey & key) const;
+    };
+
+    struct TextMesh
+    {
+        std::unique_ptr<MCTextureTextMesh> mesh;
+
+        unsigned int lastUsed;
+    };
+
+    typedef std::unordered_map<TextMeshKey, TextMesh, TextMeshKeyHash> TextMeshHash;
+    TextMeshHash m_textMeshes;
+
+    unsigned int m_textMeshUseCount;
+
     MCTextureGlyph m_default;
 
     typedef std::unordered_map<wchar_t, MCTextureGlyph> GlyphHash;
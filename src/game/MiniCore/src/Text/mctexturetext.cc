@@ -18,17 +18,12 @@
 //
 
 #include "mctexturetext.hh"
+#include "mcglstate.hh"
 #include "mctexturefont.hh"
-#include "mctextureglyph.hh"
-#include "mccamera.hh"
-#include "mcsurface.hh"
-#include "mcgltexcoord.hh"
+#include "mctexturetextmesh.hh"
 
 #include <MCGLEW>
 
-#include <map>
-#include <vector>
-
 MCTextureText::MCTextureText(const std::wstring & text)
 : m_text(text)
 , m_glyphWidth(32)
@@ -129,100 +124,19 @@ float MCTextureText::height(MCTextureFont & font) const
 
 void MCTextureText::render(float x, float y, MCCamera * camera, MCTextureFont & font, bool shadow)
 {
-    glDisable(GL_DEPTH_TEST);
-
-    wchar_t prevGlyph = 0;
-
-    wchar_t glyph = 0;
-
-    float glyphXPos = x;
+    MCGLState::setDepthTest(false);
 
-    float glyphYPos = y;
-
-    if (shadow)
+    MCTextureTextMesh & mesh = font.textMesh(m_text, m_glyphWidth, m_glyphHeight);
+    if (!mesh.glyphCount())
     {
-        font.surface().bindShadow();
-
-        for (int i = 0; i < static_cast<int>(m_text.size()); i++)
-        {
-            prevGlyph = glyph;
-            glyph = m_text[i];
-
-            if (glyph == '\n')
-            {
-                glyphXPos  = x;
-                glyphYPos -= font.yDensity() * m_glyphHeight;
-            }
-            else if (glyph == ' ')
-            {
-                glyphXPos += font.xDensity() * m_glyphWidth;
-            }
-            else
-            {
-                if (glyph != prevGlyph)
-                {
-                    auto && texGlyph = font.glyph(glyph);
-                    const MCGLTexCoord uv[4] =
-                    {
-                        {texGlyph.uv(3).m_u, texGlyph.uv(3).m_v},
-                        {texGlyph.uv(0).m_u, texGlyph.uv(0).m_v},
-                        {texGlyph.uv(1).m_u, texGlyph.uv(1).m_v},
-                        {texGlyph.uv(2).m_u, texGlyph.uv(2).m_v}
-                    };
-
-                    font.surface().updateTexCoords(uv);
-                }
-
-                font.surface().setSize(m_glyphWidth, m_glyphHeight);
-                font.surface().renderShadow(camera, MCVector3dF(glyphXPos + m_xOffset, glyphYPos + m_yOffset, 0), 0);
-
-                glyphXPos += font.xDensity() * m_glyphWidth;
-            }
-        }
+        return;
     }
 
-    font.surface().bind();
-    font.surface().setColor(m_color);
-
-    prevGlyph = 0;
-    glyph     = 0;
-    glyphXPos = x;
-    glyphYPos = y;
-
-    for (int i = 0; i < static_cast<int>(m_text.size()); i++)
+    if (shadow)
     {
-        prevGlyph = glyph;
-        glyph = m_text[i];
-
-        if (glyph == '\n')
-        {
-            glyphXPos  = x;
-            glyphYPos -= font.yDensity() * m_glyphHeight;
-        }
-        else if (glyph == ' ')
-        {
-            glyphXPos += font.xDensity() * m_glyphWidth;
-        }
-        else
-        {
-            if (glyph != prevGlyph)
-            {
-                auto && texGlyph = font.glyph(glyph);
-                const MCGLTexCoord uv[4] =
-                {
-                    {texGlyph.uv(3).m_u, texGlyph.uv(3).m_v},
-                    {texGlyph.uv(0).m_u, texGlyph.uv(0).m_v},
-                    {texGlyph.uv(1).m_u, texGlyph.uv(1).m_v},
-                    {texGlyph.uv(2).m_u, texGlyph.uv(2).m_v}
-                };
-
-                font.surface().updateTexCoords(uv);
-            }
-
-            font.surface().setSize(m_glyphWidth, m_glyphHeight);
-            font.surface().render(camera, MCVector3dF(glyphXPos, glyphYPos, 0), 0);
-
-            glyphXPos += font.xDensity() * m_glyphWidth;
-        }
+        mesh.renderShadow(camera, MCVector3dF(x + m_xOffset, y + m_yOffset, 0), 0);
     }
+
+    mesh.setColor(m_color);
+    mesh.render(camera, MCVector3dF(x, y, 0), 0);
 }
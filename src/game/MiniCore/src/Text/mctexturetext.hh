@@ -31,7 +31,8 @@ class MCCamera;
 class MCTextureFont;
 
 /*! MCTextureText is a renderable texture text object.
- *  A monospace font is assumed (MCTextureFont). */
+ *  A monospace font is assumed (MCTextureFont). The whole text is drawn with
+ *  one call by using a mesh cached by the font. */
 class MCTextureText
 {
 public:
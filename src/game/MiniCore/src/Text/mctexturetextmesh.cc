@@ -0,0 +1,133 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#include "mctexturetextmesh.hh"
+#include "mctexturefont.hh"
+#include "mctextureglyph.hh"
+#include "mcsurface.hh"
+
+static const int NUM_VERTICES_PER_GLYPH = 6;
+
+MCTextureTextMesh::MCTextureTextMesh()
+: MCGLObjectBase("textureTextMesh")
+, m_glyphCount(0)
+{
+}
+
+void MCTextureTextMesh::build(const std::wstring & text, MCTextureFont & font, float glyphWidth, float glyphHeight)
+{
+    MCSurface & surface = font.surface();
+
+    setMaterial(surface.material());
+    setShaderProgram(surface.shaderProgram());
+    setShadowShaderProgram(surface.shadowShaderProgram());
+
+    VertexVector vertices;
+    VertexVector normals;
+    TexCoordVector texCoords;
+    ColorVector colors;
+
+    // Same two triangles as in MCSurface
+    const float w2 = glyphWidth / 2;
+    const float h2 = glyphHeight / 2;
+    const MCGLVertex quad[NUM_VERTICES_PER_GLYPH] =
+    {
+        {-w2, -h2, 0},
+        { w2,  h2, 0},
+        {-w2,  h2, 0},
+        {-w2, -h2, 0},
+        { w2, -h2, 0},
+        { w2,  h2, 0}
+    };
+
+    float glyphXPos = 0;
+    float glyphYPos = 0;
+
+    m_glyphCount = 0;
+
+    for (auto && glyph : text)
+    {
+        if (glyph == '\n')
+        {
+            glyphXPos  = 0;
+            glyphYPos -= font.yDensity() * glyphHeight;
+        }
+        else if (glyph == ' ')
+        {
+            glyphXPos += font.xDensity() * glyphWidth;
+        }
+        else
+        {
+            // Same order as in MCSurface::updateTexCoords()
+            auto && texGlyph = font.glyph(glyph);
+            const MCGLTexCoord uv[NUM_VERTICES_PER_GLYPH] =
+            {
+                {texGlyph.uv(3).m_u, texGlyph.uv(3).m_v},
+                {texGlyph.uv(1).m_u, texGlyph.uv(1).m_v},
+                {texGlyph.uv(0).m_u, texGlyph.uv(0).m_v},
+                {texGlyph.uv(3).m_u, texGlyph.uv(3).m_v},
+                {texGlyph.uv(2).m_u, texGlyph.uv(2).m_v},
+                {texGlyph.uv(1).m_u, texGlyph.uv(1).m_v}
+            };
+
+            for (int i = 0; i < NUM_VERTICES_PER_GLYPH; i++)
+            {
+                vertices.push_back(MCGLVertex(glyphXPos + quad[i].x(), glyphYPos + quad[i].y(), 0));
+                normals.push_back(MCGLVertex(0, 0, 1));
+                texCoords.push_back(uv[i]);
+                colors.push_back(MCGLColor());
+            }
+
+            glyphXPos += font.xDensity() * glyphWidth;
+
+            m_glyphCount++;
+        }
+    }
+
+    setVertices(vertices);
+    setNormals(normals);
+    setTexCoords(texCoords);
+    setColors(colors);
+
+    if (!m_glyphCount)
+    {
+        return;
+    }
+
+    const int VERTEX_DATA_SIZE = sizeof(MCGLVertex) * vertices.size();
+    const int NORMAL_DATA_SIZE = sizeof(MCGLVertex) * normals.size();
+    const int TEXCOORD_DATA_SIZE = sizeof(MCGLTexCoord) * texCoords.size();
+    const int COLOR_DATA_SIZE = sizeof(MCGLColor) * colors.size();
+    const int TOTAL_DATA_SIZE = VERTEX_DATA_SIZE + NORMAL_DATA_SIZE + TEXCOORD_DATA_SIZE + COLOR_DATA_SIZE;
+
+    // The VAO and the VBO are created only once
+    initBufferData(TOTAL_DATA_SIZE, GL_DYNAMIC_DRAW);
+
+    addBufferSubData(MCGLShaderProgram::VAL_Vertex, VERTEX_DATA_SIZE, verticesAsGlArray());
+    addBufferSubData(MCGLShaderProgram::VAL_Normal, NORMAL_DATA_SIZE, normalsAsGlArray());
+    addBufferSubData(MCGLShaderProgram::VAL_TexCoords, TEXCOORD_DATA_SIZE, texCoordsAsGlArray());
+    addBufferSubData(MCGLShaderProgram::VAL_Color, COLOR_DATA_SIZE, colorsAsGlArray());
+
+    finishBufferData();
+}
+
+int MCTextureTextMesh::glyphCount() const
+{
+    return m_glyphCount;
+}
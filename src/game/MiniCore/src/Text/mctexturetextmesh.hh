@@ -0,0 +1,55 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#ifndef MCTEXTURETEXTMESH_HH
+#define MCTEXTURETEXTMESH_HH
+
+#include "mcglobjectbase.hh"
+#include "mcmacros.hh"
+
+#include <string>
+
+class MCTextureFont;
+
+/*! Vertex buffer that contains the glyph quads of a whole string, so that the
+ *  string can be drawn with a single call. The same quads are used for the shadow.
+ *  Meshes are cached by MCTextureFont, see MCTextureFont::textMesh(). */
+class MCTextureTextMesh : public MCGLObjectBase
+{
+public:
+
+    //! Constructor.
+    MCTextureTextMesh();
+
+    /*! Build the quads of the given text. The quads are relative to the position of the
+     *  first glyph. Buffers of the previous text are re-used. */
+    void build(const std::wstring & text, MCTextureFont & font, float glyphWidth, float glyphHeight);
+
+    //! \return number of glyph quads in the mesh. Spaces and line breaks don't have quads.
+    int glyphCount() const;
+
+private:
+
+    DISABLE_COPY(MCTextureTextMesh);
+    DISABLE_ASSI(MCTextureTextMesh);
+
+    int m_glyphCount;
+};
+
+#endif // MCTEXTURETEXTMESH_HH
@@ -0,0 +1,96 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#include "MCFrameArenaTest.hpp"
+#include "../../Core/mcframearena.hh"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+MCFrameArenaTest::MCFrameArenaTest()
+{
+}
+
+void MCFrameArenaTest::testAllocate()
+{
+    MCFrameArena arena(256);
+
+    std::vector<unsigned char *> allocations;
+    for (unsigned int i = 0; i < 100; i++)
+    {
+        const std::size_t alignment = std::size_t(1) << (i % 4);
+        unsigned char * data = static_cast<unsigned char *>(arena.allocate(24, alignment));
+        QVERIFY(data);
+        QCOMPARE(reinterpret_cast<std::uintptr_t>(data) % alignment, std::uintptr_t(0));
+        std::memset(data, static_cast<int>(i), 24);
+        allocations.push_back(data);
+    }
+
+    // Allocations must not overlap
+    for (unsigned int i = 0; i < allocations.size(); i++)
+    {
+        for (unsigned int j = 0; j < 24; j++)
+        {
+            QCOMPARE(static_cast<unsigned int>(allocations[i][j]), i);
+        }
+    }
+
+    QCOMPARE(arena.usedSize(), std::size_t(100 * 24));
+    QVERIFY(arena.capacity() >= arena.usedSize());
+}
+
+void MCFrameArenaTest::testLargeAllocation()
+{
+    MCFrameArena arena(256);
+
+    void * small = arena.allocate(16, 8);
+    void * large = arena.allocate(1000, 8);
+    QVERIFY(small != large);
+    std::memset(large, 0, 1000);
+
+    QVERIFY(arena.capacity() >= 256 + 1000);
+}
+
+void MCFrameArenaTest::testReset()
+{
+    MCFrameArena arena(256);
+
+    void * first = arena.allocate(100, 4);
+    for (unsigned int i = 0; i < 10; i++)
+    {
+        arena.allocate(100, 4);
+    }
+
+    const std::size_t capacity = arena.capacity();
+
+    arena.reset();
+    QCOMPARE(arena.usedSize(), std::size_t(0));
+
+    // The blocks are reused
+    QCOMPARE(arena.allocate(100, 4), first);
+    for (unsigned int i = 0; i < 10; i++)
+    {
+        arena.allocate(100, 4);
+    }
+
+    QCOMPARE(arena.capacity(), capacity);
+}
+
+QTEST_GUILESS_MAIN(MCFrameArenaTest)
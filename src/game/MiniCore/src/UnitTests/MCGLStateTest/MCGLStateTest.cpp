@@ -0,0 +1,119 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#include "MCGLStateTest.hpp"
+#include "../../Graphics/mcglstate.hh"
+
+MCGLStateTest::MCGLStateTest()
+{
+}
+
+void MCGLStateTest::init()
+{
+    MCGLState::invalidate();
+    MCGLState::resetRedundantCallCount();
+}
+
+void MCGLStateTest::testBindings()
+{
+    QVERIFY(MCGLState::useProgram(1));
+    QVERIFY(!MCGLState::useProgram(1));
+    QVERIFY(MCGLState::useProgram(2));
+
+    QVERIFY(MCGLState::bindVertexArray(3));
+    QVERIFY(!MCGLState::bindVertexArray(3));
+    QVERIFY(MCGLState::bindVertexArray(0));
+
+    QVERIFY(MCGLState::bindArrayBuffer(4));
+    QVERIFY(!MCGLState::bindArrayBuffer(4));
+    QVERIFY(!MCGLState::bindArrayBuffer(4));
+
+    QCOMPARE(MCGLState::redundantCallCount(), 4u);
+
+    MCGLState::resetRedundantCallCount();
+    QCOMPARE(MCGLState::redundantCallCount(), 0u);
+}
+
+void MCGLStateTest::testTextures()
+{
+    QVERIFY(MCGLState::activeTexture(0));
+    QVERIFY(!MCGLState::activeTexture(0));
+    QVERIFY(MCGLState::activeTexture(1));
+
+    // Each unit has its own binding
+    QVERIFY(MCGLState::bindTexture(0, 5));
+    QVERIFY(MCGLState::bindTexture(1, 5));
+    QVERIFY(!MCGLState::bindTexture(0, 5));
+    QVERIFY(!MCGLState::bindTexture(1, 5));
+    QVERIFY(MCGLState::bindTexture(1, 6));
+
+    QCOMPARE(MCGLState::redundantCallCount(), 3u);
+}
+
+void MCGLStateTest::testDeletedObjects()
+{
+    MCGLState::useProgram(1);
+    MCGLState::bindVertexArray(2);
+    MCGLState::bindArrayBuffer(3);
+    MCGLState::bindTexture(0, 4);
+    MCGLState::bindTexture(2, 4);
+
+    // Unrelated names don't change anything
+    MCGLState::programDeleted(7);
+    MCGLState::vertexArrayDeleted(7);
+    MCGLState::bufferDeleted(7);
+    MCGLState::textureDeleted(7);
+
+    QVERIFY(!MCGLState::useProgram(1));
+    QVERIFY(!MCGLState::bindVertexArray(2));
+    QVERIFY(!MCGLState::bindArrayBuffer(3));
+    QVERIFY(!MCGLState::bindTexture(0, 4));
+
+    // The names can be reused by new objects
+    MCGLState::programDeleted(1);
+    MCGLState::vertexArrayDeleted(2);
+    MCGLState::bufferDeleted(3);
+    MCGLState::textureDeleted(4);
+
+    QVERIFY(MCGLState::useProgram(1));
+    QVERIFY(MCGLState::bindVertexArray(2));
+    QVERIFY(MCGLState::bindArrayBuffer(3));
+    QVERIFY(MCGLState::bindTexture(0, 4));
+    QVERIFY(MCGLState::bindTexture(2, 4));
+}
+
+void MCGLStateTest::testInvalidate()
+{
+    MCGLState::useProgram(1);
+    MCGLState::bindVertexArray(2);
+    MCGLState::bindArrayBuffer(3);
+    MCGLState::activeTexture(0);
+    MCGLState::bindTexture(0, 4);
+
+    MCGLState::invalidate();
+
+    QVERIFY(MCGLState::useProgram(1));
+    QVERIFY(MCGLState::bindVertexArray(2));
+    QVERIFY(MCGLState::bindArrayBuffer(3));
+    QVERIFY(MCGLState::activeTexture(0));
+    QVERIFY(MCGLState::bindTexture(0, 4));
+    QCOMPARE(MCGLState::redundantCallCount(), 0u);
+}
+
+QTEST_GUILESS_MAIN(MCGLStateTest)
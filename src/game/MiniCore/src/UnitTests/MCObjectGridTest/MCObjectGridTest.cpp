@@ -0,0 +1,192 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#include "MCObjectGridTest.hpp"
+#include "../../Core/mcworld.hh"
+#include "../../Core/mcobject.hh"
+#include "../../Physics/mcobjectgrid.hh"
+#include "../../Physics/mcphysicscomponent.hh"
+#include "../../Physics/mcrectshape.hh"
+
+#include <algorithm>
+#include <cstddef>
+
+static bool containsPair(const MCObjectGrid::CollisionVector & collisions, MCObject & object1, MCObject & object2)
+{
+    return std::find(collisions.begin(), collisions.end(), std::make_pair(&object1, &object2)) != collisions.end();
+}
+
+MCObjectGridTest::MCObjectGridTest()
+{
+}
+
+void MCObjectGridTest::testInsertAndRemove()
+{
+    MCWorld world;
+    world.setDimensions(0, 100, 0, 100, 0, 100, 1, false, 10);
+
+    MCObject object(MCShapePtr(new MCRectShape(nullptr, 2, 2)), "test");
+    object.translate(MCVector3dF(55, 55)); // Inside a single cell
+
+    MCObjectGrid & grid = world.objectGrid();
+    grid.insert(object);
+    grid.insert(object); // Inserting twice must not duplicate the object
+    QCOMPARE(grid.objects().size(), size_t(1));
+
+    // A duplicate in the cell would also collide with itself or twice with another object
+    MCObject other(MCShapePtr(new MCRectShape(nullptr, 2, 2)), "test");
+    other.translate(MCVector3dF(56, 55));
+    grid.insert(other);
+
+    const MCObjectGrid::CollisionVector & collisions = grid.getPossibleCollisions();
+    QCOMPARE(std::count(collisions.begin(), collisions.end(), std::make_pair(&object, &other)), std::ptrdiff_t(1));
+    QCOMPARE(std::count(collisions.begin(), collisions.end(), std::make_pair(&object, &object)), std::ptrdiff_t(0));
+
+    QVERIFY(grid.remove(other));
+    QVERIFY(grid.remove(object));
+    QVERIFY(!grid.remove(object));
+    QVERIFY(grid.objects().empty());
+}
+
+void MCObjectGridTest::testUpdate()
+{
+    MCWorld world;
+    world.setDimensions(0, 100, 0, 100, 0, 100, 1, false, 10);
+
+    MCObject object1(MCShapePtr(new MCRectShape(nullptr, 2, 2)), "test");
+    object1.physicsComponent().preventSleeping(true);
+    MCObject object2(MCShapePtr(new MCRectShape(nullptr, 2, 2)), "test");
+    object2.physicsComponent().preventSleeping(true);
+
+    world.addObject(object1);
+    world.addObject(object2);
+
+    object1.translate(MCVector3dF(15, 15));
+    object2.translate(MCVector3dF(85, 85));
+
+    MCObjectGrid & grid = world.objectGrid();
+    QVERIFY(grid.getPossibleCollisions().empty());
+
+    // Move object1 across several cells on top of object2
+    object1.translate(MCVector3dF(85.5, 85.5));
+    QVERIFY(containsPair(grid.getPossibleCollisions(), object1, object2));
+    QVERIFY(containsPair(grid.getPossibleCollisions(), object2, object1));
+
+    // Move object1 back. The old cells must not contain it anymore.
+    object1.translate(MCVector3dF(15, 15));
+    QVERIFY(grid.getPossibleCollisions().empty());
+
+    world.removeObjectNow(object1);
+    world.removeObjectNow(object2);
+    QVERIFY(!grid.update(object1));
+}
+
+void MCObjectGridTest::testPossibleCollisions()
+{
+    MCWorld world;
+    world.setDimensions(0, 100, 0, 100, 0, 100, 1, false, 10);
+
+    MCObject object1(MCShapePtr(new MCRectShape(nullptr, 2, 2)), "test");
+    MCObject object2(MCShapePtr(new MCRectShape(nullptr, 2, 2)), "test");
+
+    world.addObject(object1);
+    world.addObject(object2);
+
+    object1.translate(MCVector3dF(55, 55));
+    object2.translate(MCVector3dF(56, 55));
+
+    MCObjectGrid & grid = world.objectGrid();
+    QVERIFY(containsPair(grid.getPossibleCollisions(), object1, object2));
+
+    // Collisions between sleeping objects are ignored
+    object1.physicsComponent().toggleSleep(true);
+    object2.physicsComponent().toggleSleep(true);
+    QVERIFY(grid.getPossibleCollisions().empty());
+
+    // Cells without collisions are dropped, but moving an object marks them again
+    object1.physicsComponent().toggleSleep(false);
+    object1.translate(MCVector3dF(55.5, 55));
+    QVERIFY(containsPair(grid.getPossibleCollisions(), object1, object2));
+}
+
+void MCObjectGridTest::testStaticLayer()
+{
+    MCWorld world;
+    world.setDimensions(0, 100, 0, 100, 0, 100, 1, false, 10);
+
+    MCObject wall1(MCShapePtr(new MCRectShape(nullptr, 2, 2)), "wall");
+    wall1.physicsComponent().setMass(0, true);
+    MCObject wall2(MCShapePtr(new MCRectShape(nullptr, 2, 2)), "wall");
+    wall2.physicsComponent().setMass(0, true);
+    MCObject object(MCShapePtr(new MCRectShape(nullptr, 2, 2)), "test");
+
+    wall1.addToWorld(world, 55, 55);
+    wall2.addToWorld(world, 56, 55);
+
+    // Static objects are never tested against each other
+    MCObjectGrid & grid = world.objectGrid();
+    QVERIFY(grid.getPossibleCollisions().empty());
+
+    // Awake objects are tested against the static layer
+    object.addToWorld(world, 55, 56);
+    QVERIFY(containsPair(grid.getPossibleCollisions(), object, wall1));
+    QVERIFY(containsPair(grid.getPossibleCollisions(), wall2, object));
+
+    object.physicsComponent().toggleSleep(true);
+    QVERIFY(grid.getPossibleCollisions().empty());
+
+    // All layers are included in the queries
+    QVERIFY(grid.objects().size() == 3);
+
+    // Making a static object movable moves it to the dynamic layer
+    object.physicsComponent().toggleSleep(false);
+    wall1.physicsComponent().setMass(1);
+    wall1.physicsComponent().toggleSleep(false);
+    wall1.translate(MCVector3dF(55.5, 55));
+    QVERIFY(containsPair(grid.getPossibleCollisions(), wall1, wall2));
+    QVERIFY(grid.objects().size() == 3);
+
+    world.removeObjectNow(wall1);
+    world.removeObjectNow(wall2);
+    world.removeObjectNow(object);
+    QVERIFY(grid.objects().empty());
+}
+
+void MCObjectGridTest::testRemoveAll()
+{
+    MCWorld world;
+    world.setDimensions(0, 100, 0, 100, 0, 100, 1, false, 10);
+
+    MCObject object1(MCShapePtr(new MCRectShape(nullptr, 2, 2)), "test");
+    MCObject object2(MCShapePtr(new MCRectShape(nullptr, 2, 2)), "test");
+
+    world.addObject(object1);
+    world.addObject(object2);
+
+    object1.translate(MCVector3dF(55, 55));
+    object2.translate(MCVector3dF(56, 55));
+
+    MCObjectGrid & grid = world.objectGrid();
+    grid.removeAll();
+    QVERIFY(grid.getPossibleCollisions().empty());
+    QVERIFY(!grid.remove(object1));
+    QVERIFY(!grid.remove(object2));
+}
+
+QTEST_GUILESS_MAIN(MCObjectGridTest)
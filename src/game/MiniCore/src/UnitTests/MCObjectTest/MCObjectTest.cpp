@@ -97,7 +97,7 @@ void MCObjectTest::testAddChildren()
     QVERIFY(child1->index() == -1);
     QVERIFY(child2->index() == -1);
 
-    root.addToWorld(); // Adding via object adds also children
+    root.addToWorld(world); // Adding via object adds also children
 
     QVERIFY(root.index() >= 0);
     QVERIFY(child1->index() >= 0);
@@ -139,7 +139,7 @@ void MCObjectTest::testAddToWorld()
     MCWorld world;
     MCObject object("test");
     QVERIFY(object.index() == -1);
-    object.addToWorld();
+    object.addToWorld(world);
     QVERIFY(object.index() >= 0);
 
     object.removeFromWorld(); // Lazy removal
@@ -147,7 +147,7 @@ void MCObjectTest::testAddToWorld()
     world.stepTime(1);
     QVERIFY(object.index() == -1);
 
-    object.addToWorld();
+    object.addToWorld(world);
     QVERIFY(object.index() >= 0);
 
     object.removeFromWorldNow(); // Immediate removal
@@ -158,7 +158,7 @@ void MCObjectTest::testAngularVelocityAndSleep()
 {
     MCWorld world;
     MCObject object("TestObject");
-    object.addToWorld();
+    object.addToWorld(world);
 
     QVERIFY(qFuzzyCompare(object.physicsComponent().angularVelocity(), float(0)));
 
@@ -187,7 +187,7 @@ void MCObjectTest::testAngularVelocityIntegration()
 {
     MCWorld world;
     MCObject object("TestObject");
-    object.addToWorld();
+    object.addToWorld(world);
 
     QVERIFY(qFuzzyCompare(object.physicsComponent().angularVelocity(), float(0)));
     QVERIFY(qFuzzyCompare(object.angle(), float(0)));
@@ -245,7 +245,7 @@ void MCObjectTest::testDelete()
 {
     MCWorld world;
     MCObject * object = new MCObject("TestObject");
-    object->addToWorld();
+    object->addToWorld(world);
     QVERIFY(world.objectCount() == 5); // 5 includes internal walls
 
     delete object;
@@ -268,7 +268,7 @@ void MCObjectTest::testChildRotate()
     const float child2Angle = 90;
     root.addChildObject(child2, MCVector3dF(2, 2, 2), 90);
 
-    root.addToWorld();
+    root.addToWorld(world);
 
     // Root at (0, 0, 0)
 
@@ -324,7 +324,7 @@ void MCObjectTest::testChildTranslate()
     root.addChildObject(child1, MCVector3dF(1, 1, 1));
     root.addChildObject(child2, MCVector3dF(2, 2, 2));
 
-    root.addToWorld();
+    root.addToWorld(world);
 
     // Root at (0, 0, 0)
 
@@ -353,7 +353,7 @@ void MCObjectTest::testCollisionLayer()
     root.addChildObject(child1);
     root.addChildObject(child2);
 
-    root.addToWorld();
+    root.addToWorld(world);
 
     QVERIFY(root.collisionLayer() == 0);
     QVERIFY(child1->collisionLayer() == 0);
@@ -387,7 +387,7 @@ void MCObjectTest::testLinearDamping()
 {
     MCWorld world;
     MCObject object("TestObject");
-    object.addToWorld();
+    object.addToWorld(world);
     object.physicsComponent().setLinearDamping(0.5f);
     vector3dCompare(object.physicsComponent().velocity(), MCVector3dF(0, 0, 0));
 
@@ -427,7 +427,7 @@ void MCObjectTest::testRotate()
     QVERIFY(qFuzzyCompare(object.angle(), float(45)));
     QVERIFY(qFuzzyCompare(shape->angle(), float(45)));
 
-    object.addToWorld();
+    object.addToWorld(world);
     object.rotate(22);
     QVERIFY(qFuzzyCompare(object.angle(), float(22)));
     QVERIFY(qFuzzyCompare(shape->angle(), float(22)));
@@ -467,7 +467,7 @@ void MCObjectTest::testTranslate()
 {
     MCWorld world;
     MCObject object("TestObject");
-    object.addToWorld();
+    object.addToWorld(world);
 
     vector3dCompare(object.location(), MCVector3dF(0, 0, 0));
 
@@ -480,7 +480,7 @@ void MCObjectTest::testVelocityAndSleep()
 {
     MCWorld world;
     MCObject object("TestObject");
-    object.addToWorld();
+    object.addToWorld(world);
     object.physicsComponent().setLinearDamping(1); // Disable damping
     vector3dCompare(object.physicsComponent().velocity(), MCVector3dF(0, 0, 0));
 
@@ -509,7 +509,7 @@ void MCObjectTest::testVelocityAndPreventSleeping()
 {
     MCWorld world;
     MCObject object("TestObject");
-    object.addToWorld();
+    object.addToWorld(world);
 
     object.physicsComponent().setVelocity(MCVector3dF(1, 1, 1));
 
@@ -541,7 +541,7 @@ void MCObjectTest::testVelocityIntegration()
     MCWorld world;
     world.setDimensions(0, 1024, 0, 768, 0, 100, 1);
     MCObject object("TestObject");
-    object.addToWorld();
+    object.addToWorld(world);
 
     vector3dCompare(object.location(), MCVector3dF(0, 0, 0));
     vector3dCompare(object.physicsComponent().velocity(), MCVector3dF(0, 0, 0));
@@ -0,0 +1,199 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#include "MCParticleSystemTest.hpp"
+#include "../../Core/mcworld.hh"
+#include "../../Graphics/mcparticlesystem.hh"
+
+#include <vector>
+
+static void vector3dCompare(MCVector3dF vector1, MCVector3dF vector2)
+{
+    QVERIFY(qFuzzyCompare(vector1.i(), vector2.i()));
+    QVERIFY(qFuzzyCompare(vector1.j(), vector2.j()));
+    QVERIFY(qFuzzyCompare(vector1.k(), vector2.k()));
+}
+
+MCParticleSystemTest::MCParticleSystemTest()
+{
+}
+
+void MCParticleSystemTest::testEmit()
+{
+    MCParticleSystem particleSystem(2);
+    QCOMPARE(particleSystem.capacity(), 2u);
+    QCOMPARE(particleSystem.count(), 0u);
+
+    QVERIFY(particleSystem.emit(MCVector3dF(1, 2, 3), MCVector3dF(), 4, 100, MCGLColor(0.5f, 0.5f, 0.5f, 0.5f), 45));
+    QVERIFY(!particleSystem.emit(MCVector3dF(), MCVector3dF(), 4, 0, MCGLColor()));
+    QVERIFY(particleSystem.emit(MCVector3dF(), MCVector3dF(), 4, 100, MCGLColor()));
+    QVERIFY(!particleSystem.emit(MCVector3dF(), MCVector3dF(), 4, 100, MCGLColor()));
+    QCOMPARE(particleSystem.count(), 2u);
+
+    vector3dCompare(particleSystem.location(0), MCVector3dF(1, 2, 3));
+    vector3dCompare(particleSystem.renderLocation(0), MCVector3dF(1, 2, 3));
+    QCOMPARE(particleSystem.renderAngle(0), 45.0f);
+    QCOMPARE(particleSystem.radius(0), 4.0f);
+    QCOMPARE(particleSystem.scale(0), 1.0f);
+    QCOMPARE(particleSystem.color(0).a(), 0.5f);
+
+    particleSystem.clear();
+    QCOMPARE(particleSystem.count(), 0u);
+}
+
+void MCParticleSystemTest::testStepTime()
+{
+    MCParticleSystem particleSystem(1);
+    particleSystem.setDamping(1.0f);
+    particleSystem.setAcceleration(MCVector3dF(0, 0, -10));
+    particleSystem.emit(MCVector3dF(0, 0, 100), MCVector3dF(1, 2, 0), 1, 1000, MCGLColor(), 10, 100);
+
+    // The velocity is added to the location on each step
+    particleSystem.stepTime(100);
+    vector3dCompare(particleSystem.location(0), MCVector3dF(1, 2, 99));
+    QCOMPARE(particleSystem.renderAngle(0), 20.0f);
+
+    particleSystem.stepTime(100);
+    vector3dCompare(particleSystem.location(0), MCVector3dF(2, 4, 97));
+    QCOMPARE(particleSystem.renderAngle(0), 30.0f);
+
+    particleSystem.setDamping(0.5f);
+    particleSystem.setAcceleration(MCVector3dF());
+    particleSystem.stepTime(100);
+    vector3dCompare(particleSystem.location(0), MCVector3dF(2.5f, 5, 96));
+}
+
+void MCParticleSystemTest::testLifeTime()
+{
+    MCParticleSystem particleSystem(3);
+    particleSystem.setAnimationStyle(MCParticle::AnimationStyle::Shrink);
+    particleSystem.emit(MCVector3dF(0, 0, 1), MCVector3dF(), 10, 100, MCGLColor());
+    particleSystem.emit(MCVector3dF(0, 0, 2), MCVector3dF(), 10, 40, MCGLColor());
+    particleSystem.emit(MCVector3dF(0, 0, 3), MCVector3dF(), 10, 200, MCGLColor());
+
+    particleSystem.stepTime(20);
+    QCOMPARE(particleSystem.count(), 3u);
+    QCOMPARE(particleSystem.scale(0), 0.8f);
+    QCOMPARE(particleSystem.radius(0), 8.0f);
+    QCOMPARE(particleSystem.scale(1), 0.5f);
+
+    // The second particle dies, the others keep their order
+    particleSystem.stepTime(20);
+    QCOMPARE(particleSystem.count(), 2u);
+    QCOMPARE(particleSystem.location(0).k(), 1.0f);
+    QCOMPARE(particleSystem.location(1).k(), 3.0f);
+    QCOMPARE(particleSystem.scale(1), 0.8f);
+
+    particleSystem.setAnimationStyle(MCParticle::AnimationStyle::FadeOutAndExpand);
+    QCOMPARE(particleSystem.radius(1), 12.0f);
+
+    particleSystem.stepTime(60);
+    QCOMPARE(particleSystem.count(), 1u);
+    QCOMPARE(particleSystem.location(0).k(), 3.0f);
+}
+
+void MCParticleSystemTest::testKill()
+{
+    MCParticleSystem particleSystem(2);
+    particleSystem.emit(MCVector3dF(0, 0, 1), MCVector3dF(), 1, 1000, MCGLColor());
+    particleSystem.emit(MCVector3dF(0, 0, 2), MCVector3dF(), 1, 1000, MCGLColor());
+
+    // Killed particles are removed on the next step
+    particleSystem.kill(0);
+    QCOMPARE(particleSystem.count(), 2u);
+    QCOMPARE(particleSystem.scale(0), 0.0f);
+
+    particleSystem.stepTime(10);
+    QCOMPARE(particleSystem.count(), 1u);
+    QCOMPARE(particleSystem.location(0).k(), 2.0f);
+}
+
+void MCParticleSystemTest::testWorldBoundaries()
+{
+    MCWorld world;
+    world.setDimensions(0, 100, 0, 100, 0, 100, 1, false);
+
+    MCParticleSystem particleSystem(4);
+    particleSystem.setDamping(1.0f);
+    world.addParticleSystem(particleSystem);
+    QCOMPARE(particleSystem.world(), &world);
+    QCOMPARE(world.particleSystems().size(), size_t(1));
+
+    particleSystem.emit(MCVector3dF(50, 50, 50), MCVector3dF(1, 1, 1), 1, 1000, MCGLColor());
+    particleSystem.emit(MCVector3dF(99, 50, 50), MCVector3dF(2, 0, 0), 1, 1000, MCGLColor());
+    particleSystem.emit(MCVector3dF(50, 50, 1), MCVector3dF(0, 0, -1), 1, 1000, MCGLColor());
+    particleSystem.emit(MCVector3dF(50, 1, 50), MCVector3dF(0, -2, 0), 1, 1000, MCGLColor());
+
+    // Only the first particle stays in the world. Hitting the floor counts as leaving it.
+    world.stepTime(10);
+    QCOMPARE(particleSystem.count(), 1u);
+    vector3dCompare(particleSystem.location(0), MCVector3dF(51, 51, 51));
+
+    // The particles are rendered between the two latest steps
+    world.setRenderInterpolation(0.5f);
+    vector3dCompare(particleSystem.renderLocation(0), MCVector3dF(50.5f, 50.5f, 50.5f));
+
+    world.clear();
+    QCOMPARE(particleSystem.count(), 0u);
+    QCOMPARE(particleSystem.world(), &world);
+
+    world.removeParticleSystem(particleSystem);
+    QCOMPARE(particleSystem.world(), static_cast<MCWorld *>(nullptr));
+    QVERIFY(world.particleSystems().empty());
+}
+
+void MCParticleSystemTest::testRemoveFromWorld()
+{
+    MCWorld world;
+    {
+        MCParticleSystem particleSystem(1);
+        world.addParticleSystem(particleSystem);
+    }
+
+    QVERIFY(world.particleSystems().empty());
+
+    MCParticleSystem particleSystem(1);
+    {
+        MCWorld otherWorld;
+        otherWorld.addParticleSystem(particleSystem);
+    }
+
+    QCOMPARE(particleSystem.world(), static_cast<MCWorld *>(nullptr));
+}
+
+void MCParticleSystemTest::testSortByZ()
+{
+    MCParticleSystem particleSystem(6);
+    const float z[] = {3.0f, -1.0f, 2.5f, 3.0f, 0.0f, 1000.0f};
+    for (float k : z)
+    {
+        particleSystem.emit(MCVector3dF(0, 0, k), MCVector3dF(), 1, 1000, MCGLColor());
+    }
+
+    std::vector<unsigned int> indices = {0, 1, 2, 3, 4, 5};
+    particleSystem.sortByZ(indices);
+    QCOMPARE(indices, std::vector<unsigned int>({1, 4, 2, 0, 3, 5}));
+
+    // Equal Z-coordinates keep their order
+    indices = {3, 0};
+    particleSystem.sortByZ(indices);
+    QCOMPARE(indices, std::vector<unsigned int>({3, 0}));
+}
+
+QTEST_GUILESS_MAIN(MCParticleSystemTest)
@@ -0,0 +1,189 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#include "MCProfilerTest.hpp"
+#include "../../Core/mcprofiler.hh"
+
+#include <QDir>
+#include <QFile>
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+static unsigned int countEvents(const MCProfiler::EventVector & events, const char * name)
+{
+    unsigned int count = 0;
+    for (auto && event : events)
+    {
+        if (!std::strcmp(event.name, name))
+        {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+MCProfilerTest::MCProfilerTest()
+{
+}
+
+void MCProfilerTest::testDisabled()
+{
+    MCProfiler::setEnabled(false);
+    MCProfiler::clear();
+
+    {
+        MC_PROFILE_ZONE("disabled");
+    }
+
+    QVERIFY(MCProfiler::events().empty());
+}
+
+void MCProfilerTest::testNestedZones()
+{
+    MCProfiler::setEnabled(true);
+    MCProfiler::clear();
+
+    {
+        MC_PROFILE_ZONE("outer");
+        {
+            MC_PROFILE_ZONE("inner");
+        }
+    }
+
+    MCProfiler::setEnabled(false);
+
+    const MCProfiler::EventVector events = MCProfiler::events();
+    QCOMPARE(events.size(), size_t(2));
+
+    // Events are sorted by the start time, so the outer zone comes first
+    QVERIFY(!std::strcmp(events[0].name, "outer"));
+    QVERIFY(!std::strcmp(events[1].name, "inner"));
+    QVERIFY(events[0].start <= events[1].start);
+    QVERIFY(events[0].start + events[0].duration >= events[1].start + events[1].duration);
+    QCOMPARE(events[0].thread, events[1].thread);
+}
+
+void MCProfilerTest::testMultipleThreads()
+{
+    MCProfiler::setEnabled(true);
+    MCProfiler::clear();
+
+    const unsigned int threadCount = 4;
+    const unsigned int zonesPerThread = 100;
+
+    std::vector<std::thread> threads;
+    for (unsigned int i = 0; i < threadCount; i++)
+    {
+        threads.push_back(std::thread([] () {
+            for (unsigned int j = 0; j < zonesPerThread; j++)
+            {
+                MC_PROFILE_ZONE("worker");
+            }
+        }));
+    }
+
+    for (auto && thread : threads)
+    {
+        thread.join();
+    }
+
+    MCProfiler::setEnabled(false);
+
+    const MCProfiler::EventVector events = MCProfiler::events();
+    QCOMPARE(countEvents(events, "worker"), threadCount * zonesPerThread);
+
+    for (unsigned int i = 1; i < events.size(); i++)
+    {
+        QVERIFY(events[i - 1].start <= events[i].start);
+    }
+}
+
+void MCProfilerTest::testOverflow()
+{
+    MCProfiler::setEnabled(true);
+    MCProfiler::clear();
+
+    const int64_t start = MCProfiler::now();
+    for (unsigned int i = 0; i < MCProfiler::EVENTS_PER_THREAD + 100; i++)
+    {
+        MCProfiler::record(i < 100 ? "old" : "new", start + i, start + i + 1);
+    }
+
+    MCProfiler::setEnabled(false);
+
+    // The oldest events have been overwritten
+    const MCProfiler::EventVector events = MCProfiler::events(start);
+    QCOMPARE(countEvents(events, "old"), 0u);
+    QCOMPARE(countEvents(events, "new"), MCProfiler::EVENTS_PER_THREAD);
+}
+
+void MCProfilerTest::testSummary()
+{
+    MCProfiler::setEnabled(true);
+    MCProfiler::clear();
+
+    const int64_t start = MCProfiler::now();
+    MCProfiler::record("b", start, start + 10);
+    MCProfiler::record("a", start + 10, start + 40);
+    MCProfiler::record("b", start + 40, start + 70);
+
+    MCProfiler::setEnabled(false);
+
+    const MCProfiler::SummaryVector summary = MCProfiler::summary(start);
+    QCOMPARE(summary.size(), size_t(2));
+
+    QVERIFY(!std::strcmp(summary[0].name, "a"));
+    QCOMPARE(summary[0].count, 1u);
+    QCOMPARE(summary[0].total, int64_t(30));
+
+    QVERIFY(!std::strcmp(summary[1].name, "b"));
+    QCOMPARE(summary[1].count, 2u);
+    QCOMPARE(summary[1].total, int64_t(40));
+    QCOMPARE(summary[1].longest, int64_t(30));
+}
+
+void MCProfilerTest::testChromeTrace()
+{
+    MCProfiler::setEnabled(true);
+    MCProfiler::clear();
+
+    {
+        MC_PROFILE_ZONE("trace \"zone\"");
+    }
+
+    MCProfiler::setEnabled(false);
+
+    const QString fileName = QDir::tempPath() + QDir::separator() + "MCProfilerTest.json";
+    QVERIFY(MCProfiler::writeChromeTrace(fileName.toStdString()));
+
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QByteArray data = file.readAll();
+    file.close();
+    file.remove();
+
+    QVERIFY(data.startsWith("{\"traceEvents\":["));
+    QVERIFY(data.contains("\"name\":\"trace \\\"zone\\\"\""));
+    QVERIFY(data.contains("\"ph\":\"X\""));
+}
+
+QTEST_GUILESS_MAIN(MCProfilerTest)
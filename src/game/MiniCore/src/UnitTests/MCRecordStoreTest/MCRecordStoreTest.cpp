@@ -0,0 +1,188 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#include "MCRecordStoreTest.hpp"
+#include "../../Core/mcrecordstore.hh"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+namespace {
+// Backend that keeps the records in memory and can simulate slow writes.
+class TestBackend : public MCRecordStore::Backend
+{
+public:
+
+    TestBackend(MCRecordStore::RecordMap & storage, std::mutex & mutex, std::atomic<int> & writeCount, int writeDelay = 0)
+        : m_storage(storage)
+        , m_mutex(mutex)
+        , m_writeCount(writeCount)
+        , m_writeDelay(writeDelay)
+    {
+    }
+
+    MCRecordStore::RecordMap read() override
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_storage;
+    }
+
+    void write(const MCRecordStore::ChangeList & changes) override
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(m_writeDelay));
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto && change : changes)
+        {
+            if (change.removed)
+            {
+                m_storage.erase(change.key);
+            }
+            else
+            {
+                m_storage[change.key] = change.value;
+            }
+        }
+
+        m_writeCount++;
+    }
+
+private:
+
+    MCRecordStore::RecordMap & m_storage;
+
+    std::mutex & m_mutex;
+
+    std::atomic<int> & m_writeCount;
+
+    int m_writeDelay;
+};
+}
+
+MCRecordStoreTest::MCRecordStoreTest()
+{
+}
+
+void MCRecordStoreTest::testLoad()
+{
+    MCRecordStore::RecordMap storage = {{"LapRecords/a", 1000}, {"LapRecords/b", 2000}};
+    std::mutex mutex;
+    std::atomic<int> writeCount(0);
+
+    MCRecordStore store(std::unique_ptr<MCRecordStore::Backend>(new TestBackend(storage, mutex, writeCount)));
+    QCOMPARE(store.value("LapRecords/a", -1), -1);
+
+    store.load();
+    QCOMPARE(store.value("LapRecords/a", -1), 1000);
+    QCOMPARE(store.value("LapRecords/b", -1), 2000);
+    QCOMPARE(store.value("LapRecords/c", -1), -1);
+    QCOMPARE(store.dirtyCount(), size_t(0));
+}
+
+void MCRecordStoreTest::testSetValue()
+{
+    MCRecordStore::RecordMap storage;
+    std::mutex mutex;
+    std::atomic<int> writeCount(0);
+
+    MCRecordStore store(std::unique_ptr<MCRecordStore::Backend>(new TestBackend(storage, mutex, writeCount)));
+    store.load();
+
+    store.setValue("LapRecords/a", 1000);
+    store.setValue("LapRecords/a", 900);
+    QCOMPARE(store.value("LapRecords/a", -1), 900);
+    QCOMPARE(store.dirtyCount(), size_t(1));
+
+    // Nothing is written before flush()
+    QCOMPARE(writeCount.load(), 0);
+    QVERIFY(storage.empty());
+}
+
+void MCRecordStoreTest::testRemove()
+{
+    MCRecordStore::RecordMap storage = {{"LapRecords/a", 1000}, {"LapRecords/b", 2000}, {"RaceRecords/a", 5000}};
+    std::mutex mutex;
+    std::atomic<int> writeCount(0);
+
+    MCRecordStore store(std::unique_ptr<MCRecordStore::Backend>(new TestBackend(storage, mutex, writeCount)));
+    store.load();
+
+    store.remove("LapRecords/");
+    QCOMPARE(store.value("LapRecords/a", -1), -1);
+    QCOMPARE(store.value("LapRecords/b", -1), -1);
+    QCOMPARE(store.value("RaceRecords/a", -1), 5000);
+    QCOMPARE(store.dirtyCount(), size_t(2));
+
+    store.flush();
+    store.waitForFlush();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    QCOMPARE(storage.size(), size_t(1));
+    QCOMPARE(storage["RaceRecords/a"], 5000);
+}
+
+void MCRecordStoreTest::testFlush()
+{
+    MCRecordStore::RecordMap storage;
+    std::mutex mutex;
+    std::atomic<int> writeCount(0);
+
+    MCRecordStore store(std::unique_ptr<MCRecordStore::Backend>(new TestBackend(storage, mutex, writeCount)));
+    store.load();
+
+    store.setValue("LapRecords/a", 1000);
+    store.setValue("BestPositions/a", 2);
+    store.flush();
+    QCOMPARE(store.dirtyCount(), size_t(0));
+
+    store.waitForFlush();
+    QCOMPARE(writeCount.load(), 1);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        QCOMPARE(storage.size(), size_t(2));
+        QCOMPARE(storage["LapRecords/a"], 1000);
+        QCOMPARE(storage["BestPositions/a"], 2);
+    }
+
+    // Flushing without changes doesn't write anything
+    store.flush();
+    store.waitForFlush();
+    QCOMPARE(writeCount.load(), 1);
+}
+
+void MCRecordStoreTest::testFlushOnDestruction()
+{
+    MCRecordStore::RecordMap storage;
+    std::mutex mutex;
+    std::atomic<int> writeCount(0);
+
+    {
+        MCRecordStore store(std::unique_ptr<MCRecordStore::Backend>(new TestBackend(storage, mutex, writeCount, 10)));
+        store.load();
+        store.setValue("LapRecords/a", 1000);
+    }
+
+    QCOMPARE(writeCount.load(), 1);
+    QCOMPARE(storage["LapRecords/a"], 1000);
+}
+
+QTEST_GUILESS_MAIN(MCRecordStoreTest)
@@ -0,0 +1,151 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#include "MCTextureAtlasTest.hpp"
+#include "../../Asset/mctextureatlas.hh"
+
+#include <vector>
+
+namespace {
+bool overlaps(const MCTextureAtlas::Item & l, const MCTextureAtlas::Item & r, int padding)
+{
+    return l.page == r.page &&
+        l.x - padding < r.x + r.width + padding && r.x - padding < l.x + l.width + padding &&
+        l.y - padding < r.y + r.height + padding && r.y - padding < l.y + l.height + padding;
+}
+}
+
+MCTextureAtlasTest::MCTextureAtlasTest()
+{
+}
+
+void MCTextureAtlasTest::testPack()
+{
+    MCTextureAtlas atlas(512, 2);
+
+    std::vector<MCTextureAtlas::Item> items;
+    for (int i = 0; i < 40; i++)
+    {
+        MCTextureAtlas::Item item;
+        item.handle = std::to_string(i);
+        item.width = 8 + (i * 7) % 60;
+        item.height = 8 + (i * 13) % 50;
+        items.push_back(item);
+    }
+
+    QCOMPARE(atlas.pack(items), 1);
+    QCOMPARE(atlas.pages().size(), size_t(1));
+
+    const MCTextureAtlas::Page & page = atlas.pages().at(0);
+    for (size_t i = 0; i < items.size(); i++)
+    {
+        const MCTextureAtlas::Item & item = items[i];
+        QCOMPARE(item.handle, std::to_string(i));
+        QCOMPARE(item.page, 0);
+
+        // The padding must also fit on the page
+        QVERIFY(item.x >= 2);
+        QVERIFY(item.y >= 2);
+        QVERIFY(item.x + item.width + 2 <= page.width);
+        QVERIFY(item.y + item.height + 2 <= page.height);
+
+        for (size_t j = i + 1; j < items.size(); j++)
+        {
+            QVERIFY(!overlaps(item, items[j], 2));
+        }
+    }
+}
+
+void MCTextureAtlasTest::testPageDimensions()
+{
+    MCTextureAtlas atlas(1024, 1);
+
+    std::vector<MCTextureAtlas::Item> items(3);
+    items[0].width = 100;
+    items[0].height = 30;
+    items[1].width = 50;
+    items[1].height = 60;
+    items[2].width = 20;
+    items[2].height = 10;
+
+    QCOMPARE(atlas.pack(items), 1);
+
+    // 172 x 62 pixels are used, rounded up to powers of two
+    QCOMPARE(atlas.pages().at(0).width, 256);
+    QCOMPARE(atlas.pages().at(0).height, 64);
+
+    // The tallest item goes first
+    QCOMPARE(items[1].x, 1);
+    QCOMPARE(items[1].y, 1);
+    QCOMPARE(items[0].x, 53);
+    QCOMPARE(items[2].x, 155);
+}
+
+void MCTextureAtlasTest::testMultiplePages()
+{
+    MCTextureAtlas atlas(256, 0);
+
+    std::vector<MCTextureAtlas::Item> items(5);
+    for (auto && item : items)
+    {
+        item.width = 128;
+        item.height = 128;
+    }
+
+    QCOMPARE(atlas.pack(items), 2);
+    QCOMPARE(atlas.pages().at(0).width, 256);
+    QCOMPARE(atlas.pages().at(0).height, 256);
+    QCOMPARE(atlas.pages().at(1).width, 128);
+    QCOMPARE(atlas.pages().at(1).height, 128);
+
+    for (size_t i = 0; i < items.size(); i++)
+    {
+        QCOMPARE(items[i].page, i < 4 ? 0 : 1);
+        for (size_t j = i + 1; j < items.size(); j++)
+        {
+            QVERIFY(!overlaps(items[i], items[j], 0));
+        }
+    }
+
+    // Packing again replaces the previous layout
+    items.resize(1);
+    QCOMPARE(atlas.pack(items), 1);
+    QCOMPARE(atlas.pages().size(), size_t(1));
+}
+
+void MCTextureAtlasTest::testTooLargeItem()
+{
+    MCTextureAtlas atlas(64, 2);
+
+    std::vector<MCTextureAtlas::Item> items(2);
+    items[0].width = 61;
+    items[0].height = 10;
+    items[1].width = 60;
+    items[1].height = 60;
+
+    QCOMPARE(atlas.pack(items), 1);
+    QCOMPARE(items[0].page, -1);
+    QCOMPARE(items[1].page, 0);
+
+    items.resize(1);
+    QCOMPARE(atlas.pack(items), 0);
+    QVERIFY(atlas.pages().empty());
+}
+
+QTEST_GUILESS_MAIN(MCTextureAtlasTest)
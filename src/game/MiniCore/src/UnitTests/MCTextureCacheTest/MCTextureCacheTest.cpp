@@ -0,0 +1,154 @@
+// This file belongs to the "MiniCore" game engine.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//
+
+#include "MCTextureCacheTest.hpp"
+#include "../../Asset/mctexturecache.hh"
+#include "../../Asset/mcsurfacemetadata.hh"
+
+#include <QFile>
+
+#include <string>
+
+namespace {
+const char SOURCE[] = "not really a png";
+
+MCTextureCache::Entry createEntry()
+{
+    MCTextureCache::Entry entry;
+    entry.imageWidth = 30;
+    entry.imageHeight = 20;
+    entry.texture = QImage(32, 16, QImage::Format_ARGB32);
+    for (int y = 0; y < entry.texture.height(); y++)
+    {
+        for (int x = 0; x < entry.texture.width(); x++)
+        {
+            entry.texture.setPixel(x, y, qRgba(x * 8, y * 16, x + y, x * y % 256));
+        }
+    }
+    return entry;
+}
+}
+
+MCTextureCacheTest::MCTextureCacheTest()
+{
+}
+
+void MCTextureCacheTest::testKey()
+{
+    MCSurfaceMetaData data;
+    data.handle = "surface";
+    data.imagePath = "surface.png";
+    const std::string key = MCTextureCache::key(data, SOURCE, sizeof(SOURCE), 2048, false);
+
+    QCOMPARE(MCTextureCache::key(data, SOURCE, sizeof(SOURCE), 2048, false), key);
+    QVERIFY(MCTextureCache::key(data, SOURCE, sizeof(SOURCE) - 1, 2048, false) != key);
+    QVERIFY(MCTextureCache::key(data, SOURCE, sizeof(SOURCE), 1024, false) != key);
+    QVERIFY(MCTextureCache::key(data, SOURCE, sizeof(SOURCE), 2048, true) != key);
+
+    // Settings that don't affect the pixels don't affect the key either
+    MCSurfaceMetaData other = data;
+    other.handle = "other";
+    other.imagePath = "other.png";
+    other.z0 = 1.0f;
+    QCOMPARE(MCTextureCache::key(other, SOURCE, sizeof(SOURCE), 2048, false), key);
+
+    other = data;
+    other.xAxisMirror = true;
+    QVERIFY(MCTextureCache::key(other, SOURCE, sizeof(SOURCE), 2048, false) != key);
+
+    other = data;
+    other.sizeDivider = 2;
+    QVERIFY(MCTextureCache::key(other, SOURCE, sizeof(SOURCE), 2048, false) != key);
+
+    other = data;
+    other.alphaClamp = {0.5f, true};
+    QVERIFY(MCTextureCache::key(other, SOURCE, sizeof(SOURCE), 2048, false) != key);
+
+    other = data;
+    other.colorKeySet = true;
+    other.colorKey = {255, 0, 255};
+    const std::string colorKeyKey = MCTextureCache::key(other, SOURCE, sizeof(SOURCE), 2048, false);
+    QVERIFY(colorKeyKey != key);
+
+    other.colorKey = {255, 0, 254};
+    QVERIFY(MCTextureCache::key(other, SOURCE, sizeof(SOURCE), 2048, false) != colorKeyKey);
+}
+
+void MCTextureCacheTest::testSaveAndLoad()
+{
+    QVERIFY(m_dir.isValid());
+
+    // The directory is created on demand
+    MCTextureCache cache((m_dir.path() + "/textures").toStdString());
+    QVERIFY(cache.isEnabled());
+
+    const MCTextureCache::Entry entry = createEntry();
+    QVERIFY(cache.save("0123456789abcdef", entry));
+
+    MCTextureCache::Entry loaded;
+    QVERIFY(cache.load("0123456789abcdef", loaded));
+    QCOMPARE(loaded.imageWidth, entry.imageWidth);
+    QCOMPARE(loaded.imageHeight, entry.imageHeight);
+    QCOMPARE(loaded.texture.format(), QImage::Format_ARGB32);
+    QCOMPARE(loaded.texture, entry.texture);
+}
+
+void MCTextureCacheTest::testMissingEntry()
+{
+    QVERIFY(m_dir.isValid());
+
+    MCTextureCache cache(m_dir.path().toStdString());
+
+    MCTextureCache::Entry entry;
+    QVERIFY(!cache.load("fedcba9876543210", entry));
+    QVERIFY(entry.texture.isNull());
+}
+
+void MCTextureCacheTest::testBrokenEntry()
+{
+    QVERIFY(m_dir.isValid());
+
+    MCTextureCache cache(m_dir.path().toStdString());
+    QVERIFY(cache.save("broken", createEntry()));
+
+    // Truncate the pixel data
+    QFile file(m_dir.path() + "/broken.mctex");
+    QVERIFY(file.resize(file.size() - 1));
+
+    MCTextureCache::Entry entry;
+    QVERIFY(!cache.load("broken", entry));
+
+    // Not a cache file at all
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    file.write(SOURCE, sizeof(SOURCE));
+    file.close();
+    QVERIFY(!cache.load("broken", entry));
+}
+
+void MCTextureCacheTest::testDisabled()
+{
+    MCTextureCache cache("");
+    QVERIFY(!cache.isEnabled());
+    QVERIFY(!cache.save("0123456789abcdef", createEntry()));
+
+    MCTextureCache::Entry entry;
+    QVERIFY(!cache.load("0123456789abcdef", entry));
+}
+
+QTEST_GUILESS_MAIN(MCTextureCacheTest)
@@ -20,9 +20,19 @@
 #include "MCWorldTest.hpp"
 #include "../../Core/mcworld.hh"
 #include "../../Core/mcobject.hh"
-#include "../../Physics/mcrectshape.hh"
+#include "../../Core/mcframearena.hh"
+#include "../../Physics/mccircleshape.hh"
+#include "../../Physics/mccollisiondetector.hh"
 #include "../../Physics/mccollisionevent.hh"
+#include "../../Physics/mccontact.hh"
+#include "../../Physics/mccontactcache.hh"
 #include "../../Physics/mcphysicscomponent.hh"
+#include "../../Physics/mcrectshape.hh"
+
+#include <map>
+#include <memory>
+#include <thread>
+#include <vector>
 
 class TestObject : public MCObject
 {
@@ -71,15 +81,59 @@ void MCWorldTest::testAddToWorld()
     QVERIFY(world.objectCount() == 4);
 }
 
-void MCWorldTest::testInstance()
+void MCWorldTest::testMultipleWorlds()
 {
-    QVERIFY(MCWorld::hasInstance() == false);
+    MCWorld world1;
+    MCWorld world2;
+    world1.setDimensions(-10, 10, -10, 10, -10, 10, 0.5f);
+    world2.setDimensions(-10, 10, -10, 10, -10, 10, 2.0f);
+
+    QVERIFY(qFuzzyCompare(world1.metersPerUnit(), 0.5f));
+    QVERIFY(qFuzzyCompare(world2.metersPerUnit(), 2.0f));
+
+    std::vector<std::unique_ptr<TestObject>> objects;
+    for (MCWorld * world : {&world1, &world2})
     {
-        MCWorld world;
-        QVERIFY(MCWorld::hasInstance() == true);
-        QVERIFY(&MCWorld::instance() == &world);
+        for (float x : {-0.5f, 0.5f})
+        {
+            TestObject * object = new TestObject;
+            object->setShape(MCShapePtr(new MCRectShape(MCShapeViewPtr(), 2.0, 2.0)));
+            object->physicsComponent().preventSleeping(true);
+            QVERIFY(object->world() == nullptr);
+            object->addToWorld(*world, x, 0.0f);
+            QVERIFY(object->world() == world);
+            objects.push_back(std::unique_ptr<TestObject>(object));
+        }
     }
-    QVERIFY(MCWorld::hasInstance() == false);
+
+    QVERIFY(world1.objectCount() == world2.objectCount());
+
+    // Worlds don't share state, so they can be stepped in parallel
+    std::thread thread([&world2] () {
+        for (int i = 0; i < 10; i++)
+        {
+            world2.stepTime(1.0);
+        }
+    });
+
+    for (int i = 0; i < 10; i++)
+    {
+        world1.stepTime(1.0);
+    }
+
+    thread.join();
+
+    for (auto && object : objects)
+    {
+        QVERIFY(object->m_collisionEventReceived);
+    }
+
+    objects.front()->removeFromWorldNow();
+    QVERIFY(objects.front()->world() == nullptr);
+    QVERIFY(world1.objectCount() == world2.objectCount() - 1);
+
+    world2.clear();
+    QVERIFY(objects.back()->world() == nullptr);
 }
 
 void MCWorldTest::testSetDimensions()
@@ -132,6 +186,200 @@ void MCWorldTest::testSimpleCollision()
     QVERIFY(object2.m_collisionEventReceived);
 }
 
+namespace {
+// Overlapping grid of boxes and circles with enough possible collisions to be split between threads
+void createCollisionScene(MCWorld & world, std::vector<std::unique_ptr<TestObject>> & objects)
+{
+    world.setDimensions(-20, 20, -20, 20, -10, 10, 1.0f, false);
+
+    for (int i = 0; i < 12; i++)
+    {
+        for (int j = 0; j < 12; j++)
+        {
+            TestObject * object = new TestObject;
+            if ((i + j) % 3)
+            {
+                object->setShape(MCShapePtr(new MCRectShape(MCShapeViewPtr(), 2.0, 2.0)));
+            }
+            else
+            {
+                object->setShape(MCShapePtr(new MCCircleShape(MCShapeViewPtr(), 1.0)));
+            }
+
+            object->physicsComponent().preventSleeping(true);
+            world.addObject(*object);
+            object->translate(MCVector3dF(-8.0f + i * 1.5f, -8.0f + j * 1.5f));
+            object->rotate(i * 7 + j * 13);
+            object->physicsComponent().setVelocity(MCVector3dF(0.1f * (i % 3 - 1), 0.1f * (j % 5 - 2)));
+            objects.push_back(std::unique_ptr<TestObject>(object));
+        }
+    }
+}
+
+// Contacts of the objects with the other objects referred to by their indices
+struct ContactRecord
+{
+    size_t object1;
+    size_t object2;
+    float x, y, nx, ny, depth;
+
+    bool operator==(const ContactRecord & other) const
+    {
+        return object1 == other.object1 && object2 == other.object2 &&
+            x == other.x && y == other.y && nx == other.nx && ny == other.ny && depth == other.depth;
+    }
+};
+
+std::vector<ContactRecord> recordContacts(const std::vector<std::unique_ptr<TestObject>> & objects)
+{
+    std::map<const MCObject *, size_t> indices;
+    for (size_t i = 0; i < objects.size(); i++)
+    {
+        indices[objects[i].get()] = i;
+    }
+
+    std::vector<ContactRecord> records;
+    for (size_t i = 0; i < objects.size(); i++)
+    {
+        for (const MCContact * contact : objects[i]->contacts())
+        {
+            records.push_back({i, indices.at(&contact->object()),
+                contact->contactPoint().i(), contact->contactPoint().j(),
+                contact->contactNormal().i(), contact->contactNormal().j(),
+                contact->interpenetrationDepth()});
+        }
+    }
+
+    return records;
+}
+}
+
+void MCWorldTest::testMultiThreadedCollisionDetection()
+{
+    const unsigned int threadCount = 4;
+
+    // Same contacts from the serial and the parallel narrow phase
+    {
+        MCWorld world;
+        std::vector<std::unique_ptr<TestObject>> objects;
+        createCollisionScene(world, objects);
+
+        const MCObjectGrid::CollisionVector & possibleCollisions = world.objectGrid().getPossibleCollisions();
+
+        // The detector uses the parallel path only with at least 64 possible collisions per thread
+        QVERIFY(possibleCollisions.size() >= threadCount * 64);
+
+        MCFrameArena arena;
+        MCCollisionDetector serialDetector(arena);
+        const unsigned int serialCollisions = serialDetector.detectCollisions(possibleCollisions);
+        const std::vector<ContactRecord> serialContacts = recordContacts(objects);
+        serialDetector.releaseContacts();
+
+        MCCollisionDetector parallelDetector(arena);
+        parallelDetector.setThreadCount(threadCount);
+        QVERIFY(parallelDetector.threadCount() == threadCount);
+        const unsigned int parallelCollisions = parallelDetector.detectCollisions(possibleCollisions);
+        const std::vector<ContactRecord> parallelContacts = recordContacts(objects);
+        parallelDetector.releaseContacts();
+
+        QVERIFY(serialCollisions > 0);
+        QVERIFY(parallelCollisions == serialCollisions);
+        QVERIFY(!serialContacts.empty());
+        QVERIFY(parallelContacts == serialContacts);
+
+        for (auto && object : objects)
+        {
+            QVERIFY(object->m_collisionEventReceived);
+        }
+    }
+
+    // Same simulation with one and multiple threads
+    MCWorld serialWorld;
+    std::vector<std::unique_ptr<TestObject>> serialObjects;
+    createCollisionScene(serialWorld, serialObjects);
+
+    MCWorld parallelWorld;
+    parallelWorld.setCollisionDetectionThreadCount(threadCount);
+    std::vector<std::unique_ptr<TestObject>> parallelObjects;
+    createCollisionScene(parallelWorld, parallelObjects);
+
+    for (int i = 0; i < 10; i++)
+    {
+        serialWorld.stepTime(1);
+        parallelWorld.stepTime(1);
+    }
+
+    for (size_t i = 0; i < serialObjects.size(); i++)
+    {
+        MCObject & serial = *serialObjects[i];
+        MCObject & parallel = *parallelObjects[i];
+        QVERIFY(serial.location().i() == parallel.location().i());
+        QVERIFY(serial.location().j() == parallel.location().j());
+        QVERIFY(serial.angle() == parallel.angle());
+        QVERIFY(serial.physicsComponent().velocity().i() == parallel.physicsComponent().velocity().i());
+        QVERIFY(serial.physicsComponent().velocity().j() == parallel.physicsComponent().velocity().j());
+        QVERIFY(serial.physicsComponent().angularVelocity() == parallel.physicsComponent().angularVelocity());
+    }
+}
+
+void MCWorldTest::testPositionResolving()
+{
+    MCWorld world;
+    world.setDimensions(-10, 10, -10, 10, -10, 10);
+
+    TestObject object1;
+    object1.setShape(MCShapePtr(new MCRectShape(MCShapeViewPtr(), 2.0, 2.0)));
+    object1.physicsComponent().preventSleeping(true);
+
+    TestObject object2;
+    object2.setShape(MCShapePtr(new MCRectShape(MCShapeViewPtr(), 2.0, 2.0)));
+    object2.physicsComponent().preventSleeping(true);
+
+    world.addObject(object1);
+    world.addObject(object2);
+
+    object1.translate(MCVector3dF(-0.5, 0.1));
+    object2.translate(MCVector3dF( 0.5, 0.0));
+
+    world.stepTime(1.0);
+
+    // Interpenetration is resolved without re-running the collision detection
+    QVERIFY(object1.location().i() < -0.5f);
+    QVERIFY(object2.location().i() > 0.5f);
+}
+
+void MCWorldTest::testContactCacheObjectRemoval()
+{
+    MCFrameArena arena;
+    TestObject object1;
+    TestObject object2;
+    TestObject object3;
+
+    MCContact & contact12 = MCContact::create(arena);
+    contact12.init(object2, MCVector2dF(), MCVector2dF(1, 0), 0.5f);
+    object1.addContact(contact12);
+
+    MCContact & contact13 = MCContact::create(arena);
+    contact13.init(object3, MCVector2dF(), MCVector2dF(0, 1), 0.25f);
+    object1.addContact(contact13);
+
+    MCContactCache cache;
+    cache.update({&object1});
+    QCOMPARE(cache.manifolds().size(), size_t(2));
+
+    // An object created later at the same address must not get the manifold
+    cache.removeObject(object2);
+    QCOMPARE(cache.manifolds().size(), size_t(1));
+    QVERIFY(!cache.manifold(object1, object2));
+    QVERIFY(cache.manifold(object1, object3));
+    QCOMPARE(cache.manifold(object1, object3)->detectedDepth, 0.25f);
+
+    cache.removeObject(object2);
+    QCOMPARE(cache.manifolds().size(), size_t(1));
+
+    object1.deleteContacts();
+}
+
 void MCWorldTest::testSleepingObjectRemovalFromIntegration()
 {
     MCWorld world;
@@ -148,4 +396,193 @@ void MCWorldTest::testSleepingObjectRemovalFromIntegration()
     QVERIFY(world.objectCount() == 5);
 }
 
+void MCWorldTest::testBatchedIntegration()
+{
+    MCWorld world;
+    world.setDimensions(-100, 100, -100, 100, -10, 10);
+
+    MCObject object1("test");
+    object1.physicsComponent().setMass(1.0f);
+    object1.physicsComponent().setVelocity(MCVector3dF(1.0f, 2.0f));
+    object1.physicsComponent().addAngularImpulse(1.0f);
+    world.addObject(object1);
+
+    MCObject object2("test");
+    object2.physicsComponent().setMass(1.0f);
+    object2.physicsComponent().setVelocity(MCVector3dF(1.0f, 2.0f));
+    object2.physicsComponent().addAngularImpulse(1.0f);
+    world.addObject(object2);
+    object2.physicsComponent().toggleSleep(true);
+
+    world.stepTime(10);
+    const MCVector3dF location = object1.location();
+    const float angle = object1.angle();
+    QVERIFY(!location.isZero());
+    object1.translate(MCVector3dF());
+    object1.rotate(0);
+
+    // Batched integration must give exactly the same result
+    world.enableBatchedIntegration(true);
+    object1.physicsComponent().reset();
+    object1.physicsComponent().setVelocity(MCVector3dF(1.0f, 2.0f));
+    object1.physicsComponent().addAngularImpulse(1.0f);
+    world.stepTime(10);
+    QCOMPARE(object1.location().i(), location.i());
+    QCOMPARE(object1.location().j(), location.j());
+    QCOMPARE(object1.angle(), angle);
+
+    // Sleeping objects are not integrated
+    QVERIFY(object2.location().isZero());
+}
+
+void MCWorldTest::testSleepingIslands()
+{
+    MCWorld world;
+    world.setDimensions(-100, 100, -100, 100, -10, 10);
+
+    // Two boxes that touch each other within the resolver tolerance and a third one far away
+    std::vector<std::unique_ptr<MCObject>> objects;
+    for (float x : {-1.0f, 0.995f, 50.0f})
+    {
+        MCObject * object = new MCObject(MCShapePtr(new MCRectShape(nullptr, 2.0, 2.0)), "test");
+        object->physicsComponent().setMass(1.0f);
+        object->addToWorld(world, x, 0.0f);
+        objects.push_back(std::unique_ptr<MCObject>(object));
+    }
+
+    MCPhysicsComponent & component1 = objects.at(0)->physicsComponent();
+    MCPhysicsComponent & component2 = objects.at(1)->physicsComponent();
+    MCPhysicsComponent & component3 = objects.at(2)->physicsComponent();
+
+    // The island can't fall asleep while one of its objects is kept awake
+    component2.preventSleeping(true);
+    for (int i = 0; i < 3; i++)
+    {
+        world.stepTime(1);
+    }
+
+    QVERIFY(!component1.isSleeping());
+    QVERIFY(!component2.isSleeping());
+    QVERIFY(component3.isSleeping());
+
+    component2.preventSleeping(false);
+    world.stepTime(1);
+    world.stepTime(1);
+    QVERIFY(component1.isSleeping());
+    QVERIFY(component2.isSleeping());
+
+    // Waking up one object wakes up the whole island, but not the others
+    component1.setVelocity(MCVector3dF(0.0f, 1.0f));
+    QVERIFY(!component1.isSleeping());
+    QVERIFY(!component2.isSleeping());
+    QVERIFY(component3.isSleeping());
+}
+
+void MCWorldTest::testImpulseOfAwakeSlowObjects()
+{
+    MCWorld world;
+    world.setDimensions(-100, 100, -100, 100, -10, 10, 1.0f, false);
+
+    // A slow and a fast box touching each other in the same island and a slow box kept awake
+    std::vector<std::unique_ptr<MCObject>> objects;
+    for (float x : {-1.0f, 0.995f, 50.0f})
+    {
+        MCObject * object = new MCObject(MCShapePtr(new MCRectShape(nullptr, 2.0, 2.0)), "test");
+        object->physicsComponent().setMass(1.0f);
+        object->physicsComponent().setLinearDamping(1.0f);
+        object->addToWorld(world, x, 0.0f);
+        objects.push_back(std::unique_ptr<MCObject>(object));
+    }
+
+    MCPhysicsComponent & slow = objects.at(0)->physicsComponent();
+    MCPhysicsComponent & fast = objects.at(1)->physicsComponent();
+    MCPhysicsComponent & awake = objects.at(2)->physicsComponent();
+
+    fast.setAngularVelocity(1.0f);
+    awake.preventSleeping(true);
+
+    // Let the slow boxes become ready to sleep
+    world.stepTime(1);
+    world.stepTime(1);
+
+    const MCVector3dF impulse(0.0f, 0.004f);
+    slow.addImpulse(impulse);
+    awake.addImpulse(impulse);
+
+    // The impulses are below the sleep limit, but the boxes stay awake
+    world.stepTime(1);
+    QVERIFY(!slow.isSleeping());
+    QVERIFY(!awake.isSleeping());
+    QVERIFY(slow.velocity().i() == impulse.i() && slow.velocity().j() == impulse.j());
+    QVERIFY(awake.velocity().i() == impulse.i() && awake.velocity().j() == impulse.j());
+
+    // The impulses must be consumed by the first step
+    const MCVector3dF slowVelocity = slow.velocity();
+    const MCVector3dF awakeVelocity = awake.velocity();
+    world.stepTime(1);
+    QVERIFY(!slow.isSleeping());
+    QVERIFY(slow.velocity().i() == slowVelocity.i() && slow.velocity().j() == slowVelocity.j());
+    QVERIFY(awake.velocity().i() == awakeVelocity.i() && awake.velocity().j() == awakeVelocity.j());
+}
+
+void MCWorldTest::testRenderInterpolation()
+{
+    MCWorld world;
+    world.setDimensions(-100, 100, -100, 100, -10, 10);
+
+    MCObject object(MCShapePtr(new MCRectShape(nullptr, 2.0, 2.0)), "test");
+    object.physicsComponent().setMass(1.0f);
+    object.physicsComponent().preventSleeping(true);
+    object.addToWorld(world, 0.0f, 0.0f);
+
+    // Moves done outside of a step aren't interpolated
+    world.setRenderInterpolation(0.0f);
+    QCOMPARE(world.renderInterpolation(), 0.0f);
+    QCOMPARE(object.shape()->renderLocation().i(), object.location().i());
+    QCOMPARE(object.shape()->renderLocation().j(), object.location().j());
+
+    object.physicsComponent().setVelocity(MCVector3dF(10.0f, 0.0f));
+    object.physicsComponent().setAngularVelocity(1.0f);
+    world.stepTime(100);
+    QCOMPARE(world.stepCount(), 1u);
+    QVERIFY(!world.isStepping());
+
+    const MCVector3dF location = object.location();
+    const float angle = object.angle();
+    QVERIFY(location.i() > 0.0f);
+    QVERIFY(angle > 0.0f);
+
+    QCOMPARE(object.shape()->renderLocation().i(), 0.0f);
+    QCOMPARE(object.shape()->renderLocation().j(), 0.0f);
+    QCOMPARE(object.shape()->renderAngle(), 0.0f);
+
+    world.setRenderInterpolation(0.5f);
+    QCOMPARE(object.shape()->renderLocation().i(), location.i() * 0.5f);
+    QCOMPARE(object.shape()->renderLocation().j(), location.j() * 0.5f);
+    QCOMPARE(object.shape()->renderAngle(), angle * 0.5f);
+
+    world.setRenderInterpolation(1.0f);
+    QCOMPARE(object.shape()->renderLocation().i(), location.i());
+    QCOMPARE(object.shape()->renderLocation().j(), location.j());
+    QCOMPARE(object.shape()->renderAngle(), angle);
+
+    // Teleports snap to the new location
+    world.setRenderInterpolation(0.5f);
+    object.translate(MCVector3dF(50.0f, 50.0f));
+    QCOMPARE(object.shape()->renderLocation().i(), object.location().i());
+    QCOMPARE(object.shape()->renderLocation().j(), object.location().j());
+
+    // Objects that didn't move during the latest step are rendered at their current pose
+    object.physicsComponent().setVelocity(MCVector3dF());
+    object.physicsComponent().setAngularVelocity(0.0f);
+    object.physicsComponent().preventSleeping(false);
+    object.physicsComponent().toggleSleep(true);
+    world.stepTime(100);
+    QCOMPARE(object.shape()->renderLocation().i(), object.location().i());
+    QCOMPARE(object.shape()->renderLocation().j(), object.location().j());
+    QCOMPARE(object.shape()->renderAngle(), object.angle());
+
+    world.clear();
+}
+
 QTEST_GUILESS_MAIN(MCWorldTest)
@@ -31,11 +31,25 @@ private slots:
 
     void testAddToWorld();
 
-    void testInstance();
+    void testMultipleWorlds();
 
     void testSetDimensions();
 
     void testSimpleCollision();
 
+    void testMultiThreadedCollisionDetection();
+
+    void testPositionResolving();
+
+    void testContactCacheObjectRemoval();
+
     void testSleepingObjectRemovalFromIntegration();
+
+    void testBatchedIntegration();
+
+    void testSleepingIslands();
+
+    void testImpulseOfAwakeSlowObjects();
+
+    void testRenderInterpolation();
 };
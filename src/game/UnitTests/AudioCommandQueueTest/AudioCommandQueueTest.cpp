@@ -0,0 +1,325 @@
+// This file is part of Dust Racing 2D.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// Dust Racing 2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Dust Racing 2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Dust Racing 2D. If not, see <http://www.gnu.org/licenses/>.
+
+#include "AudioCommandQueueTest.hpp"
+
+#include "../../audio/audiocommandqueue.hpp"
+
+#include <vector>
+
+namespace {
+
+const size_t SOURCE_COUNT = 32;
+
+AudioCommand play(int source)
+{
+    return {AudioCommand::Type::Play, source, 0, 0, false};
+}
+
+AudioCommand stop(int source)
+{
+    return {AudioCommand::Type::Stop, source, 0, 0, false};
+}
+
+AudioCommand pitch(int source, float pitch)
+{
+    return {AudioCommand::Type::SetPitch, source, pitch, 0, false};
+}
+
+AudioCommand volume(int source, float volume)
+{
+    return {AudioCommand::Type::SetVolume, source, volume, 0, false};
+}
+
+AudioCommand location(int source, float x, float y)
+{
+    return {AudioCommand::Type::SetLocation, source, x, y, false};
+}
+
+AudioCommand listenerLocation(float x, float y)
+{
+    return {AudioCommand::Type::SetListenerLocation, -1, x, y, false};
+}
+
+void compareCommand(const AudioCommand & actual, const AudioCommand & expected)
+{
+    QCOMPARE(actual.type, expected.type);
+    QCOMPARE(actual.source, expected.source);
+    QCOMPARE(actual.x, expected.x);
+    QCOMPARE(actual.y, expected.y);
+    QCOMPARE(actual.flag, expected.flag);
+}
+
+void compareCommands(const std::vector<AudioCommand> & actual, const std::vector<AudioCommand> & expected)
+{
+    QCOMPARE(actual.size(), expected.size());
+    for (size_t i = 0; i < actual.size(); i++)
+    {
+        compareCommand(actual[i], expected[i]);
+    }
+}
+
+//! Coalesce the given commands like AudioWorker does with a single drained batch.
+std::vector<AudioCommand> coalesce(const std::vector<AudioCommand> & commands, size_t sourceCount = 4)
+{
+    AudioCommandCoalescer coalescer;
+    coalescer.resize(sourceCount);
+
+    std::vector<AudioCommand> result;
+    for (auto && command : commands)
+    {
+        coalescer.add(command, result);
+    }
+    coalescer.flush(result);
+
+    return result;
+}
+
+} // namespace
+
+AudioCommandQueueTest::AudioCommandQueueTest()
+{
+}
+
+void AudioCommandQueueTest::testCapacityIsRoundedUp()
+{
+    QCOMPARE(AudioCommandQueue(1, SOURCE_COUNT).capacity(), size_t(1));
+    QCOMPARE(AudioCommandQueue(5, SOURCE_COUNT).capacity(), size_t(8));
+    QCOMPARE(AudioCommandQueue(4096, SOURCE_COUNT).capacity(), size_t(4096));
+}
+
+void AudioCommandQueueTest::testFifoOrder()
+{
+    AudioCommandQueue queue(8, SOURCE_COUNT);
+    for (int i = 0; i < 5; i++)
+    {
+        QVERIFY(queue.push(pitch(i, i * 0.5f)));
+    }
+
+    AudioCommand commands[8];
+    QCOMPARE(queue.pop(commands, 8), size_t(5));
+    for (int i = 0; i < 5; i++)
+    {
+        compareCommand(commands[i], pitch(i, i * 0.5f));
+    }
+
+    QCOMPARE(queue.pop(commands, 8), size_t(0));
+}
+
+void AudioCommandQueueTest::testWraparound()
+{
+    AudioCommandQueue queue(4, SOURCE_COUNT);
+    AudioCommand commands[4];
+
+    // The head and the tail pass the capacity several times
+    int next = 0;
+    int expected = 0;
+    for (int round = 0; round < 10; round++)
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            QVERIFY(queue.push(play(next++)));
+        }
+
+        const size_t count = queue.pop(commands, 4);
+        QCOMPARE(count, size_t(3));
+        for (size_t i = 0; i < count; i++)
+        {
+            compareCommand(commands[i], play(expected++));
+        }
+    }
+
+    QCOMPARE(expected, 30);
+}
+
+void AudioCommandQueueTest::testPushFailsWhenFull()
+{
+    AudioCommandQueue queue(4, SOURCE_COUNT);
+    for (int i = 0; i < 4; i++)
+    {
+        QVERIFY(queue.push(pitch(i, 1.0f)));
+    }
+
+    QVERIFY(!queue.push(pitch(4, 1.0f)));
+    QVERIFY(!queue.push(volume(4, 1.0f)));
+    QVERIFY(!queue.push(location(4, 1, 1)));
+    QVERIFY(!queue.push(listenerLocation(1, 1)));
+
+    AudioCommand commands[4];
+    QCOMPARE(queue.pop(commands, 1), size_t(1));
+    compareCommand(commands[0], pitch(0, 1.0f));
+
+    // A popped slot can be reused, but the dropped command is gone
+    QVERIFY(queue.push(pitch(5, 1.0f)));
+    QVERIFY(!queue.push(pitch(6, 1.0f)));
+
+    QCOMPARE(queue.pop(commands, 4), size_t(4));
+    compareCommand(commands[0], pitch(1, 1.0f));
+    compareCommand(commands[1], pitch(2, 1.0f));
+    compareCommand(commands[2], pitch(3, 1.0f));
+    compareCommand(commands[3], pitch(5, 1.0f));
+}
+
+void AudioCommandQueueTest::testStateCommandsAreNotDropped()
+{
+    const AudioCommand loop = {AudioCommand::Type::Play, 2, 0, 0, true};
+    const AudioCommand disable = {AudioCommand::Type::SetEnabled, -1, 0, 0, false};
+
+    AudioCommandQueue queue(4, 4);
+    for (int i = 0; i < 4; i++)
+    {
+        QVERIFY(queue.push(pitch(i, 1.0f)));
+    }
+
+    QVERIFY(queue.push(stop(1)));
+    QVERIFY(!queue.push(pitch(0, 2.0f)));
+    QVERIFY(queue.push(loop));
+    QVERIFY(queue.push(disable));
+    QVERIFY(queue.push(play(1))); // Replaces the stop
+    QVERIFY(queue.push(stop(3)));
+    QVERIFY(!queue.push(play(4))); // No such source
+
+    // The ring is drained first
+    AudioCommand commands[8];
+    QCOMPARE(queue.pop(commands, 8), size_t(4));
+    compareCommand(commands[3], pitch(3, 1.0f));
+
+    // Play and stop go after the ones that didn't fit, even if the ring has room
+    QVERIFY(queue.push(stop(2)));
+    QVERIFY(queue.push(pitch(3, 2.0f)));
+
+    QCOMPARE(queue.pop(commands, 2), size_t(1));
+    compareCommand(commands[0], pitch(3, 2.0f));
+
+    QCOMPARE(queue.pop(commands, 2), size_t(2));
+    compareCommand(commands[0], disable);
+    compareCommand(commands[1], play(1));
+
+    // The slots have been taken, so the ring is used again
+    QVERIFY(queue.push(stop(0)));
+
+    QCOMPARE(queue.pop(commands, 8), size_t(3));
+    compareCommand(commands[0], stop(2));
+    compareCommand(commands[1], stop(3));
+    compareCommand(commands[2], stop(0));
+
+    QCOMPARE(queue.pop(commands, 8), size_t(0));
+}
+
+void AudioCommandQueueTest::testPartialPop()
+{
+    AudioCommandQueue queue(8, SOURCE_COUNT);
+    for (int i = 0; i < 7; i++)
+    {
+        QVERIFY(queue.push(stop(i)));
+    }
+
+    AudioCommand commands[8];
+    QCOMPARE(queue.pop(commands, 3), size_t(3));
+    compareCommand(commands[0], stop(0));
+    compareCommand(commands[2], stop(2));
+
+    QCOMPARE(queue.pop(commands, 3), size_t(3));
+    compareCommand(commands[0], stop(3));
+    compareCommand(commands[2], stop(5));
+
+    QCOMPARE(queue.pop(commands, 3), size_t(1));
+    compareCommand(commands[0], stop(6));
+
+    QCOMPARE(queue.pop(commands, 0), size_t(0));
+}
+
+void AudioCommandQueueTest::testParametersAreCoalesced()
+{
+    const std::vector<AudioCommand> result = coalesce({
+        location(1, 1, 1),
+        pitch(1, 1.0f),
+        volume(2, 0.1f),
+        location(1, 2, 2),
+        pitch(1, 1.5f),
+        volume(1, 0.5f),
+        volume(2, 0.2f),
+        location(1, 3, 3)});
+
+    // Sources in the order of their first update, only the latest values
+    compareCommands(result, {
+        pitch(1, 1.5f),
+        volume(1, 0.5f),
+        location(1, 3, 3),
+        volume(2, 0.2f)});
+
+    // Nothing is left pending
+    AudioCommandCoalescer coalescer;
+    coalescer.resize(4);
+    std::vector<AudioCommand> commands;
+    coalescer.add(pitch(0, 2.0f), commands);
+    QVERIFY(commands.empty());
+    coalescer.flush(commands);
+    QCOMPARE(commands.size(), size_t(1));
+    commands.clear();
+    coalescer.flush(commands);
+    QVERIFY(commands.empty());
+}
+
+void AudioCommandQueueTest::testParametersAreAppliedBeforePlayAndStop()
+{
+    const std::vector<AudioCommand> result = coalesce({
+        pitch(0, 1.0f),
+        volume(1, 0.3f),
+        pitch(0, 1.2f),
+        play(0),
+        pitch(0, 0.8f),
+        stop(0),
+        pitch(0, 0.9f),
+        play(1)});
+
+    compareCommands(result, {
+        pitch(0, 1.2f),
+        play(0),
+        pitch(0, 0.8f),
+        stop(0),
+        volume(1, 0.3f),
+        play(1),
+        pitch(0, 0.9f)});
+}
+
+void AudioCommandQueueTest::testListenerLocationIsCoalesced()
+{
+    const AudioCommand enable = {AudioCommand::Type::SetEnabled, -1, 0, 0, true};
+    const std::vector<AudioCommand> result = coalesce({
+        listenerLocation(1, 2),
+        enable,
+        location(3, 5, 5),
+        listenerLocation(3, 4)});
+
+    compareCommands(result, {
+        enable,
+        location(3, 5, 5),
+        listenerLocation(3, 4)});
+}
+
+void AudioCommandQueueTest::testInvalidSourcesAreIgnored()
+{
+    const std::vector<AudioCommand> result = coalesce({
+        play(4),
+        pitch(4, 1.0f),
+        play(-1),
+        volume(-1, 1.0f),
+        stop(3)}, 4);
+
+    compareCommands(result, {stop(3)});
+}
+
+QTEST_GUILESS_MAIN(AudioCommandQueueTest)
@@ -0,0 +1,427 @@
+// This file is part of Dust Racing 2D.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// Dust Racing 2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Dust Racing 2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Dust Racing 2D. If not, see <http://www.gnu.org/licenses/>.
+
+#include "CompiledTrackTest.hpp"
+
+#include "../../../common/compiledtrack.hpp"
+#include "../../../common/trackdatabase.hpp"
+
+#include <QDir>
+#include <QDomDocument>
+#include <QDomElement>
+#include <QFile>
+#include <QFileInfo>
+#include <QStringList>
+#include <QTemporaryDir>
+
+#include <cstring>
+#include <vector>
+
+namespace {
+
+/*! Expected contents of a track. The track files are read here independently of
+ *  CompiledTrackWriter::fromXml() with the defaults of the game's track index. */
+struct TrackRecords
+{
+    struct Tile
+    {
+        unsigned int i;
+        unsigned int j;
+        QString type;
+        int orientation;
+        int computerHint;
+        bool excludeFromMinimap;
+    };
+
+    struct Object
+    {
+        QString category;
+        QString role;
+        int x;
+        int y;
+        int orientation;
+        bool forceStationary;
+    };
+
+    struct Node
+    {
+        int index;
+        int x;
+        int y;
+        int width;
+        int height;
+    };
+
+    QString name;
+    unsigned int cols = 0;
+    unsigned int rows = 0;
+    unsigned int index = 0;
+    bool isUserTrack = false;
+    std::vector<Tile> tiles;
+    std::vector<Object> objects;
+    std::vector<Node> nodes;
+};
+
+bool readXml(QString fileName, TrackRecords & track)
+{
+    typedef TrackDataBase::DataKeywords Keywords;
+
+    QFile file(fileName);
+    QDomDocument doc;
+    if (!file.open(QIODevice::ReadOnly) || !doc.setContent(&file))
+    {
+        return false;
+    }
+
+    const QDomElement root = doc.documentElement();
+    track.name = root.attribute(Keywords::Header::name, "undefined");
+    track.cols = root.attribute(Keywords::Header::cols, "0").toUInt();
+    track.rows = root.attribute(Keywords::Header::rows, "0").toUInt();
+    track.index = root.attribute(Keywords::Header::index, "999").toUInt();
+    track.isUserTrack = root.attribute(Keywords::Header::user, "0").toInt();
+
+    for (QDomElement element = root.firstChildElement(); !element.isNull(); element = element.nextSiblingElement())
+    {
+        if (element.nodeName() == Keywords::Track::tile)
+        {
+            track.tiles.push_back({
+                element.attribute(Keywords::Tile::i, "0").toUInt(),
+                element.attribute(Keywords::Tile::j, "0").toUInt(),
+                element.attribute(Keywords::Tile::type, "clear"),
+                element.attribute(Keywords::Tile::orientation, "0").toInt(),
+                element.attribute(Keywords::Tile::computerHint, "0").toInt(),
+                static_cast<bool>(element.attribute(Keywords::Tile::excludeFromMinimap, "0").toInt())});
+        }
+        else if (element.nodeName() == Keywords::Track::object)
+        {
+            track.objects.push_back({
+                element.attribute(Keywords::Object::category, ""),
+                element.attribute(Keywords::Object::role, ""),
+                element.attribute(Keywords::Object::x, "0").toInt(),
+                element.attribute(Keywords::Object::y, "0").toInt(),
+                element.attribute(Keywords::Object::orientation, "0").toInt(),
+                static_cast<bool>(element.attribute(Keywords::Object::forceStationary, "0").toUInt())});
+        }
+        else if (element.nodeName() == Keywords::Track::node)
+        {
+            track.nodes.push_back({
+                element.attribute(Keywords::Node::index, "0").toInt(),
+                element.attribute(Keywords::Node::x, "0").toInt(),
+                element.attribute(Keywords::Node::y, "0").toInt(),
+                element.attribute(Keywords::Node::width, "0").toInt(),
+                element.attribute(Keywords::Node::height, "0").toInt()});
+        }
+    }
+
+    return true;
+}
+
+bool compile(const TrackRecords & track, QString fileName, qint64 sourceSize)
+{
+    CompiledTrackWriter writer(track.name, track.isUserTrack, track.cols, track.rows, track.index);
+    writer.setSourceSize(sourceSize);
+
+    for (auto && tile : track.tiles)
+    {
+        writer.addTile(tile.i, tile.j, tile.type, tile.orientation, tile.computerHint, tile.excludeFromMinimap);
+    }
+
+    for (auto && object : track.objects)
+    {
+        writer.addObject(object.category, object.role, object.x, object.y, object.orientation, object.forceStationary);
+    }
+
+    for (auto && node : track.nodes)
+    {
+        writer.addNode(node.index, node.x, node.y, node.width, node.height);
+    }
+
+    return writer.save(fileName);
+}
+
+void compareTrack(const TrackRecords & expected, const CompiledTrack & compiled)
+{
+    QCOMPARE(compiled.name(), expected.name);
+    QCOMPARE(compiled.cols(), expected.cols);
+    QCOMPARE(compiled.rows(), expected.rows);
+    QCOMPARE(compiled.index(), expected.index);
+    QCOMPARE(compiled.isUserTrack(), expected.isUserTrack);
+
+    QCOMPARE(compiled.tileCount(), static_cast<unsigned int>(expected.tiles.size()));
+    for (unsigned int index = 0; index < compiled.tileCount(); index++)
+    {
+        const CompiledTrack::Tile & tile = compiled.tiles()[index];
+        QCOMPARE(static_cast<unsigned int>(tile.i), expected.tiles[index].i);
+        QCOMPARE(static_cast<unsigned int>(tile.j), expected.tiles[index].j);
+        QCOMPARE(QString::fromUtf8(compiled.string(tile.type)), expected.tiles[index].type);
+        QCOMPARE(static_cast<int>(tile.orientation), expected.tiles[index].orientation);
+        QCOMPARE(static_cast<int>(tile.computerHint), expected.tiles[index].computerHint);
+        QCOMPARE(static_cast<bool>(tile.excludeFromMinimap), expected.tiles[index].excludeFromMinimap);
+    }
+
+    QCOMPARE(compiled.objectCount(), static_cast<unsigned int>(expected.objects.size()));
+    for (unsigned int index = 0; index < compiled.objectCount(); index++)
+    {
+        const CompiledTrack::Object & object = compiled.objects()[index];
+        QCOMPARE(QString::fromUtf8(compiled.string(object.category)), expected.objects[index].category);
+        QCOMPARE(QString::fromUtf8(compiled.string(object.role)), expected.objects[index].role);
+        QCOMPARE(static_cast<int>(object.x), expected.objects[index].x);
+        QCOMPARE(static_cast<int>(object.y), expected.objects[index].y);
+        QCOMPARE(static_cast<int>(object.orientation), expected.objects[index].orientation);
+        QCOMPARE(static_cast<bool>(object.forceStationary), expected.objects[index].forceStationary);
+    }
+
+    QCOMPARE(compiled.nodeCount(), static_cast<unsigned int>(expected.nodes.size()));
+    for (unsigned int index = 0; index < compiled.nodeCount(); index++)
+    {
+        const CompiledTrack::Node & node = compiled.nodes()[index];
+        QCOMPARE(static_cast<int>(node.index), expected.nodes[index].index);
+        QCOMPARE(static_cast<int>(node.x), expected.nodes[index].x);
+        QCOMPARE(static_cast<int>(node.y), expected.nodes[index].y);
+        QCOMPARE(static_cast<int>(node.width), expected.nodes[index].width);
+        QCOMPARE(static_cast<int>(node.height), expected.nodes[index].height);
+    }
+}
+
+TrackRecords testTrack()
+{
+    TrackRecords track;
+    track.name = QString::fromUtf8("Tähtirata");
+    track.cols = 3;
+    track.rows = 2;
+    track.index = 7;
+    track.isUserTrack = true;
+
+    track.tiles.push_back({0, 0, "corner90", 0, 0, false});
+    track.tiles.push_back({1, 0, "straight", 90, 1, false});
+    track.tiles.push_back({2, 0, "corner90", 90, 0, false});
+    track.tiles.push_back({0, 1, "corner90", -90, 2, true});
+    track.tiles.push_back({1, 1, "finish", 270, 0, false});
+    track.tiles.push_back({2, 1, "corner90", 180, 0, false});
+
+    track.objects.push_back({"tree", "tree", 100, -20, 45, false});
+    track.objects.push_back({"tire", "wall", 512, 300, 0, true});
+
+    track.nodes.push_back({0, 128, 128, 256, 256});
+    track.nodes.push_back({1, 640, 128, 0, 0});
+    track.nodes.push_back({2, 384, 384, 128, 256});
+
+    return track;
+}
+
+//! Write the given data to a file and try to open it as a compiled track.
+bool openData(QString fileName, const QByteArray & data)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size())
+    {
+        return false;
+    }
+
+    file.close();
+
+    CompiledTrack compiled;
+    return compiled.open(fileName);
+}
+
+} // namespace
+
+CompiledTrackTest::CompiledTrackTest()
+{
+}
+
+void CompiledTrackTest::testCompiledFileName()
+{
+    QCOMPARE(CompiledTrack::compiledFileName("levels/Figure 8.trk"), QString("levels") + QDir::separator() + "Figure 8.trkb");
+}
+
+void CompiledTrackTest::testRoundTrip()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.path() + QDir::separator() + "test.trkb";
+
+    const TrackRecords track = testTrack();
+    QVERIFY(compile(track, fileName, 1234));
+
+    CompiledTrack compiled;
+    QVERIFY(compiled.open(fileName));
+    QVERIFY(compiled.isOpen());
+    QCOMPARE(compiled.sourceSize(), qint64(1234));
+
+    compareTrack(track, compiled);
+
+    compiled.close();
+    QVERIFY(!compiled.isOpen());
+}
+
+void CompiledTrackTest::testCompileShippedTracks()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    const QFileInfoList trackFiles(QDir(TRACK_PATH).entryInfoList(QStringList("*.trk")));
+    QVERIFY(trackFiles.size());
+
+    for (auto && trackFile : trackFiles)
+    {
+        TrackRecords track;
+        QVERIFY(readXml(trackFile.filePath(), track));
+        QVERIFY(track.tiles.size() == track.cols * track.rows);
+        QVERIFY(!track.nodes.empty());
+
+        const auto writer = CompiledTrackWriter::fromXml(trackFile.filePath());
+        QVERIFY(writer);
+
+        const QString fileName = dir.path() + QDir::separator() + trackFile.completeBaseName() + ".trkb";
+        QVERIFY(writer->save(fileName));
+
+        CompiledTrack compiled;
+        QVERIFY(compiled.open(fileName));
+        QCOMPARE(compiled.sourceSize(), trackFile.size());
+        compareTrack(track, compiled);
+
+        // The game uses the data as such, if it can't be cached
+        QVERIFY(compiled.open(writer->data()));
+        QCOMPARE(compiled.sourceSize(), trackFile.size());
+        compareTrack(track, compiled);
+    }
+}
+
+void CompiledTrackTest::testCompileMissingAttributes()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString trackFileName = dir.path() + QDir::separator() + "test.trk";
+
+    QFile file(trackFileName);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("<track cols=\"2\" rows=\"1\"><t i=\"1\"/><o category=\"tree\"/><n x=\"10\"/></track>");
+    file.close();
+
+    const auto writer = CompiledTrackWriter::fromXml(trackFileName);
+    QVERIFY(writer);
+
+    CompiledTrack compiled;
+    QVERIFY(compiled.open(writer->data()));
+    QCOMPARE(compiled.name(), QString("undefined"));
+    QCOMPARE(compiled.index(), 999u);
+    QCOMPARE(compiled.isUserTrack(), false);
+
+    TrackRecords track;
+    QVERIFY(readXml(trackFileName, track));
+    compareTrack(track, compiled);
+
+    QCOMPARE(QString::fromUtf8(compiled.string(compiled.tiles()[0].type)), QString("clear"));
+    QCOMPARE(QString::fromUtf8(compiled.string(compiled.objects()[0].role)), QString(""));
+    QCOMPARE(static_cast<int>(compiled.nodes()[0].width), 0);
+
+    QVERIFY(!CompiledTrackWriter::fromXml(dir.path() + QDir::separator() + "missing.trk"));
+
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("<route/>");
+    file.close();
+    QVERIFY(!CompiledTrackWriter::fromXml(trackFileName));
+}
+
+void CompiledTrackTest::testStringsAreStoredOnce()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.path() + QDir::separator() + "test.trkb";
+
+    QVERIFY(compile(testTrack(), fileName, 0));
+
+    CompiledTrack compiled;
+    QVERIFY(compiled.open(fileName));
+
+    // Name, corner90, straight, finish, tree, tire and wall
+    QCOMPARE(compiled.stringCount(), 7u);
+    QCOMPARE(compiled.tiles()[0].type, compiled.tiles()[5].type);
+    QCOMPARE(compiled.objects()[0].category, compiled.objects()[0].role);
+}
+
+void CompiledTrackTest::testInvalidFilesAreRejected()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.path() + QDir::separator() + "test.trkb";
+    const QString modifiedFileName = dir.path() + QDir::separator() + "modified.trkb";
+
+    QVERIFY(compile(testTrack(), fileName, 0));
+
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QByteArray data = file.readAll();
+    file.close();
+
+    QVERIFY(openData(modifiedFileName, data));
+
+    CompiledTrack::Header header;
+    std::memcpy(&header, data.constData(), sizeof(header));
+
+    const auto withHeader = [&data] (const CompiledTrack::Header & header) {
+        QByteArray modified = data;
+        std::memcpy(modified.data(), &header, sizeof(header));
+        return modified;
+    };
+
+    QVERIFY(!CompiledTrack().open(dir.path() + QDir::separator() + "missing.trkb"));
+    QVERIFY(!CompiledTrack().open(QByteArray()));
+    QVERIFY(!CompiledTrack().open(data.left(data.size() - 1)));
+    QVERIFY(!openData(modifiedFileName, QByteArray()));
+    QVERIFY(!openData(modifiedFileName, data.left(sizeof(header) - 1)));
+    QVERIFY(!openData(modifiedFileName, data.left(data.size() - 1)));
+
+    CompiledTrack::Header modified = header;
+    modified.magic[0] = 'X';
+    QVERIFY(!openData(modifiedFileName, withHeader(modified)));
+
+    modified = header;
+    modified.version++;
+    QVERIFY(!openData(modifiedFileName, withHeader(modified)));
+
+    // A file written on a machine of the other byte order
+    modified = header;
+    modified.byteOrderMark = 0x04030201;
+    QVERIFY(!openData(modifiedFileName, withHeader(modified)));
+
+    modified = header;
+    modified.tiles.offset++;
+    QVERIFY(!openData(modifiedFileName, withHeader(modified)));
+
+    modified = header;
+    modified.nodes.count = 0x10000000;
+    QVERIFY(!openData(modifiedFileName, withHeader(modified)));
+
+    modified = header;
+    modified.name = header.strings.count;
+    QVERIFY(!openData(modifiedFileName, withHeader(modified)));
+
+    // Tile outside the map
+    modified = header;
+    modified.cols = 2;
+    QVERIFY(!openData(modifiedFileName, withHeader(modified)));
+
+    // String index of an object out of range
+    QByteArray badRole = data;
+    CompiledTrack::Object object;
+    std::memcpy(&object, data.constData() + header.objects.offset, sizeof(object));
+    object.role = header.strings.count;
+    std::memcpy(badRole.data() + header.objects.offset, &object, sizeof(object));
+    QVERIFY(!openData(modifiedFileName, badRole));
+}
+
+QTEST_GUILESS_MAIN(CompiledTrackTest)
@@ -0,0 +1,150 @@
+// This file is part of Dust Racing 2D.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// Dust Racing 2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Dust Racing 2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Dust Racing 2D. If not, see <http://www.gnu.org/licenses/>.
+
+#include "SettingsTest.hpp"
+
+#include "../../settings.hpp"
+#include "../../trackdata.hpp"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QSettings>
+
+#include <algorithm>
+
+namespace {
+const auto DIFFICULTY = DifficultyProfile::Difficulty::Medium;
+}
+
+SettingsTest::SettingsTest()
+{
+}
+
+void SettingsTest::initTestCase()
+{
+    // Keep the records away from the real settings of the game
+    QVERIFY(m_settingsDir.isValid());
+    QSettings::setPath(QSettings::NativeFormat, QSettings::UserScope, m_settingsDir.path());
+    QCoreApplication::setOrganizationName("SettingsTest");
+    QCoreApplication::setApplicationName("SettingsTest");
+}
+
+void SettingsTest::testRecordsAreWrittenOnFlush()
+{
+    TrackData trackData("Flush", false, 1, 1);
+
+    {
+        Settings settings;
+        settings.resetLapRecords();
+        settings.resetRaceRecords();
+
+        settings.saveLapRecord(trackData, 61000);
+        settings.saveRaceRecord(trackData, 305000, 5, DIFFICULTY);
+        QCOMPARE(settings.loadLapRecord(trackData), 61000);
+
+        // Nothing is on the disk before the flush
+        QCOMPARE(QSettings().value("LapRecords/Flush", -1).toInt(), -1);
+
+        settings.flushRecords();
+    }
+
+    // The settings have been destroyed, so the write has finished
+    QSettings settings;
+    QCOMPARE(settings.value("LapRecords/Flush", -1).toInt(), 61000);
+    QCOMPARE(settings.value("RaceRecords/Flush_5_" + QString::number(static_cast<int>(DIFFICULTY)), -1).toInt(), 305000);
+}
+
+void SettingsTest::testFrameTimeAroundLapCompletion()
+{
+    // Frames of a race at 60 Hz, each lap taking a second
+    const int frameCount = 600;
+    const int framesPerLap = 60;
+    const int lapCount = 5;
+    const int raceEndFrame = lapCount * framesPerLap;
+
+    TrackData trackData("FrameTime", false, 1, 1);
+
+    // Make the QSettings file large, so that each write takes a while
+    {
+        QSettings settings;
+        for (int i = 0; i < 10000; i++)
+        {
+            settings.setValue(QString("Filler/Track%1").arg(i), i);
+        }
+    }
+
+    qint64 worstFrameTime = 0;
+    {
+        Settings settings;
+        settings.resetLapRecords();
+        settings.resetRaceRecords();
+
+        QElapsedTimer timer;
+        int lapRecord = -1;
+        for (int frame = 1; frame <= frameCount; frame++)
+        {
+            timer.start();
+
+            // Like the Race when a lap is completed
+            const bool isRecordFrame = frame <= raceEndFrame && frame % framesPerLap == 0;
+            if (isRecordFrame)
+            {
+                const int lapTime = 61000 - frame;
+                if (lapRecord == -1 || lapTime < lapRecord)
+                {
+                    lapRecord = lapTime;
+                    settings.saveLapRecord(trackData, lapTime);
+                }
+
+                if (frame == raceEndFrame)
+                {
+                    settings.saveRaceRecord(trackData, 305000, lapCount, DIFFICULTY);
+                    settings.saveBestPos(trackData, 1, lapCount, DIFFICULTY);
+                    settings.flushRecords();
+                }
+            }
+            else
+            {
+                // Reads of the track menu and the timing overlay
+                settings.loadLapRecord(trackData);
+                settings.loadRaceRecord(trackData, lapCount, DIFFICULTY);
+            }
+
+            worstFrameTime = std::max(worstFrameTime, timer.nsecsElapsed());
+
+            if (frame < raceEndFrame)
+            {
+                // The records are only kept in memory during the race
+                QCOMPARE(settings.unflushedRecordCount(), size_t(frame >= framesPerLap ? 1 : 0));
+            }
+            else
+            {
+                // Handed over to the writer thread at the end of the race
+                QCOMPARE(settings.unflushedRecordCount(), size_t(0));
+            }
+        }
+
+        QCOMPARE(settings.loadLapRecord(trackData), 61000 - raceEndFrame);
+    }
+
+    // The frame time depends on the machine, so it is reported instead of verified
+    QTest::setBenchmarkResult(worstFrameTime / 1000000.0, QTest::WalltimeMilliseconds);
+
+    QSettings settings;
+    QCOMPARE(settings.value("LapRecords/FrameTime", -1).toInt(), 61000 - raceEndFrame);
+    QCOMPARE(settings.value("BestPositions/FrameTime_5_" + QString::number(static_cast<int>(DIFFICULTY)), -1).toInt(), 1);
+}
+
+QTEST_GUILESS_MAIN(SettingsTest)
@@ -0,0 +1,258 @@
+// This file is part of Dust Racing 2D.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// Dust Racing 2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Dust Racing 2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Dust Racing 2D. If not, see <http://www.gnu.org/licenses/>.
+
+#include "TrackIndexTest.hpp"
+
+#include "../../trackindex.hpp"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+
+namespace {
+
+// Header of the index file as written by TrackIndex::save()
+const quint32 INDEX_MAGIC = 0x44524958;
+const quint32 INDEX_VERSION = 1;
+const int STREAM_VERSION = QDataStream::Qt_5_0;
+
+const char * TRACK =
+    "<track name=\"Test\" cols=\"3\" rows=\"1\" index=\"5\" isUserTrack=\"1\">"
+    "<t i=\"0\" j=\"0\" t=\"corner90\" o=\"90\"/>"
+    "<t i=\"1\" j=\"0\" t=\"straight\" o=\"90\" e=\"1\"/>"
+    "<t i=\"2\" j=\"0\" t=\"corner90\" o=\"180\"/>"
+    "<n i=\"0\" x=\"0\" y=\"0\"/>"
+    "<n i=\"1\" x=\"300\" y=\"400\"/>"
+    "</track>";
+
+bool writeFile(QString fileName, const QByteArray & data)
+{
+    QFile file(fileName);
+    return file.open(QIODevice::WriteOnly) && file.write(data) == data.size();
+}
+
+QByteArray readFile(QString fileName)
+{
+    QFile file(fileName);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+void compareEntry(const TrackIndex::Entry & actual, const TrackIndex::Entry & expected)
+{
+    QCOMPARE(actual.fileName, expected.fileName);
+    QCOMPARE(actual.fileSize, expected.fileSize);
+    QCOMPARE(actual.lastModified, expected.lastModified);
+    QCOMPARE(actual.name, expected.name);
+    QCOMPARE(actual.index, expected.index);
+    QCOMPARE(actual.isUserTrack, expected.isUserTrack);
+    QCOMPARE(actual.cols, expected.cols);
+    QCOMPARE(actual.rows, expected.rows);
+    QCOMPARE(actual.routeLength, expected.routeLength);
+    QCOMPARE(actual.tileTypes, expected.tileTypes);
+    QCOMPARE(actual.tiles.size(), expected.tiles.size());
+    for (size_t i = 0; i < actual.tiles.size(); i++)
+    {
+        QCOMPARE(actual.tiles[i].type, expected.tiles[i].type);
+        QCOMPARE(actual.tiles[i].orientation, expected.tiles[i].orientation);
+        QCOMPARE(actual.tiles[i].excludeFromMinimap, expected.tiles[i].excludeFromMinimap);
+    }
+}
+
+//! Write an index of a single entry with the given dimensions and tile count, but no tiles.
+bool writeIndexHeader(QString fileName, quint32 cols, quint32 rows, quint32 tileCount)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        return false;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(STREAM_VERSION);
+    out << INDEX_MAGIC << INDEX_VERSION << quint32(1)
+        << QString("test.trk") << qint64(0) << qint64(0) << QString("Test") << quint32(1) << false
+        << cols << rows << quint32(0) << QStringList("clear") << tileCount;
+
+    return out.status() == QDataStream::Ok;
+}
+
+} // namespace
+
+TrackIndexTest::TrackIndexTest()
+{
+}
+
+void TrackIndexTest::testRoundTrip()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString trackFileName = dir.path() + QDir::separator() + "test.trk";
+    const QString indexFileName = dir.path() + QDir::separator() + "cache" + QDir::separator() + "tracks.idx";
+    QVERIFY(writeFile(trackFileName, TRACK));
+
+    TrackIndex index(indexFileName);
+    QVERIFY(!index.load());
+
+    const TrackIndex::Entry * entry = index.entry(QFileInfo(trackFileName));
+    QVERIFY(entry);
+    QCOMPARE(index.scanCount(), 1u);
+    QCOMPARE(entry->name, QString("Test"));
+    QCOMPARE(entry->index, 5u);
+    QCOMPARE(entry->isUserTrack, true);
+    QCOMPARE(entry->cols, 3u);
+    QCOMPARE(entry->rows, 1u);
+    QCOMPARE(entry->routeLength, 1000u);
+    QCOMPARE(entry->tileTypes, QStringList() << "corner90" << "straight");
+    QCOMPARE(entry->tiles.size(), size_t(3));
+    QCOMPARE(entry->tiles[1].type, uint8_t(1));
+    QCOMPARE(entry->tiles[2].orientation, int16_t(180));
+    QCOMPARE(entry->tiles[1].excludeFromMinimap, true);
+    QCOMPARE(entry->tiles[0].excludeFromMinimap, false);
+
+    const TrackIndex::Entry scanned = *entry;
+    QVERIFY(index.save());
+    QVERIFY(QFileInfo(indexFileName).exists());
+
+    // An up-to-date entry is used as such
+    TrackIndex loaded(indexFileName);
+    QVERIFY(loaded.load());
+    entry = loaded.entry(QFileInfo(trackFileName));
+    QVERIFY(entry);
+    QCOMPARE(loaded.scanCount(), 0u);
+    compareEntry(*entry, scanned);
+
+    // Entries of removed tracks are dropped on save
+    TrackIndex unused(indexFileName);
+    QVERIFY(unused.load());
+    QVERIFY(unused.save());
+    QVERIFY(loaded.load());
+    QVERIFY(loaded.entry(QFileInfo(trackFileName)));
+    QCOMPARE(loaded.scanCount(), 1u);
+}
+
+void TrackIndexTest::testChangedFilesAreRescanned()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString trackFileName = dir.path() + QDir::separator() + "test.trk";
+    const QString indexFileName = dir.path() + QDir::separator() + "tracks.idx";
+    QVERIFY(writeFile(trackFileName, TRACK));
+
+    TrackIndex index(indexFileName);
+    QVERIFY(index.entry(QFileInfo(trackFileName)));
+    QVERIFY(index.save());
+
+    // Size changes
+    QVERIFY(writeFile(trackFileName, QByteArray(TRACK).replace("name=\"Test\"", "name=\"Test 2\"")));
+
+    TrackIndex resized(indexFileName);
+    QVERIFY(resized.load());
+    const TrackIndex::Entry * entry = resized.entry(QFileInfo(trackFileName));
+    QVERIFY(entry);
+    QCOMPARE(resized.scanCount(), 1u);
+    QCOMPARE(entry->name, QString("Test 2"));
+    QCOMPARE(entry->fileSize, QFileInfo(trackFileName).size());
+    QVERIFY(resized.save());
+
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 10, 0))
+    // Only the modification time changes
+    const QByteArray data = readFile(trackFileName);
+    QVERIFY(writeFile(trackFileName, QByteArray(data).replace("name=\"Test 2\"", "name=\"Test 3\"")));
+    QCOMPARE(QFileInfo(trackFileName).size(), qint64(data.size()));
+    {
+        QFile file(trackFileName);
+        QVERIFY(file.open(QIODevice::ReadWrite));
+        QVERIFY(file.setFileTime(QFileInfo(trackFileName).lastModified().addSecs(60), QFileDevice::FileModificationTime));
+    }
+
+    TrackIndex touched(indexFileName);
+    QVERIFY(touched.load());
+    entry = touched.entry(QFileInfo(trackFileName));
+    QVERIFY(entry);
+    QCOMPARE(touched.scanCount(), 1u);
+    QCOMPARE(entry->name, QString("Test 3"));
+    QCOMPARE(entry->lastModified, QFileInfo(trackFileName).lastModified().toMSecsSinceEpoch());
+#endif
+
+    // Invalid tracks are not indexed
+    QVERIFY(writeFile(trackFileName, "<route/>"));
+    TrackIndex invalid(indexFileName);
+    QVERIFY(invalid.load());
+    QVERIFY(!invalid.entry(QFileInfo(trackFileName)));
+    QCOMPARE(invalid.scanCount(), 1u);
+}
+
+void TrackIndexTest::testTruncatedIndexIsRejected()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString trackFileName = dir.path() + QDir::separator() + "test.trk";
+    const QString indexFileName = dir.path() + QDir::separator() + "tracks.idx";
+    QVERIFY(writeFile(trackFileName, TRACK));
+
+    TrackIndex index(indexFileName);
+    QVERIFY(index.entry(QFileInfo(trackFileName)));
+    QVERIFY(index.save());
+
+    const QByteArray data = readFile(indexFileName);
+    QVERIFY(data.size());
+
+    // Cut inside the tiles, inside the header of the entry and inside the header of the file
+    for (int size : {data.size() - 1, data.size() / 2, 6})
+    {
+        QVERIFY(writeFile(indexFileName, data.left(size)));
+
+        TrackIndex truncated(indexFileName);
+        QVERIFY(!truncated.load());
+
+        // The track is still found by scanning it
+        QVERIFY(truncated.entry(QFileInfo(trackFileName)));
+        QCOMPARE(truncated.scanCount(), 1u);
+    }
+
+    QByteArray modified = data;
+    modified[0] = 'X';
+    QVERIFY(writeFile(indexFileName, modified));
+    QVERIFY(!TrackIndex(indexFileName).load());
+}
+
+void TrackIndexTest::testCorruptTileCountIsRejected()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString indexFileName = dir.path() + QDir::separator() + "tracks.idx";
+
+    // A valid header with its tiles missing
+    QVERIFY(writeIndexHeader(indexFileName, 2, 2, 4));
+    QVERIFY(!TrackIndex(indexFileName).load());
+
+    // Count that doesn't match the dimensions
+    QVERIFY(writeIndexHeader(indexFileName, 2, 2, 0xffffffff));
+    QVERIFY(!TrackIndex(indexFileName).load());
+
+    // Dimensions whose product overflows 32 bits
+    QVERIFY(writeIndexHeader(indexFileName, 0x10000, 0x10000, 0));
+    QVERIFY(!TrackIndex(indexFileName).load());
+
+    // Consistent, but far more tiles than there are bytes in the file. These would
+    // take gigabytes, if the tiles were allocated before checking the file size.
+    QVERIFY(writeIndexHeader(indexFileName, 0x10000, 0xffff, 0xffff0000));
+    QVERIFY(!TrackIndex(indexFileName).load());
+}
+
+QTEST_GUILESS_MAIN(TrackIndexTest)
@@ -0,0 +1,275 @@
+// This file is part of Dust Racing 2D.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// Dust Racing 2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Dust Racing 2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Dust Racing 2D. If not, see <http://www.gnu.org/licenses/>.
+
+#include "audiocommandqueue.hpp"
+
+static size_t roundUpToPowerOfTwo(size_t value)
+{
+    size_t result = 1;
+    while (result < value)
+    {
+        result <<= 1;
+    }
+    return result;
+}
+
+AudioCommandQueue::AudioCommandQueue(size_t capacity, size_t sourceCount)
+    : m_commands(roundUpToPowerOfTwo(capacity))
+    , m_mask(m_commands.size() - 1)
+    , m_head(0)
+    , m_tail(0)
+    , m_sourceSlots(sourceCount)
+    , m_enabledSlot(Empty)
+    , m_hasOverflow(false)
+    , m_overflowIndex(0)
+{
+    for (auto && slot : m_sourceSlots)
+    {
+        slot.store(Empty, std::memory_order_relaxed);
+    }
+
+    m_overflowCommands.reserve(sourceCount + 1);
+}
+
+bool AudioCommandQueue::push(const AudioCommand & command)
+{
+    const bool isParameter = command.type != AudioCommand::Type::Play &&
+        command.type != AudioCommand::Type::Stop && command.type != AudioCommand::Type::SetEnabled;
+
+    if (isParameter || !m_hasOverflow.load(std::memory_order_acquire))
+    {
+        if (pushToRing(command))
+        {
+            return true;
+        }
+
+        if (isParameter)
+        {
+            return false;
+        }
+    }
+
+    if (command.type == AudioCommand::Type::SetEnabled)
+    {
+        m_enabledSlot.store(command.flag ? Enable : Disable, std::memory_order_relaxed);
+    }
+    else if (command.source >= 0 && command.source < static_cast<int>(m_sourceSlots.size()))
+    {
+        const uint8_t slot = command.type == AudioCommand::Type::Stop ? Stop : (command.flag ? PlayLoop : Play);
+        m_sourceSlots[command.source].store(slot, std::memory_order_relaxed);
+    }
+    else
+    {
+        return false;
+    }
+
+    m_hasOverflow.store(true, std::memory_order_release);
+
+    return true;
+}
+
+bool AudioCommandQueue::pushToRing(const AudioCommand & command)
+{
+    // The indices grow without wrapping to the capacity, so tail - head is always the fill level
+    const size_t tail = m_tail.load(std::memory_order_relaxed);
+    if (tail - m_head.load(std::memory_order_acquire) == m_commands.size())
+    {
+        return false;
+    }
+
+    m_commands[tail & m_mask] = command;
+    m_tail.store(tail + 1, std::memory_order_release);
+
+    return true;
+}
+
+size_t AudioCommandQueue::pop(AudioCommand * commands, size_t maxCount)
+{
+    const size_t head = m_head.load(std::memory_order_relaxed);
+    size_t available = m_tail.load(std::memory_order_acquire) - head;
+
+    // The slots are taken only when the ring is empty. Play, Stop and SetEnabled pushed to
+    // the ring after that are newer, because the producer uses the slots until they're taken.
+    if (!available && m_overflowIndex == m_overflowCommands.size() && m_hasOverflow.exchange(false, std::memory_order_acquire))
+    {
+        takeOverflow();
+    }
+
+    size_t count = 0;
+    while (count < maxCount && m_overflowIndex < m_overflowCommands.size())
+    {
+        commands[count++] = m_overflowCommands[m_overflowIndex++];
+    }
+
+    if (m_overflowIndex == m_overflowCommands.size())
+    {
+        m_overflowCommands.clear();
+        m_overflowIndex = 0;
+    }
+
+    if (available > maxCount - count)
+    {
+        available = maxCount - count;
+    }
+
+    for (size_t i = 0; i < available; i++)
+    {
+        commands[count++] = m_commands[(head + i) & m_mask];
+    }
+
+    m_head.store(head + available, std::memory_order_release);
+
+    return count;
+}
+
+void AudioCommandQueue::takeOverflow()
+{
+    // Enabling applies to the Play commands taken with it
+    const uint8_t enabled = m_enabledSlot.exchange(Empty, std::memory_order_acquire);
+    if (enabled != Empty)
+    {
+        m_overflowCommands.push_back({AudioCommand::Type::SetEnabled, -1, 0, 0, enabled == Enable});
+    }
+
+    for (size_t source = 0; source < m_sourceSlots.size(); source++)
+    {
+        const uint8_t slot = m_sourceSlots[source].exchange(Empty, std::memory_order_acquire);
+        if (slot != Empty)
+        {
+            m_overflowCommands.push_back({
+                slot == Stop ? AudioCommand::Type::Stop : AudioCommand::Type::Play,
+                static_cast<int>(source), 0, 0, slot == PlayLoop});
+        }
+    }
+}
+
+size_t AudioCommandQueue::capacity() const
+{
+    return m_commands.size();
+}
+
+AudioCommandCoalescer::AudioCommandCoalescer()
+    : m_hasListenerLocation(false)
+    , m_listenerX(0)
+    , m_listenerY(0)
+{
+}
+
+void AudioCommandCoalescer::resize(size_t sourceCount)
+{
+    m_pendingUpdates.resize(sourceCount);
+    m_pendingSources.reserve(sourceCount);
+}
+
+void AudioCommandCoalescer::add(const AudioCommand & command, std::vector<AudioCommand> & commands)
+{
+    if (command.source >= static_cast<int>(m_pendingUpdates.size()))
+    {
+        return;
+    }
+
+    const auto markPending = [&] () -> PendingUpdate & {
+        PendingUpdate & update = m_pendingUpdates[command.source];
+        if (!update.listed)
+        {
+            update.listed = true;
+            m_pendingSources.push_back(command.source);
+        }
+        return update;
+    };
+
+    switch (command.type)
+    {
+    case AudioCommand::Type::Play:
+    case AudioCommand::Type::Stop:
+        if (command.source >= 0)
+        {
+            flushSource(command.source, commands);
+            commands.push_back(command);
+        }
+        break;
+    case AudioCommand::Type::SetPitch:
+        if (command.source >= 0)
+        {
+            PendingUpdate & update = markPending();
+            update.hasPitch = true;
+            update.pitch = command.x;
+        }
+        break;
+    case AudioCommand::Type::SetVolume:
+        if (command.source >= 0)
+        {
+            PendingUpdate & update = markPending();
+            update.hasVolume = true;
+            update.volume = command.x;
+        }
+        break;
+    case AudioCommand::Type::SetLocation:
+        if (command.source >= 0)
+        {
+            PendingUpdate & update = markPending();
+            update.hasLocation = true;
+            update.x = command.x;
+            update.y = command.y;
+        }
+        break;
+    case AudioCommand::Type::SetListenerLocation:
+        m_hasListenerLocation = true;
+        m_listenerX = command.x;
+        m_listenerY = command.y;
+        break;
+    case AudioCommand::Type::SetEnabled:
+        commands.push_back(command);
+        break;
+    }
+}
+
+void AudioCommandCoalescer::flush(std::vector<AudioCommand> & commands)
+{
+    // Sources flushed by Play or Stop meanwhile have nothing pending anymore
+    for (int source : m_pendingSources)
+    {
+        flushSource(source, commands);
+        m_pendingUpdates[source].listed = false;
+    }
+    m_pendingSources.clear();
+
+    if (m_hasListenerLocation)
+    {
+        commands.push_back({AudioCommand::Type::SetListenerLocation, -1, m_listenerX, m_listenerY, false});
+        m_hasListenerLocation = false;
+    }
+}
+
+size_t AudioCommandCoalescer::maxOutputSize(size_t commandCount) const
+{
+    // Each add() passes at most its own command and the three parameters of a source
+    return commandCount + 3 * m_pendingUpdates.size() + 1;
+}
+
+void AudioCommandCoalescer::flushSource(int source, std::vector<AudioCommand> & commands)
+{
+    PendingUpdate & update = m_pendingUpdates[source];
+    if (update.hasPitch)
+        commands.push_back({AudioCommand::Type::SetPitch, source, update.pitch, 0, false});
+    if (update.hasVolume)
+        commands.push_back({AudioCommand::Type::SetVolume, source, update.volume, 0, false});
+    if (update.hasLocation)
+        commands.push_back({AudioCommand::Type::SetLocation, source, update.x, update.y, false});
+
+    update.hasPitch = false;
+    update.hasVolume = false;
+    update.hasLocation = false;
+}
@@ -0,0 +1,181 @@
+// This file is part of Dust Racing 2D.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// Dust Racing 2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Dust Racing 2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Dust Racing 2D. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef AUDIOCOMMANDQUEUE_HPP
+#define AUDIOCOMMANDQUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//! A request to the audio thread. Sources are referred to by ids given by AudioWorker::sourceId().
+struct AudioCommand
+{
+    enum class Type
+    {
+        Play,
+        Stop,
+        SetPitch,
+        SetVolume,
+        SetLocation,
+        SetListenerLocation,
+        SetEnabled
+    };
+
+    Type type;
+
+    int source;
+
+    //! Pitch, volume or x, depending on the type.
+    float x;
+
+    //! y of a location.
+    float y;
+
+    //! Loop for Play, the value for SetEnabled.
+    bool flag;
+};
+
+/*! Preallocated single-producer single-consumer ring of audio commands.
+ *  push() must be called from one thread only and pop() from one other thread only.
+ *  Neither of them allocates or blocks.
+ *
+ *  Only parameter commands are dropped if the ring is full. Play, Stop and SetEnabled
+ *  change state that isn't refreshed every frame, so they are kept in per-source slots
+ *  instead, where a later command replaces an earlier one. The slots are popped once
+ *  the ring has been drained. While they are in use, Play, Stop and SetEnabled go to
+ *  the slots even if the ring has room, so that they are executed in order. */
+class AudioCommandQueue
+{
+public:
+
+    /*! Constructor. The capacity is rounded up to a power of two.
+     *  \param sourceCount Number of source ids. */
+    AudioCommandQueue(size_t capacity, size_t sourceCount);
+
+    //! \return false if the command was dropped, because it's a parameter command and the ring is full or its source is invalid.
+    bool push(const AudioCommand & command);
+
+    //! Move at most maxCount commands to the given array in the order they were pushed.
+    //! \return number of commands moved.
+    size_t pop(AudioCommand * commands, size_t maxCount);
+
+    size_t capacity() const;
+
+    AudioCommandQueue(const AudioCommandQueue & other) = delete;
+    AudioCommandQueue & operator=(const AudioCommandQueue & other) = delete;
+
+private:
+
+    //! Values of the overflow slots.
+    enum Slot : uint8_t
+    {
+        Empty,
+        Play,
+        PlayLoop,
+        Stop,
+        Enable,
+        Disable
+    };
+
+    bool pushToRing(const AudioCommand & command);
+
+    //! Move the commands of the overflow slots to m_overflowCommands.
+    void takeOverflow();
+
+    std::vector<AudioCommand> m_commands;
+
+    const size_t m_mask;
+
+    //! Written by the consumer only.
+    std::atomic<size_t> m_head;
+
+    //! Written by the producer only.
+    std::atomic<size_t> m_tail;
+
+    //! Play or Stop of each source that didn't fit in the ring.
+    std::vector<std::atomic<uint8_t>> m_sourceSlots;
+
+    //! SetEnabled that didn't fit in the ring.
+    std::atomic<uint8_t> m_enabledSlot;
+
+    //! Set by the producer after filling a slot, cleared by the consumer before emptying them.
+    std::atomic<bool> m_hasOverflow;
+
+    //! Commands taken from the slots, but not popped yet. Used by the consumer only.
+    std::vector<AudioCommand> m_overflowCommands;
+
+    size_t m_overflowIndex;
+};
+
+/*! Merges the parameter commands of the batches drained from the queue, so that only the
+ *  latest pitch, volume and location of a source and the latest listener location are applied.
+ *  Play, Stop and SetEnabled are passed in order. The parameters pending for a source are
+ *  passed just before its Play or Stop, so they take effect before the sound starts or stops.
+ *  Used by the audio thread only. Doesn't allocate after resize(). */
+class AudioCommandCoalescer
+{
+public:
+
+    //! Constructor.
+    AudioCommandCoalescer();
+
+    //! Set the number of sources. Commands of sources out of range are ignored.
+    void resize(size_t sourceCount);
+
+    //! Add a command. Commands that must be executed now are appended to the given vector.
+    void add(const AudioCommand & command, std::vector<AudioCommand> & commands);
+
+    //! Append the latest pending parameters to the given vector and clear them.
+    void flush(std::vector<AudioCommand> & commands);
+
+    //! \return upper bound for the number of commands add() and flush() append after the given number of add() calls.
+    size_t maxOutputSize(size_t commandCount) const;
+
+private:
+
+    void flushSource(int source, std::vector<AudioCommand> & commands);
+
+    //! Latest parameters of a source not yet passed.
+    struct PendingUpdate
+    {
+        bool hasPitch = false;
+        bool hasVolume = false;
+        bool hasLocation = false;
+
+        //! True if the source is in m_pendingSources.
+        bool listed = false;
+
+        float pitch = 0;
+        float volume = 0;
+        float x = 0;
+        float y = 0;
+    };
+
+    //! Indexed by the source id.
+    std::vector<PendingUpdate> m_pendingUpdates;
+
+    //! Sources with pending parameters in the order of their first update.
+    std::vector<int> m_pendingSources;
+
+    bool m_hasListenerLocation;
+
+    float m_listenerX;
+
+    float m_listenerY;
+};
+
+#endif // AUDIOCOMMANDQUEUE_HPP
@@ -15,28 +15,142 @@
 
 #include "audioworker.hpp"
 #include "audiosource.hpp"
+#include "oggdecoder.hpp"
 #include "openalwavdata.hpp"
 #include "openaloggdata.hpp"
+#include "openaloggstreamdata.hpp"
+#include "openalstream.hpp"
 #include "settings.hpp"
 
+#include <MCLogger>
+#include <MCWorkerPool>
+
 #include <QDir>
 #include <QFile>
 #include <QString>
+#include <QThread>
+#include <QTimer>
 
-#include <sstream>
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
 
 #include <AL/al.h>
 
 static const int MAX_DIST       = 250;
 static const int REFERENCE_DIST = 50;
 
+// Enough for several seconds of per-frame updates of all cars
+static const size_t COMMAND_QUEUE_SIZE = 4096;
+
+static const size_t COMMAND_BATCH_SIZE = 256;
+
+// Common sounds at least this long (seconds) are streamed instead of decoded in advance.
+// Car sounds are shared by all cars, so they are cheaper to decode once.
+static const double MIN_STREAMED_DURATION = 5.0;
+
+// The queued buffers of a stream last about 0.7 s of 44.1 kHz stereo
+static const int STREAM_UPDATE_INTERVAL_MS = 50;
+
+namespace {
+
+enum class SoundType
+{
+    Common,
+    SingleInstanceCar,
+    MultiInstanceCar
+};
+
+struct SoundInfo
+{
+    const char * handle;
+    const char * file;
+    float volume; // Relative to the default volume
+    SoundType type;
+};
+
+// All sounds. Multi-instance car sounds get a source for each car, e.g. "carEngine0".
+const SoundInfo SOUNDS[] = {
+    {"bell", "bell.ogg", 0.5f, SoundType::Common},
+    {"cheering", "cheering.ogg", 0.5f, SoundType::Common},
+    {"menuBoom", "menuBoom.ogg", 0.5f, SoundType::Common},
+    {"menuClick", "menuClick.ogg", 1.0f, SoundType::Common},
+    {"pit", "pit.ogg", 1.0f, SoundType::Common},
+    {"carEngine", "carEngine.ogg", 0.33f, SoundType::MultiInstanceCar},
+    {"carHit", "carHit.ogg", 0.5f, SoundType::MultiInstanceCar},
+    {"skid", "skid.ogg", 0.25f, SoundType::MultiInstanceCar},
+    {"carHit2", "carHit2.ogg", 0.5f, SoundType::SingleInstanceCar},
+    {"carHit3", "carHit3.ogg", 0.5f, SoundType::SingleInstanceCar}
+};
+
+const unsigned int SOUND_COUNT = sizeof(SOUNDS) / sizeof(SOUNDS[0]);
+
+size_t sourceCount(int numCars)
+{
+    size_t count = 0;
+    for (auto && sound : SOUNDS)
+    {
+        count += sound.type == SoundType::MultiInstanceCar ? numCars : 1;
+    }
+    return count;
+}
+
+struct DecodedSound
+{
+    OpenALOggData::Pcm pcm;
+    bool streamed = false;
+    double decodeTimeMs = 0;
+    size_t peakMemory = 0;
+    std::string error;
+};
+
+}
+
 AudioWorker::AudioWorker(int numCars, bool enabled)
     : m_openALDevice(new OpenALDevice)
+    , m_commandQueue(COMMAND_QUEUE_SIZE, sourceCount(numCars))
+    , m_commandBatch(COMMAND_BATCH_SIZE)
+    , m_processScheduled(false)
     , m_inited(false)
     , m_defaultVolume(0.5)
     , m_numCars(numCars)
     , m_enabled(enabled)
+    , m_playbackEnabled(enabled)
+{
+    // The ids are fixed here, because sourceId() is used before the sounds have been loaded
+    for (auto && sound : SOUNDS)
+    {
+        if (sound.type == SoundType::MultiInstanceCar)
+        {
+            for (int i = 0; i < m_numCars; i++)
+            {
+                registerSource(QString(sound.handle) + QString::number(i));
+            }
+        }
+        else
+        {
+            registerSource(sound.handle);
+        }
+    }
+
+    assert(m_sourceIds.size() == sourceCount(m_numCars));
+    m_sources.resize(m_sourceIds.size());
+    m_commandCoalescer.resize(m_sourceIds.size());
+    m_coalescedCommands.reserve(m_commandCoalescer.maxOutputSize(COMMAND_BATCH_SIZE));
+}
+
+void AudioWorker::registerSource(const QString & handle)
 {
+    const int id = static_cast<int>(m_sourceIds.size());
+    m_sourceIds[handle] = id;
+}
+
+int AudioWorker::sourceId(const QString & handle) const
+{
+    auto iter = m_sourceIds.find(handle);
+    return iter != m_sourceIds.end() ? iter->second : -1;
 }
 
 void AudioWorker::init()
@@ -62,16 +176,17 @@ bool AudioWorker::enabled() const
 
 void AudioWorker::connectAudioSource(AudioSource & source)
 {
+    // The slots only push to the command queue, so they are called directly in the emitting thread
     connect(&source, SIGNAL(playRequested(QString, bool)),
-        this, SLOT(playSound(QString, bool)));
+        this, SLOT(playSound(QString, bool)), Qt::DirectConnection);
     connect(&source, SIGNAL(stopRequested(QString)),
-        this, SLOT(stopSound(QString)));
+        this, SLOT(stopSound(QString)), Qt::DirectConnection);
     connect(&source, SIGNAL(pitchChanged(QString, float)),
-        this, SLOT(setPitch(QString, float)));
+        this, SLOT(setPitch(QString, float)), Qt::DirectConnection);
     connect(&source, SIGNAL(volumeChanged(QString, float)),
-        this, SLOT(setVolume(QString, float)));
+        this, SLOT(setVolume(QString, float)), Qt::DirectConnection);
     connect(&source, SIGNAL(locationChanged(QString, float, float)),
-        this, SLOT(setLocation(QString, float, float)));
+        this, SLOT(setLocation(QString, float, float)), Qt::DirectConnection);
 }
 
 void AudioWorker::disconnectAudioSource(AudioSource & source)
@@ -90,89 +205,220 @@ void AudioWorker::disconnectAudioSource(AudioSource & source)
 
 void AudioWorker::loadSounds()
 {
-    loadCommonSound("bell", "bell.ogg", m_defaultVolume * 0.5f);
-    loadCommonSound("cheering", "cheering.ogg", m_defaultVolume * 0.5f);
-    loadCommonSound("menuBoom", "menuBoom.ogg", m_defaultVolume * 0.5f);
-    loadCommonSound("menuClick", "menuClick.ogg", m_defaultVolume * 1.0f);
-    loadCommonSound("pit", "pit.ogg", m_defaultVolume);
+    const auto loadStart = std::chrono::steady_clock::now();
+
+    std::vector<std::string> paths;
+    for (auto && sound : SOUNDS)
+    {
+        const QString soundPath =
+            QString(DATA_PATH) + QDir::separator() + "sounds" + QDir::separator() + sound.file;
+        checkFile(soundPath);
+        paths.push_back(soundPath.toStdString());
+    }
+
+    // Decoding doesn't use OpenAL, so the sounds can be decoded in parallel.
+    // OpenAL buffers are created afterwards in the audio thread.
+    std::vector<DecodedSound> decodedSounds(SOUND_COUNT);
+    MCWorkerPool workerPool(std::max(std::thread::hardware_concurrency(), 1u));
+    workerPool.run(SOUND_COUNT, [&] (unsigned int index) {
+        DecodedSound & decoded = decodedSounds[index];
+        const auto start = std::chrono::steady_clock::now();
+        try
+        {
+            OggDecoder decoder(paths[index]);
+            if (SOUNDS[index].type == SoundType::Common && decoder.duration() >= MIN_STREAMED_DURATION)
+            {
+                decoded.streamed = true;
+                decoded.peakMemory = OpenALStream::memoryUsage();
+            }
+            else
+            {
+                decoded.pcm = OpenALOggData::decode(decoder);
+                decoded.peakMemory = decoded.pcm.samples.capacity();
+            }
+        }
+        catch (std::exception & e)
+        {
+            decoded.error = e.what();
+        }
+        decoded.decodeTimeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    });
+
+    for (auto && decoded : decodedSounds)
+    {
+        if (!decoded.error.empty())
+        {
+            throw std::runtime_error(decoded.error);
+        }
+    }
+
+    size_t totalMemory = 0;
+    for (unsigned int i = 0; i < SOUND_COUNT; i++)
+    {
+        const SoundInfo & sound = SOUNDS[i];
+        const float volume = m_defaultVolume * sound.volume;
+        DecodedSound & decoded = decodedSounds[i];
+
+        STFH::DataPtr data;
+        if (decoded.streamed)
+        {
+            data.reset(new OpenALOggStreamData(paths[i]));
+        }
+        else
+        {
+            data.reset(new OpenALOggData(paths[i], decoded.pcm));
+
+            // OpenAL has its own copy now
+            std::vector<char>().swap(decoded.pcm.samples);
+        }
+
+        switch (sound.type)
+        {
+        case SoundType::Common:
+            loadCommonSound(sound.handle, data, volume);
+            break;
+        case SoundType::SingleInstanceCar:
+            loadSingleInstanceCarSound(sound.handle, data, volume);
+            break;
+        case SoundType::MultiInstanceCar:
+            loadMultiInstanceCarSound(sound.handle, data, volume);
+            break;
+        }
+
+        MCLogger().info() << "Sound '" << sound.file << "' " << (decoded.streamed ? "streamed" : "decoded")
+                          << " in " << decoded.decodeTimeMs << " ms, peak memory " << decoded.peakMemory / 1024 << " KB";
+
+        totalMemory += decoded.peakMemory;
+    }
+
+    MCLogger().info() << "Loaded " << SOUND_COUNT << " sounds in "
+                      << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count()
+                      << " ms using " << workerPool.threadCount() << " threads, peak memory " << totalMemory / 1024 << " KB";
 
-    loadMultiInstanceCarSound("carEngine", "carEngine.ogg", m_defaultVolume * 0.33f);
+    if (!m_streamedSources.empty())
+    {
+        // Created here, because the worker has been moved to the audio thread
+        auto streamTimer = new QTimer(this);
+        connect(streamTimer, SIGNAL(timeout()), this, SLOT(updateStreams()));
 
-    loadMultiInstanceCarSound("carHit", "carHit.ogg", m_defaultVolume * 0.5f);
-    loadMultiInstanceCarSound("skid", "skid.ogg", m_defaultVolume * 0.25f);
+        // The timer must be stopped in its own thread
+        connect(thread(), SIGNAL(finished()), streamTimer, SLOT(stop()), Qt::DirectConnection);
 
-    loadSingleInstanceCarSound("carHit2", "carHit2.ogg", m_defaultVolume * 0.5f);
-    loadSingleInstanceCarSound("carHit3", "carHit3.ogg", m_defaultVolume * 0.5f);
+        streamTimer->start(STREAM_UPDATE_INTERVAL_MS);
+    }
 }
 
-void AudioWorker::loadSingleInstanceCarSound(QString handle, QString path, float volume)
+STFH::SourcePtr AudioWorker::createSource(STFH::DataPtr data)
 {
-    const QString soundPath =
-        QString(DATA_PATH) + QDir::separator() + "sounds" + QDir::separator() + path;
-    checkFile(soundPath);
+    std::shared_ptr<OpenALSource> source(new OpenALSource(data));
+    if (source->isStreamed())
+    {
+        m_streamedSources.push_back(source);
+    }
+
+    return source;
+}
 
-    STFH::SourcePtr source(new OpenALSource(
-        STFH::DataPtr(new OpenALOggData(soundPath.toStdString()))));
+void AudioWorker::loadSingleInstanceCarSound(QString handle, STFH::DataPtr data, float volume)
+{
+    STFH::SourcePtr source(createSource(data));
     source->setMaxDist(MAX_DIST);
     source->setReferenceDist(REFERENCE_DIST);
     source->setVolume(volume);
-    m_soundMap[handle] = source;
+    m_sources.at(sourceId(handle)) = source;
 }
 
-void AudioWorker::loadCommonSound(QString handle, QString path, float volume)
+void AudioWorker::loadCommonSound(QString handle, STFH::DataPtr data, float volume)
 {
-    const QString soundPath =
-        QString(DATA_PATH) + QDir::separator() + "sounds" + QDir::separator() + path;
-    checkFile(soundPath);
-
-    m_soundMap[handle] =
-        STFH::SourcePtr(new OpenALSource(
-            STFH::DataPtr(new OpenALOggData(soundPath.toStdString()))));
-    m_soundMap[handle]->setVolume(volume);
+    STFH::SourcePtr source(createSource(data));
+    source->setVolume(volume);
+    m_sources.at(sourceId(handle)) = source;
 }
 
-void AudioWorker::loadMultiInstanceCarSound(QString baseName, QString path, float volume)
+void AudioWorker::loadMultiInstanceCarSound(QString baseName, STFH::DataPtr data, float volume)
 {
-    const QString soundPath =
-        QString(DATA_PATH) + QDir::separator() + "sounds" + QDir::separator() + path;
-    checkFile(soundPath);
-
-    STFH::DataPtr sharedData(new OpenALOggData(soundPath.toStdString()));
-
     for (int i = 0; i < m_numCars; i++)
     {
-        std::stringstream ss;
-        ss << baseName.toStdString() << i;
-        STFH::SourcePtr source(new OpenALSource(sharedData));
-        m_soundMap[ss.str().c_str()] = source;
+        STFH::SourcePtr source(createSource(data));
+        m_sources.at(sourceId(baseName + QString::number(i))) = source;
         source->setMaxDist(MAX_DIST);
         source->setReferenceDist(REFERENCE_DIST);
         source->setVolume(volume);
     }
 }
 
+void AudioWorker::updateStreams()
+{
+    for (auto && source : m_streamedSources)
+    {
+        source->update();
+    }
+}
+
+void AudioWorker::submit(const AudioCommand & command)
+{
+    // Parameter commands are dropped if the audio thread is stalled. They are updated
+    // every frame anyway. Play, Stop and SetEnabled are kept by the queue.
+    if (!m_commandQueue.push(command))
+    {
+        return;
+    }
+
+    // A single queued call handles all the commands pushed before it starts
+    if (!m_processScheduled.exchange(true))
+    {
+        QMetaObject::invokeMethod(this, "processCommands", Qt::QueuedConnection);
+    }
+}
+
+void AudioWorker::playSound(int source, bool loop)
+{
+    if (source >= 0)
+        submit({AudioCommand::Type::Play, source, 0, 0, loop});
+}
+
+void AudioWorker::stopSound(int source)
+{
+    if (source >= 0)
+        submit({AudioCommand::Type::Stop, source, 0, 0, false});
+}
+
+void AudioWorker::setPitch(int source, float pitch)
+{
+    if (source >= 0)
+        submit({AudioCommand::Type::SetPitch, source, pitch, 0, false});
+}
+
+void AudioWorker::setVolume(int source, float volume)
+{
+    if (source >= 0)
+        submit({AudioCommand::Type::SetVolume, source, volume, 0, false});
+}
+
+void AudioWorker::setLocation(int source, float x, float y)
+{
+    if (source >= 0)
+        submit({AudioCommand::Type::SetLocation, source, x, y, false});
+}
+
 void AudioWorker::playSound(const QString & handle, bool loop)
 {
-    if (m_soundMap.count(handle) && m_enabled)
-        m_soundMap[handle]->play(loop);
+    playSound(sourceId(handle), loop);
 }
 
 void AudioWorker::stopSound(const QString & handle)
 {
-    if (m_soundMap.count(handle))
-        m_soundMap[handle]->stop();
+    stopSound(sourceId(handle));
 }
 
 void AudioWorker::setPitch(const QString & handle, float pitch)
 {
-    if (m_soundMap.count(handle))
-        m_soundMap[handle]->setPitch(pitch);
+    setPitch(sourceId(handle), pitch);
 }
 
 void AudioWorker::setVolume(const QString & handle, float volume)
 {
-    if (m_soundMap.count(handle))
-        m_soundMap[handle]->setVolume(volume);
+    setVolume(sourceId(handle), volume);
 }
 
 void AudioWorker::setDefaultVolume(float volume)
@@ -182,18 +428,80 @@ void AudioWorker::setDefaultVolume(float volume)
 
 void AudioWorker::setLocation(const QString & handle, float x, float y)
 {
-    if (m_soundMap.count(handle))
-        m_soundMap[handle]->setLocation(STFH::Location(x, y));
+    setLocation(sourceId(handle), x, y);
 }
 
 void AudioWorker::setListenerLocation(float x, float y)
 {
-    alListener3f(AL_POSITION, x, y, 1);
+    submit({AudioCommand::Type::SetListenerLocation, -1, x, y, false});
 }
 
 void AudioWorker::setEnabled(bool enabled)
 {
     m_enabled = enabled;
+    submit({AudioCommand::Type::SetEnabled, -1, 0, 0, enabled});
+}
+
+void AudioWorker::execute(const AudioCommand & command)
+{
+    switch (command.type)
+    {
+    case AudioCommand::Type::Play:
+        if (m_sources[command.source] && m_playbackEnabled)
+            m_sources[command.source]->play(command.flag);
+        break;
+    case AudioCommand::Type::Stop:
+        if (m_sources[command.source])
+            m_sources[command.source]->stop();
+        break;
+    case AudioCommand::Type::SetPitch:
+        if (m_sources[command.source])
+            m_sources[command.source]->setPitch(command.x);
+        break;
+    case AudioCommand::Type::SetVolume:
+        if (m_sources[command.source])
+            m_sources[command.source]->setVolume(command.x);
+        break;
+    case AudioCommand::Type::SetLocation:
+        if (m_sources[command.source])
+            m_sources[command.source]->setLocation(STFH::Location(command.x, command.y));
+        break;
+    case AudioCommand::Type::SetListenerLocation:
+        alListener3f(AL_POSITION, command.x, command.y, 1);
+        break;
+    case AudioCommand::Type::SetEnabled:
+        m_playbackEnabled = command.flag;
+        break;
+    }
+}
+
+void AudioWorker::processCommands()
+{
+    // Cleared before draining, so that a command pushed meanwhile schedules a new call
+    m_processScheduled = false;
+
+    // Only the latest parameters of the drained commands are applied, see AudioCommandCoalescer
+    size_t count;
+    while ((count = m_commandQueue.pop(m_commandBatch.data(), m_commandBatch.size())))
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            m_commandCoalescer.add(m_commandBatch[i], m_coalescedCommands);
+        }
+
+        for (auto && command : m_coalescedCommands)
+        {
+            execute(command);
+        }
+        m_coalescedCommands.clear();
+    }
+
+    m_commandCoalescer.flush(m_coalescedCommands);
+    for (auto && command : m_coalescedCommands)
+    {
+        execute(command);
+    }
+    m_coalescedCommands.clear();
 }
 
 AudioWorker::~AudioWorker()
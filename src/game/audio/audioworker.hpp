@@ -19,13 +19,27 @@
 #include <QObject>
 #include <QString>
 
+#include <atomic>
 #include <map>
+#include <memory>
+#include <vector>
 
+#include "audiocommandqueue.hpp"
 #include "openaldevice.hpp"
 #include "openalsource.hpp"
 
 class AudioSource;
 
+/*! Owns the OpenAL sources and lives in the audio thread.
+ *
+ *  Sound requests are made from the main thread. They are pushed to a lock-free
+ *  command queue that the audio thread drains in batches, so the frequent per-car
+ *  updates don't go through the event loop. Sources are referred to by integer ids
+ *  resolved once with sourceId(). The QString-based slots do the same via direct
+ *  connections.
+ *
+ *  The sounds are decoded in parallel by loadSounds(). Long sounds of a single
+ *  source are not decoded in advance, but streamed while playing. */
 class AudioWorker : public QObject
 {
     Q_OBJECT
@@ -36,12 +50,31 @@ public:
 
     virtual ~AudioWorker();
 
+    //! Connect the signals of the given source. Must be emitted from the main thread.
     void connectAudioSource(AudioSource & source);
 
     void disconnectAudioSource(AudioSource & source);
 
     bool enabled() const;
 
+    //! \return id of the source of the given handle or -1 if there's no such sound.
+    int sourceId(const QString & handle) const;
+
+    //! Main thread only.
+    void playSound(int source, bool loop = false);
+
+    //! Main thread only.
+    void stopSound(int source);
+
+    //! Main thread only.
+    void setPitch(int source, float pitch);
+
+    //! Main thread only.
+    void setVolume(int source, float volume);
+
+    //! Main thread only.
+    void setLocation(int source, float x, float y);
+
 public slots:
 
     void init();
@@ -64,20 +97,55 @@ public slots:
 
     void setEnabled(bool enabled);
 
+private slots:
+
+    //! Execute the queued commands in the audio thread.
+    void processCommands();
+
+    //! Refill the buffers of the streamed sounds in the audio thread.
+    void updateStreams();
+
 private:
 
     void checkFile(QString path);
 
-    void loadCommonSound(QString handle, QString path, float volume = 1.0f);
+    STFH::SourcePtr createSource(STFH::DataPtr data);
+
+    void loadCommonSound(QString handle, STFH::DataPtr data, float volume = 1.0f);
+
+    void loadSingleInstanceCarSound(QString handle, STFH::DataPtr data, float volume = 1.0f);
 
-    void loadSingleInstanceCarSound(QString handle, QString path, float volume = 1.0f);
+    void loadMultiInstanceCarSound(QString baseName, STFH::DataPtr data, float volume = 1.0f);
 
-    void loadMultiInstanceCarSound(QString baseName, QString path, float volume = 1.0f);
+    void registerSource(const QString & handle);
+
+    void submit(const AudioCommand & command);
+
+    void execute(const AudioCommand & command);
 
     STFH::DevicePtr m_openALDevice;
 
-    typedef std::map<QString, STFH::SourcePtr> SoundMap;
-    SoundMap m_soundMap;
+    //! Not modified after the constructor, so it can be read from both threads.
+    typedef std::map<QString, int> SourceIdMap;
+    SourceIdMap m_sourceIds;
+
+    //! Indexed by the source id. Used by the audio thread only.
+    std::vector<STFH::SourcePtr> m_sources;
+
+    //! Sources that need to be updated regularly. Used by the audio thread only.
+    std::vector<std::shared_ptr<OpenALSource>> m_streamedSources;
+
+    AudioCommandQueue m_commandQueue;
+
+    std::vector<AudioCommand> m_commandBatch;
+
+    AudioCommandCoalescer m_commandCoalescer;
+
+    //! Coalesced commands to be executed. Used by the audio thread only.
+    std::vector<AudioCommand> m_coalescedCommands;
+
+    //! True if processCommands() has been requested but not yet started.
+    std::atomic<bool> m_processScheduled;
 
     bool m_inited;
 
@@ -85,7 +153,10 @@ private:
 
     int m_numCars;
 
+    //! Read by the main thread, but applied to the audio thread via the queue.
     bool m_enabled;
+
+    bool m_playbackEnabled;
 };
 
 #endif // AUDIOWORKER_HPP
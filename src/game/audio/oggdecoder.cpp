@@ -0,0 +1,104 @@
+// This file is part of Dust Racing 2D.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// Dust Racing 2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Dust Racing 2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Dust Racing 2D. If not, see <http://www.gnu.org/licenses/>.
+
+#include "oggdecoder.hpp"
+
+#include <stdexcept>
+
+#include <vorbis/vorbisfile.h>
+
+OggDecoder::OggDecoder(const std::string & path)
+    : m_file(new OggVorbis_File)
+    , m_path(path)
+    , m_channels(0)
+    , m_frequency(0)
+{
+    if (ov_fopen(path.c_str(), m_file.get()))
+    {
+        // The file is not cleared if opening fails
+        m_file.reset();
+        throw std::runtime_error("Failed to open Ogg file '" + path + "'");
+    }
+
+    const vorbis_info * info = ov_info(m_file.get(), -1);
+    m_channels = info->channels;
+    m_frequency = info->rate;
+}
+
+int OggDecoder::channels() const
+{
+    return m_channels;
+}
+
+int OggDecoder::frequency() const
+{
+    return m_frequency;
+}
+
+size_t OggDecoder::pcmSize() const
+{
+    // The total is known only for seekable files
+    const ogg_int64_t samples = ov_pcm_total(m_file.get(), -1);
+    return samples > 0 ? static_cast<size_t>(samples) * m_channels * 2 : 0;
+}
+
+double OggDecoder::duration() const
+{
+    const double seconds = ov_time_total(m_file.get(), -1);
+    return seconds > 0 ? seconds : 0;
+}
+
+size_t OggDecoder::read(char * data, size_t size)
+{
+    const int endian = 0; // 0 for Little-Endian, 1 for Big-Endian
+
+    // ov_read() decodes at most one packet per call
+    size_t total = 0;
+    while (total < size)
+    {
+        int bitStream;
+        const long bytes = ov_read(m_file.get(), data + total, static_cast<int>(size - total), endian, 2, 1, &bitStream);
+        if (bytes > 0)
+        {
+            total += bytes;
+        }
+        else if (bytes == 0)
+        {
+            break;
+        }
+        else if (bytes != OV_HOLE) // Holes in the data are skipped
+        {
+            throw std::runtime_error("Failed to decode Ogg file '" + m_path + "'");
+        }
+    }
+
+    return total;
+}
+
+void OggDecoder::rewind()
+{
+    if (ov_pcm_seek(m_file.get(), 0))
+    {
+        throw std::runtime_error("Failed to rewind Ogg file '" + m_path + "'");
+    }
+}
+
+OggDecoder::~OggDecoder()
+{
+    if (m_file)
+    {
+        ov_clear(m_file.get());
+    }
+}
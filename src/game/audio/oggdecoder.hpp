@@ -0,0 +1,70 @@
+// This file is part of Dust Racing 2D.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// Dust Racing 2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Dust Racing 2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Dust Racing 2D. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef OGGDECODER_HPP
+#define OGGDECODER_HPP
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+struct OggVorbis_File;
+
+//! Decodes an Ogg Vorbis file to 16-bit little-endian PCM. The decoder of a file
+//! can be used in any thread, but only in one thread at a time.
+class OggDecoder
+{
+public:
+
+    //! Constructor. Opens the given file. Throws on failure.
+    explicit OggDecoder(const std::string & path);
+
+    //! Destructor.
+    ~OggDecoder();
+
+    OggDecoder(const OggDecoder & other) = delete;
+
+    OggDecoder & operator= (const OggDecoder & other) = delete;
+
+    int channels() const;
+
+    int frequency() const;
+
+    //! \return size of the whole decoded sound in bytes or 0 if unknown.
+    size_t pcmSize() const;
+
+    //! \return duration in seconds or 0 if unknown.
+    double duration() const;
+
+    /*! Decode the next samples to the given buffer. The size must be a multiple of the
+     *  size of a sample of all channels. Throws on a decoding error.
+     *  \return number of bytes decoded. Less than size only at the end of the sound. */
+    size_t read(char * data, size_t size);
+
+    //! Seek to the beginning. Throws on failure.
+    void rewind();
+
+private:
+
+    std::unique_ptr<OggVorbis_File> m_file;
+
+    std::string m_path;
+
+    int m_channels;
+
+    int m_frequency;
+};
+
+#endif // OGGDECODER_HPP
@@ -14,13 +14,12 @@
 // along with Dust Racing 2D. If not, see <http://www.gnu.org/licenses/>.
 
 #include "openaloggdata.hpp"
+#include "oggdecoder.hpp"
 
 #include <AL/alc.h>
 
-#include <vector>
-#include <cstdio>
-
-#include <vorbis/vorbisfile.h>
+#include <algorithm>
+#include <stdexcept>
 
 static bool checkError()
 {
@@ -30,62 +29,70 @@ static bool checkError()
 
 static const int BUFFER_SIZE = 32768; // 32 KB buffers
 
-// This routine is originally from
-// http://www.gamedev.net/page/resources/_/technical/game-programming/introduction-to-ogg-vorbis-r2031
-static void loadOgg(const char * fileName, std::vector<char> & buffer, ALenum & format, ALsizei & freq)
+OpenALOggData::Pcm OpenALOggData::decode(OggDecoder & decoder)
 {
-    int endian = 0;             // 0 for Little-Endian, 1 for Big-Endian
-    int bitStream;
-    long bytes;
-    char array[BUFFER_SIZE];    // Local fixed size array
-    FILE *f;
-
-    // Open for binary reading
-    f = std::fopen(fileName, "rb");
-
-    vorbis_info *pInfo;
-    OggVorbis_File oggFile;
-    ov_open(f, &oggFile, NULL, 0);
+    Pcm pcm;
+    pcm.format = format(decoder);
+    pcm.frequency = decoder.frequency();
 
-    // Get some information about the OGG file
-    pInfo = ov_info(&oggFile, -1);
+    // Decode directly to the final buffer. The size is known for files,
+    // so usually there's only one allocation and no extra copies.
+    const size_t pcmSize = decoder.pcmSize();
+    pcm.samples.resize(pcmSize ? pcmSize : BUFFER_SIZE);
 
-    // Check the number of channels... always use 16-bit samples
-    if (pInfo->channels == 1)
-    {
-        format = AL_FORMAT_MONO16;
-    }
-    else
+    size_t size = 0;
+    while ((size += decoder.read(&pcm.samples[size], pcm.samples.size() - size)) == pcm.samples.size())
     {
-        format = AL_FORMAT_STEREO16;
+        // Grow the buffer only if there's more to decode
+        char next[4096];
+        const size_t bytes = decoder.read(next, sizeof(next));
+        if (!bytes)
+        {
+            break;
+        }
+
+        pcm.samples.resize(size + bytes + BUFFER_SIZE);
+        std::copy(next, next + bytes, &pcm.samples[size]);
+        size += bytes;
     }
 
-    freq = pInfo->rate;
-
-    do
-    {
-        // Read up to a buffer's worth of decoded sound data
-        bytes = ov_read(&oggFile, array, BUFFER_SIZE, endian, 2, 1, &bitStream);
-
-        // Append to end of buffer
-        buffer.insert(buffer.end(), array, array + bytes);
-
-    } while (bytes > 0);
+    pcm.samples.resize(size);
+    return pcm;
+}
 
-    ov_clear(&oggFile);
+ALenum OpenALOggData::format(const OggDecoder & decoder)
+{
+    // Check the number of channels... always use 16-bit samples
+    return decoder.channels() == 1 ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
 }
 
 OpenALOggData::OpenALOggData(const std::string & path)
     : m_freq(0)
+    , m_format(AL_FORMAT_MONO16)
     , m_buffer(0)
 {
     load(path);
 }
 
+OpenALOggData::OpenALOggData(const std::string & path, const Pcm & pcm)
+    : m_freq(0)
+    , m_format(AL_FORMAT_MONO16)
+    , m_buffer(0)
+{
+    Data::load(path);
+    setBufferData(pcm);
+}
+
 void OpenALOggData::load(const std::string & path)
 {
     Data::load(path);
 
+    OggDecoder decoder(path);
+    setBufferData(decode(decoder));
+}
+
+void OpenALOggData::setBufferData(const Pcm & pcm)
+{
     alGetError();
 
     if (!m_buffer)
@@ -93,14 +100,14 @@ void OpenALOggData::load(const std::string & path)
         alGenBuffers(1, &m_buffer);
     }
 
-    std::vector<char> oggBuffer;
-    loadOgg(path.c_str(), oggBuffer, m_format, m_freq);
+    m_format = pcm.format;
+    m_freq = pcm.frequency;
 
-    alBufferData(m_buffer, m_format, &oggBuffer[0], static_cast<ALsizei>(oggBuffer.size()), m_freq);
+    alBufferData(m_buffer, m_format, pcm.samples.data(), static_cast<ALsizei>(pcm.samples.size()), m_freq);
 
     if (!checkError())
     {
-        throw std::runtime_error("Failed to set buffer data of '" + path + "'");
+        throw std::runtime_error("Failed to set buffer data of '" + path() + "'");
     }
 }
 
@@ -18,14 +18,38 @@
 
 #include "openaldata.hpp"
 
-//! OpenAL Ogg data loader.
+#include <vector>
+
+class OggDecoder;
+
+//! OpenAL Ogg data loader. The whole sound is decoded to a buffer.
 class OpenALOggData : public OpenALData
 {
 public:
 
-    //! Constructor.
+    //! Decoded sound.
+    struct Pcm
+    {
+        ALenum format = AL_FORMAT_MONO16;
+
+        ALsizei frequency = 0;
+
+        std::vector<char> samples;
+    };
+
+    /*! Decode the rest of the sound. Doesn't use OpenAL, so it can be
+     *  called from any thread. Throws on failure. */
+    static Pcm decode(OggDecoder & decoder);
+
+    //! \return OpenAL format of the sound of the given decoder.
+    static ALenum format(const OggDecoder & decoder);
+
+    //! Constructor. Decodes and loads the given file.
     OpenALOggData(const std::string & path);
 
+    //! Constructor. Loads the given sound already decoded from the given file.
+    OpenALOggData(const std::string & path, const Pcm & pcm);
+
     //! Destructor.
     virtual ~OpenALOggData();
 
@@ -37,6 +61,8 @@ public:
 
 private:
 
+    void setBufferData(const Pcm & pcm);
+
     ALsizei m_freq;
     ALenum  m_format;
     ALuint  m_buffer;
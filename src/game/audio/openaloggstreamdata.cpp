@@ -0,0 +1,39 @@
+// This file is part of Dust Racing 2D.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// Dust Racing 2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Dust Racing 2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Dust Racing 2D. If not, see <http://www.gnu.org/licenses/>.
+
+#include "openaloggstreamdata.hpp"
+#include "oggdecoder.hpp"
+
+OpenALOggStreamData::OpenALOggStreamData(const std::string & path)
+{
+    load(path);
+}
+
+void OpenALOggStreamData::load(const std::string & path)
+{
+    Data::load(path);
+
+    // Throws if the file is not valid
+    OggDecoder decoder(path);
+}
+
+std::unique_ptr<OggDecoder> OpenALOggStreamData::createDecoder() const
+{
+    return std::unique_ptr<OggDecoder>(new OggDecoder(path()));
+}
+
+OpenALOggStreamData::~OpenALOggStreamData()
+{
+}
@@ -0,0 +1,44 @@
+// This file is part of Dust Racing 2D.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// Dust Racing 2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Dust Racing 2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Dust Racing 2D. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef OPENALOGGSTREAMDATA_HPP
+#define OPENALOGGSTREAMDATA_HPP
+
+#include <Data>
+
+#include <memory>
+
+class OggDecoder;
+
+//! Ogg data that is not decoded in advance, but streamed by each source playing it.
+//! \see OpenALStream.
+class OpenALOggStreamData : public STFH::Data
+{
+public:
+
+    //! Constructor.
+    OpenALOggStreamData(const std::string & path);
+
+    //! Destructor.
+    virtual ~OpenALOggStreamData();
+
+    //! \reimp Only checks that the file can be decoded.
+    virtual void load(const std::string & path) override;
+
+    //! \return a new decoder of the sound. Throws on failure.
+    std::unique_ptr<OggDecoder> createDecoder() const;
+};
+
+#endif // OPENALOGGSTREAMDATA_HPP
@@ -14,11 +14,15 @@
 // along with Dust Racing 2D. If not, see <http://www.gnu.org/licenses/>.
 
 #include "openalsource.hpp"
+#include "oggdecoder.hpp"
 #include "openaldata.hpp"
+#include "openaloggstreamdata.hpp"
+#include "openalstream.hpp"
 
 #include <AL/alc.h>
 
 #include <memory>
+#include <stdexcept>
 
 static bool checkError()
 {
@@ -44,6 +48,12 @@ void OpenALSource::setData(STFH::DataPtr data)
 {
     alGetError();
 
+    if (m_stream)
+    {
+        m_stream->stop(m_handle);
+        m_stream.reset();
+    }
+
     if (auto soundData = std::dynamic_pointer_cast<OpenALData>(data))
     {
         Source::setData(data);
@@ -54,6 +64,18 @@ void OpenALSource::setData(STFH::DataPtr data)
             throw std::runtime_error("Failed to bind '" + data->path() + "'");
         }
     }
+    else if (auto streamData = std::dynamic_pointer_cast<OpenALOggStreamData>(data))
+    {
+        Source::setData(data);
+        alSourcei(m_handle, AL_BUFFER, 0);
+        alSourcei(m_handle, AL_LOOPING, AL_FALSE);
+        m_stream.reset(new OpenALStream(streamData->createDecoder()));
+
+        if (!checkError())
+        {
+            throw std::runtime_error("Failed to bind '" + data->path() + "'");
+        }
+    }
     else
     {
         throw std::runtime_error("Incompatible sound data container for '" + data->path() + "'");
@@ -62,13 +84,41 @@ void OpenALSource::setData(STFH::DataPtr data)
 
 void OpenALSource::play(bool loop)
 {
-    alSourcei(m_handle, AL_LOOPING, loop);
-    alSourcePlay(m_handle);
+    if (m_stream)
+    {
+        // The stream loops by itself, so that the queued buffers keep rotating
+        m_stream->play(m_handle, loop);
+    }
+    else
+    {
+        alSourcei(m_handle, AL_LOOPING, loop);
+        alSourcePlay(m_handle);
+    }
 }
 
 void OpenALSource::stop()
 {
-    alSourceStop(m_handle);
+    if (m_stream)
+    {
+        m_stream->stop(m_handle);
+    }
+    else
+    {
+        alSourceStop(m_handle);
+    }
+}
+
+void OpenALSource::update()
+{
+    if (m_stream)
+    {
+        m_stream->update(m_handle);
+    }
+}
+
+bool OpenALSource::isStreamed() const
+{
+    return static_cast<bool>(m_stream);
 }
 
 void OpenALSource::setVolume(float volume)
@@ -103,5 +153,12 @@ void OpenALSource::setReferenceDist(float refDist)
 
 OpenALSource::~OpenALSource()
 {
+    // The buffers of the stream can't be deleted while queued
+    if (m_stream)
+    {
+        m_stream->stop(m_handle);
+        m_stream.reset();
+    }
+
     alDeleteSources(1, &m_handle);
 }
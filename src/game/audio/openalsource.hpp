@@ -22,8 +22,12 @@
 #include <AL/al.h>
 #include <AL/alc.h>
 
+#include <memory>
 #include <string>
 
+class OpenALStream;
+
+//! OpenAL source. Plays OpenALData from a buffer and OpenALOggStreamData through an OpenALStream.
 class OpenALSource : public STFH::Source
 {
 public:
@@ -58,9 +62,17 @@ public:
     //! \reimp
     virtual void setReferenceDist(float refDist) override;
 
+    //! Refill the queued buffers of a streamed sound. Must be called regularly while playing.
+    void update();
+
+    //! \return true if the data is streamed and update() is needed.
+    bool isStreamed() const;
+
 private:
 
     ALuint m_handle;
+
+    std::unique_ptr<OpenALStream> m_stream;
 };
 
 #endif // OPENALSOURCE_HPP
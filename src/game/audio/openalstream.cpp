@@ -0,0 +1,163 @@
+// This file is part of Dust Racing 2D.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// Dust Racing 2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Dust Racing 2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Dust Racing 2D. If not, see <http://www.gnu.org/licenses/>.
+
+#include "openalstream.hpp"
+#include "oggdecoder.hpp"
+#include "openaloggdata.hpp"
+
+#include <MCLogger>
+
+#include <stdexcept>
+
+OpenALStream::OpenALStream(std::unique_ptr<OggDecoder> decoder)
+    : m_decoder(std::move(decoder))
+    , m_format(OpenALOggData::format(*m_decoder))
+    , m_data(BUFFER_SIZE)
+    , m_loop(false)
+    , m_playing(false)
+    , m_ended(false)
+{
+    alGenBuffers(NUM_BUFFERS, m_buffers);
+}
+
+void OpenALStream::play(ALuint source, bool loop)
+{
+    stop(source);
+
+    m_loop = loop;
+    m_ended = false;
+
+    try
+    {
+        m_decoder->rewind();
+
+        for (ALuint buffer : m_buffers)
+        {
+            if (!fill(buffer))
+            {
+                break;
+            }
+
+            alSourceQueueBuffers(source, 1, &buffer);
+        }
+
+        alSourcePlay(source);
+        m_playing = true;
+    }
+    catch (std::exception & e)
+    {
+        MCLogger().error() << e.what();
+        stop(source);
+    }
+}
+
+void OpenALStream::stop(ALuint source)
+{
+    alSourceStop(source);
+
+    // Unqueues all buffers of a stopped source
+    alSourcei(source, AL_BUFFER, 0);
+
+    m_playing = false;
+}
+
+void OpenALStream::update(ALuint source)
+{
+    if (!m_playing)
+    {
+        return;
+    }
+
+    try
+    {
+        ALint processed = 0;
+        alGetSourcei(source, AL_BUFFERS_PROCESSED, &processed);
+        while (processed-- > 0)
+        {
+            ALuint buffer;
+            alSourceUnqueueBuffers(source, 1, &buffer);
+
+            if (!m_ended && fill(buffer))
+            {
+                alSourceQueueBuffers(source, 1, &buffer);
+            }
+        }
+
+        ALint queued = 0;
+        alGetSourcei(source, AL_BUFFERS_QUEUED, &queued);
+
+        ALint state = 0;
+        alGetSourcei(source, AL_SOURCE_STATE, &state);
+
+        if (!queued)
+        {
+            m_playing = false;
+        }
+        else if (state != AL_PLAYING)
+        {
+            // The source stops if it runs out of buffers before they are refilled
+            alSourcePlay(source);
+        }
+    }
+    catch (std::exception & e)
+    {
+        MCLogger().error() << e.what();
+        stop(source);
+    }
+}
+
+bool OpenALStream::isPlaying() const
+{
+    return m_playing;
+}
+
+size_t OpenALStream::memoryUsage()
+{
+    // The queued buffers and the decoding buffer
+    return (NUM_BUFFERS + 1) * BUFFER_SIZE;
+}
+
+bool OpenALStream::fill(ALuint buffer)
+{
+    size_t size = m_decoder->read(m_data.data(), m_data.size());
+
+    // A looped sound continues from the beginning in the same buffer
+    while (m_loop && size < m_data.size())
+    {
+        m_decoder->rewind();
+
+        const size_t bytes = m_decoder->read(&m_data[size], m_data.size() - size);
+        if (!bytes)
+        {
+            break;
+        }
+
+        size += bytes;
+    }
+
+    if (!size)
+    {
+        m_ended = true;
+        return false;
+    }
+
+    alBufferData(buffer, m_format, m_data.data(), static_cast<ALsizei>(size), m_decoder->frequency());
+    return true;
+}
+
+OpenALStream::~OpenALStream()
+{
+    alDeleteBuffers(NUM_BUFFERS, m_buffers);
+}
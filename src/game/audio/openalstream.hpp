@@ -0,0 +1,84 @@
+// This file is part of Dust Racing 2D.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// Dust Racing 2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Dust Racing 2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Dust Racing 2D. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef OPENALSTREAM_HPP
+#define OPENALSTREAM_HPP
+
+#include <AL/al.h>
+
+#include <memory>
+#include <vector>
+
+class OggDecoder;
+
+/*! Plays a sound by decoding it part by part to a few buffers queued to an OpenAL
+ *  source, so only the queued part of the sound is kept in memory. Used by
+ *  OpenALSource for OpenALOggStreamData. update() must be called regularly while
+ *  the sound is playing. */
+class OpenALStream
+{
+public:
+
+    //! Number of buffers queued at a time.
+    static const int NUM_BUFFERS = 4;
+
+    //! Size of a buffer in bytes.
+    static const int BUFFER_SIZE = 32768;
+
+    //! Constructor.
+    explicit OpenALStream(std::unique_ptr<OggDecoder> decoder);
+
+    //! Destructor. The buffers must not be queued to a source anymore.
+    ~OpenALStream();
+
+    OpenALStream(const OpenALStream & other) = delete;
+
+    OpenALStream & operator= (const OpenALStream & other) = delete;
+
+    //! Queue the beginning of the sound to the given source and play it.
+    void play(ALuint source, bool loop);
+
+    //! Stop the given source and unqueue the buffers.
+    void stop(ALuint source);
+
+    //! Refill and queue again the buffers the given source has played.
+    void update(ALuint source);
+
+    bool isPlaying() const;
+
+    //! \return memory used by a stream for the decoded samples in bytes.
+    static size_t memoryUsage();
+
+private:
+
+    //! Decode the next part of the sound to the given buffer. \return false at the end.
+    bool fill(ALuint buffer);
+
+    std::unique_ptr<OggDecoder> m_decoder;
+
+    ALenum m_format;
+
+    ALuint m_buffers[NUM_BUFFERS];
+
+    std::vector<char> m_data;
+
+    bool m_loop;
+
+    bool m_playing;
+
+    bool m_ended;
+};
+
+#endif // OPENALSTREAM_HPP
@@ -44,10 +44,11 @@
 using std::dynamic_pointer_cast;
 using std::static_pointer_cast;
 
-Car::Car(Description & desc, MCSurface & surface, unsigned int index, bool isHuman)
+Car::Car(Description & desc, MCSurface & surface, MCWorld & world, unsigned int index, bool isHuman)
 : MCObject(surface, "car")
 , m_desc(desc)
-, m_onTrackFriction(new MCFrictionGenerator(desc.rollingFrictionOnTrack, 0.0))
+, m_forceRegistry(world.forceRegistry())
+, m_onTrackFriction(new MCFrictionGenerator(desc.rollingFrictionOnTrack, 0.0, world.gravity()))
 , m_leftSideOffTrack(false)
 , m_rightSideOffTrack(false)
 , m_accelerating(false)
@@ -143,11 +144,11 @@ void Car::setProperties(Description & desc)
 void Car::initForceGenerators(Description & desc)
 {
     // Add rolling friction generator (on-track)
-    MCWorld::instance().forceRegistry().addForceGenerator(m_onTrackFriction, *this);
+    m_forceRegistry.addForceGenerator(m_onTrackFriction, *this);
     m_onTrackFriction->enable(true);
 
     MCForceGeneratorPtr drag(new MCDragForceGenerator(desc.dragLinear, desc.dragQuadratic));
-    MCWorld::instance().forceRegistry().addForceGenerator(drag, *this);
+    m_forceRegistry.addForceGenerator(drag, *this);
 }
 
 void Car::clearStatuses()
@@ -193,8 +194,9 @@ void Car::accelerate(bool deccelerate)
     static_pointer_cast<Tire>(m_leftRearTire)->setSpinCoeff(1.0f);
     static_pointer_cast<Tire>(m_rightRearTire)->setSpinCoeff(1.0f);
 
-    const float maxForce =
-        physicsComponent().mass() * m_desc.accelerationFriction * std::fabs(MCWorld::instance().gravity().k());
+    // No traction if the car is not in a world
+    const float gravity = world() ? std::fabs(world()->gravity().k()) : 0.0f;
+    const float maxForce = physicsComponent().mass() * m_desc.accelerationFriction * gravity;
     float currentForce = maxForce;
     const float velocity = physicsComponent().velocity().length();
     if (velocity > 0.001f)
@@ -555,5 +557,5 @@ CarSoundEffectManagerPtr Car::soundEffectManager() const
 
 Car::~Car()
 {
-    MCWorld::instance().forceRegistry().removeForceGenerators(*this);
+    m_forceRegistry.removeForceGenerators(*this);
 }
@@ -25,7 +25,9 @@
 
 #include <memory>
 
+class MCForceRegistry;
 class MCSurface;
+class MCWorld;
 class MCFrictionGenerator;
 class Route;
 
@@ -61,7 +63,7 @@ public:
     };
 
     //! Constructor.
-    Car(Description & desc, MCSurface & surface, unsigned int index, bool isHuman);
+    Car(Description & desc, MCSurface & surface, MCWorld & world, unsigned int index, bool isHuman);
 
     //! Destructor.
     virtual ~Car();
@@ -181,6 +183,10 @@ private:
 
     Description m_desc;
 
+    //! The registry of the world given to the constructor. The force generators stay
+    //! registered there also when the car is not in the world.
+    MCForceRegistry & m_forceRegistry;
+
     MCForceGeneratorPtr m_onTrackFriction;
 
     bool m_leftSideOffTrack;
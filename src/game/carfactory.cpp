@@ -17,7 +17,7 @@
 
 #include <MCAssetManager>
 
-CarPtr CarFactory::buildCar(int index, int numCars, Game & game)
+CarPtr CarFactory::buildCar(int index, int numCars, Game & game, MCWorld & world)
 {
     const int   defaultPower = 200000; // This in Watts
     const float defaultDrag  = 2.5f;
@@ -54,7 +54,7 @@ CarPtr CarFactory::buildCar(int index, int numCars, Game & game)
         desc.dragQuadratic        = defaultDrag;
         desc.accelerationFriction = 0.55f * Game::instance().difficultyProfile().accelerationFrictionMultiplier(true);
 
-        car.reset(new Car(desc, MCAssetManager::surfaceManager().surface(carImage), index, true));
+        car.reset(new Car(desc, MCAssetManager::surfaceManager().surface(carImage), world, index, true));
     }
     else if (game.hasComputerPlayers())
     {
@@ -66,7 +66,7 @@ CarPtr CarFactory::buildCar(int index, int numCars, Game & game)
             Game::instance().difficultyProfile().accelerationFrictionMultiplier(false);
         desc.dragQuadratic        = defaultDrag;
 
-        car.reset(new Car(desc, MCAssetManager::surfaceManager().surface(carImage), index, false));
+        car.reset(new Car(desc, MCAssetManager::surfaceManager().surface(carImage), world, index, false));
     }
 
     return car;
@@ -20,7 +20,7 @@
 #include "game.hpp"
 
 namespace CarFactory {
-CarPtr buildCar(int index, int numCars, Game & game);
+CarPtr buildCar(int index, int numCars, Game & game, MCWorld & world);
 }
 
 #endif // CARFACTORY_HPP
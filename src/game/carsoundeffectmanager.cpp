@@ -14,6 +14,7 @@
 // along with Dust Racing 2D. If not, see <http://www.gnu.org/licenses/>.
 
 #include "carsoundeffectmanager.hpp"
+#include "audioworker.hpp"
 #include "car.hpp"
 
 #include <MCCollisionEvent>
@@ -24,8 +25,9 @@
 static std::vector<float> gearRatios = {1.0f, 0.8f, 0.6f, 0.5f, 0.4f, 0.3f};
 
 CarSoundEffectManager::CarSoundEffectManager(
-    Car & car, const CarSoundEffectManager::MultiSoundHandles & handles)
+    Car & car, AudioWorker & audioWorker, const CarSoundEffectManager::MultiSoundHandles & handles)
     : m_car(car)
+    , m_audioWorker(audioWorker)
     , m_gear(0)
     , m_prevSpeed(0)
     , m_handles(handles)
@@ -38,15 +40,21 @@ CarSoundEffectManager::CarSoundEffectManager(
     m_skidTimer.setInterval(100);
 }
 
+void CarSoundEffectManager::setLocation(int handle)
+{
+    m_audioWorker.setLocation(handle, m_car.location().i(), m_car.location().j());
+}
+
 void CarSoundEffectManager::startEngineSound()
 {
-    emit playRequested(m_handles.engineSoundHandle, true);
-    emit locationChanged(m_handles.engineSoundHandle, m_car.location().i(), m_car.location().j());
+    m_audioWorker.playSound(m_handles.engineSoundHandle, true);
+    setLocation(m_handles.engineSoundHandle);
+    m_prevLocation = m_car.location();
 }
 
 void CarSoundEffectManager::stopEngineSound()
 {
-    emit stopRequested(m_handles.engineSoundHandle);
+    m_audioWorker.stopSound(m_handles.engineSoundHandle);
 }
 
 void CarSoundEffectManager::update()
@@ -80,11 +88,15 @@ void CarSoundEffectManager::processEngineSound()
         }
 
         m_prevSpeed = speed;
-        emit pitchChanged(m_handles.engineSoundHandle, pitch);
+        m_audioWorker.setPitch(m_handles.engineSoundHandle, pitch);
     }
 
-    emit locationChanged(m_handles.engineSoundHandle, m_car.location().i(), m_car.location().j());
-    m_prevLocation = m_car.location();
+    // Parked cars don't need updates
+    if (m_car.location().i() != m_prevLocation.i() || m_car.location().j() != m_prevLocation.j())
+    {
+        setLocation(m_handles.engineSoundHandle);
+        m_prevLocation = m_car.location();
+    }
 }
 
 void CarSoundEffectManager::processSkidSound()
@@ -93,15 +105,15 @@ void CarSoundEffectManager::processSkidSound()
     {
         if (!m_skidTimer.isActive())
         {
-            emit locationChanged(m_handles.skidSoundHandle, m_car.location().i(), m_car.location().j());
-            emit playRequested(m_handles.skidSoundHandle, false);
+            setLocation(m_handles.skidSoundHandle);
+            m_audioWorker.playSound(m_handles.skidSoundHandle, false);
             m_skidPlaying = true;
             m_skidTimer.start();
         }
     }
     else if (m_skidPlaying)
     {
-        emit stopRequested(m_handles.skidSoundHandle);
+        m_audioWorker.stopSound(m_handles.skidSoundHandle);
         m_skidPlaying = false;
     }
 }
@@ -117,8 +129,8 @@ void CarSoundEffectManager::collision(const MCCollisionEvent & event)
             event.collidingObject().typeId() == MCObject::typeId("tree")       ||
             event.collidingObject().typeId() == MCObject::typeId("rock"))
         {
-            emit locationChanged(m_handles.hitSoundHandle, m_car.location().i(), m_car.location().j());
-            emit playRequested(m_handles.hitSoundHandle, false);
+            setLocation(m_handles.hitSoundHandle);
+            m_audioWorker.playSound(m_handles.hitSoundHandle, false);
             m_hitTimer.start();
         }
         else if (
@@ -126,8 +138,8 @@ void CarSoundEffectManager::collision(const MCCollisionEvent & event)
             event.collidingObject().typeId() == MCObject::typeId("bridgeRail") ||
             event.collidingObject().typeId() == MCObject::typeId("wallLong"))
         {
-            emit locationChanged("carHit2", m_car.location().i(), m_car.location().j());
-            emit playRequested("carHit2", false);
+            setLocation(m_handles.wallHitSoundHandle);
+            m_audioWorker.playSound(m_handles.wallHitSoundHandle, false);
             m_hitTimer.start();
         }
         else if (
@@ -139,8 +151,8 @@ void CarSoundEffectManager::collision(const MCCollisionEvent & event)
             event.collidingObject().typeId() == MCObject::typeId("right")              ||
             event.collidingObject().typeId() == MCObject::typeId("tire"))
         {
-            emit locationChanged("carHit3", m_car.location().i(), m_car.location().j());
-            emit playRequested("carHit3", false);
+            setLocation(m_handles.objectHitSoundHandle);
+            m_audioWorker.playSound(m_handles.objectHitSoundHandle, false);
             m_hitTimer.start();
         }
     }
@@ -16,35 +16,38 @@
 #ifndef CARSOUNDEFFECTMANAGER_HPP
 #define CARSOUNDEFFECTMANAGER_HPP
 
-#include <QString>
+#include <QObject>
 #include <QTimer>
 
 #include <memory>
 #include <Location>
 #include <MCVector3d>
-#include "audiosource.hpp"
 
+class AudioWorker;
 class Car;
 class MCCollisionEvent;
 
-/*! Manages sound effects, like the engine sound. These are connected
- *  to the AudioThread via Qt signals. */
-class CarSoundEffectManager : public AudioSource
+/*! Manages sound effects, like the engine sound. These are updated every frame,
+ *  so the requests are sent to AudioWorker with source ids instead of signals. */
+class CarSoundEffectManager : public QObject
 {
     Q_OBJECT
 
 public:
 
-    /*! Handles to special sounds that can be played simultaneously by each car */
+    /*! Source ids of the sounds of the car given by AudioWorker::sourceId().
+     *  The wall and object hit sounds are shared by all cars. */
     struct MultiSoundHandles
     {
-        QString engineSoundHandle;
-        QString hitSoundHandle;
-        QString skidSoundHandle;
+        int engineSoundHandle = -1;
+        int hitSoundHandle = -1;
+        int skidSoundHandle = -1;
+        int wallHitSoundHandle = -1;
+        int objectHitSoundHandle = -1;
     };
 
     //! Constructor.
-    CarSoundEffectManager(Car & car, const MultiSoundHandles & handles);
+    CarSoundEffectManager(Car & car, AudioWorker & audioWorker, const MultiSoundHandles & handles);
 
     //! Destructor.
     virtual ~CarSoundEffectManager();
@@ -65,7 +68,10 @@ private:
 
     void processSkidSound();
 
+    void setLocation(int handle);
+
     Car &             m_car;
+    AudioWorker &     m_audioWorker;
     int               m_gear;
     int               m_prevSpeed;
     MCVector3dF       m_prevLocation;
@@ -18,6 +18,7 @@
 
 #include <MCAssetManager>
 #include <MCGLColor>
+#include <MCGLState>
 #include <MCSurface>
 
 CrashOverlay::CrashOverlay()
@@ -43,7 +44,7 @@ void CrashOverlay::render()
 {
     if (m_isTriggered)
     {
-        glDisable(GL_DEPTH_TEST);
+        MCGLState::setDepthTest(false);
 
         const int w2 = width()  / 2;
         const int h2 = height() / 2;
@@ -262,6 +262,12 @@ bool EventHandler::applyMatchingAction(QKeyEvent * event, bool press)
             case Qt::Key_P:
                 emit pauseToggled();
                 return true;
+            case Qt::Key_F3:
+                emit profilerToggled();
+                return true;
+            case Qt::Key_F4:
+                emit profilerTraceRequested();
+                return true;
             default:
                 break;
             }
@@ -276,7 +282,9 @@ bool EventHandler::mapKeyToAction(int player, InputHandler::Action action, int k
     if (key &&
         key != Qt::Key_Escape &&
         key != Qt::Key_Q &&
-        key != Qt::Key_P)
+        key != Qt::Key_P &&
+        key != Qt::Key_F3 &&
+        key != Qt::Key_F4)
     {
         // Find the matching action and change the key
         auto iter = m_keyToActionMap.begin();
@@ -50,6 +50,10 @@ signals:
 
     void pauseToggled();
 
+    void profilerToggled();
+
+    void profilerTraceRequested();
+
     void gameExited();
 
     void soundRequested(QString handle);
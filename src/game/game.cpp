@@ -32,13 +32,14 @@
 
 #include <MCCamera>
 #include <MCLogger>
+#include <MCProfiler>
 #include <MCWorldRenderer>
 
 #include <QApplication>
+#include <QDateTime>
 #include <QDesktopWidget>
 #include <QDir>
 #include <QThread>
-#include <QTime>
 #include <QScreen>
 #include <QSurfaceFormat>
 
@@ -46,6 +47,10 @@
 
 static const unsigned int MAX_PLAYERS = 2;
 
+// Simulation steps run per rendered frame at most. The rest of the backlog is dropped
+// so that a slow frame can't make the following frames even slower.
+static const int MAX_STEPS_PER_FRAME = 5;
+
 Game * Game::m_instance = nullptr;
 
 Game::Game(int & argc, char ** argv)
@@ -60,8 +65,10 @@ Game::Game(int & argc, char ** argv)
 , m_scene(nullptr)
 , m_trackLoader(new TrackLoader)
 , m_updateFps(60)
-, m_updateDelay(1000 / m_updateFps)
 , m_timeStep(1000 / m_updateFps)
+, m_renderDelay(0)
+, m_timeAccumulator(0)
+, m_previousFrameTime(0)
 , m_lapCount(m_settings.loadValue(Settings::lapCountKey(), 5))
 , m_paused(false)
 , m_renderElapsed(0)
@@ -85,6 +92,8 @@ Game::Game(int & argc, char ** argv)
     });
 
     connect(m_eventHandler, &EventHandler::pauseToggled, this, &Game::togglePause);
+    connect(m_eventHandler, &EventHandler::profilerToggled, this, &Game::toggleProfiler);
+    connect(m_eventHandler, &EventHandler::profilerTraceRequested, this, &Game::writeProfilerTrace);
     connect(m_eventHandler, &EventHandler::gameExited, this, &Game::exitGame);
 
     connect(m_eventHandler, &EventHandler::cursorRevealed, [this] () {
@@ -95,16 +104,12 @@ Game::Game(int & argc, char ** argv)
         m_renderer->setCursor(Qt::BlankCursor);
     });
 
-    connect(m_eventHandler, SIGNAL(soundRequested(QString)), m_audioWorker, SLOT(playSound(QString)));
+    connect(m_eventHandler, SIGNAL(soundRequested(QString)), m_audioWorker, SLOT(playSound(QString)), Qt::DirectConnection);
 
-    connect(&m_updateTimer, &QTimer::timeout, [this] () {
-        m_stateMachine->update();
-        m_scene->updateFrame(*m_inputHandler, m_timeStep);
-        m_scene->updateOverlays();
-        m_renderer->renderNow();
-    });
+    connect(&m_updateTimer, &QTimer::timeout, this, &Game::updateFrame);
 
-    m_updateTimer.setInterval(m_updateDelay);
+    m_updateTimer.setInterval(m_renderDelay);
+    m_updateTimer.setTimerType(Qt::PreciseTimer);
 
     connect(m_stateMachine, &StateMachine::exitGameRequested, this, &Game::exitGame);
 
@@ -131,6 +136,7 @@ static void printHelp()
     std::cout << "--help        Show this help." << std::endl;
     std::cout << "--lang [lang] Force language: fi, fr, it, cs." << std::endl;
     std::cout << "--no-vsync    Force vsync off." << std::endl;
+    std::cout << "--profile     Enable the frame profiler. F3 toggles it and F4 writes a trace." << std::endl;
     std::cout << std::endl;
 }
 
@@ -172,6 +178,10 @@ void Game::parseArgs(int argc, char ** argv)
         {
             m_forceNoVSync = true;
         }
+        else if (args[i] == "--profile")
+        {
+            MCProfiler::setEnabled(true);
+        }
     }
 
     initTranslations(m_appTranslator, m_app, lang);
@@ -220,11 +230,20 @@ void Game::createRenderer()
     {
         format.setSwapInterval(Settings::instance().loadVSync());
     }
+
+    // Buffer swaps block until the next refresh when vsync is on. Otherwise pace
+    // the frames with the timer at the refresh rate of the screen.
+    if (format.swapInterval() < 1)
+    {
+        const qreal refreshRate = QGuiApplication::primaryScreen()->refreshRate();
+        m_renderDelay = static_cast<int>(1000 / (refreshRate > 0 ? refreshRate : m_updateFps));
+    }
 #endif
 
     m_renderer = new Renderer(hRes, vRes, fullScreen, m_world->renderer().glScene());
     m_renderer->setFormat(format);
     m_renderer->setCursor(Qt::BlankCursor);
+    m_renderer->setShadowBufferDivisor(m_settings.loadValue(Settings::shadowBufferDivisorKey(), 1)); // Full resolution by default
 
     if (fullScreen)
     {
@@ -385,6 +404,11 @@ void Game::init()
 void Game::start()
 {
     m_paused = false;
+
+    // Don't try to catch up with the time spent paused
+    m_timeAccumulator = 0;
+    m_previousFrameTime = m_elapsed.nsecsElapsed();
+
     m_updateTimer.start();
 }
 
@@ -394,6 +418,31 @@ void Game::stop()
     m_updateTimer.stop();
 }
 
+void Game::updateFrame()
+{
+    MC_PROFILE_ZONE("Game::frame");
+
+    // Simulate in fixed steps regardless of the frame rate so that the results don't
+    // depend on the timing of the frames, and render in between the two latest steps.
+    const qint64 now = m_elapsed.nsecsElapsed();
+    m_timeAccumulator += now - m_previousFrameTime;
+    m_previousFrameTime = now;
+
+    const qint64 stepNs = static_cast<qint64>(m_timeStep) * 1000000;
+    for (int steps = 0; m_timeAccumulator >= stepNs && steps < MAX_STEPS_PER_FRAME; steps++)
+    {
+        m_stateMachine->update();
+        m_scene->updateFrame(*m_inputHandler, m_timeStep);
+        m_scene->updateOverlays();
+        m_timeAccumulator -= stepNs;
+    }
+
+    m_timeAccumulator %= stepNs;
+
+    m_scene->setRenderInterpolation(static_cast<float>(m_timeAccumulator) / stepNs);
+    m_renderer->renderNow();
+}
+
 Game::Fps Game::fps() const
 {
     return m_fps;
@@ -418,10 +467,33 @@ void Game::togglePause()
     }
 }
 
+void Game::toggleProfiler()
+{
+    MCProfiler::setEnabled(!MCProfiler::isEnabled());
+    MCLogger().info() << "Profiler " << (MCProfiler::isEnabled() ? "enabled." : "disabled.");
+}
+
+void Game::writeProfilerTrace()
+{
+    const QString fileName = QDir::tempPath() + QDir::separator() +
+        "dustrac-trace-" + QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss") + ".json";
+
+    if (MCProfiler::writeChromeTrace(fileName.toStdString()))
+    {
+        MCLogger().info() << "Profiler trace written to " << fileName.toStdString();
+    }
+    else
+    {
+        MCLogger().warning() << "Failed to write profiler trace to " << fileName.toStdString();
+    }
+}
+
 void Game::exitGame()
 {
     stop();
 
+    m_settings.flushRecords();
+
     m_renderer->close();
 
     m_audioThread->quit();
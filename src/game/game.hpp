@@ -17,8 +17,8 @@
 #define GAME_HPP
 
 #include <QObject>
+#include <QElapsedTimer>
 #include <QTimer>
-#include <QTime>
 #include <QTranslator>
 
 #include <MCWorld>
@@ -124,6 +124,11 @@ private slots:
 
     void togglePause();
 
+    void toggleProfiler();
+
+    //! Write the events buffered by the profiler as Chrome trace JSON to the temp dir.
+    void writeProfilerTrace();
+
 private:
 
     void adjustSceneSize(int hRes, int vRes);
@@ -140,6 +145,9 @@ private:
 
     void stop();
 
+    //! Run the simulation steps that are due and render a frame.
+    void updateFrame();
+
     Application m_app;
 
     QTranslator m_appTranslator;
@@ -162,11 +170,19 @@ private:
 
     TrackLoader * m_trackLoader;
 
+    //! Simulation steps per second.
     int m_updateFps;
 
-    int m_updateDelay;
+    //! Simulation time step in msecs.
+    int m_timeStep;
+
+    //! Interval of the frame timer in msecs. Zero when vsync paces the frames.
+    int m_renderDelay;
+
+    //! Wall-clock time that hasn't been simulated yet in nsecs.
+    qint64 m_timeAccumulator;
 
-    float m_timeStep;
+    qint64 m_previousFrameTime;
 
     int m_lapCount;
 
@@ -174,7 +190,7 @@ private:
 
     QTimer m_updateTimer;
 
-    QTime m_elapsed;
+    QElapsedTimer m_elapsed;
 
     int m_renderElapsed;
 
@@ -37,6 +37,7 @@ INCLUDEPATH += . \
 
 # Input
 HEADERS += \
+    ../common/compiledtrack.hpp \
     ../common/config.hpp \
     ../common/mapbase.hpp \
     ../common/objectbase.hpp \
@@ -45,12 +46,16 @@ HEADERS += \
     ../common/targetnodebase.hpp \
     ../common/trackdatabase.hpp \
     ../common/tracktilebase.hpp \
+    audio/audiocommandqueue.hpp \
     audio/audiosource.hpp \
     audio/audioworker.hpp \
+    audio/oggdecoder.hpp \
     audio/openaldata.hpp \
     audio/openaldevice.hpp \
     audio/openaloggdata.hpp \
+    audio/openaloggstreamdata.hpp \
     audio/openalsource.hpp \
+    audio/openalstream.hpp \
     audio/openalwavdata.hpp \
     menu/confirmationmenu.hpp \
     menu/credits.hpp \
@@ -94,6 +99,8 @@ HEADERS += \
     overlaybase.hpp \
     particlefactory.hpp \
     pit.hpp \
+    postprocessstage.hpp \
+    profileroverlay.hpp \
     race.hpp \
     renderable.hpp \
     renderer.hpp \
@@ -109,6 +116,8 @@ HEADERS += \
     tire.hpp \
     track.hpp \
     trackdata.hpp \
+    trackgeometry.hpp \
+    trackindex.hpp \
     trackloader.hpp \
     trackobject.hpp \
     trackobjectfactory.hpp \
@@ -132,9 +141,12 @@ HEADERS += \
     MiniCore/src/Asset/mcsurfacemanager.hh \
     MiniCore/src/Asset/mcsurfacemetadata.hh \
     MiniCore/src/Asset/mcsurfaceobjectdata.hh \
+    MiniCore/src/Asset/mctextureatlas.hh \
+    MiniCore/src/Asset/mctexturecache.hh \
     MiniCore/src/Core/mcbbox.hh \
     MiniCore/src/Core/mccast.hh \
     MiniCore/src/Core/mcevent.hh \
+    MiniCore/src/Core/mcframearena.hh \
     MiniCore/src/Core/mclogger.hh \
     MiniCore/src/Core/mcmacros.hh \
     MiniCore/src/Core/mcmathutil.hh \
@@ -143,7 +155,10 @@ HEADERS += \
     MiniCore/src/Core/mcobjectcomponent.hh \
     MiniCore/src/Core/mcobjectdata.hh \
     MiniCore/src/Core/mcobjectfactory.hh \
+    MiniCore/src/Core/mcprofiler.hh \
+    MiniCore/src/Core/mcradixsort.hh \
     MiniCore/src/Core/mcrandom.hh \
+    MiniCore/src/Core/mcrecordstore.hh \
     MiniCore/src/Core/mcrecycler.hh \
     MiniCore/src/Core/mctimerevent.hh \
     MiniCore/src/Core/mctrigonom.hh \
@@ -152,6 +167,7 @@ HEADERS += \
     MiniCore/src/Core/mcvector2d.hh \
     MiniCore/src/Core/mcvector3d.hh \
     MiniCore/src/Core/mcvectoranimation.hh \
+    MiniCore/src/Core/mcworkerpool.hh \
     MiniCore/src/Core/mcworld.hh \
     MiniCore/src/Graphics/mccamera.hh \
     MiniCore/src/Graphics/mcglambientlight.hh \
@@ -161,6 +177,7 @@ HEADERS += \
     MiniCore/src/Graphics/mcglobjectbase.hh \
     MiniCore/src/Graphics/mcglscene.hh \
     MiniCore/src/Graphics/mcglshaderprogram.hh \
+    MiniCore/src/Graphics/mcglstate.hh \
     MiniCore/src/Graphics/mcgltexcoord.hh \
     MiniCore/src/Graphics/mcglvertex.hh \
     MiniCore/src/Graphics/mcmesh.hh \
@@ -176,6 +193,7 @@ HEADERS += \
     MiniCore/src/Graphics/mcobjectrendererbase.hh \
     MiniCore/src/Graphics/mcparticle.hh \
     MiniCore/src/Graphics/mcparticlerendererbase.hh \
+    MiniCore/src/Graphics/mcparticlesystem.hh \
     MiniCore/src/Graphics/mcsurfaceparticle.hh \
     MiniCore/src/Graphics/mcsurfaceparticlerenderer.hh \
     MiniCore/src/Graphics/mcworldrenderer.hh \
@@ -183,6 +201,7 @@ HEADERS += \
     MiniCore/src/Physics/mccollisiondetector.hh \
     MiniCore/src/Physics/mccollisionevent.hh \
     MiniCore/src/Physics/mccontact.hh \
+    MiniCore/src/Physics/mccontactcache.hh \
     MiniCore/src/Physics/mcdragforcegenerator.hh \
     MiniCore/src/Physics/mcedge.hh \
     MiniCore/src/Physics/mcforcegenerator.hh \
@@ -194,8 +213,10 @@ HEADERS += \
     MiniCore/src/Physics/mcoutofboundariesevent.hh \
     MiniCore/src/Physics/mcphysicscomponent.hh \
     MiniCore/src/Physics/mcrectshape.hh \
+    MiniCore/src/Physics/mcrigidbodystore.hh \
     MiniCore/src/Physics/mcsegment.hh \
     MiniCore/src/Physics/mcshape.hh \
+    MiniCore/src/Physics/mcsleepislands.hh \
     MiniCore/src/Physics/mcspringforcegenerator.hh \
     MiniCore/src/Physics/mcspringforcegenerator2dfast.hh \
     MiniCore/src/Text/mctexturefont.hh \
@@ -204,6 +225,7 @@ HEADERS += \
     MiniCore/src/Text/mctexturefontmanager.hh \
     MiniCore/src/Text/mctextureglyph.hh \
     MiniCore/src/Text/mctexturetext.hh \
+    MiniCore/src/Text/mctexturetextmesh.hh \
     STFH/data.hpp \
     STFH/device.hpp \
     STFH/listener.hpp \
@@ -211,6 +233,7 @@ HEADERS += \
     STFH/source.hpp \
 
 SOURCES += \
+    ../common/compiledtrack.cpp \
     ../common/mapbase.cpp \
     ../common/objectbase.cpp \
     ../common/objects.cpp \
@@ -218,12 +241,16 @@ SOURCES += \
     ../common/targetnodebase.cpp \
     ../common/trackdatabase.cpp \
     ../common/tracktilebase.cpp \
+    audio/audiocommandqueue.cpp \
     audio/audiosource.cpp \
     audio/audioworker.cpp \
+    audio/oggdecoder.cpp \
     audio/openaldata.cpp \
     audio/openaldevice.cpp \
     audio/openaloggdata.cpp \
+    audio/openaloggstreamdata.cpp \
     audio/openalsource.cpp \
+    audio/openalstream.cpp \
     audio/openalwavdata.cpp \
     menu/confirmationmenu.cpp \
     menu/credits.cpp \
@@ -266,6 +293,8 @@ SOURCES += \
     overlaybase.cpp \
     particlefactory.cpp \
     pit.cpp \
+    postprocessstage.cpp \
+    profileroverlay.cpp \
     race.cpp \
     renderer.cpp \
     scene.cpp \
@@ -278,6 +307,8 @@ SOURCES += \
     tire.cpp \
     track.cpp \
     trackdata.cpp \
+    trackgeometry.cpp \
+    trackindex.cpp \
     trackloader.cpp \
     trackobject.cpp \
     trackobjectfactory.cpp \
@@ -297,18 +328,24 @@ SOURCES += \
     MiniCore/src/Asset/mcsurfaceconfigloader.cc \
     MiniCore/src/Asset/mcsurfacemanager.cc \
     MiniCore/src/Asset/mcsurfaceobjectdata.cc \
+    MiniCore/src/Asset/mctextureatlas.cc \
+    MiniCore/src/Asset/mctexturecache.cc \
     MiniCore/src/Core/mcmathutil.cc \
     MiniCore/src/Core/mcevent.cc \
+    MiniCore/src/Core/mcframearena.cc \
     MiniCore/src/Core/mclogger.cc \
     MiniCore/src/Core/mcobject.cc \
     MiniCore/src/Core/mcobjectcomponent.cc \
     MiniCore/src/Core/mcobjectdata.cc \
     MiniCore/src/Core/mcobjectfactory.cc \
+    MiniCore/src/Core/mcprofiler.cc \
     MiniCore/src/Core/mcrandom.cc \
+    MiniCore/src/Core/mcrecordstore.cc \
     MiniCore/src/Core/mctimerevent.cc \
     MiniCore/src/Core/mctrigonom.cc \
     MiniCore/src/Core/mctyperegistry.cc \
     MiniCore/src/Core/mcvectoranimation.cc \
+    MiniCore/src/Core/mcworkerpool.cc \
     MiniCore/src/Core/mcworld.cc \
     MiniCore/src/Graphics/mccamera.cc \
     MiniCore/src/Graphics/mcglambientlight.cc \
@@ -317,6 +354,7 @@ SOURCES += \
     MiniCore/src/Graphics/mcglobjectbase.cc \
     MiniCore/src/Graphics/mcglscene.cc \
     MiniCore/src/Graphics/mcglshaderprogram.cc \
+    MiniCore/src/Graphics/mcglstate.cc \
     MiniCore/src/Graphics/mcmesh.cc \
     MiniCore/src/Graphics/mcmeshview.cc \
     MiniCore/src/Graphics/mcrenderlayer.cc \
@@ -327,6 +365,7 @@ SOURCES += \
     MiniCore/src/Graphics/mcobjectrendererbase.cc \
     MiniCore/src/Graphics/mcparticle.cc \
     MiniCore/src/Graphics/mcparticlerendererbase.cc \
+    MiniCore/src/Graphics/mcparticlesystem.cc \
     MiniCore/src/Graphics/mcsurfaceparticle.cc \
     MiniCore/src/Graphics/mcsurfaceparticlerenderer.cc \
     MiniCore/src/Graphics/mcworldrenderer.cc \
@@ -334,6 +373,7 @@ SOURCES += \
     MiniCore/src/Physics/mccollisiondetector.cc \
     MiniCore/src/Physics/mccollisionevent.cc \
     MiniCore/src/Physics/mccontact.cc \
+    MiniCore/src/Physics/mccontactcache.cc \
     MiniCore/src/Physics/mcdragforcegenerator.cc \
     MiniCore/src/Physics/mcforcegenerator.cc \
     MiniCore/src/Physics/mcforceregistry.cc \
@@ -344,7 +384,9 @@ SOURCES += \
     MiniCore/src/Physics/mcoutofboundariesevent.cc \
     MiniCore/src/Physics/mcphysicscomponent.cc \
     MiniCore/src/Physics/mcrectshape.cc \
+    MiniCore/src/Physics/mcrigidbodystore.cc \
     MiniCore/src/Physics/mcshape.cc \
+    MiniCore/src/Physics/mcsleepislands.cc \
     MiniCore/src/Physics/mcspringforcegenerator.cc \
     MiniCore/src/Physics/mcspringforcegenerator2dfast.cc \
     MiniCore/src/Text/mctexturefont.cc \
@@ -353,6 +395,7 @@ SOURCES += \
     MiniCore/src/Text/mctexturefontmanager.cc \
     MiniCore/src/Text/mctextureglyph.cc \
     MiniCore/src/Text/mctexturetext.cc \
+    MiniCore/src/Text/mctexturetextmesh.cc \
     MiniCore/src/Graphics/contrib/glew/glew.c \
     STFH/data.cpp \
     STFH/device.cpp \
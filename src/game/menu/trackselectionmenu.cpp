@@ -23,6 +23,7 @@
 #include "timing.hpp"
 #include "track.hpp"
 #include "trackdata.hpp"
+#include "trackloader.hpp"
 #include "tracktile.hpp"
 
 #include <MenuItem>
@@ -63,11 +64,11 @@ public:
     , m_star(MCAssetManager::surfaceManager().surface("star"))
     , m_glow(MCAssetManager::surfaceManager().surface("starGlow"))
     , m_lock(MCAssetManager::surfaceManager().surface("lock"))
-    , m_lapRecord(Settings::instance().loadLapRecord(m_track))
+    , m_lapRecord(Settings::instance().loadLapRecord(m_track.trackData()))
     , m_raceRecord(Settings::instance().loadRaceRecord(
-        m_track, m_game.lapCount(), m_game.difficultyProfile().difficulty()))
+        m_track.trackData(), m_game.lapCount(), m_game.difficultyProfile().difficulty()))
     , m_bestPos(Settings::instance().loadBestPos(
-        m_track, m_game.lapCount(), m_game.difficultyProfile().difficulty()))
+        m_track.trackData(), m_game.lapCount(), m_game.difficultyProfile().difficulty()))
     {
         auto && program = Renderer::instance().program("menu");
         m_star.setShaderProgram(program);
@@ -84,11 +85,11 @@ public:
     {
         MenuItem::setFocused(focused);
 
-        m_lapRecord  = Settings::instance().loadLapRecord(m_track);
+        m_lapRecord  = Settings::instance().loadLapRecord(m_track.trackData());
         m_raceRecord = Settings::instance().loadRaceRecord(
-            m_track, m_game.lapCount(), m_game.difficultyProfile().difficulty());
+            m_track.trackData(), m_game.lapCount(), m_game.difficultyProfile().difficulty());
         m_bestPos = Settings::instance().loadBestPos(
-            m_track, m_game.lapCount(), m_game.difficultyProfile().difficulty());
+            m_track.trackData(), m_game.lapCount(), m_game.difficultyProfile().difficulty());
     }
 
     //! \reimp
@@ -278,7 +279,7 @@ void TrackItem::renderTrackProperties()
 
     ss.str(L"");
     ss << QObject::tr("     Length: ").toStdWString()
-       << int(m_track.trackData().route().geometricLength() * MCWorld::metersPerUnit());
+       << int(m_track.trackData().routeLength() * Scene::METERS_PER_UNIT);
     text.setText(ss.str());
     maxWidth = std::fmax(maxWidth, text.width(m_font));
     texts.push_back(text);
@@ -393,7 +394,8 @@ void TrackSelectionMenu::selectCurrentItem()
 {
     Menu::selectCurrentItem();
     auto && selection = std::static_pointer_cast<TrackItem>(currentItem())->track();
-    if (!selection.trackData().isLocked())
+    // The full track is loaded only when it's selected
+    if (!selection.trackData().isLocked() && TrackLoader::instance().loadTrackContents(selection))
     {
         m_selectedTrack = &selection;
         m_scene.setActiveTrack(*m_selectedTrack);
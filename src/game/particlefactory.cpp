@@ -20,23 +20,20 @@
 
 #include <MCAssetManager>
 #include <MCGLColor>
-#include <MCParticle>
-#include <MCPhysicsComponent>
 #include <MCRandom>
-#include <MCSurfaceParticle>
-#include <MCSurfaceParticleRenderer>
+#include <MCTrigonom>
 #include <MCWorld>
-#include <MCWorldRenderer>
 
 #include <cassert>
 
 ParticleFactory * ParticleFactory::m_instance = nullptr;
 
-ParticleFactory::ParticleFactory()
+ParticleFactory::ParticleFactory(MCWorld & world)
+: m_world(world)
 {
     assert(!ParticleFactory::m_instance);
     ParticleFactory::m_instance = this;
-    preCreateParticles();
+    createParticleSystems();
 }
 
 ParticleFactory & ParticleFactory::instance()
@@ -45,44 +42,43 @@ ParticleFactory & ParticleFactory::instance()
     return *ParticleFactory::m_instance;
 }
 
-void ParticleFactory::preCreateSurfaceParticles(
-    int count, std::string typeId, ParticleFactory::ParticleType typeEnum, MCSurface & surface, bool alphaBlend, bool hasShadow)
+void ParticleFactory::createParticleSystem(
+    unsigned int capacity, ParticleType typeEnum, MCSurface & surface, MCParticle::AnimationStyle animationStyle,
+    bool alphaBlend, bool hasShadow, MCVector3dF acceleration)
 {
-    m_particleRenderers[typeEnum] = MCParticleRendererPtr(new MCSurfaceParticleRenderer);
+    MCParticleSystem * particleSystem = new MCParticleSystem(capacity);
+    particleSystem->setSurface(surface);
+    particleSystem->setAlphaBlend(alphaBlend);
+    particleSystem->setHasShadow(hasShadow);
+    particleSystem->setAnimationStyle(animationStyle);
+    particleSystem->setAcceleration(acceleration);
 
-    for (int i = 0; i < count; i++)
-    {
-        MCSurfaceParticle * particle = new MCSurfaceParticle(typeId, surface);
-        particle->setFreeList(m_freeLists[typeEnum]);
-        particle->setCustomDeathCondition([] (MCParticle & self) {
-            return self.location().k() <= 0;
-        });
-        particle->setAlphaBlend(alphaBlend);
-        particle->setHasShadow(hasShadow);
-
-        // Initially push to list of free particles
-        m_freeLists[typeEnum].push_back(particle);
-
-        // Store for deletion
-        m_delete.push_back(std::unique_ptr<MCParticle>(particle));
-    }
+    m_particleSystems[typeEnum].reset(particleSystem);
+    m_world.addParticleSystem(*particleSystem);
 }
 
-void ParticleFactory::preCreateParticles()
+void ParticleFactory::createParticleSystems()
 {
-    preCreateSurfaceParticles(500, "SMOKE", Smoke, MCAssetManager::surfaceManager().surface("smoke"), true);
+    createParticleSystem(500, Smoke, MCAssetManager::surfaceManager().surface("smoke"),
+        MCParticle::AnimationStyle::FadeOutAndExpand, true);
 
-    preCreateSurfaceParticles(500, "OFFSMOKE", OffTrackSmoke, MCAssetManager::surfaceManager().surface("smoke"), true);
+    createParticleSystem(500, OffTrackSmoke, MCAssetManager::surfaceManager().surface("smoke"),
+        MCParticle::AnimationStyle::FadeOut, true);
 
-    preCreateSurfaceParticles(500, "SPARKLE", Sparkle, MCAssetManager::surfaceManager().surface("sparkle"), true);
+    createParticleSystem(500, Sparkle, MCAssetManager::surfaceManager().surface("sparkle"),
+        MCParticle::AnimationStyle::Shrink, true, false, m_world.gravity() * 0.5f);
 
-    preCreateSurfaceParticles(100, "LEAF", Leaf, MCAssetManager::surfaceManager().surface("leaf"), false, true);
+    createParticleSystem(100, Leaf, MCAssetManager::surfaceManager().surface("leaf"),
+        MCParticle::AnimationStyle::Shrink, false, true, MCVector3dF(0, 0, -2.5f));
 
-    preCreateSurfaceParticles(500, "MUD", Mud, MCAssetManager::surfaceManager().surface("mud"), false, true);
+    createParticleSystem(500, Mud, MCAssetManager::surfaceManager().surface("mud"),
+        MCParticle::AnimationStyle::Shrink, false, true, m_world.gravity());
 
-    preCreateSurfaceParticles(500, "ONSKID", OnTrackSkidMark, MCAssetManager::surfaceManager().surface("skid"), true);
+    createParticleSystem(500, OnTrackSkidMark, MCAssetManager::surfaceManager().surface("skid"),
+        MCParticle::AnimationStyle::FadeOut, true);
 
-    preCreateSurfaceParticles(500, "OFFSKID", OffTrackSkidMark, MCAssetManager::surfaceManager().surface("skid"), true);
+    createParticleSystem(500, OffTrackSkidMark, MCAssetManager::surfaceManager().surface("skid"),
+        MCParticle::AnimationStyle::FadeOut, true);
 }
 
 void ParticleFactory::doParticle(
@@ -131,141 +127,68 @@ void ParticleFactory::doParticle(
     };
 }
 
-MCSurfaceParticle * ParticleFactory::newSurfaceParticle(ParticleType typeEnum) const
-{
-    MCSurfaceParticle * p = nullptr;
-    MCParticle::ParticleFreeList & freeList = m_freeLists[typeEnum];
-    if (freeList.size())
-    {
-        p = dynamic_cast<MCSurfaceParticle *>(freeList.back());
-        assert(p);
-        freeList.pop_back();
-    }
-
-    return p;
-}
-
 void ParticleFactory::doDamageSmoke(MCVector3dFR location, MCVector3dFR velocity) const
 {
-    if (MCSurfaceParticle * smoke = ParticleFactory::newSurfaceParticle(Smoke))
-    {
-        smoke->init(location + MCVector3dF(0, 0, 10), 12, 3000);
-        smoke->setColor(MCGLColor(0.1f, 0.1f, 0.1f, 0.25f));
-        smoke->setAnimationStyle(MCParticle::AnimationStyle::FadeOutAndExpand);
-        smoke->rotate(MCRandom::getValue() * 360);
-        smoke->physicsComponent().setVelocity(velocity + MCRandom::randomVector3dPositiveZ() * 0.2f);
-        smoke->addToWorld();
-    }
+    m_particleSystems[Smoke]->emit(
+        location + MCVector3dF(0, 0, 10), velocity + MCRandom::randomVector3dPositiveZ() * 0.2f, 12, 3000,
+        MCGLColor(0.1f, 0.1f, 0.1f, 0.25f), MCRandom::getValue() * 360);
 }
 
 void ParticleFactory::doSkidSmoke(MCVector3dFR location, MCVector3dFR velocity) const
 {
-    if (MCSurfaceParticle * smoke = ParticleFactory::newSurfaceParticle(Smoke))
-    {
-        smoke->init(location + MCVector3dF(0, 0, 5), 6, 3000);
-        smoke->setColor(MCGLColor(1.0f, 1.0f, 1.0f, 0.1f));
-        smoke->setAnimationStyle(MCParticle::AnimationStyle::FadeOutAndExpand);
-        smoke->rotate(MCRandom::getValue() * 360);
-        smoke->physicsComponent().setVelocity(velocity + MCRandom::randomVector3dPositiveZ() * 0.1f);
-        smoke->addToWorld();
-    }
+    m_particleSystems[Smoke]->emit(
+        location + MCVector3dF(0, 0, 5), velocity + MCRandom::randomVector3dPositiveZ() * 0.1f, 6, 3000,
+        MCGLColor(1.0f, 1.0f, 1.0f, 0.1f), MCRandom::getValue() * 360);
 }
 
 void ParticleFactory::doSmoke(MCVector3dFR location, MCVector3dFR velocity) const
 {
-    if (MCSurfaceParticle * smoke = ParticleFactory::newSurfaceParticle(Smoke))
-    {
-        smoke->init(location + MCVector3dF(0, 0, 10), 12, 3000);
-        smoke->setColor(MCGLColor(0.75f, 0.75f, 0.75f, 0.15f));
-        smoke->setAnimationStyle(MCParticle::AnimationStyle::FadeOutAndExpand);
-        smoke->rotate(MCRandom::getValue() * 360);
-        smoke->physicsComponent().setVelocity(velocity + MCRandom::randomVector3dPositiveZ() * 0.1f);
-        smoke->addToWorld();
-    }
+    m_particleSystems[Smoke]->emit(
+        location + MCVector3dF(0, 0, 10), velocity + MCRandom::randomVector3dPositiveZ() * 0.1f, 12, 3000,
+        MCGLColor(0.75f, 0.75f, 0.75f, 0.15f), MCRandom::getValue() * 360);
 }
 
 void ParticleFactory::doOffTrackSmoke(MCVector3dFR location) const
 {
-    if (MCSurfaceParticle * smoke = ParticleFactory::newSurfaceParticle(OffTrackSmoke))
-    {
-        smoke->init(location + MCVector3dF(0, 0, 10), 15, 3000);
-        smoke->setColor(MCGLColor(0.6f, 0.4f, 0.0f, 0.25f));
-        smoke->setAnimationStyle(MCParticle::AnimationStyle::FadeOut);
-        smoke->rotate(MCRandom::getValue() * 360);
-        smoke->physicsComponent().setVelocity(MCRandom::randomVector3dPositiveZ() * 0.1f);
-        smoke->addToWorld();
-    }
+    m_particleSystems[OffTrackSmoke]->emit(
+        location + MCVector3dF(0, 0, 10), MCRandom::randomVector3dPositiveZ() * 0.1f, 15, 3000,
+        MCGLColor(0.6f, 0.4f, 0.0f, 0.25f), MCRandom::getValue() * 360);
 }
 
 void ParticleFactory::doOnTrackSkidMark(MCVector3dFR location, int angle) const
 {
-    if (MCSurfaceParticle * skidMark = newSurfaceParticle(OnTrackSkidMark))
-    {
-        skidMark->init(location + MCVector3dF(0, 0, 1), 8, 50000);
-        skidMark->setColor(MCGLColor(0.1f, 0.1f, 0.1f, 0.25f));
-        skidMark->setAnimationStyle(MCParticle::AnimationStyle::FadeOut);
-        skidMark->rotate(angle);
-        skidMark->physicsComponent().setVelocity(MCVector3dF(0, 0, 0));
-        skidMark->physicsComponent().setAcceleration(MCVector3dF(0, 0, 0));
-        skidMark->addToWorld();
-    }
+    m_particleSystems[OnTrackSkidMark]->emit(
+        location + MCVector3dF(0, 0, 1), MCVector3dF(0, 0, 0), 8, 50000,
+        MCGLColor(0.1f, 0.1f, 0.1f, 0.25f), angle);
 }
 
 void ParticleFactory::doOffTrackSkidMark(MCVector3dFR location, int angle) const
 {
-    if (MCSurfaceParticle * skidMark = newSurfaceParticle(OffTrackSkidMark))
-    {
-        skidMark->init(location + MCVector3dF(0, 0, 1), 8, 50000);
-        skidMark->setColor(MCGLColor(0.2f, 0.1f, 0.0f, 0.25f));
-        skidMark->setAnimationStyle(MCParticle::AnimationStyle::FadeOut);
-        skidMark->rotate(angle);
-        skidMark->physicsComponent().setVelocity(MCVector3dF(0, 0, 0));
-        skidMark->physicsComponent().setAcceleration(MCVector3dF(0, 0, 0));
-        skidMark->addToWorld();
-    }
+    m_particleSystems[OffTrackSkidMark]->emit(
+        location + MCVector3dF(0, 0, 1), MCVector3dF(0, 0, 0), 8, 50000,
+        MCGLColor(0.2f, 0.1f, 0.0f, 0.25f), angle);
 }
 
 void ParticleFactory::doMud(MCVector3dFR location, MCVector3dFR velocity) const
 {
-    if (MCSurfaceParticle * mud = newSurfaceParticle(Mud))
-    {
-        mud->init(location, 12, 3000);
-        mud->rotate(MCRandom::getValue() * 360);
-        mud->setColor(MCGLColor(1.0f, 1.0f, 1.0f, 0.5f));
-        mud->setAnimationStyle(MCParticle::AnimationStyle::Shrink);
-        mud->physicsComponent().setVelocity(velocity + MCVector3dF(0, 0, 4.0f));
-        mud->physicsComponent().setAcceleration(MCWorld::instance().gravity());
-        mud->addToWorld();
-    }
+    m_particleSystems[Mud]->emit(
+        location, velocity + MCVector3dF(0, 0, 4.0f), 12, 3000,
+        MCGLColor(1.0f, 1.0f, 1.0f, 0.5f), MCRandom::getValue() * 360);
 }
 
 void ParticleFactory::doSparkle(MCVector3dFR location, MCVector3dFR velocity) const
 {
-    if (MCSurfaceParticle * sparkle = ParticleFactory::newSurfaceParticle(Sparkle))
-    {
-        sparkle->init(location, 2 + MCRandom::getValue() * 2, 1500);
-        sparkle->setColor(MCGLColor(1.0f, 1.0f, 1.0f, 0.33f));
-        sparkle->setAnimationStyle(MCParticle::AnimationStyle::Shrink);
-        sparkle->physicsComponent().setVelocity(velocity + MCVector3dF(0, 0, 4.0f));
-        sparkle->physicsComponent().setAcceleration(MCWorld::instance().gravity() * 0.5f);
-        sparkle->addToWorld();
-    }
+    m_particleSystems[Sparkle]->emit(
+        location, velocity + MCVector3dF(0, 0, 4.0f), 2 + MCRandom::getValue() * 2, 1500,
+        MCGLColor(1.0f, 1.0f, 1.0f, 0.33f));
 }
 
 void ParticleFactory::doLeaf(MCVector3dFR location, MCVector3dFR velocity) const
 {
-    if (MCSurfaceParticle * leaf = newSurfaceParticle(Leaf))
-    {
-        leaf->init(location, 5, 3000);
-        leaf->setAnimationStyle(MCParticle::AnimationStyle::Shrink);
-        leaf->rotate(MCRandom::getValue() * 360);
-        leaf->setColor(MCGLColor(0.0, 0.75f, 0.0, 0.75f));
-        leaf->physicsComponent().setVelocity(velocity + MCVector3dF(0, 0, 2.0f) + MCRandom::randomVector3d() * 0.5f);
-        leaf->physicsComponent().setAngularVelocity((MCRandom::getValue() - 0.5) * 5.0f);
-        leaf->physicsComponent().setMomentOfInertia(1.0f);
-        leaf->physicsComponent().setAcceleration(MCVector3dF(0, 0, -2.5f));
-        leaf->addToWorld();
-    }
+    m_particleSystems[Leaf]->emit(
+        location, velocity + MCVector3dF(0, 0, 2.0f) + MCRandom::randomVector3d() * 0.5f, 5, 3000,
+        MCGLColor(0.0, 0.75f, 0.0, 0.75f), MCRandom::getValue() * 360,
+        MCTrigonom::radToDeg((MCRandom::getValue() - 0.5f) * 5.0f));
 }
 
 ParticleFactory::~ParticleFactory()
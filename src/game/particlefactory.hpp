@@ -16,17 +16,15 @@
 #ifndef PARTICLEFACTORY_HPP
 #define PARTICLEFACTORY_HPP
 
-#include <MCParticle>
-#include <MCParticleRendererBase>
-
+#include <MCParticleSystem>
 #include <MCVector3d>
 
-#include <vector>
 #include <memory>
 
-class MCSurfaceParticle;
+class MCSurface;
+class MCWorld;
 
-//! ParticleFactory takes care of spawning and recycling particles.
+//! ParticleFactory takes care of spawning particles into particle systems.
 class ParticleFactory
 {
 public:
@@ -46,7 +44,7 @@ public:
     };
 
     //! Constructor.
-    ParticleFactory();
+    explicit ParticleFactory(MCWorld & world);
 
     //! Destructor.
     ~ParticleFactory();
@@ -79,21 +77,16 @@ private:
 
     void doLeaf(MCVector3dFR location, MCVector3dFR velocity) const;
 
-    void preCreateParticles();
-
-    void preCreateSurfaceParticles(
-        int count, std::string typeId, ParticleType typeEnum, MCSurface & surface, bool alphaBlend = false, bool hasShadow = false);
-
-    MCSurfaceParticle * newSurfaceParticle(ParticleType typeEnum) const;
+    void createParticleSystems();
 
-    // Free lists (recycling) for different types of particles.
-    mutable MCParticle::ParticleFreeList m_freeLists[NumParticleTypes];
+    void createParticleSystem(
+        unsigned int capacity, ParticleType typeEnum, MCSurface & surface, MCParticle::AnimationStyle animationStyle,
+        bool alphaBlend = false, bool hasShadow = false, MCVector3dF acceleration = MCVector3dF(0, 0, 0));
 
-    // Renderers for different particle types.
-    MCParticleRendererPtr m_particleRenderers[NumParticleTypes];
+    // Particle systems for different particle types. Smoke types share the Smoke system.
+    std::unique_ptr<MCParticleSystem> m_particleSystems[NumParticleTypes];
 
-    // Particles to delete.
-    std::vector<std::unique_ptr<MCParticle> > m_delete;
+    MCWorld & m_world;
 
     static ParticleFactory * m_instance;
 };
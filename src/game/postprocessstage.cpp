@@ -0,0 +1,81 @@
+// This file is part of Dust Racing 2D.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// Dust Racing 2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Dust Racing 2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Dust Racing 2D. If not, see <http://www.gnu.org/licenses/>.
+
+#include "postprocessstage.hpp"
+
+#include <MCSurface>
+
+#include <algorithm>
+#include <stdexcept>
+
+PostProcessStage::PostProcessStage()
+: m_material(new MCGLMaterial)
+{
+}
+
+PostProcessStage::~PostProcessStage() = default;
+
+void PostProcessStage::addPass(std::string name, MCGLShaderProgramPtr program,
+    MCGLColor color, bool alphaBlend, GLenum alphaSrc, GLenum alphaDst)
+{
+    m_passes.push_back({name, program, color, alphaBlend, alphaSrc, alphaDst, true});
+}
+
+void PostProcessStage::setPassEnabled(const std::string & name, bool enabled)
+{
+    pass(name).enabled = enabled;
+}
+
+const std::vector<PostProcessStage::Pass> & PostProcessStage::passes() const
+{
+    return m_passes;
+}
+
+PostProcessStage::Pass & PostProcessStage::pass(const std::string & name)
+{
+    auto iter = std::find_if(m_passes.begin(), m_passes.end(), [&name] (const Pass & pass) {
+        return pass.name == name;
+    });
+
+    if (iter == m_passes.end())
+    {
+        throw std::runtime_error("Cannot find post-process pass '" + name + "'");
+    }
+
+    return *iter;
+}
+
+void PostProcessStage::render(const std::string & name, GLuint texture)
+{
+    Pass & pass = this->pass(name);
+    if (!pass.enabled)
+    {
+        return;
+    }
+
+    // The quad covers the whole viewport: the pass shaders don't transform the vertices.
+    // It's created here, because a current GL context is needed for the buffers.
+    if (!m_quad)
+    {
+        m_quad.reset(new MCSurface("postProcessQuad", m_material, 2.0f, 2.0f));
+    }
+
+    m_material->setTexture(texture, 0);
+    m_material->setAlphaBlend(pass.alphaBlend, pass.alphaSrc, pass.alphaDst);
+
+    m_quad->setColor(pass.color);
+    m_quad->setShaderProgram(pass.program);
+    m_quad->render(nullptr, MCVector3dF(), 0);
+}
@@ -0,0 +1,93 @@
+// This file is part of Dust Racing 2D.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// Dust Racing 2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Dust Racing 2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Dust Racing 2D. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef POSTPROCESSSTAGE_HPP
+#define POSTPROCESSSTAGE_HPP
+
+#include <MCGLColor>
+#include <MCGLEW>
+#include <MCGLMaterial>
+#include <MCGLShaderProgram>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+class MCSurface;
+
+/*! Draws fullscreen passes that composite textures, typically FBO textures, onto the
+ *  current render target. All passes share the same quad geometry and material, so
+ *  no GL objects are created after the first pass has been rendered. */
+class PostProcessStage
+{
+public:
+
+    //! A fullscreen pass in the chain.
+    struct Pass
+    {
+        //! Name used to render the pass.
+        std::string name;
+
+        //! Program used to draw the quad. The vertices are in normalized device coordinates.
+        MCGLShaderProgramPtr program;
+
+        //! Color of the quad.
+        MCGLColor color;
+
+        bool alphaBlend;
+
+        GLenum alphaSrc;
+
+        GLenum alphaDst;
+
+        //! Disabled passes are skipped.
+        bool enabled;
+    };
+
+    //! Constructor.
+    PostProcessStage();
+
+    //! Destructor.
+    ~PostProcessStage();
+
+    PostProcessStage(const PostProcessStage & other) = delete;
+    PostProcessStage & operator=(const PostProcessStage & other) = delete;
+
+    //! Append a pass to the chain.
+    void addPass(std::string name, MCGLShaderProgramPtr program,
+        MCGLColor color = MCGLColor(), bool alphaBlend = false,
+        GLenum alphaSrc = GL_SRC_ALPHA, GLenum alphaDst = GL_ONE_MINUS_SRC_ALPHA);
+
+    void setPassEnabled(const std::string & name, bool enabled);
+
+    //! \return the passes in the order they were added.
+    const std::vector<Pass> & passes() const;
+
+    /*! Draw the given texture over the current render target with the settings of the pass.
+     *  Throws if there's no pass with the given name. */
+    void render(const std::string & name, GLuint texture);
+
+private:
+
+    Pass & pass(const std::string & name);
+
+    std::vector<Pass> m_passes;
+
+    MCGLMaterialPtr m_material;
+
+    std::unique_ptr<MCSurface> m_quad;
+};
+
+#endif // POSTPROCESSSTAGE_HPP
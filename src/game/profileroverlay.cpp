@@ -0,0 +1,150 @@
+// This file is part of Dust Racing 2D.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// Dust Racing 2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Dust Racing 2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Dust Racing 2D. If not, see <http://www.gnu.org/licenses/>.
+
+#include "profileroverlay.hpp"
+#include "game.hpp"
+
+#include <MCAssetManager>
+#include <MCGLColor>
+#include <MCProfiler>
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+static const int GLYPH_WIDTH  = 10;
+static const int GLYPH_HEIGHT = 12;
+
+static const unsigned int MAX_LINES = 20;
+
+static const int NAME_WIDTH = 56;
+
+static const int UPDATES_PER_REFRESH = 60;
+
+static const int64_t WINDOW_NS = 1000000000;
+
+static const double FRAME_BUDGET_MS = 1000.0 / 60;
+
+static const char * FRAME_ZONE = "Game::frame";
+
+static const MCGLColor RED   (1.0, 0.0, 0.0);
+static const MCGLColor WHITE (1.0, 1.0, 1.0);
+
+ProfilerOverlay::ProfilerOverlay()
+: m_fontManager(MCAssetManager::textureFontManager())
+, m_font(m_fontManager.font(Game::instance().fontName()))
+, m_text(L"")
+, m_updateCount(0)
+, m_drawCallCount(0)
+, m_trackDrawCallCount(0)
+, m_redundantGLCallCount(0)
+{
+    m_text.setShadowOffset(1, -1);
+    m_text.setGlyphSize(GLYPH_WIDTH, GLYPH_HEIGHT);
+}
+
+void ProfilerOverlay::render()
+{
+    int y = height() - GLYPH_HEIGHT;
+    for (auto && line : m_lines)
+    {
+        m_text.setText(line.text);
+        m_text.setColor(line.overBudget ? RED : WHITE);
+        m_text.render(GLYPH_WIDTH, y, nullptr, m_font);
+        y -= GLYPH_HEIGHT;
+    }
+}
+
+bool ProfilerOverlay::update()
+{
+    if (++m_updateCount >= UPDATES_PER_REFRESH)
+    {
+        m_updateCount = 0;
+        refresh();
+    }
+
+    return true;
+}
+
+void ProfilerOverlay::reset()
+{
+    m_updateCount = 0;
+    m_lines.clear();
+}
+
+void ProfilerOverlay::setDrawCallCount(unsigned int drawCallCount)
+{
+    m_drawCallCount = drawCallCount;
+}
+
+void ProfilerOverlay::setTrackDrawCallCount(unsigned int trackDrawCallCount)
+{
+    m_trackDrawCallCount = trackDrawCallCount;
+}
+
+void ProfilerOverlay::setRedundantGLCallCount(unsigned int redundantGLCallCount)
+{
+    m_redundantGLCallCount = redundantGLCallCount;
+}
+
+void ProfilerOverlay::refresh()
+{
+    m_lines.clear();
+
+    MCProfiler::SummaryVector summary = MCProfiler::summary(MCProfiler::now() - WINDOW_NS);
+
+    auto frames = std::find_if(summary.begin(), summary.end(), [] (const MCProfiler::Summary & zone) {
+        return !std::strcmp(zone.name, FRAME_ZONE);
+    });
+
+    if (frames == summary.end())
+    {
+        return;
+    }
+
+    const unsigned int frameCount = frames->count;
+
+    std::stable_sort(summary.begin(), summary.end(), [] (const MCProfiler::Summary & l, const MCProfiler::Summary & r) {
+        return l.total > r.total;
+    });
+
+    std::wstringstream header;
+    header << std::left << std::setw(NAME_WIDTH) << L"ZONE" << std::right << std::setw(10) << L"MS/FRAME" << std::setw(9) << L"MAX MS";
+    m_lines.push_back({header.str(), false});
+
+    std::wstringstream drawCalls;
+    drawCalls << L"WORLD DRAW CALLS: " << m_drawCallCount << L" TRACK: " << m_trackDrawCallCount
+              << L" GL CALLS AVOIDED: " << m_redundantGLCallCount;
+    m_lines.push_back({drawCalls.str(), false});
+
+    for (auto && zone : summary)
+    {
+        if (m_lines.size() > MAX_LINES)
+        {
+            break;
+        }
+
+        const double average = static_cast<double>(zone.total) / frameCount / 1000000;
+        const double longest = static_cast<double>(zone.longest) / 1000000;
+
+        std::wstringstream ss;
+        ss << std::left << std::setw(NAME_WIDTH) << std::wstring(zone.name, zone.name + std::strlen(zone.name))
+           << std::right << std::fixed << std::setprecision(2)
+           << std::setw(10) << average << std::setw(9) << longest;
+
+        m_lines.push_back({ss.str(), longest > FRAME_BUDGET_MS});
+    }
+}
@@ -0,0 +1,84 @@
+// This file is part of Dust Racing 2D.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// Dust Racing 2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Dust Racing 2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Dust Racing 2D. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef PROFILEROVERLAY_HPP
+#define PROFILEROVERLAY_HPP
+
+#include "overlaybase.hpp"
+
+#include <MCTextureText>
+
+#include <string>
+#include <vector>
+
+class MCTextureFontManager;
+class MCTextureFont;
+
+//! Shows per-frame zone timings of MCProfiler on top of the game scene.
+class ProfilerOverlay : public OverlayBase
+{
+public:
+
+    //! Constructor.
+    ProfilerOverlay();
+
+    //! \reimp
+    virtual void render() override;
+
+    /*! \reimp
+     *  Refreshes the statistics from the profiler about once a second. */
+    virtual bool update() override;
+
+    //! \reimp
+    virtual void reset() override;
+
+    //! Set the number of draw calls of the world in the latest frame.
+    void setDrawCallCount(unsigned int drawCallCount);
+
+    //! Set the number of draw calls of the track in the latest frame.
+    void setTrackDrawCallCount(unsigned int trackDrawCallCount);
+
+    //! Set the number of redundant GL state changes skipped in the latest frame.
+    void setRedundantGLCallCount(unsigned int redundantGLCallCount);
+
+private:
+
+    struct Line
+    {
+        std::wstring text;
+
+        bool overBudget;
+    };
+
+    void refresh();
+
+    MCTextureFontManager & m_fontManager;
+
+    MCTextureFont & m_font;
+
+    MCTextureText m_text;
+
+    std::vector<Line> m_lines;
+
+    int m_updateCount;
+
+    unsigned int m_drawCallCount;
+
+    unsigned int m_trackDrawCallCount;
+
+    unsigned int m_redundantGLCallCount;
+};
+
+#endif // PROFILEROVERLAY_HPP
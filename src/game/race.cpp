@@ -45,7 +45,7 @@ static const int HUMAN_PLAYER_INDEX1 = 0;
 static const int HUMAN_PLAYER_INDEX2 = 1;
 static const int UNLOCK_LIMIT        = 6; // Position required to unlock a new track
 
-Race::Race(Game & game, unsigned int numCars)
+Race::Race(Game & game, MCWorld & world, unsigned int numCars)
 : m_numCars(numCars)
 , m_lapCount(5)
 , m_timing(numCars)
@@ -57,6 +57,7 @@ Race::Race(Game & game, unsigned int numCars)
 , m_bestPos(-1)
 , m_offTrackCounter(0)
 , m_game(game)
+, m_world(world)
 {
     createStartGridObjects();
 
@@ -64,13 +65,13 @@ Race::Race(Game & game, unsigned int numCars)
     m_offTrackMessageTimer.setInterval(30000);
 
     connect(&m_timing, &Timing::lapRecordAchieved, [this] (int msecs) {
-        Settings::instance().saveLapRecord(*m_track, msecs);
+        Settings::instance().saveLapRecord(m_track->trackData(), msecs);
         emit messageRequested(QObject::tr("New lap record!"));
     });
 
     connect(&m_timing, &Timing::raceRecordAchieved, [this] (int msecs) {
         if (m_game.hasComputerPlayers()) {
-            Settings::instance().saveRaceRecord(*m_track, msecs, m_lapCount, m_game.difficultyProfile().difficulty());
+            Settings::instance().saveRaceRecord(m_track->trackData(), msecs, m_lapCount, m_game.difficultyProfile().difficulty());
             emit messageRequested(QObject::tr("New race record!"));
         }
     });
@@ -99,6 +100,9 @@ void Race::createStartGridObjects()
 
 void Race::init(Track & track, int lapCount)
 {
+    // Write records left from an interrupted race
+    Settings::instance().flushRecords();
+
     setTrack(track, lapCount);
 
     clearPositions();
@@ -110,8 +114,8 @@ void Race::init(Track & track, int lapCount)
 
 void Race::initTiming()
 {
-    m_timing.setLapRecord(Settings::instance().loadLapRecord(*m_track));
-    m_timing.setRaceRecord(Settings::instance().loadRaceRecord(*m_track, m_lapCount, m_game.difficultyProfile().difficulty()));
+    m_timing.setLapRecord(Settings::instance().loadLapRecord(m_track->trackData()));
+    m_timing.setRaceRecord(Settings::instance().loadRaceRecord(m_track->trackData(), m_lapCount, m_game.difficultyProfile().difficulty()));
     m_timing.reset();
 }
 
@@ -160,11 +164,11 @@ void placeCar(Car & car, float x, float y, int angle)
     car.rotate(angle);
 }
 
-void placeStartGrid(MCObject & grid, float x, float y, int angle)
+void placeStartGrid(MCObject & grid, MCWorld & world, float x, float y, int angle)
 {
     grid.translate(MCVector2dF(x, y));
     grid.rotate(angle);
-    grid.addToWorld();
+    grid.addToWorld(world);
 }
 
 void Race::translateCarsToStartPositions()
@@ -189,7 +193,7 @@ void Race::translateCarsToStartPositions()
         // of the current race track.
         if (m_game.hasComputerPlayers() && !m_game.hasTwoHumanPlayers())
         {
-            const int bestPos = Settings::instance().loadBestPos(*m_track, m_lapCount, m_game.difficultyProfile().difficulty());
+            const int bestPos = Settings::instance().loadBestPos(m_track->trackData(), m_lapCount, m_game.difficultyProfile().difficulty());
             if (bestPos > 0)
             {
                 order.insert(order.begin() + bestPos - 1, *m_cars.begin());
@@ -208,7 +212,7 @@ void Race::translateCarsToStartPositions()
                 const float rowPos = (i / 2) * spacing + (i % 2) * oddOffset;
                 const float colPos = (i % 2) * tileHeight / 3 - tileHeight / 6;
                 placeCar(*order.at(i), startTileX + rowPos, startTileY + colPos, 180);
-                placeStartGrid(*m_startGridObjects.at(i), startTileX + rowPos - gridOffset, startTileY + colPos, 180);
+                placeStartGrid(*m_startGridObjects.at(i), m_world, startTileX + rowPos - gridOffset, startTileY + colPos, 180);
             }
             break;
 
@@ -220,7 +224,7 @@ void Race::translateCarsToStartPositions()
                 const float rowPos = (i / 2) * spacing + (i % 2) * oddOffset;
                 const float colPos = (i % 2) * tileHeight / 3 - tileHeight / 6;
                 placeCar(*order.at(i), startTileX - rowPos, startTileY + colPos, 0);
-                placeStartGrid(*m_startGridObjects.at(i), startTileX - rowPos + gridOffset, startTileY + colPos, 0);
+                placeStartGrid(*m_startGridObjects.at(i), m_world, startTileX - rowPos + gridOffset, startTileY + colPos, 0);
             }
             break;
 
@@ -230,7 +234,7 @@ void Race::translateCarsToStartPositions()
                 const float rowPos = (i % 2) * tileWidth / 3 - tileWidth / 6;
                 const float colPos = (i / 2) * spacing + (i % 2) * oddOffset;
                 placeCar(*order.at(i), startTileX + rowPos, startTileY - colPos, 90);
-                placeStartGrid(*m_startGridObjects.at(i), startTileX + rowPos, startTileY - colPos + gridOffset, 90);
+                placeStartGrid(*m_startGridObjects.at(i), m_world, startTileX + rowPos, startTileY - colPos + gridOffset, 90);
             }
             break;
 
@@ -241,7 +245,7 @@ void Race::translateCarsToStartPositions()
                 const float rowPos = (i % 2) * tileWidth  / 3 - tileWidth / 6;
                 const float colPos = (i / 2) * spacing + (i % 2) * oddOffset;
                 placeCar(*order.at(i), startTileX + rowPos, startTileY + colPos, 270);
-                placeStartGrid(*m_startGridObjects.at(i), startTileX + rowPos, startTileY + colPos - gridOffset, 270);
+                placeStartGrid(*m_startGridObjects.at(i), m_world, startTileX + rowPos, startTileY + colPos - gridOffset, 270);
             }
             break;
         }
@@ -332,6 +336,9 @@ void Race::update()
 
     if (isRaceFinished() && !m_isfinishedSignalSent)
     {
+        // Records achieved during the race are written in the background
+        Settings::instance().flushRecords();
+
         emit finished();
         m_isfinishedSignalSent = true;
     }
@@ -536,7 +543,7 @@ void Race::checkForNewBestPosition(const Car & car)
             const int pos = car.position();
             if (pos < m_bestPos || m_bestPos == -1)
             {
-                Settings::instance().saveBestPos(*m_track, pos, m_lapCount, m_game.difficultyProfile().difficulty());
+                Settings::instance().saveBestPos(m_track->trackData(), pos, m_lapCount, m_game.difficultyProfile().difficulty());
                 emit messageRequested(QObject::tr("A new best pos!"));
             }
 
@@ -546,7 +553,7 @@ void Race::checkForNewBestPosition(const Car & car)
                 if (pos <= UNLOCK_LIMIT)
                 {
                     next->trackData().setIsLocked(false);
-                    Settings::instance().saveTrackUnlockStatus(*next, m_lapCount, m_game.difficultyProfile().difficulty());
+                    Settings::instance().saveTrackUnlockStatus(next->trackData(), m_lapCount, m_game.difficultyProfile().difficulty());
                     emit messageRequested(QObject::tr("A new track unlocked!"));
                 }
                 else
@@ -663,7 +670,7 @@ void Race::setTrack(Track & track, int lapCount)
 {
     m_lapCount = lapCount;
     m_track    = &track;
-    m_bestPos  = Settings::instance().loadBestPos(*m_track, m_lapCount, m_game.difficultyProfile().difficulty());
+    m_bestPos  = Settings::instance().loadBestPos(m_track->trackData(), m_lapCount, m_game.difficultyProfile().difficulty());
 
     for (OffTrackDetectorPtr otd : m_offTrackDetectors)
     {
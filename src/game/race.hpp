@@ -30,6 +30,7 @@
 
 class Car;
 class Game;
+class MCWorld;
 class OffTrackDetector;
 class Route;
 class Track;
@@ -42,7 +43,7 @@ class Race : public AudioSource
 public:
 
     //! Constructor.
-    Race(Game & game, unsigned int numCars);
+    Race(Game & game, MCWorld & world, unsigned int numCars);
 
     //! Destructor.
     virtual ~Race();
@@ -169,6 +170,8 @@ private:
     int m_offTrackCounter;
 
     Game & m_game;
+
+    MCWorld & m_world;
 };
 
 #endif // RACE_HPP
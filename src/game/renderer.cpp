@@ -18,6 +18,7 @@
 #include "eventhandler.hpp"
 #include "fontfactory.hpp"
 #include "game.hpp"
+#include "postprocessstage.hpp"
 #include "scene.hpp"
 
 #ifdef __MC_GL30__
@@ -29,12 +30,14 @@
 #include "../common/config.hpp"
 
 #include <MCGLScene>
+#include <MCGLState>
 #include <MCAssetManager>
 #include <MCLogger>
-#include <MCSurface>
+#include <MCProfiler>
 #include <MCSurfaceManager>
 #include <MCTrigonom>
 
+#include <algorithm>
 #include <cmath>
 #include <cassert>
 
@@ -65,6 +68,7 @@ Renderer::Renderer(int hRes, int vRes, bool fullScreen, MCGLScene & glScene)
 , m_frameCounter(0)
 , m_fullScreen(fullScreen)
 , m_updatePending(false)
+, m_shadowBufferDivisor(1)
 , m_glScene(glScene)
 {
     assert(!Renderer::m_instance);
@@ -102,6 +106,8 @@ void Renderer::initialize()
     loadShaders();
     loadFonts();
 
+    createPostProcessStage();
+
     emit initialized();
 }
 
@@ -145,6 +151,17 @@ void Renderer::loadShaders()
     createProgramFromSource("tile3d", tileVsh, tile3dFsh);
 }
 
+void Renderer::createPostProcessStage()
+{
+    m_postProcessStage.reset(new PostProcessStage);
+
+    // Blend the shadow buffer over the scene
+    m_postProcessStage->addPass("shadowComposite", program("fbo"), MCGLColor(1, 1, 1, 0.5f), true);
+
+    // Blit the scene to the window. The fade value of the scene is applied by the program.
+    m_postProcessStage->addPass("finalBlit", program("fbo"));
+}
+
 void Renderer::loadFonts()
 {
     QStringList fonts = {"DejaVuSans-Bold.ttf"};
@@ -203,27 +220,98 @@ float Renderer::fadeValue() const
     return m_fadeValue;
 }
 
-void Renderer::render()
+void Renderer::setShadowBufferDivisor(int divisor)
 {
-    if (!m_scene)
+#ifdef __MC_GLES__
+    // Scaled depth blits are not supported
+    divisor = 1;
+#endif
+    divisor = std::max(divisor, 1);
+    if (divisor != m_shadowBufferDivisor)
     {
-        return;
+        m_shadowBufferDivisor = divisor;
+
+        m_shadowFbo.reset();
     }
+}
 
-    resizeGL(m_hRes, m_vRes);
+int Renderer::shadowBufferDivisor() const
+{
+    return m_shadowBufferDivisor;
+}
 
+void Renderer::createFramebufferObjects()
+{
     if (!m_fbo)
     {
         m_fbo.reset(new QOpenGLFramebufferObject(m_hRes, m_vRes));
         m_fbo->setAttachment(QOpenGLFramebufferObject::Depth);
+
+        // Creating the FBO binds textures behind the back of the state cache
+        MCGLState::invalidate();
     }
 
     if (!m_shadowFbo)
     {
-        m_shadowFbo.reset(new QOpenGLFramebufferObject(m_hRes, m_vRes));
+        m_shadowFbo.reset(new QOpenGLFramebufferObject(
+            std::max(m_hRes / m_shadowBufferDivisor, 1), std::max(m_vRes / m_shadowBufferDivisor, 1)));
         m_shadowFbo->setAttachment(QOpenGLFramebufferObject::Depth);
+
+        // Smooth the edges of scaled up shadows
+        if (m_shadowBufferDivisor > 1)
+        {
+            glBindTexture(GL_TEXTURE_2D, m_shadowFbo->texture());
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glBindTexture(GL_TEXTURE_2D, 0);
+        }
+
+        MCGLState::invalidate();
+    }
+}
+
+void Renderer::renderShadows()
+{
+    m_shadowFbo->bind();
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    // The depth buffer of the scene is needed so that objects hide the shadows behind them
+    if (m_shadowBufferDivisor > 1)
+    {
+        QOpenGLFramebufferObject::blitFramebuffer(
+            m_shadowFbo.get(), QRect(QPoint(), m_shadowFbo->size()),
+            m_fbo.get(), QRect(QPoint(), m_fbo->size()), GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+
+        resizeGL(m_shadowFbo->width(), m_shadowFbo->height());
+    }
+    else
+    {
+        QOpenGLFramebufferObject::blitFramebuffer(m_shadowFbo.get(), m_fbo.get(), GL_DEPTH_BUFFER_BIT);
+    }
+
+    m_scene->renderWorld(MCRenderGroup::ObjectShadows);
+    m_scene->renderWorld(MCRenderGroup::ParticleShadows);
+    m_shadowFbo->release();
+
+    if (m_shadowBufferDivisor > 1)
+    {
+        resizeGL(m_hRes, m_vRes);
+    }
+}
+
+void Renderer::render()
+{
+    MC_PROFILE_ZONE("Renderer::render");
+
+    if (!m_scene)
+    {
+        return;
     }
 
+    resizeGL(m_hRes, m_vRes);
+
+    createFramebufferObjects();
+
     m_fbo->bind();
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     m_scene->renderTrack();
@@ -231,22 +319,10 @@ void Renderer::render()
     m_scene->renderWorld(MCRenderGroup::Objects, true);
     m_fbo->release();
 
-    m_shadowFbo->bind();
-    glClear(GL_COLOR_BUFFER_BIT);
-    QOpenGLFramebufferObject::blitFramebuffer(m_shadowFbo.get(), m_fbo.get(), GL_DEPTH_BUFFER_BIT);
-    m_scene->renderWorld(MCRenderGroup::ObjectShadows);
-    m_scene->renderWorld(MCRenderGroup::ParticleShadows);
-    m_shadowFbo->release();
+    renderShadows();
 
     m_fbo->bind();
-    static MCGLMaterialPtr dummyMaterial(new MCGLMaterial);
-    dummyMaterial->setTexture(m_shadowFbo->texture(), 0);
-    dummyMaterial->setAlphaBlend(true, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    MCSurface ss("dummy", dummyMaterial, 2.0f, 2.0f);
-    ss.setColor(MCGLColor(1, 1, 1, 0.5f));
-    ss.setShaderProgram(program("fbo"));
-    ss.bind();
-    ss.render(nullptr, MCVector3dF(), 0);
+    m_postProcessStage->render("shadowComposite", m_shadowFbo->texture());
     m_scene->renderWorld(MCRenderGroup::Particles); // Render particles here to avoid glitches due to transparency
     m_scene->renderHUD();
     m_scene->renderCommonHUD();
@@ -261,12 +337,7 @@ void Renderer::render()
         resizeGL(m_hRes, m_vRes);
     }
 
-    dummyMaterial->setTexture(m_fbo->texture(), 0);
-    dummyMaterial->setAlphaBlend(false);
-    MCSurface sd("dummy2", dummyMaterial, 2.0f, 2.0f);
-    sd.setShaderProgram(program("fbo"));
-    sd.bind();
-    sd.render(nullptr, MCVector3dF(), 0);
+    m_postProcessStage->render("finalBlit", m_fbo->texture());
 }
 
 void Renderer::renderLater()
@@ -339,6 +410,7 @@ void Renderer::renderNow()
     {
         render();
 
+        MC_PROFILE_ZONE("Renderer::swapBuffers");
         m_context->swapBuffers(this);
     }
 }
@@ -402,6 +474,8 @@ Renderer::~Renderer()
 
     m_shadowFbo.reset(nullptr);
 
+    m_postProcessStage.reset(nullptr);
+
     m_shaderHash.clear();
 
     delete m_context;
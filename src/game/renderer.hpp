@@ -29,6 +29,7 @@
 #include <unordered_map>
 
 class InputHandler;
+class PostProcessStage;
 class QKeyEvent;
 class QOpenGLFramebufferObject;
 class QPaintEvent;
@@ -75,6 +76,12 @@ public:
         return m_fullScreen;
     }
 
+    /*! Render the shadows into a buffer that is smaller than the view by the given divisor.
+     *  1 renders the shadows at full resolution. */
+    void setShadowBufferDivisor(int divisor);
+
+    int shadowBufferDivisor() const;
+
 signals:
 
     void closed();
@@ -128,6 +135,12 @@ private:
 
     void createProgramFromSource(std::string handle, std::string vshSource, std::string fshSource);
 
+    void createPostProcessStage();
+
+    void createFramebufferObjects();
+
+    void renderShadows();
+
     void render();
 
     void resizeGL(int viewWidth, int viewHeight);
@@ -172,6 +185,10 @@ private:
 
     std::unique_ptr<QOpenGLFramebufferObject> m_shadowFbo;
 
+    std::unique_ptr<PostProcessStage> m_postProcessStage;
+
+    int m_shadowBufferDivisor;
+
     MCGLScene & m_glScene;
 };
 
@@ -31,6 +31,7 @@
 #include "messageoverlay.hpp"
 #include "particlefactory.hpp"
 #include "pit.hpp"
+#include "profileroverlay.hpp"
 #include "race.hpp"
 #include "renderer.hpp"
 #include "settings.hpp"
@@ -55,20 +56,24 @@
 #include <MCGLDiffuseLight>
 #include <MCGLScene>
 #include <MCGLShaderProgram>
+#include <MCGLState>
 #include <MCLogger>
 #include <MCObjectFactory>
+#include <MCProfiler>
 #include <MCObject>
 #include <MCPhysicsComponent>
 #include <MCShape>
 #include <MCSurface>
 #include <MCSurfaceView>
 #include <MCTextureFont>
+#include <MCTrigonom>
 
 #include <MCWorld>
 #include <MCWorldRenderer>
 
 #include <QObject>
 #include <QApplication>
+#include <QThread>
 
 #include <algorithm>
 #include <cassert>
@@ -80,14 +85,13 @@ using std::dynamic_pointer_cast;
 int Scene::m_width  = 1024;
 int Scene::m_height = 768;
 
-static const float METERS_PER_UNIT = 0.05f;
-
 Scene::Scene(Game & game, StateMachine & stateMachine, Renderer & renderer, MCWorld & world)
 : m_game(game)
 , m_stateMachine(stateMachine)
 , m_renderer(renderer)
 , m_messageOverlay(new MessageOverlay)
-, m_race(game, NUM_CARS)
+, m_profilerOverlay(new ProfilerOverlay)
+, m_race(game, world, NUM_CARS)
 , m_activeTrack(nullptr)
 , m_world(world)
 , m_startlights(new Startlights)
@@ -96,7 +100,7 @@ Scene::Scene(Game & game, StateMachine & stateMachine, Renderer & renderer, MCWo
 , m_mainMenu(nullptr)
 , m_menuManager(nullptr)
 , m_intro(new Intro)
-, m_particleFactory(new ParticleFactory)
+, m_particleFactory(new ParticleFactory(world))
 , m_fadeAnimation(new FadeAnimation)
 {
     connect(m_startlights, SIGNAL(raceStarted()), &m_race, SLOT(start()));
@@ -116,7 +120,7 @@ Scene::Scene(Game & game, StateMachine & stateMachine, Renderer & renderer, MCWo
     connect(&m_race, SIGNAL(messageRequested(QString)), m_messageOverlay, SLOT(addMessage(QString)));
 
     connect(m_startlights, SIGNAL(messageRequested(QString)), m_messageOverlay, SLOT(addMessage(QString)));
-    connect(this, SIGNAL(listenerLocationChanged(float, float)), &m_game.audioWorker(), SLOT(setListenerLocation(float, float)));
+    connect(this, SIGNAL(listenerLocationChanged(float, float)), &m_game.audioWorker(), SLOT(setListenerLocation(float, float)), Qt::DirectConnection);
 
     m_game.audioWorker().connectAudioSource(m_race);
 
@@ -130,8 +134,11 @@ Scene::Scene(Game & game, StateMachine & stateMachine, Renderer & renderer, MCWo
     m_intro->setDimensions(width(), height());
     m_startlightsOverlay->setDimensions(width(), height());
     m_messageOverlay->setDimensions(width(), height());
+    m_profilerOverlay->setDimensions(width(), height());
 
     m_world.setMetersPerUnit(METERS_PER_UNIT);
+    m_world.setCollisionDetectionThreadCount(static_cast<unsigned int>(std::max(QThread::idealThreadCount(), 1)));
+    m_world.enableBatchedIntegration(true);
 
     MCAssetManager::textureFontManager().font(m_game.fontName()).setShaderProgram(
         m_renderer.program("text"));
@@ -142,7 +149,7 @@ Scene::Scene(Game & game, StateMachine & stateMachine, Renderer & renderer, MCWo
     const MCGLDiffuseLight diffuseLight(MCVector3dF(1.0, -1.0, -1.0), 1.0, 0.9, 0.5, 0.75);
     const MCGLDiffuseLight specularLight(MCVector3dF(1.0, -1.0, -1.0), 1.0, 1.0, 0.8, 0.9);
 
-    MCGLScene & glScene = MCWorld::instance().renderer().glScene();
+    MCGLScene & glScene = m_world.renderer().glScene();
     glScene.setAmbientLight(ambientLight);
     glScene.setDiffuseLight(diffuseLight);
     glScene.setSpecularLight(specularLight);
@@ -154,22 +161,16 @@ Scene::Scene(Game & game, StateMachine & stateMachine, Renderer & renderer, MCWo
 
 void Scene::setupAudio(Car & car, int index)
 {
-    std::stringstream engine;
-    engine << "carEngine" << index;
-
-    std::stringstream hit;
-    hit << "carHit" << index;
-
-    std::stringstream skid;
-    skid << "skid" << index;
+    AudioWorker & audioWorker = m_game.audioWorker();
 
     CarSoundEffectManager::MultiSoundHandles handles;
-    handles.engineSoundHandle = engine.str().c_str();
-    handles.hitSoundHandle    = hit.str().c_str();
-    handles.skidSoundHandle   = skid.str().c_str();
+    handles.engineSoundHandle = audioWorker.sourceId("carEngine" + QString::number(index));
+    handles.hitSoundHandle    = audioWorker.sourceId("carHit" + QString::number(index));
+    handles.skidSoundHandle   = audioWorker.sourceId("skid" + QString::number(index));
+    handles.wallHitSoundHandle   = audioWorker.sourceId("carHit2");
+    handles.objectHitSoundHandle = audioWorker.sourceId("carHit3");
 
-    CarSoundEffectManagerPtr sfx(new CarSoundEffectManager(car, handles));
-    m_game.audioWorker().connectAudioSource(*sfx);
+    CarSoundEffectManagerPtr sfx(new CarSoundEffectManager(car, audioWorker, handles));
     car.setSoundEffectManager(sfx);
 }
 
@@ -182,7 +183,7 @@ void Scene::createCars()
     // Create and add cars.
     for (int i = 0; i < NUM_CARS; i++)
     {
-        CarPtr car(CarFactory::buildCar(i, NUM_CARS, m_game));
+        CarPtr car(CarFactory::buildCar(i, NUM_CARS, m_game, m_world));
         if (car)
         {
             if (!car->isHuman())
@@ -252,34 +253,30 @@ void Scene::createMenus()
 
 void Scene::updateFrame(InputHandler & handler, int step)
 {
-    if (m_stateMachine.state() == StateMachine::State::GameTransitionIn  ||
-        m_stateMachine.state() == StateMachine::State::GameTransitionOut ||
-        m_stateMachine.state() == StateMachine::State::DoStartlights     ||
-        m_stateMachine.state() == StateMachine::State::Play)
+    MC_PROFILE_ZONE("Scene::updateFrame");
+
+    if (isRaceRunning())
     {
-        if (m_activeTrack)
+        if (m_race.started())
         {
-            if (m_race.started())
-            {
-                processUserInput(handler);
-                updateAi();
-            }
+            processUserInput(handler);
+            updateAi();
+        }
 
-            updateWorld(step);
-            updateRace();
+        updateWorld(step);
+        updateRace();
 
-            if (m_game.hasTwoHumanPlayers())
-            {
-                for (int i = 0; i < 2; i++)
-                {
-                    updateCameraLocation(m_camera[i], m_cameraOffset[i], *m_cars.at(i));
-                }
-            }
-            else
+        if (m_game.hasTwoHumanPlayers())
+        {
+            for (int i = 0; i < 2; i++)
             {
-                updateCameraLocation(m_camera[0], m_cameraOffset[0], *m_cars.at(0));
+                updateCameraLocation(m_camera[i], m_cameraOffset[i], *m_cars.at(i));
             }
         }
+        else
+        {
+            updateCameraLocation(m_camera[0], m_cameraOffset[0], *m_cars.at(0));
+        }
     }
     else if (m_stateMachine.state() == StateMachine::State::Menu)
     {
@@ -289,13 +286,15 @@ void Scene::updateFrame(InputHandler & handler, int step)
     const float fadeValue = m_renderer.fadeValue();
     if (m_fadeAnimation->isFading())
     {
-        MCGLScene & glScene = MCWorld::instance().renderer().glScene();
+        MCGLScene & glScene = m_world.renderer().glScene();
         glScene.setFadeValue(fadeValue);
     }
 }
 
 void Scene::updateOverlays()
 {
+    MC_PROFILE_ZONE("Scene::updateOverlays");
+
     if (m_game.hasTwoHumanPlayers())
     {
         m_timingOverlay[1].update();
@@ -306,6 +305,11 @@ void Scene::updateOverlays()
     m_crashOverlay[0].update();
 
     m_messageOverlay->update();
+
+    if (MCProfiler::isEnabled())
+    {
+        m_profilerOverlay->update();
+    }
 }
 
 void Scene::updateWorld(float timeStep)
@@ -327,15 +331,44 @@ void Scene::updateCameraLocation(MCCamera & camera, float & offset, MCObject & o
     // Update camera location with respect to the car speed.
     // Make changes a bit smoother so that an abrupt decrease
     // in the speed won't look bad.
-    MCVector2dF loc(object.location());
+    const float smooth = 0.2;
+
+    offset += (object.physicsComponent().velocity().lengthFast() - offset) * smooth;
 
+    placeCamera(camera, offset, object.location(), object.angle());
+}
+
+void Scene::placeCamera(MCCamera & camera, float offset, MCVector2dF location, float angle)
+{
     const float offsetAmplification = m_game.hasTwoHumanPlayers() ? 9.6 : 13.8;
-    const float smooth              = 0.2;
 
-    offset += (object.physicsComponent().velocity().lengthFast() - offset) * smooth;
-    loc    += object.direction() * offset * offsetAmplification;
+    location += MCVector2dF(MCTrigonom::cos(angle), MCTrigonom::sin(angle)) * offset * offsetAmplification;
 
-    camera.setPos(loc.i(), loc.j());
+    camera.setPos(location.i(), location.j());
+}
+
+void Scene::setRenderInterpolation(float alpha)
+{
+    m_world.setRenderInterpolation(alpha);
+
+    // Follow the interpolated cars so that the camera doesn't jitter against them
+    if (isRaceRunning())
+    {
+        for (int i = 0; i < (m_game.hasTwoHumanPlayers() ? 2 : 1); i++)
+        {
+            const MCShape & shape = *m_cars.at(i)->shape();
+            placeCamera(m_camera[i], m_cameraOffset[i], shape.renderLocation(), shape.renderAngle());
+        }
+    }
+}
+
+bool Scene::isRaceRunning() const
+{
+    return m_activeTrack && (
+        m_stateMachine.state() == StateMachine::State::GameTransitionIn  ||
+        m_stateMachine.state() == StateMachine::State::GameTransitionOut ||
+        m_stateMachine.state() == StateMachine::State::DoStartlights     ||
+        m_stateMachine.state() == StateMachine::State::Play);
 }
 
 void Scene::processUserInput(InputHandler & handler)
@@ -378,6 +411,8 @@ void Scene::processUserInput(InputHandler & handler)
 
 void Scene::updateAi()
 {
+    MC_PROFILE_ZONE("Scene::updateAi");
+
     for (AIPtr ai : m_ai)
     {
         const bool isRaceCompleted = m_race.timing().raceCompleted(ai->car().index());
@@ -469,7 +504,7 @@ void Scene::addCarsToWorld()
     // Add objects to the world
     for (CarPtr car : m_cars)
     {
-        car->addToWorld();
+        car->addToWorld(m_world);
     }
 }
 
@@ -490,7 +525,7 @@ void Scene::createNormalObjects()
         assert(trackObject);
 
         MCObject & object = trackObject->object();
-        object.addToWorld();
+        object.addToWorld(m_world);
 
         // Set the base Z of mesh objects at ground level instead of at the object center
         float baseZ = 0;
@@ -532,7 +567,7 @@ void Scene::createBridgeObjects()
 
                 bridge->translate(MCVector3dF(i * w + w / 2, j * h + h / 2, 0));
                 bridge->rotate(tile->rotation());
-                bridge->addToWorld();
+                bridge->addToWorld(m_world);
                 m_bridges.push_back(bridge);
             }
         }
@@ -600,6 +635,8 @@ void Scene::getSplitPositions(MCGLScene::SplitType & p0, MCGLScene::SplitType &
 
 void Scene::renderTrack()
 {
+    MC_PROFILE_ZONE("Scene::renderTrack");
+
     switch (m_stateMachine.state())
     {
     case StateMachine::State::GameTransitionIn:
@@ -607,7 +644,10 @@ void Scene::renderTrack()
     case StateMachine::State::DoStartlights:
     case StateMachine::State::Play:
     {
-        MCGLScene & glScene = MCWorld::instance().renderer().glScene();
+        MCGLScene & glScene = m_world.renderer().glScene();
+
+        // The count covers all cameras of the frame
+        m_activeTrack->resetDrawCallCount();
 
         if (m_game.hasTwoHumanPlayers())
         {
@@ -636,7 +676,9 @@ void Scene::renderTrack()
 
 void Scene::renderMenu()
 {
-    MCGLScene & glScene = MCWorld::instance().renderer().glScene();
+    MC_PROFILE_ZONE("Scene::renderMenu");
+
+    MCGLScene & glScene = m_world.renderer().glScene();
 
     switch (m_stateMachine.state())
     {
@@ -665,6 +707,8 @@ void Scene::renderMenu()
 
 void Scene::renderCommonHUD()
 {
+    MC_PROFILE_ZONE("Scene::renderCommonHUD");
+
     switch (m_stateMachine.state())
     {
     case StateMachine::State::GameTransitionIn:
@@ -673,7 +717,7 @@ void Scene::renderCommonHUD()
     case StateMachine::State::Play:
     {
         // Setup for common scene
-        MCGLScene & glScene = MCWorld::instance().renderer().glScene();
+        MCGLScene & glScene = m_world.renderer().glScene();
         glScene.setSplitType(MCGLScene::ShowFullScreen);
 
         if (m_race.checkeredFlagEnabled() && !m_game.hasTwoHumanPlayers())
@@ -683,6 +727,16 @@ void Scene::renderCommonHUD()
 
         m_startlightsOverlay->render();
         m_messageOverlay->render();
+
+        if (MCProfiler::isEnabled())
+        {
+            m_profilerOverlay->setDrawCallCount(m_world.renderer().drawCallCount());
+            m_profilerOverlay->setTrackDrawCallCount(m_activeTrack->drawCallCount());
+            m_profilerOverlay->setRedundantGLCallCount(MCGLState::redundantCallCount());
+            MCGLState::resetRedundantCallCount();
+            m_profilerOverlay->render();
+        }
+
         break;
     }
     default:
@@ -692,6 +746,8 @@ void Scene::renderCommonHUD()
 
 void Scene::renderHUD()
 {
+    MC_PROFILE_ZONE("Scene::renderHUD");
+
     switch (m_stateMachine.state())
     {
     case StateMachine::State::GameTransitionIn:
@@ -699,7 +755,7 @@ void Scene::renderHUD()
     case StateMachine::State::DoStartlights:
     case StateMachine::State::Play:
     {
-        MCGLScene & glScene = MCWorld::instance().renderer().glScene();
+        MCGLScene & glScene = m_world.renderer().glScene();
 
         if (m_game.hasTwoHumanPlayers())
         {
@@ -734,6 +790,8 @@ void Scene::renderHUD()
 
 void Scene::renderWorld(MCRenderGroup renderGroup, bool prepareRendering)
 {
+    MC_PROFILE_ZONE("Scene::renderWorld");
+
     switch (m_stateMachine.state())
     {
     case StateMachine::State::GameTransitionIn:
@@ -741,7 +799,13 @@ void Scene::renderWorld(MCRenderGroup renderGroup, bool prepareRendering)
     case StateMachine::State::DoStartlights:
     case StateMachine::State::Play:
     {
-        MCGLScene & glScene = MCWorld::instance().renderer().glScene();
+        MCGLScene & glScene = m_world.renderer().glScene();
+
+        if (prepareRendering)
+        {
+            // The count covers all cameras of the frame
+            m_world.renderer().resetDrawCallCount();
+        }
 
         if (m_game.hasTwoHumanPlayers())
         {
@@ -785,6 +849,7 @@ Scene::~Scene()
     delete m_intro;
     delete m_menuManager;
     delete m_messageOverlay;
+    delete m_profilerOverlay;
     delete m_particleFactory;
     delete m_startlights;
     delete m_startlightsOverlay;
@@ -41,6 +41,7 @@ class MCSurface;
 class MCWorld;
 class MessageOverlay;
 class ParticleFactory;
+class ProfilerOverlay;
 class Renderer;
 class Startlights;
 class StartlightsOverlay;
@@ -61,6 +62,8 @@ public:
 
     static const int NUM_CARS = 12;
 
+    static constexpr float METERS_PER_UNIT = 0.05f;
+
     //! Constructor.
     Scene(Game & game, StateMachine & stateMachine, Renderer & renderer, MCWorld & world);
 
@@ -84,6 +87,10 @@ public:
     //! Update HUD overlays.
     void updateOverlays();
 
+    /*! Set the point between the two latest updates that is rendered.
+     *  \param alpha Blend factor [0.0, 1.0]. \see MCWorld::setRenderInterpolation(). */
+    void setRenderInterpolation(float alpha);
+
     //! Set the active race track.
     void setActiveTrack(Track & activeTrack);
 
@@ -141,6 +148,10 @@ private:
 
     void getSplitPositions(MCGLScene::SplitType & p0, MCGLScene::SplitType & p1);
 
+    bool isRaceRunning() const;
+
+    void placeCamera(MCCamera & camera, float offset, MCVector2dF location, float angle);
+
     void setWorldDimensions();
 
     void updateAi();
@@ -163,6 +174,8 @@ private:
 
     MessageOverlay * m_messageOverlay;
 
+    ProfilerOverlay * m_profilerOverlay;
+
     Race m_race;
 
     Track * m_activeTrack;
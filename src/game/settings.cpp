@@ -14,9 +14,9 @@
 // along with Dust Racing 2D. If not, see <http://www.gnu.org/licenses/>.
 
 #include "settings.hpp"
-#include "track.hpp"
 #include "trackdata.hpp"
 #include <QSettings>
+#include <QStringList>
 #include <cassert>
 
 Settings * Settings::m_instance = nullptr;
@@ -27,14 +27,71 @@ static const char * SETTINGS_GROUP_RACE   = "RaceRecords";
 static const char * SETTINGS_GROUP_POS    = "BestPositions";
 static const char * SETTINGS_GROUP_UNLOCK = "UnlockedTracks";
 
-static QString combine(const Track & track, int lapCount, DifficultyProfile::Difficulty difficulty)
+static std::string recordKey(const char * group, const QString & key)
 {
-    return (QString("%1_%2_%3").arg(track.trackData().name()).arg(lapCount)).arg(static_cast<int>(difficulty));
+    return (QString(group) + "/" + key).toStdString();
 }
 
-static QString combineBase64(const Track & track, int lapCount, DifficultyProfile::Difficulty difficulty)
+namespace {
+//! Reads and writes the records with QSettings.
+class RecordBackend : public MCRecordStore::Backend
 {
-    return combine(track, lapCount, difficulty).toLatin1().toBase64();
+public:
+
+    MCRecordStore::RecordMap read() override
+    {
+        MCRecordStore::RecordMap records;
+        QSettings settings;
+        for (const char * group : {SETTINGS_GROUP_LAP, SETTINGS_GROUP_RACE, SETTINGS_GROUP_POS, SETTINGS_GROUP_UNLOCK})
+        {
+            const bool isBool = group == SETTINGS_GROUP_UNLOCK;
+
+            settings.beginGroup(group);
+            const QStringList keys = settings.allKeys();
+            for (auto && key : keys)
+            {
+                const QVariant value = settings.value(key);
+                records[recordKey(group, key)] = isBool ? value.toBool() : value.toInt();
+            }
+            settings.endGroup();
+        }
+
+        return records;
+    }
+
+    void write(const MCRecordStore::ChangeList & changes) override
+    {
+        QSettings settings;
+        for (auto && change : changes)
+        {
+            const QString key = QString::fromStdString(change.key);
+            if (change.removed)
+            {
+                settings.remove(key);
+            }
+            else if (key.startsWith(QString(SETTINGS_GROUP_UNLOCK) + "/"))
+            {
+                settings.setValue(key, change.value != 0);
+            }
+            else
+            {
+                settings.setValue(key, change.value);
+            }
+        }
+
+        settings.sync();
+    }
+};
+}
+
+static QString combine(const TrackData & trackData, int lapCount, DifficultyProfile::Difficulty difficulty)
+{
+    return (QString("%1_%2_%3").arg(trackData.name()).arg(lapCount)).arg(static_cast<int>(difficulty));
+}
+
+static QString combineBase64(const TrackData & trackData, int lapCount, DifficultyProfile::Difficulty difficulty)
+{
+    return combine(trackData, lapCount, difficulty).toLatin1().toBase64();
 }
 
 QString Settings::difficultyKey()
@@ -52,6 +109,11 @@ QString Settings::lapCountKey()
     return "lapCount";
 }
 
+QString Settings::shadowBufferDivisorKey()
+{
+    return "shadowBufferDivisor";
+}
+
 QString Settings::soundsKey()
 {
     return "sounds";
@@ -63,6 +125,7 @@ QString Settings::vsyncKey()
 }
 
 Settings::Settings()
+    : m_records(std::unique_ptr<MCRecordStore::Backend>(new RecordBackend))
 {
     assert(!Settings::m_instance);
     Settings::m_instance = this;
@@ -71,6 +134,13 @@ Settings::Settings()
     m_actionToStringMap[InputHandler::Action::Down]  = "IA_DOWN";
     m_actionToStringMap[InputHandler::Action::Left]  = "IA_LEFT";
     m_actionToStringMap[InputHandler::Action::Right] = "IA_RIGHT";
+
+    m_records.load();
+}
+
+Settings::~Settings()
+{
+    Settings::m_instance = nullptr;
 }
 
 Settings & Settings::instance()
@@ -79,126 +149,79 @@ Settings & Settings::instance()
     return *Settings::m_instance;
 }
 
-void Settings::saveLapRecord(const Track & track, int msecs)
+void Settings::saveLapRecord(const TrackData & trackData, int msecs)
 {
-    QSettings settings;
-
-    settings.beginGroup(SETTINGS_GROUP_LAP);
-    settings.setValue(track.trackData().name(), msecs);
-    settings.endGroup();
+    m_records.setValue(recordKey(SETTINGS_GROUP_LAP, trackData.name()), msecs);
 }
 
-int Settings::loadLapRecord(const Track & track) const
+int Settings::loadLapRecord(const TrackData & trackData) const
 {
-    QSettings settings;
-
-    settings.beginGroup(SETTINGS_GROUP_LAP);
-    const int time = settings.value(track.trackData().name(), -1).toInt();
-    settings.endGroup();
-
-    return time;
+    return m_records.value(recordKey(SETTINGS_GROUP_LAP, trackData.name()), -1);
 }
 
 void Settings::resetLapRecords()
 {
-    QSettings settings;
-
-    settings.beginGroup(SETTINGS_GROUP_LAP);
-    settings.remove("");
-    settings.endGroup();
+    m_records.remove(recordKey(SETTINGS_GROUP_LAP, ""));
+    m_records.flush();
 }
 
-void Settings::saveRaceRecord(const Track & track, int msecs, int lapCount, DifficultyProfile::Difficulty difficulty)
+void Settings::saveRaceRecord(const TrackData & trackData, int msecs, int lapCount, DifficultyProfile::Difficulty difficulty)
 {
-    QSettings settings;
-    const QString trackNameAndLapCount = combine(track, lapCount, difficulty);
-
-    settings.beginGroup(SETTINGS_GROUP_RACE);
-    settings.setValue(trackNameAndLapCount, msecs);
-    settings.endGroup();
+    m_records.setValue(recordKey(SETTINGS_GROUP_RACE, combine(trackData, lapCount, difficulty)), msecs);
 }
 
-int Settings::loadRaceRecord(const Track & track, int lapCount, DifficultyProfile::Difficulty difficulty) const
+int Settings::loadRaceRecord(const TrackData & trackData, int lapCount, DifficultyProfile::Difficulty difficulty) const
 {
-    QSettings settings;
-    const QString trackNameAndLapCount = combine(track, lapCount, difficulty);
-
-    settings.beginGroup(SETTINGS_GROUP_RACE);
-    const int time = settings.value(trackNameAndLapCount, -1).toInt();
-    settings.endGroup();
-
-    return time;
+    return m_records.value(recordKey(SETTINGS_GROUP_RACE, combine(trackData, lapCount, difficulty)), -1);
 }
 
 void Settings::resetRaceRecords()
 {
-    QSettings settings;
-
-    settings.beginGroup(SETTINGS_GROUP_RACE);
-    settings.remove("");
-    settings.endGroup();
+    m_records.remove(recordKey(SETTINGS_GROUP_RACE, ""));
+    m_records.flush();
 }
 
-void Settings::saveBestPos(const Track & track, int pos, int lapCount, DifficultyProfile::Difficulty difficulty)
+void Settings::saveBestPos(const TrackData & trackData, int pos, int lapCount, DifficultyProfile::Difficulty difficulty)
 {
-    QSettings settings;
-    const QString trackNameAndLapCount = combine(track, lapCount, difficulty);
-
-    settings.beginGroup(SETTINGS_GROUP_POS);
-    settings.setValue(trackNameAndLapCount, pos);
-    settings.endGroup();
+    m_records.setValue(recordKey(SETTINGS_GROUP_POS, combine(trackData, lapCount, difficulty)), pos);
 }
 
-int Settings::loadBestPos(const Track & track, int lapCount, DifficultyProfile::Difficulty difficulty) const
+int Settings::loadBestPos(const TrackData & trackData, int lapCount, DifficultyProfile::Difficulty difficulty) const
 {
-    QSettings settings;
-    const QString trackNameAndLapCount = combine(track, lapCount, difficulty);
-
-    settings.beginGroup(SETTINGS_GROUP_POS);
-    const int pos = settings.value(trackNameAndLapCount, -1).toInt();
-    settings.endGroup();
-
-    return pos;
+    return m_records.value(recordKey(SETTINGS_GROUP_POS, combine(trackData, lapCount, difficulty)), -1);
 }
 
 void Settings::resetBestPos()
 {
-    QSettings settings;
-
-    settings.beginGroup(SETTINGS_GROUP_POS);
-    settings.remove("");
-    settings.endGroup();
+    m_records.remove(recordKey(SETTINGS_GROUP_POS, ""));
+    m_records.flush();
 }
 
-void Settings::saveTrackUnlockStatus(const Track & track, int lapCount, DifficultyProfile::Difficulty difficulty)
+void Settings::saveTrackUnlockStatus(const TrackData & trackData, int lapCount, DifficultyProfile::Difficulty difficulty)
 {
-    QSettings settings;
-    const QString trackNameAndLapCount = combineBase64(track, lapCount, difficulty);
-
-    settings.beginGroup(SETTINGS_GROUP_UNLOCK);
-    settings.setValue(trackNameAndLapCount, !track.trackData().isLocked());
-    settings.endGroup();
+    m_records.setValue(
+        recordKey(SETTINGS_GROUP_UNLOCK, combineBase64(trackData, lapCount, difficulty)), !trackData.isLocked());
 }
 
-bool Settings::loadTrackUnlockStatus(const Track & track, int lapCount, DifficultyProfile::Difficulty difficulty) const
+bool Settings::loadTrackUnlockStatus(const TrackData & trackData, int lapCount, DifficultyProfile::Difficulty difficulty) const
 {
-    QSettings settings;
-    const QString trackNameAndLapCount = combineBase64(track, lapCount, difficulty);
-
-    settings.beginGroup(SETTINGS_GROUP_UNLOCK);
-    const bool status = settings.value(trackNameAndLapCount, 0).toBool();
-    settings.endGroup();
-
-    return status;
+    return m_records.value(recordKey(SETTINGS_GROUP_UNLOCK, combineBase64(trackData, lapCount, difficulty)), 0);
 }
 
 void Settings::resetTrackUnlockStatuses()
 {
-    QSettings settings;
+    m_records.remove(recordKey(SETTINGS_GROUP_UNLOCK, ""));
+    m_records.flush();
+}
 
-    settings.beginGroup(SETTINGS_GROUP_UNLOCK);
-    settings.remove("");
-    settings.endGroup();
+void Settings::flushRecords()
+{
+    m_records.flush();
+}
+
+size_t Settings::unflushedRecordCount() const
+{
+    return m_records.dirtyCount();
 }
 
 void Settings::saveResolution(int hRes, int vRes, bool fullScreen)
@@ -19,12 +19,18 @@
 #include "difficultyprofile.hpp"
 #include "inputhandler.hpp"
 
+#include <MCRecordStore>
+
 #include <map>
 #include <QString>
 
-class Track;
+class TrackData;
 
-//! Singleton settings class that wraps the use of QSettings.
+/*! Singleton settings class that wraps the use of QSettings.
+ *
+ *  Lap records, race records, best positions and unlock statuses are loaded
+ *  once on construction and kept in memory. Saving them doesn't touch the disk:
+ *  the changes are written in the background by flushRecords() and on destruction. */
 class Settings
 {
 public:
@@ -32,24 +38,33 @@ public:
     //! Constructor.
     Settings();
 
+    //! Destructor. Writes the unsaved records.
+    ~Settings();
+
     static Settings & instance();
 
-    void saveLapRecord(const Track & track, int msecs);
-    int loadLapRecord(const Track & track) const;
+    void saveLapRecord(const TrackData & trackData, int msecs);
+    int loadLapRecord(const TrackData & trackData) const;
     void resetLapRecords();
 
-    void saveRaceRecord(const Track & track, int msecs, int lapCount, DifficultyProfile::Difficulty difficulty);
-    int loadRaceRecord(const Track & track, int lapCount, DifficultyProfile::Difficulty difficulty) const;
+    void saveRaceRecord(const TrackData & trackData, int msecs, int lapCount, DifficultyProfile::Difficulty difficulty);
+    int loadRaceRecord(const TrackData & trackData, int lapCount, DifficultyProfile::Difficulty difficulty) const;
     void resetRaceRecords();
 
-    void saveBestPos(const Track & track, int pos, int lapCount, DifficultyProfile::Difficulty difficulty);
-    int loadBestPos(const Track & track, int lapCount, DifficultyProfile::Difficulty difficulty) const;
+    void saveBestPos(const TrackData & trackData, int pos, int lapCount, DifficultyProfile::Difficulty difficulty);
+    int loadBestPos(const TrackData & trackData, int lapCount, DifficultyProfile::Difficulty difficulty) const;
     void resetBestPos();
 
-    void saveTrackUnlockStatus(const Track & track, int lapCount, DifficultyProfile::Difficulty difficulty);
-    bool loadTrackUnlockStatus(const Track & track, int lapCount, DifficultyProfile::Difficulty difficulty) const;
+    void saveTrackUnlockStatus(const TrackData & trackData, int lapCount, DifficultyProfile::Difficulty difficulty);
+    bool loadTrackUnlockStatus(const TrackData & trackData, int lapCount, DifficultyProfile::Difficulty difficulty) const;
     void resetTrackUnlockStatuses();
 
+    //! Start writing the changed records in the background. Call at safe points, e.g. when a race ends.
+    void flushRecords();
+
+    //! \return Number of changed records not yet handed over by flushRecords().
+    size_t unflushedRecordCount() const;
+
     void saveResolution(int hRes, int vRes, bool fullScreen);
     void loadResolution(int & hRes, int & vRes, bool & fullScreen);
 
@@ -68,6 +83,7 @@ public:
     static QString difficultyKey();
     static QString fpsKey();
     static QString lapCountKey();
+    static QString shadowBufferDivisorKey();
     static QString soundsKey();
     static QString vsyncKey();
 
@@ -77,6 +93,7 @@ private:
 
     static Settings * m_instance;
     std::map<InputHandler::Action, QString> m_actionToStringMap;
+    MCRecordStore m_records;
 };
 
 #endif // SETTINGS_HPP
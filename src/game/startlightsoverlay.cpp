@@ -18,6 +18,7 @@
 
 #include <MCAssetManager>
 #include <MCGLColor>
+#include <MCGLState>
 #include <MCSurface>
 
 StartlightsOverlay::StartlightsOverlay(Startlights & model)
@@ -127,7 +128,7 @@ void StartlightsOverlay::setDimensions(int width, int height)
 
 void StartlightsOverlay::render()
 {
-    glDisable(GL_DEPTH_TEST);
+    MCGLState::setDepthTest(false);
 
     switch (m_model.state())
     {
@@ -17,6 +17,7 @@
 #include "inputhandler.hpp"
 
 #include <MenuManager>
+#include <MCProfiler>
 #include <cassert>
 
 StateMachine * StateMachine::m_instance = nullptr;
@@ -66,6 +67,8 @@ void StateMachine::quit()
 
 bool StateMachine::update()
 {
+    MC_PROFILE_ZONE("StateMachine::update");
+
     // Run the state function on transition
     if (m_state == State::Init || m_oldState != m_state)
     {
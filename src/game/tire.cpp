@@ -21,6 +21,7 @@
 #include <MCPhysicsComponent>
 #include <MCSurface>
 #include <MCTrigonom>
+#include <MCWorld>
 
 Tire::Tire(Car & car, float friction, float offTrackFriction)
     : MCObject(MCAssetManager::surfaceManager().surface("frontTire"), "Tire")
@@ -45,7 +46,9 @@ void Tire::setSpinCoeff(float spinCoeff)
 
 void Tire::onStepTime(int)
 {
-    if (physicsComponent().velocity().lengthFast() > 0)
+    // The car may have been removed from its world already
+    const MCWorld * carWorld = m_car.world();
+    if (carWorld && physicsComponent().velocity().lengthFast() > 0)
     {
         const float tireNormalAngle = angle() + 90;
         const MCVector2dF tire(
@@ -55,7 +58,7 @@ void Tire::onStepTime(int)
         MCVector2dF impulse =
             MCVector2dF::projection(v, tire) *
                 (m_isOffTrack ? m_offTrackFriction : m_friction) * m_spinCoeff *
-                    -MCWorld::instance().gravity().k() * parent().physicsComponent().mass();
+                    -carWorld->gravity().k() * parent().physicsComponent().mass();
         impulse.clampFast(parent().physicsComponent().mass() * 7.0f * m_car.tireWearFactor());
         parent().physicsComponent().addForce(-impulse, location());
 
@@ -63,7 +66,7 @@ void Tire::onStepTime(int)
         {
             MCVector2dF impulse =
                 v * 0.5f * (m_isOffTrack ? m_offTrackFriction : m_friction) *
-                    -MCWorld::instance().gravity().k() * parent().physicsComponent().mass() * m_car.tireWearFactor();
+                    -carWorld->gravity().k() * parent().physicsComponent().mass() * m_car.tireWearFactor();
             parent().physicsComponent().addForce(-impulse, location());
         }
     }
@@ -18,12 +18,12 @@
 #include "renderer.hpp"
 #include "scene.hpp"
 #include "trackdata.hpp"
+#include "trackgeometry.hpp"
 #include "tracktile.hpp"
 #include "map.hpp"
 
 #include <MCAssetManager>
 #include <MCCamera>
-#include <MCGLShaderProgram>
 #include <MCSurface>
 
 #include <cassert>
@@ -116,6 +116,11 @@ void Track::calculateVisibleIndices(const MCBBox<int> & r,
 
 void Track::render(MCCamera * camera)
 {
+    if (!m_geometry)
+    {
+        m_geometry.reset(new TrackGeometry(m_trackData->map(), m_asphalt));
+    }
+
     // Get the Camera window
     MCBBox<float> cameraBox(camera->bbox());
 
@@ -123,121 +128,20 @@ void Track::render(MCCamera * camera)
     unsigned int i2, j2, i0, j0;
     calculateVisibleIndices(cameraBox, i0, i2, j0, j2);
 
-    MCGLShaderProgramPtr prog2d = Renderer::instance().program("tile2d");
-    prog2d->bind();
-    renderAsphalt(camera, prog2d, i0, i2, j0, j2);
-    prog2d->release();
-
-    MCGLShaderProgramPtr prog3d = Renderer::instance().program("tile3d");
-    prog3d->bind();
-    renderTiles(camera, prog3d, i0, i2, j0, j2);
-    prog3d->release();
+    m_geometry->render(
+        camera, Renderer::instance().program("tile2d"), Renderer::instance().program("tile3d"), i0, i2, j0, j2);
 }
 
-void Track::renderAsphalt(
-    MCCamera * camera, MCGLShaderProgramPtr prog, unsigned int i0, unsigned int i2, unsigned int j0, unsigned int j2)
+unsigned int Track::drawCallCount() const
 {
-    float x1, y1; // Coordinates mapped to camera
-
-    // Bind common geometry and textures for all asphalt tiles.
-    m_asphalt.setShaderProgram(prog);
-    m_asphalt.bind();
-
-    const MapBase & map = m_trackData->map();
-
-    // Loop through the visible tile matrix and draw the tiles
-    int initX = i0 * TrackTile::TILE_W;
-    int x;
-    int y = j0 * TrackTile::TILE_H;
-    for (unsigned int j = j0; j <= j2; j++)
-    {
-        x = initX;
-        for (unsigned int i = i0; i <= i2; i++)
-        {
-            auto tile = static_pointer_cast<TrackTile>(map.getTile(i, j));
-
-            if (tile->hasAsphalt())
-            {
-                x1 = x;
-                y1 = y;
-                camera->mapToCamera(x1, y1);
-                prog->setTransform(0, MCVector3dF(x1 + TrackTile::TILE_W / 2, y1 + TrackTile::TILE_H / 2, 0));
-                m_asphalt.render();
-            }
-
-            x += TrackTile::TILE_W;
-        }
-
-        y += TrackTile::TILE_H;
-    }
+    return m_geometry ? m_geometry->drawCallCount() : 0;
 }
 
-void Track::renderTiles(
-    MCCamera * camera, MCGLShaderProgramPtr prog, unsigned int i0, unsigned int i2, unsigned int j0, unsigned int j2)
+void Track::resetDrawCallCount()
 {
-    float x1, y1; // Coordinates mapped to camera
-
-    struct SortedTile
-    {
-        TrackTile * tile;
-        float x1, y1;
-    };
-
-    // The tiles are sorted with respect to their surface in order
-    // to minimize GPU context switches.
-    std::map<MCSurface *, std::vector<SortedTile> > sortedTiles;
-
-    const MapBase & map = m_trackData->map();
-
-    // Loop through the visible tile matrix and sort the tiles.
-    int initX = i0 * TrackTile::TILE_W;
-    int x;
-    int y = j0 * TrackTile::TILE_H;
-    for (unsigned int j = j0; j <= j2; j++)
+    if (m_geometry)
     {
-        x = initX;
-        for (unsigned int i = i0; i <= i2; i++)
-        {
-            auto tile = static_pointer_cast<TrackTile>(map.getTile(i, j));
-            if (MCSurface * surface = tile->surface())
-            {
-                x1 = x;
-                y1 = y;
-                camera->mapToCamera(x1, y1);
-
-                SortedTile sortedTile;
-                sortedTile.tile = tile.get();
-                sortedTile.x1 = x1;
-                sortedTile.y1 = y1;
-                sortedTiles[surface].push_back(sortedTile);
-            }
-
-            x += TrackTile::TILE_W;
-        }
-
-        y += TrackTile::TILE_H;
-    }
-
-    // Render the tiles.
-    auto iter = sortedTiles.begin();
-    while (iter != sortedTiles.end())
-    {
-        MCSurface * surface = iter->first;
-        surface->setShaderProgram(prog);
-        surface->bind();
-
-        for (unsigned int i = 0; i < iter->second.size(); i++)
-        {
-            x1 = iter->second[i].x1;
-            y1 = iter->second[i].y1;
-
-            const TrackTile * tile = iter->second[i].tile;
-            prog->setTransform(tile->rotation(), MCVector3dF(x1 + TrackTile::TILE_W / 2, y1 + TrackTile::TILE_H / 2, 0));
-            prog->setScale(TrackTile::TILE_W / surface->width(), TrackTile::TILE_H / surface->height(), 1.0f);
-            surface->render();
-        }
-
-        iter++;
+        m_geometry->resetDrawCallCount();
     }
 }
 
@@ -22,8 +22,10 @@
 #include <MCBBox>
 #include <MCGLShaderProgram>
 
+#include <memory>
 
 class TrackData;
+class TrackGeometry;
 class MCCamera;
 class MCSurface;
 
@@ -40,9 +42,16 @@ public:
     //! Destructor.
     virtual ~Track();
 
-    //! Render as seen through the given camera window.
+    /*! Render as seen through the given camera window.
+     *  The tile geometry is baked into vertex buffers on the first call. */
     void render(MCCamera * camera);
 
+    //! \return Number of draw calls made by render() since the latest resetDrawCallCount().
+    unsigned int drawCallCount() const;
+
+    //! Reset the draw call count. Call once per frame, before rendering the first camera.
+    void resetDrawCallCount();
+
     //! Return width in length units.
     unsigned int width() const;
 
@@ -75,12 +84,6 @@ private:
     void calculateVisibleIndices(const MCBBox<int> & r,
         unsigned int & i0, unsigned int & i2, unsigned int & j0, unsigned int & j2);
 
-    void renderAsphalt(
-        MCCamera * camera, MCGLShaderProgramPtr prog, unsigned int i0, unsigned int i2, unsigned int j0, unsigned int j2);
-
-    void renderTiles(
-        MCCamera * camera, MCGLShaderProgramPtr prog, unsigned int i0, unsigned int i2, unsigned int j0, unsigned int j2);
-
 
     TrackData * m_trackData;
 
@@ -88,6 +91,8 @@ private:
 
     MCSurface & m_asphalt;
 
+    std::unique_ptr<TrackGeometry> m_geometry;
+
     Track * m_next;
 
     Track * m_prev;
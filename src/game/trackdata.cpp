@@ -21,6 +21,8 @@ TrackData::TrackData(QString name, bool isUserTrack, unsigned int cols, unsigned
 , m_map(cols, rows)
 , m_route()
 , m_isLocked(false)
+, m_isLoaded(false)
+, m_routeLength(0)
 {}
 
 QString TrackData::fileName() const
@@ -73,6 +75,26 @@ void TrackData::setIsLocked(bool locked)
     m_isLocked = locked;
 }
 
+bool TrackData::isLoaded() const
+{
+    return m_isLoaded;
+}
+
+void TrackData::setIsLoaded(bool loaded)
+{
+    m_isLoaded = loaded;
+}
+
+unsigned int TrackData::routeLength() const
+{
+    return m_routeLength;
+}
+
+void TrackData::setRouteLength(unsigned int routeLength)
+{
+    m_routeLength = routeLength;
+}
+
 TrackData::~TrackData()
 {
 }
@@ -65,6 +65,18 @@ public:
     //! Set the locked state.
     void setIsLocked(bool locked);
 
+    //! Return true if the objects and the route have been loaded, i.e. the track can be raced.
+    bool isLoaded() const;
+
+    //! Set the loaded state.
+    void setIsLoaded(bool loaded);
+
+    //! Get route length in length units. Available also before the route is loaded.
+    unsigned int routeLength() const;
+
+    //! Set route length.
+    void setRouteLength(unsigned int routeLength);
+
 private:
 
     QString m_fileName;
@@ -72,6 +84,8 @@ private:
     Objects m_objects;
     Route   m_route;
     bool    m_isLocked;
+    bool    m_isLoaded;
+    unsigned int m_routeLength;
 };
 
 #endif // TRACKDATA_HPP
@@ -0,0 +1,216 @@
+// This file is part of Dust Racing 2D.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// Dust Racing 2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Dust Racing 2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Dust Racing 2D. If not, see <http://www.gnu.org/licenses/>.
+
+#include "trackgeometry.hpp"
+
+#include "tracktile.hpp"
+#include "../common/mapbase.hpp"
+
+#include <MCCamera>
+#include <MCMathUtil>
+#include <MCSurface>
+
+#include <algorithm>
+#include <map>
+#include <memory>
+
+using std::static_pointer_cast;
+
+TrackGeometry::TrackGeometry(const MapBase & map, MCSurface & asphalt)
+: MCGLObjectBase("trackGeometry")
+, m_chunkCols((map.cols() + CHUNK_SIZE - 1) / CHUNK_SIZE)
+, m_chunkRows((map.rows() + CHUNK_SIZE - 1) / CHUNK_SIZE)
+, m_drawCallCount(0)
+{
+    const unsigned int chunkCount = m_chunkCols * m_chunkRows;
+
+    // Sort the tiles by surface and chunk. The asphalt is the first group so that
+    // it gets drawn under the tiles like before.
+    struct SortedTile
+    {
+        TrackTile * tile;
+        unsigned int i, j;
+    };
+
+    std::vector<std::vector<std::vector<SortedTile>>> groupTiles;
+    std::map<MCSurface *, size_t> groupIndices;
+
+    m_groups.push_back({&asphalt, true, std::vector<GLint>()});
+    groupTiles.push_back(std::vector<std::vector<SortedTile>>(chunkCount));
+
+    const auto tileGroupIndex = [&] (MCSurface * surface) {
+        auto iter = groupIndices.find(surface);
+        if (iter == groupIndices.end())
+        {
+            m_groups.push_back({surface, false, std::vector<GLint>()});
+            groupTiles.push_back(std::vector<std::vector<SortedTile>>(chunkCount));
+            iter = groupIndices.insert({surface, m_groups.size() - 1}).first;
+        }
+        return iter->second;
+    };
+
+    for (unsigned int j = 0; j < map.rows(); j++)
+    {
+        for (unsigned int i = 0; i < map.cols(); i++)
+        {
+            auto tile = static_pointer_cast<TrackTile>(map.getTile(i, j));
+            if (!tile)
+            {
+                continue;
+            }
+
+            const unsigned int chunk = (j / CHUNK_SIZE) * m_chunkCols + i / CHUNK_SIZE;
+            if (tile->hasAsphalt())
+            {
+                groupTiles[0][chunk].push_back({tile.get(), i, j});
+            }
+
+            if (MCSurface * surface = tile->surface())
+            {
+                groupTiles[tileGroupIndex(surface)][chunk].push_back({tile.get(), i, j});
+            }
+        }
+    }
+
+    // Transform the vertices like the tile shader would do with the model matrix
+    VertexVector vertices;
+    VertexVector normals;
+    TexCoordVector texCoords;
+    ColorVector colors;
+
+    for (size_t groupIndex = 0; groupIndex < m_groups.size(); groupIndex++)
+    {
+        Group & group = m_groups[groupIndex];
+        MCSurface & surface = *group.surface;
+
+        // The asphalt is drawn 1:1, the tiles are scaled to the tile size
+        const float scaleX = group.isAsphalt ? 1.0f : TrackTile::TILE_W / surface.width();
+        const float scaleY = group.isAsphalt ? 1.0f : TrackTile::TILE_H / surface.height();
+
+        group.chunkOffsets.reserve(chunkCount + 1);
+        for (auto && chunkTiles : groupTiles[groupIndex])
+        {
+            group.chunkOffsets.push_back(static_cast<GLint>(vertices.size()));
+
+            for (auto && sortedTile : chunkTiles)
+            {
+                const float x = sortedTile.i * TrackTile::TILE_W + TrackTile::TILE_W / 2;
+                const float y = sortedTile.j * TrackTile::TILE_H + TrackTile::TILE_H / 2;
+                const float angle = group.isAsphalt ? 0 : sortedTile.tile->rotation();
+
+                for (int v = 0; v < surface.vertexCount(); v++)
+                {
+                    const MCGLVertex & vertex = surface.vertex(v);
+                    const float scaledX = vertex.x() * scaleX;
+                    const float scaledY = vertex.y() * scaleY;
+                    vertices.push_back(
+                        MCGLVertex(
+                            x + MCMathUtil::rotatedX(scaledX, scaledY, angle),
+                            y + MCMathUtil::rotatedY(scaledX, scaledY, angle),
+                            vertex.z()));
+
+                    // The tile shader doesn't rotate the normals either
+                    normals.push_back(surface.normal(v));
+                    texCoords.push_back(surface.texCoord(v));
+                    colors.push_back(static_cast<MCGLObjectBase &>(surface).color(v));
+                }
+            }
+        }
+
+        group.chunkOffsets.push_back(static_cast<GLint>(vertices.size()));
+    }
+
+    const int VERTEX_DATA_SIZE = sizeof(MCGLVertex) * vertices.size();
+    const int NORMAL_DATA_SIZE = sizeof(MCGLVertex) * normals.size();
+    const int TEXCOORD_DATA_SIZE = sizeof(MCGLTexCoord) * texCoords.size();
+    const int COLOR_DATA_SIZE = sizeof(MCGLColor) * colors.size();
+    const int TOTAL_DATA_SIZE = VERTEX_DATA_SIZE + NORMAL_DATA_SIZE + TEXCOORD_DATA_SIZE + COLOR_DATA_SIZE;
+
+    initBufferData(TOTAL_DATA_SIZE, GL_STATIC_DRAW);
+
+    addBufferSubData(
+        MCGLShaderProgram::VAL_Vertex, VERTEX_DATA_SIZE, reinterpret_cast<const GLfloat *>(vertices.data()));
+    addBufferSubData(
+        MCGLShaderProgram::VAL_Normal, NORMAL_DATA_SIZE, reinterpret_cast<const GLfloat *>(normals.data()));
+    addBufferSubData(
+        MCGLShaderProgram::VAL_TexCoords, TEXCOORD_DATA_SIZE, reinterpret_cast<const GLfloat *>(texCoords.data()));
+    addBufferSubData(
+        MCGLShaderProgram::VAL_Color, COLOR_DATA_SIZE, reinterpret_cast<const GLfloat *>(colors.data()));
+
+    finishBufferData();
+}
+
+void TrackGeometry::render(MCCamera * camera, MCGLShaderProgramPtr asphaltProgram, MCGLShaderProgramPtr tileProgram,
+    unsigned int i0, unsigned int i2, unsigned int j0, unsigned int j2)
+{
+    if (!m_chunkCols || !m_chunkRows)
+    {
+        return;
+    }
+
+    const unsigned int cx0 = i0 / CHUNK_SIZE;
+    const unsigned int cx2 = std::min(i2 / CHUNK_SIZE, m_chunkCols - 1);
+    const unsigned int cy0 = j0 / CHUNK_SIZE;
+    const unsigned int cy2 = std::min(j2 / CHUNK_SIZE, m_chunkRows - 1);
+
+    // The vertices are in world coordinates, so only the camera translation is needed
+    float x = 0;
+    float y = 0;
+    camera->mapToCamera(x, y);
+
+    for (auto && group : m_groups)
+    {
+        MCGLShaderProgramPtr program = group.isAsphalt ? asphaltProgram : tileProgram;
+        setShaderProgram(program);
+        setMaterial(group.surface->material());
+
+        bool isBound = false;
+        for (unsigned int cy = cy0; cy <= cy2; cy++)
+        {
+            const GLint first = group.chunkOffsets[cy * m_chunkCols + cx0];
+            const GLint last = group.chunkOffsets[cy * m_chunkCols + cx2 + 1];
+            if (last > first)
+            {
+                if (!isBound)
+                {
+                    bind();
+                    program->setTransform(0, MCVector3dF(x, y, 0));
+                    program->setScale(1.0f, 1.0f, 1.0f);
+                    isBound = true;
+                }
+
+                glDrawArrays(GL_TRIANGLES, first, last - first);
+                m_drawCallCount++;
+            }
+        }
+
+        if (isBound)
+        {
+            release();
+        }
+    }
+
+    releaseVBO();
+}
+
+unsigned int TrackGeometry::drawCallCount() const
+{
+    return m_drawCallCount;
+}
+
+void TrackGeometry::resetDrawCallCount()
+{
+    m_drawCallCount = 0;
+}
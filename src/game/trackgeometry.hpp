@@ -0,0 +1,84 @@
+// This file is part of Dust Racing 2D.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// Dust Racing 2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Dust Racing 2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Dust Racing 2D. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TRACKGEOMETRY_HPP
+#define TRACKGEOMETRY_HPP
+
+#include <MCGLObjectBase>
+#include <MCGLShaderProgram>
+
+#include <vector>
+
+class MapBase;
+class MCCamera;
+class MCSurface;
+
+/*! Static geometry of the track tiles baked into a single vertex buffer.
+ *
+ *  The tiles never move, so their vertices are transformed once into world
+ *  coordinates. The map is divided into chunks of CHUNK_SIZE x CHUNK_SIZE tiles and
+ *  the vertices are grouped by surface and then by chunk in row-major order.
+ *  The visible chunks of a chunk row are therefore consecutive in the buffer and
+ *  each surface is drawn with one call per visible chunk row. */
+class TrackGeometry : public MCGLObjectBase
+{
+public:
+
+    //! Width and height of a chunk in tiles.
+    static const unsigned int CHUNK_SIZE = 8;
+
+    /*! Constructor. Bakes the tiles of the given map.
+     *  \param asphalt Surface drawn under the tiles that have asphalt. */
+    TrackGeometry(const MapBase & map, MCSurface & asphalt);
+
+    /*! Render the chunks that contain the given tile range as seen through the given camera.
+     *  \param asphaltProgram Program used for the asphalt.
+     *  \param tileProgram Program used for the tiles. */
+    void render(MCCamera * camera, MCGLShaderProgramPtr asphaltProgram, MCGLShaderProgramPtr tileProgram,
+        unsigned int i0, unsigned int i2, unsigned int j0, unsigned int j2);
+
+    //! \return Number of draw calls made by render() since the latest resetDrawCallCount().
+    unsigned int drawCallCount() const;
+
+    //! Reset the draw call count. Call once per frame, before rendering the first camera.
+    void resetDrawCallCount();
+
+private:
+
+    TrackGeometry(const TrackGeometry & other) = delete;
+
+    TrackGeometry & operator=(const TrackGeometry & other) = delete;
+
+    //! Vertices of one surface.
+    struct Group
+    {
+        MCSurface * surface;
+
+        bool isAsphalt;
+
+        //! Chunk c is drawn from vertex chunkOffsets[c] to chunkOffsets[c + 1].
+        std::vector<GLint> chunkOffsets;
+    };
+
+    std::vector<Group> m_groups;
+
+    unsigned int m_chunkCols;
+
+    unsigned int m_chunkRows;
+
+    unsigned int m_drawCallCount;
+};
+
+#endif // TRACKGEOMETRY_HPP
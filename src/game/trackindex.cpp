@@ -0,0 +1,306 @@
+// This file is part of Dust Racing 2D.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// Dust Racing 2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Dust Racing 2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Dust Racing 2D. If not, see <http://www.gnu.org/licenses/>.
+
+#include "trackindex.hpp"
+
+#include "../common/route.hpp"
+#include "../common/targetnodebase.hpp"
+#include "../common/trackdatabase.hpp"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QXmlStreamReader>
+
+#include <MCLogger>
+
+namespace {
+const quint32 INDEX_MAGIC = 0x44524958; // "DRIX"
+const quint32 INDEX_VERSION = 1;
+const int STREAM_VERSION = QDataStream::Qt_5_0;
+
+// Type, orientation and minimap exclusion of a tile
+const qint64 TILE_RECORD_SIZE = sizeof(quint8) + sizeof(qint16) + sizeof(quint8);
+}
+
+const uint8_t TrackIndex::NoType;
+
+TrackIndex::TrackIndex(QString fileName)
+    : m_fileName(fileName)
+    , m_changed(false)
+    , m_scanCount(0)
+{
+}
+
+bool TrackIndex::load()
+{
+    m_entries.clear();
+    m_usedFileNames.clear();
+    m_changed = false;
+
+    if (m_fileName.isEmpty())
+    {
+        return false;
+    }
+
+    QFile file(m_fileName);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    QDataStream in(&file);
+    in.setVersion(STREAM_VERSION);
+
+    quint32 magic = 0, version = 0, count = 0;
+    in >> magic >> version >> count;
+    if (magic != INDEX_MAGIC || version != INDEX_VERSION)
+    {
+        return false;
+    }
+
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; i++)
+    {
+        Entry entry;
+        qint64 fileSize, lastModified;
+        quint32 index, cols, rows, routeLength, tileCount;
+        in >> entry.fileName >> fileSize >> lastModified >> entry.name >> index >> entry.isUserTrack
+           >> cols >> rows >> routeLength >> entry.tileTypes >> tileCount;
+
+        if (in.status() != QDataStream::Ok)
+        {
+            break;
+        }
+
+        // Reject corrupt sizes before allocating the tiles
+        if (tileCount != static_cast<quint64>(cols) * rows ||
+            static_cast<qint64>(tileCount) * TILE_RECORD_SIZE > file.bytesAvailable())
+        {
+            in.setStatus(QDataStream::ReadCorruptData);
+            break;
+        }
+
+        entry.fileSize = fileSize;
+        entry.lastModified = lastModified;
+        entry.index = index;
+        entry.cols = cols;
+        entry.rows = rows;
+        entry.routeLength = routeLength;
+
+        entry.tiles.resize(tileCount);
+        for (auto && tile : entry.tiles)
+        {
+            quint8 type, excludeFromMinimap;
+            qint16 orientation;
+            in >> type >> orientation >> excludeFromMinimap;
+
+            tile.type = type;
+            tile.orientation = orientation;
+            tile.excludeFromMinimap = excludeFromMinimap;
+        }
+
+        m_entries[entry.fileName] = entry;
+    }
+
+    if (in.status() != QDataStream::Ok)
+    {
+        MCLogger().warning() << "Track index '" << m_fileName.toStdString() << "' is corrupt.";
+        m_entries.clear();
+        return false;
+    }
+
+    return true;
+}
+
+bool TrackIndex::save()
+{
+    // Drop the entries of removed tracks
+    for (auto iter = m_entries.begin(); iter != m_entries.end();)
+    {
+        if (!m_usedFileNames.count(iter->first))
+        {
+            iter = m_entries.erase(iter);
+            m_changed = true;
+        }
+        else
+        {
+            iter++;
+        }
+    }
+
+    if (m_fileName.isEmpty() || !m_changed)
+    {
+        return true;
+    }
+
+    QDir().mkpath(QFileInfo(m_fileName).absolutePath());
+
+    QSaveFile file(m_fileName);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        return false;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(STREAM_VERSION);
+    out << INDEX_MAGIC << INDEX_VERSION << static_cast<quint32>(m_entries.size());
+
+    for (auto && iter : m_entries)
+    {
+        const Entry & entry = iter.second;
+        out << entry.fileName << static_cast<qint64>(entry.fileSize) << static_cast<qint64>(entry.lastModified)
+            << entry.name << static_cast<quint32>(entry.index) << entry.isUserTrack
+            << static_cast<quint32>(entry.cols) << static_cast<quint32>(entry.rows)
+            << static_cast<quint32>(entry.routeLength) << entry.tileTypes
+            << static_cast<quint32>(entry.tiles.size());
+
+        for (auto && tile : entry.tiles)
+        {
+            out << static_cast<quint8>(tile.type) << static_cast<qint16>(tile.orientation)
+                << static_cast<quint8>(tile.excludeFromMinimap);
+        }
+    }
+
+    if (out.status() != QDataStream::Ok || !file.commit())
+    {
+        return false;
+    }
+
+    m_changed = false;
+    return true;
+}
+
+const TrackIndex::Entry * TrackIndex::entry(const QFileInfo & file)
+{
+    const QString fileName = file.absoluteFilePath();
+    const int64_t fileSize = file.size();
+    const int64_t lastModified = file.lastModified().toMSecsSinceEpoch();
+
+    auto iter = m_entries.find(fileName);
+    if (iter == m_entries.end() || iter->second.fileSize != fileSize || iter->second.lastModified != lastModified)
+    {
+        Entry entry;
+        m_scanCount++;
+        if (!scan(fileName, entry))
+        {
+            return nullptr;
+        }
+
+        entry.fileSize = fileSize;
+        entry.lastModified = lastModified;
+
+        m_entries[fileName] = entry;
+        m_changed = true;
+    }
+
+    m_usedFileNames.insert(fileName);
+    return &m_entries[fileName];
+}
+
+bool TrackIndex::scan(QString fileName, Entry & entry)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    QXmlStreamReader reader(&file);
+    if (!reader.readNextStartElement() || reader.name() != TrackDataBase::DataKeywords::Header::track)
+    {
+        return false;
+    }
+
+    const QXmlStreamAttributes header = reader.attributes();
+    entry.fileName = fileName;
+    entry.name = header.hasAttribute(TrackDataBase::DataKeywords::Header::name) ?
+        header.value(TrackDataBase::DataKeywords::Header::name).toString() : "undefined";
+    entry.cols = header.value(TrackDataBase::DataKeywords::Header::cols).toUInt();
+    entry.rows = header.value(TrackDataBase::DataKeywords::Header::rows).toUInt();
+    entry.index = header.hasAttribute(TrackDataBase::DataKeywords::Header::index) ?
+        header.value(TrackDataBase::DataKeywords::Header::index).toUInt() : 999;
+    entry.isUserTrack = header.value(TrackDataBase::DataKeywords::Header::user).toUInt();
+
+    if (!entry.cols || !entry.rows)
+    {
+        return false;
+    }
+
+    entry.tileTypes.clear();
+    entry.tiles.assign(entry.cols * entry.rows, Tile());
+
+    // The length is calculated like in the game to get the same rounding
+    std::vector<TargetNodeBasePtr> nodes;
+
+    while (reader.readNextStartElement())
+    {
+        const QXmlStreamAttributes attributes = reader.attributes();
+        if (reader.name() == TrackDataBase::DataKeywords::Track::tile)
+        {
+            const unsigned int i = attributes.value(TrackDataBase::DataKeywords::Tile::i).toUInt();
+            const unsigned int j = attributes.value(TrackDataBase::DataKeywords::Tile::j).toUInt();
+            if (i < entry.cols && j < entry.rows)
+            {
+                const QString type = attributes.hasAttribute(TrackDataBase::DataKeywords::Tile::type) ?
+                    attributes.value(TrackDataBase::DataKeywords::Tile::type).toString() : "clear";
+
+                int typeIndex = entry.tileTypes.indexOf(type);
+                if (typeIndex < 0)
+                {
+                    typeIndex = entry.tileTypes.size();
+                    entry.tileTypes << type;
+                }
+
+                if (typeIndex < NoType)
+                {
+                    Tile & tile = entry.tiles[j * entry.cols + i];
+                    tile.type = static_cast<uint8_t>(typeIndex);
+                    tile.orientation = static_cast<int16_t>(attributes.value(TrackDataBase::DataKeywords::Tile::orientation).toInt());
+                    tile.excludeFromMinimap = attributes.value(TrackDataBase::DataKeywords::Tile::excludeFromMinimap).toInt();
+                }
+            }
+        }
+        else if (reader.name() == TrackDataBase::DataKeywords::Track::node)
+        {
+            TargetNodeBase * node = new TargetNodeBase;
+            node->setIndex(attributes.value(TrackDataBase::DataKeywords::Node::index).toInt());
+            node->setLocation(QPointF(
+                attributes.value(TrackDataBase::DataKeywords::Node::x).toInt(),
+                attributes.value(TrackDataBase::DataKeywords::Node::y).toInt()));
+            nodes.push_back(TargetNodeBasePtr(node));
+        }
+
+        reader.skipCurrentElement();
+    }
+
+    if (reader.hasError())
+    {
+        return false;
+    }
+
+    Route route;
+    route.buildFromVector(nodes);
+    entry.routeLength = route.geometricLength();
+
+    return true;
+}
+
+unsigned int TrackIndex::scanCount() const
+{
+    return m_scanCount;
+}
@@ -0,0 +1,117 @@
+// This file is part of Dust Racing 2D.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// Dust Racing 2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Dust Racing 2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Dust Racing 2D. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TRACKINDEX_HPP
+#define TRACKINDEX_HPP
+
+#include <QString>
+#include <QStringList>
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <vector>
+
+class QFileInfo;
+
+/*! Index of the metadata of the track files. Start-up and the track selection menu need only
+ *  the header, the route length and the tile types of the tracks, so the index stores just that
+ *  in a compact binary file. A track file is parsed only if it's not in the index or if it has
+ *  changed since it was indexed. The full track is loaded when it's selected. */
+class TrackIndex
+{
+public:
+
+    //! Tile type of tiles not defined in the track file.
+    static const uint8_t NoType = 0xff;
+
+    //! Preview data of a tile.
+    struct Tile
+    {
+        //! Index to Entry::tileTypes or NoType if the tile isn't defined in the file.
+        uint8_t type = NoType;
+
+        //! Orientation as in the file.
+        int16_t orientation = 0;
+
+        bool excludeFromMinimap = false;
+    };
+
+    //! Metadata of a track file.
+    struct Entry
+    {
+        QString fileName;
+
+        //! Size and modification time of the file when it was indexed.
+        int64_t fileSize = 0;
+
+        int64_t lastModified = 0;
+
+        QString name;
+
+        unsigned int index = 999;
+
+        bool isUserTrack = false;
+
+        unsigned int cols = 0;
+
+        unsigned int rows = 0;
+
+        unsigned int routeLength = 0;
+
+        //! Distinct tile types of the track.
+        QStringList tileTypes;
+
+        //! Tiles in the order j * cols + i using the coordinates of the file.
+        std::vector<Tile> tiles;
+    };
+
+    /*! Constructor.
+     *  \param fileName File of the index. The index is not stored if the file name is empty. */
+    explicit TrackIndex(QString fileName);
+
+    //! Read the index file. \return false if the file doesn't exist or is not valid.
+    bool load();
+
+    /*! Write the index file if it has been changed. Only the entries returned by entry()
+     *  after load() are stored, so entries of removed tracks are dropped.
+     *  \return false if the file couldn't be written. */
+    bool save();
+
+    /*! \return Up-to-date entry of the given track file or nullptr if the file isn't a valid track.
+     *  The file is scanned if it's not in the index or if its size or modification time has changed. */
+    const Entry * entry(const QFileInfo & file);
+
+    //! Parse the metadata of the given track file. \return false if the file isn't a valid track.
+    static bool scan(QString fileName, Entry & entry);
+
+    //! \return Number of track files scanned since the construction.
+    unsigned int scanCount() const;
+
+private:
+
+    QString m_fileName;
+
+    std::map<QString, Entry> m_entries;
+
+    //! File names of the entries returned by entry() since load().
+    std::set<QString> m_usedFileNames;
+
+    bool m_changed;
+
+    unsigned int m_scanCount;
+};
+
+#endif // TRACKINDEX_HPP
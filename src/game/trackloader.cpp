@@ -13,13 +13,15 @@
 // You should have received a copy of the GNU General Public License
 // along with Dust Racing 2D. If not, see <http://www.gnu.org/licenses/>.
 
+#include <QCryptographicHash>
 #include <QDir>
 #include <QFile>
+#include <QFileInfo>
 #include <QStringList>
 #include <QTextStream>
-#include <QDomDocument>
-#include <QDomElement>
+#include <QStandardPaths>
 
+#include "../common/compiledtrack.hpp"
 #include "../common/config.hpp"
 #include "layers.hpp"
 #include "renderer.hpp"
@@ -73,21 +75,35 @@ void TrackLoader::addTrackSearchPath(QString path)
 
 void TrackLoader::loadAssets()
 {
+    // Pre-processed textures are cached, because decoding the images is most of the start-up time
+    const QString cachePath = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if (!cachePath.isEmpty())
+    {
+        m_assetManager.surfaceManager().setTextureCachePath((cachePath + QDir::separator() + "textures").toStdString());
+    }
+
     m_assetManager.load();
 }
 
 int TrackLoader::loadTracks(int lapCount, DifficultyProfile::Difficulty difficulty)
 {
+    // Only the index is read on start-up. Track files are parsed if they are new or changed.
+    const QString cachePath = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    TrackIndex index(cachePath.isEmpty() ? QString() : cachePath + QDir::separator() + "tracks.idx");
+    index.load();
+
     int numLoaded = 0;
     for (QString path : m_paths)
     {
         MCLogger().info() << "Loading race tracks from '" << path.toStdString() << "'..";
-        QStringList trackPaths(QDir(path).entryList(QStringList("*.trk")));
-        for (QString trackPath : trackPaths)
+        const QFileInfoList trackFiles(QDir(path).entryInfoList(QStringList("*.trk")));
+        for (auto && trackFile : trackFiles)
         {
-            trackPath = path + QDir::separator() + trackPath;
-            if (TrackData * trackData = loadTrack(trackPath))
+            const QString trackPath = path + QDir::separator() + trackFile.fileName();
+            if (const TrackIndex::Entry * entry = index.entry(trackFile))
             {
+                TrackData * trackData = createTrackData(*entry);
+                trackData->setFileName(trackPath);
                 m_tracks.push_back(new Track(trackData));
                 numLoaded++;
 
@@ -100,12 +116,19 @@ int TrackLoader::loadTracks(int lapCount, DifficultyProfile::Difficulty difficul
             }
         }
 
-        if (!trackPaths.size())
+        if (!trackFiles.size())
         {
             MCLogger().info() << "  No race tracks found.";
         }
     }
 
+    MCLogger().info() << "  " << index.scanCount() << " new or changed track(s) indexed.";
+
+    if (!index.save())
+    {
+        MCLogger().warning() << "Couldn't write the track index.";
+    }
+
     if (numLoaded)
     {
         updateLockedTracks(lapCount, difficulty);
@@ -114,6 +137,33 @@ int TrackLoader::loadTracks(int lapCount, DifficultyProfile::Difficulty difficul
     return numLoaded;
 }
 
+TrackData * TrackLoader::createTrackData(const TrackIndex::Entry & entry)
+{
+    TrackData * newData = new TrackData(entry.name, entry.isUserTrack, entry.cols, entry.rows);
+    newData->setIndex(entry.index);
+    newData->setRouteLength(entry.routeLength);
+
+    for (unsigned int j = 0; j < entry.rows; j++)
+    {
+        for (unsigned int i = 0; i < entry.cols; i++)
+        {
+            const TrackIndex::Tile & tileData = entry.tiles[j * entry.cols + i];
+            if (tileData.type < entry.tileTypes.size())
+            {
+                // Mirror the y-index and the angle, because game has the y-axis pointing up.
+                auto tile = dynamic_pointer_cast<TrackTile>(newData->map().getTile(i, entry.rows - 1 - j));
+                assert(tile);
+
+                initTile(*tile, entry.tileTypes.at(tileData.type).toStdString());
+                tile->setRotation(-tileData.orientation);
+                tile->setExcludeFromMinimap(tileData.excludeFromMinimap);
+            }
+        }
+    }
+
+    return newData;
+}
+
 void TrackLoader::updateLockedTracks(int lapCount, DifficultyProfile::Difficulty difficulty)
 {
     sortTracks();
@@ -124,7 +174,7 @@ void TrackLoader::updateLockedTracks(int lapCount, DifficultyProfile::Difficulty
     for (Track * track : m_tracks)
     {
         if (!track->trackData().isUserTrack() &&
-            !Settings::instance().loadTrackUnlockStatus(*track, lapCount, difficulty))
+            !Settings::instance().loadTrackUnlockStatus(track->trackData(), lapCount, difficulty))
         {
             track->trackData().setIsLocked(true);
         }
@@ -133,13 +183,13 @@ void TrackLoader::updateLockedTracks(int lapCount, DifficultyProfile::Difficulty
             track->trackData().setIsLocked(false);
 
             // This is needed in the case new tracks are added to the game afterwards.
-            const int bestPos = Settings::instance().loadBestPos(*track, lapCount, difficulty);
+            const int bestPos = Settings::instance().loadBestPos(track->trackData(), lapCount, difficulty);
             if (bestPos >= 1 && bestPos <= UNLOCK_LIMIT)
             {
                 if (track->next())
                 {
                     track->next()->trackData().setIsLocked(false);
-                    Settings::instance().saveTrackUnlockStatus(*track->next(), lapCount, difficulty);
+                    Settings::instance().saveTrackUnlockStatus(track->next()->trackData(), lapCount, difficulty);
                 }
             }
         }
@@ -151,6 +201,8 @@ void TrackLoader::updateLockedTracks(int lapCount, DifficultyProfile::Difficulty
             firstOfficialTrack->trackData().setIsLocked(false);
         }
     }
+
+    Settings::instance().flushRecords();
 }
 
 void TrackLoader::sortTracks()
@@ -172,118 +224,151 @@ void TrackLoader::sortTracks()
     }
 }
 
-TrackData * TrackLoader::loadTrack(QString path)
+bool TrackLoader::loadTrackContents(Track & track)
 {
-    QDomDocument doc;
-
-    QFile file(path);
-    if (!file.open(QIODevice::ReadOnly))
+    TrackData & data = track.trackData();
+    if (data.isLoaded())
     {
-        return nullptr;
+        return true;
     }
 
-    if (!doc.setContent(&file))
+    CompiledTrack compiledTrack;
+    if (!openCompiledTrack(data, compiledTrack))
     {
-        file.close();
-        return nullptr;
+        return false;
     }
 
-    file.close();
+    // A temporary route vector.
+    std::vector<TargetNodeBasePtr> route;
 
-    TrackData * newData = nullptr;
+    loadCompiledTrack(data, compiledTrack, route);
 
-    QDomElement root = doc.documentElement();
-    if (root.nodeName() == "track")
-    {
-        const unsigned int cols =
-            root.attribute(TrackDataBase::DataKeywords::Header::cols, "0").toUInt();
-        const unsigned int rows =
-            root.attribute(TrackDataBase::DataKeywords::Header::rows, "0").toUInt();
+    data.route().buildFromVector(route);
+    data.setRouteLength(data.route().geometricLength());
+    data.setIsLoaded(true);
 
-        if (cols > 0 && rows > 0)
-        {
-            const QString name =
-                root.attribute(TrackDataBase::DataKeywords::Header::name, "undefined");
+    return true;
+}
 
-            const bool isUserTrack =
-                root.attribute(TrackDataBase::DataKeywords::Header::user, "0").toUInt();
+QString TrackLoader::cachedCompiledFileName(QString trackFileName)
+{
+    // Tracks of different directories may have the same name
+    const QFileInfo trackFile(trackFileName);
+    const QByteArray pathHash = QCryptographicHash::hash(
+        trackFile.absoluteFilePath().toUtf8(), QCryptographicHash::Md5).toHex();
+    const QString cachedTrackFile = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) +
+        QDir::separator() + "tracks" + QDir::separator() + trackFile.completeBaseName() + "-" + pathHash + ".trk";
+    return CompiledTrack::compiledFileName(cachedTrackFile);
+}
 
-            newData = new TrackData(name, isUserTrack, cols, rows);
-            newData->setFileName(path);
+bool TrackLoader::openCompiledFile(const TrackData & data, QString fileName, CompiledTrack & compiledTrack)
+{
+    const QFileInfo trackFile(data.fileName());
+    const QFileInfo compiledFile(fileName);
+    if (!compiledFile.exists() || compiledFile.lastModified() < trackFile.lastModified())
+    {
+        return false;
+    }
 
-            newData->setIndex(root.attribute(TrackDataBase::DataKeywords::Header::index, "999").toUInt());
+    if (!compiledTrack.open(compiledFile.filePath()) ||
+        compiledTrack.sourceSize() != trackFile.size() ||
+        compiledTrack.cols() != data.map().cols() ||
+        compiledTrack.rows() != data.map().rows())
+    {
+        MCLogger().warning() << "Ignoring outdated or invalid '" << compiledFile.filePath().toStdString() << "'..";
+        compiledTrack.close();
+        return false;
+    }
 
-            // A temporary route vector.
-            std::vector<TargetNodeBasePtr> route;
+    return true;
+}
 
-            QDomNode node = root.firstChild();
-            while(!node.isNull())
-            {
-                QDomElement element = node.toElement();
-                if(!element.isNull())
-                {
-                    // Read a tile element
-                    if (element.nodeName() == TrackDataBase::DataKeywords::Track::tile)
-                    {
-                        readTile(element, *newData);
-                    }
-                    // Read an object element
-                    else if (element.nodeName() == TrackDataBase::DataKeywords::Track::object)
-                    {
-                        readObject(element, *newData);
-                    }
-                    // Read a target node element
-                    else if (element.nodeName() == TrackDataBase::DataKeywords::Track::node)
-                    {
-                        readTargetNode(element, *newData, route);
-                    }
-                }
+bool TrackLoader::openCompiledTrack(const TrackData & data, CompiledTrack & compiledTrack)
+{
+    // Use the compiled track written by the editor or cached on an earlier run, if
+    // it's up-to-date. It's read as such from the mapped file.
+    const QString cachedFileName = cachedCompiledFileName(data.fileName());
+    if (openCompiledFile(data, CompiledTrack::compiledFileName(data.fileName()), compiledTrack) ||
+        openCompiledFile(data, cachedFileName, compiledTrack))
+    {
+        return true;
+    }
 
-                node = node.nextSibling();
-            }
+    // Otherwise compile the XML, so that it's parsed only on the first run.
+    // The shipped tracks are compiled in the cache, because the data directory
+    // is usually not writable.
+    const auto writer = CompiledTrackWriter::fromXml(data.fileName());
+    if (!writer)
+    {
+        MCLogger().error() << "Failed to read track '" << data.fileName().toStdString() << "'.";
+        return false;
+    }
 
-            newData->route().buildFromVector(route);
-        }
+    if (!QDir().mkpath(QFileInfo(cachedFileName).path()) || !writer->save(cachedFileName))
+    {
+        MCLogger().warning() << "Failed to cache '" << cachedFileName.toStdString() << "'..";
     }
 
-    return newData;
+    if (!compiledTrack.open(writer->data()) ||
+        compiledTrack.cols() != data.map().cols() ||
+        compiledTrack.rows() != data.map().rows())
+    {
+        MCLogger().error() << "Track '" << data.fileName().toStdString() << "' has changed since it was indexed.";
+        compiledTrack.close();
+        return false;
+    }
+
+    return true;
 }
 
-void TrackLoader::readTile(
-    QDomElement & element, TrackData & newData)
+void TrackLoader::loadCompiledTrack(TrackData & data, const CompiledTrack & compiledTrack, std::vector<TargetNodeBasePtr> & route)
 {
-    // X-coordinate in the tile matrix
-    const unsigned int i = element.attribute(TrackDataBase::DataKeywords::Tile::i, "0").toUInt();
-
-    // Mirror the y-index, because game has the y-axis pointing up.
-    const unsigned int j = newData.map().rows() - 1 - element.attribute(TrackDataBase::DataKeywords::Tile::j, "0").toUInt();
-
-    auto tile = dynamic_pointer_cast<TrackTile>(newData.map().getTile(i, j));
-    assert(tile);
+    // Convert each string only once
+    std::vector<QString> strings;
+    strings.reserve(compiledTrack.stringCount());
+    for (unsigned int index = 0; index < compiledTrack.stringCount(); index++)
+    {
+        strings.push_back(QString::fromUtf8(compiledTrack.string(index)));
+    }
 
-    const std::string type =
-        element.attribute(TrackDataBase::DataKeywords::Tile::type, "clear").toStdString();
-    tile->setTileType(type.c_str());
-    tile->setTileTypeEnum(tileTypeEnumFromString(type.c_str()));
+    const CompiledTrack::Tile * tiles = compiledTrack.tiles();
+    for (unsigned int index = 0; index < compiledTrack.tileCount(); index++)
+    {
+        const CompiledTrack::Tile & tile = tiles[index];
+        setTile(data, tile.i, tile.j, strings[tile.type].toStdString(),
+            tile.orientation, tile.computerHint, tile.excludeFromMinimap);
+    }
 
-    // Mirror the angle, because game has the y-axis pointing up.
-    const int o = -element.attribute("o", "0").toInt();
-    tile->setRotation(o);
+    const CompiledTrack::Object * objects = compiledTrack.objects();
+    for (unsigned int index = 0; index < compiledTrack.objectCount(); index++)
+    {
+        const CompiledTrack::Object & object = objects[index];
+        addObject(data, strings[object.category], strings[object.role],
+            object.x, object.y, object.orientation, object.forceStationary);
+    }
 
-    tile->setComputerHint(
-        static_cast<TrackTileBase::ComputerHint>(element.attribute(TrackDataBase::DataKeywords::Tile::computerHint, "0").toUInt()));
+    const CompiledTrack::Node * nodes = compiledTrack.nodes();
+    for (unsigned int index = 0; index < compiledTrack.nodeCount(); index++)
+    {
+        const CompiledTrack::Node & node = nodes[index];
+        addTargetNode(data, route, node.index, node.x, node.y, node.width, node.height);
+    }
+}
 
-    tile->setExcludeFromMinimap(element.attribute(TrackDataBase::DataKeywords::Tile::excludeFromMinimap, "0").toInt());
+void TrackLoader::initTile(TrackTile & tile, const std::string & type)
+{
+    tile.setTileType(type.c_str());
+    tile.setTileTypeEnum(tileTypeEnumFromString(type.c_str()));
 
     // Associate with a surface object corresponging
     // to the tile type.
     // surface() throws if fails. Handled of higher level.
-    tile->setSurface(&MCAssetManager::surfaceManager().surface(type));
+    tile.setSurface(&MCAssetManager::surfaceManager().surface(type));
 
     // Set preview surface, if found.
     try
     {
-        tile->setPreviewSurface(&MCAssetManager::surfaceManager().surface(type + "Preview"));
+        tile.setPreviewSurface(&MCAssetManager::surfaceManager().surface(type + "Preview"));
     }
     catch (...)
     {
@@ -291,6 +376,23 @@ void TrackLoader::readTile(
     }
 }
 
+void TrackLoader::setTile(TrackData & newData, unsigned int i, unsigned int j,
+    const std::string & type, int orientation, int computerHint, bool excludeFromMinimap)
+{
+    // Mirror the y-index, because game has the y-axis pointing up.
+    auto tile = dynamic_pointer_cast<TrackTile>(newData.map().getTile(i, newData.map().rows() - 1 - j));
+    assert(tile);
+
+    initTile(*tile, type);
+
+    // Mirror the angle, because game has the y-axis pointing up.
+    tile->setRotation(-orientation);
+
+    tile->setComputerHint(static_cast<TrackTileBase::ComputerHint>(computerHint));
+
+    tile->setExcludeFromMinimap(excludeFromMinimap);
+}
+
 TrackTile::TileType TrackLoader::tileTypeEnumFromString(std::string str)
 {
     static std::map<string, TrackTile::TileType> mappings = {
@@ -318,14 +420,9 @@ TrackTile::TileType TrackLoader::tileTypeEnumFromString(std::string str)
     return mappings[str];
 }
 
-void TrackLoader::readObject(QDomElement & element, TrackData & newData)
+void TrackLoader::addObject(TrackData & newData, QString category, QString role,
+    int x, int y, int orientation, bool forceStationary)
 {
-    // X-coordinate in the world
-    const int x = element.attribute(TrackDataBase::DataKeywords::Object::x, "0").toInt();
-
-    // Y-coordinate in the world
-    const int y = element.attribute(TrackDataBase::DataKeywords::Object::y, "0").toInt();
-
     // Height of the map.
     const int h = newData.map().rows() * TrackTile::TILE_H;
 
@@ -335,12 +432,7 @@ void TrackLoader::readObject(QDomElement & element, TrackData & newData)
 
     // Mirror the angle, because the y-axis is pointing
     // down in the editor's coordinate system.
-    const int angle = -element.attribute(TrackDataBase::DataKeywords::Object::orientation, "0").toInt();
-
-    const QString category = element.attribute(TrackDataBase::DataKeywords::Object::category, "");
-    const QString role = element.attribute(TrackDataBase::DataKeywords::Object::role, "");
-
-    const bool forceStationary = element.attribute(TrackDataBase::DataKeywords::Object::forceStationary, "0").toUInt();
+    const int angle = -orientation;
 
     if (TrackObject * object = m_trackObjectFactory.build(category, role, location, angle, forceStationary))
     {
@@ -348,23 +440,18 @@ void TrackLoader::readObject(QDomElement & element, TrackData & newData)
     }
 }
 
-void TrackLoader::readTargetNode(QDomElement & element, TrackData & newData, std::vector<TargetNodeBasePtr> & route)
+void TrackLoader::addTargetNode(TrackData & newData, std::vector<TargetNodeBasePtr> & route,
+    int index, int x, int y, int w, int h)
 {
     // Height of the map. The y-coordinates needs to be mirrored, because
     // the coordinate system is y-wise mirrored in the editor.
     const int mapHeight = newData.map().rows() * TrackTile::TILE_H;
 
     TargetNodeBase * tnode = new TargetNodeBase;
-    tnode->setIndex(element.attribute(TrackDataBase::DataKeywords::Node::index, "0").toInt());
-
-    const int x = element.attribute(TrackDataBase::DataKeywords::Node::x, "0").toInt();
-    const int y = element.attribute(TrackDataBase::DataKeywords::Node::y, "0").toInt();
+    tnode->setIndex(index);
 
     tnode->setLocation(QPointF(x, mapHeight - y));
 
-    const int w = element.attribute(TrackDataBase::DataKeywords::Node::width, "0").toInt();
-    const int h = element.attribute(TrackDataBase::DataKeywords::Node::height, "0").toInt();
-
     if (w > 0 && h > 0)
     {
         tnode->setSize(QSizeF(w, h));
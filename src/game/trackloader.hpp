@@ -23,16 +23,17 @@
 #include <MCObjectFactory>
 
 #include "difficultyprofile.hpp"
+#include "trackindex.hpp"
 #include "tracktile.hpp"
 #include "trackobjectfactory.hpp"
 
 #include "../common/targetnodebase.hpp"
 
+class CompiledTrack;
 class TargetNodeBase;
 class Track;
 class TrackData;
 class TrackTileBase;
-class QDomElement;
 
 //! A singleton class that handles track loading.
 //! TODO: This can be shared with the editor or inherit from
@@ -52,11 +53,17 @@ public:
 
     void loadAssets();
 
-    /*! Load all tracks found in the added paths.
+    /*! Load the metadata of all tracks found in the added paths from the track index.
+     *  Only new and changed track files are parsed. The objects and the route are
+     *  loaded later by loadTrackContents().
      *  Lock/unlock tracks according to the given lap count.
      *  \return Number of track loaded. */
     int loadTracks(int lapCount, DifficultyProfile::Difficulty difficulty);
 
+    /*! Load the tiles, objects and route of the given track, if not already loaded.
+     *  \return false if the track file couldn't be loaded. */
+    bool loadTrackContents(Track & track);
+
     //! Update locked tracks when lap count changes.
     void updateLockedTracks(int lapCount, DifficultyProfile::Difficulty difficulty);
 
@@ -70,20 +77,40 @@ public:
 
 private:
 
-    //! Load the given track.
-    //! \return Valid data pointer or nullptr if fails.
-    TrackData * loadTrack(QString path);
+    //! Create track data with the tiles of the given index entry.
+    TrackData * createTrackData(const TrackIndex::Entry & entry);
+
+    //! Set the type and the surfaces of the given tile.
+    void initTile(TrackTile & tile, const std::string & type);
 
     void sortTracks();
 
-    //! Read a tile element.
-    void readTile(QDomElement & element, TrackData & newData);
+    //! \return the name of the compiled file of the given track file in the cache directory.
+    static QString cachedCompiledFileName(QString trackFileName);
+
+    /*! Open the given compiled file of the track.
+     *  \return false if it's missing, invalid or not up-to-date with the track file. */
+    bool openCompiledFile(const TrackData & data, QString fileName, CompiledTrack & compiledTrack);
+
+    /*! Open the compiled track written by the editor or cached on an earlier run.
+     *  If neither is up-to-date, compile the track file and cache the result.
+     *  \return false if the track file couldn't be read. */
+    bool openCompiledTrack(const TrackData & data, CompiledTrack & compiledTrack);
+
+    //! Load the tiles, objects and route of the given compiled track.
+    void loadCompiledTrack(TrackData & data, const CompiledTrack & compiledTrack, std::vector<TargetNodeBasePtr> & route);
+
+    //! Set the tile at the given location of the editor's coordinate system.
+    void setTile(TrackData & newData, unsigned int i, unsigned int j,
+        const std::string & type, int orientation, int computerHint, bool excludeFromMinimap);
 
-    //! Read an object element.
-    void readObject(QDomElement & element, TrackData & newData);
+    //! Add an object at the given location of the editor's coordinate system.
+    void addObject(TrackData & newData, QString category, QString role,
+        int x, int y, int orientation, bool forceStationary);
 
-    //! Read a target node element and push to the given vector.
-    void readTargetNode(QDomElement & element, TrackData & newData, std::vector<TargetNodeBasePtr> & route);
+    //! Create a target node at the given location of the editor's coordinate system and push to the given vector.
+    void addTargetNode(TrackData & newData, std::vector<TargetNodeBasePtr> & route,
+        int index, int x, int y, int w, int h);
 
     //! Convert tile type string to a type enum.
     TrackTile::TileType tileTypeEnumFromString(std::string str);